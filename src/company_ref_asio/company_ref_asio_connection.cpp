@@ -99,6 +99,7 @@ void AsioConnection<T>::onConnect(boost::system::error_code const& error)
 
     onSend_ = dataHandler_->connectSendData(
             WeakBind(&AsioConnection<T>::doSend, this->shared_from_this(), std::placeholders::_1));
+    onClose_ = dataHandler_->connectClose(WeakBind(&AsioConnection<T>::close, this->shared_from_this()));
 
     doRead();
 }
@@ -147,6 +148,7 @@ void AsioConnection<T>::doClose()
     }
 
     onSend_.reset();
+    onClose_.reset();
 
     if (dataHandler_ && !doClose_) { boost::asio::post(readerStrand_, WeakBind(&AsioMsgHandler::stop, dataHandler_)); }
 
@@ -201,7 +203,7 @@ void AsioConnection<T>::onRead(boost::system::error_code const& ec, std::size_t
 }
 
 template <typename T>
-void AsioConnection<T>::doSend(BufferType&& buffer)
+void AsioConnection<T>::doSend(boost::asio::const_buffer const& buffer)
 {
     FunctionArgLog(AsioConnectionLog) << loggerIdentity() << std::endl;
 
@@ -211,7 +213,7 @@ void AsioConnection<T>::doSend(BufferType&& buffer)
 
     boost::system::error_code ec;
 
-    boost::asio::write(socket_, boost::asio::buffer(buffer.data(), buffer.size()), ec);
+    boost::asio::write(socket_, buffer, ec);
     if (ec) {
 
         DebugLog(AsioConnectionLog) << loggerIdentity() << " doSend " << ec.message() << std::endl;
@@ -116,7 +116,7 @@ protected:
     void doRead();
     void onRead(boost::system::error_code const&, std::size_t);
 
-    void doSend(BufferType&&);
+    void doSend(boost::asio::const_buffer const&);
 
 protected:
     SocketType socket_;
@@ -125,12 +125,14 @@ protected:
 private:
     AsioMsgHandlerPtr dataHandler_;
 
-    using SendFunction = std::function<void(BufferType&&)>;
+    using SendFunction = std::function<void(boost::asio::const_buffer const&)>;
     using SendConnection = std::shared_ptr<SendFunction>;
 
     std::mutex sendLock_;
     SendConnection onSend_; //!< Token for dataHandler's sending
 
+    std::shared_ptr<std::function<void()>> onClose_; //!< Token for dataHandler's close requests
+
     BufferType recvBuffer_;
 
     std::atomic<bool> doClose_;
@@ -13,11 +13,30 @@ AsioMsgHandler::~AsioMsgHandler() = default;
 
 bool AsioMsgHandler::sendData(BufferType&& buffer)
 {
-    SendConnection sendFunction = sendFunction_.lock();
-    if (!sendFunction) return false;
+    BufferType sendBuffer(std::move(buffer));
 
+    return sendData(boost::asio::buffer(sendBuffer.data(), sendBuffer.size()));
+}
+
+bool AsioMsgHandler::sendData(boost::asio::const_buffer const& buffer)
+{
+    return sendData(buffer, WrittenFunction());
+}
+
+bool AsioMsgHandler::sendData(boost::asio::const_buffer const& buffer, WrittenFunction const& onWritten)
+{
     try {
-        (*sendFunction)(std::move(buffer));
+        if (QueuedSendConnection queuedSendFunction = queuedSendFunction_.lock()) {
+            (*queuedSendFunction)(buffer, onWritten);
+            return true;
+        }
+
+        SendConnection sendFunction = sendFunction_.lock();
+        if (!sendFunction) return false;
+
+        // written before returning
+        (*sendFunction)(buffer);
+        if (onWritten) onWritten();
         return true;
     } catch (std::bad_function_call& ec) {
         std::cerr << "sendData: " << ec.what() << std::endl;
@@ -32,3 +51,32 @@ AsioMsgHandler::SendConnection AsioMsgHandler::connectSendData(SendFunction cons
     sendFunction_ = sendFunction;
     return sendFunction;
 }
+
+bool AsioMsgHandler::requestClose()
+{
+    CloseConnection closeFunction = closeFunction_.lock();
+    if (!closeFunction) return false;
+
+    try {
+        (*closeFunction)();
+        return true;
+    } catch (std::bad_function_call& ec) {
+        std::cerr << "requestClose: " << ec.what() << std::endl;
+    }
+
+    return false;
+}
+
+AsioMsgHandler::QueuedSendConnection AsioMsgHandler::connectSendDataQueued(QueuedSendFunction const& cb)
+{
+    QueuedSendConnection queuedSendFunction = std::make_shared<QueuedSendFunction>(cb);
+    queuedSendFunction_ = queuedSendFunction;
+    return queuedSendFunction;
+}
+
+AsioMsgHandler::CloseConnection AsioMsgHandler::connectClose(CloseFunction const& cb)
+{
+    CloseConnection closeFunction = std::make_shared<CloseFunction>(cb);
+    closeFunction_ = closeFunction;
+    return closeFunction;
+}
@@ -32,12 +32,21 @@ namespace Edge {
  * isConnected can be used by the recvData function
  * to know if it should consume the data or not.
  *
+ * A connection that queues data and writes it after sendData
+ * returns connects with connectSendDataQueued instead, so the
+ * handler learns when the data has actually been written.
+ *
  */
 class AsioMsgHandler {
 public:
     using BufferType = std::vector<uint8_t>;
-    using SendFunction = std::function<void(BufferType&&)>;
+    using SendFunction = std::function<void(boost::asio::const_buffer const&)>;
     using SendConnection = std::shared_ptr<SendFunction>;
+    using WrittenFunction = std::function<void()>;
+    using QueuedSendFunction = std::function<void(boost::asio::const_buffer const&, WrittenFunction const&)>;
+    using QueuedSendConnection = std::shared_ptr<QueuedSendFunction>;
+    using CloseFunction = std::function<void()>;
+    using CloseConnection = std::shared_ptr<CloseFunction>;
 
     using Ptr = std::shared_ptr<AsioMsgHandler>;
 
@@ -55,19 +64,48 @@ public:
     /// Used to send data to the connection
     bool sendData(BufferType&&);
 
+    /*!
+     * Sends data the caller keeps ownership of
+     *
+     * The connection is done with the buffer when this returns, either
+     * written or copied to it's queue, so a buffer shared between
+     * connections can be sent without the caller copying it
+     */
+    bool sendData(boost::asio::const_buffer const&);
+
+    /*!
+     * Sends data, onWritten is called once the connection has written it
+     *
+     * Called before returning unless the connection queues it's sends;
+     * then it's called on whichever thread completes the write, and not
+     * at all if the connection is closed first
+     */
+    bool sendData(boost::asio::const_buffer const&, WrittenFunction const& onWritten);
+
     /// "slot" for sending data to the Connection object
     SendConnection connectSendData(SendFunction const& f);
 
+    /// "slot" for a Connection object that writes after sendData returns
+    QueuedSendConnection connectSendDataQueued(QueuedSendFunction const& f);
+
     /// Returns true if the "slot" is connected
     bool isConnected() const;
 
+    /// Asks the connection to close, used to give up on a client
+    bool requestClose();
+
+    /// "slot" for closing the Connection object
+    CloseConnection connectClose(CloseFunction const& f);
+
 private:
     std::weak_ptr<SendFunction> sendFunction_;
+    std::weak_ptr<QueuedSendFunction> queuedSendFunction_;
+    std::weak_ptr<CloseFunction> closeFunction_;
 };
 
 inline bool AsioMsgHandler::isConnected() const
 {
-    return (bool)(sendFunction_.lock());
+    return sendFunction_.lock() || queuedSendFunction_.lock();
 }
 
 } // namespace Edge
@@ -10,3 +10,9 @@ using namespace Compan::Edge;
 AsioMsgHandlerFactory::AsioMsgHandlerFactory()
 {
 }
+
+AsioMsgHandlerPtr AsioMsgHandlerFactory::makeWithContext(uint32_t const connectionId, boost::asio::io_context&)
+{
+    // handlers not bound to an io_context can ignore it
+    return make(connectionId);
+}
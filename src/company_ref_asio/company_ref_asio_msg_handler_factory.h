@@ -8,6 +8,12 @@ Copyright © 2024 COMPAN REF
 
 #include <memory>
 
+namespace boost {
+namespace asio {
+class io_context;
+} // namespace asio
+} // namespace boost
+
 namespace Compan{
 namespace Edge {
 
@@ -21,6 +27,9 @@ public:
     virtual ~AsioMsgHandlerFactory() = default;
 
     virtual AsioMsgHandlerPtr make(uint32_t const connectionId) = 0;
+
+    /// Creates a handler serviced by ctx, a server reactor's io_context
+    virtual AsioMsgHandlerPtr makeWithContext(uint32_t const connectionId, boost::asio::io_context& ctx);
 };
 
 } // namespace Edge
@@ -0,0 +1,122 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_asio_reactor_pool.cpp
+ @brief Pool of single threaded io_contexts servicing connections
+ */
+#include "company_ref_asio_reactor_pool.h"
+
+#include <Compan_logger/Compan_logger.h>
+
+#include <algorithm>
+
+#include <pthread.h>
+#include <sched.h>
+
+using namespace Compan::Edge;
+
+CompanLogger AsioReactorPoolLog("asio.reactors", LogLevel::Information);
+
+AsioReactorPool::Reactor::Reactor()
+    : ctx(1) // concurrency hint, one thread per reactor
+    , work(std::make_unique<WorkGuard>(boost::asio::make_work_guard(ctx)))
+    , connections(0)
+    , accepted(0)
+{
+}
+
+AsioReactorPool::AsioReactorPool(size_t const reactorCount, Policy const policy, bool const pinToCores)
+    : policy_(policy)
+    , pinToCores_(pinToCores)
+    , next_(0)
+{
+    for (size_t i = 0; i < std::max<size_t>(1, reactorCount); ++i) reactors_.emplace_back(std::make_unique<Reactor>());
+}
+
+AsioReactorPool::~AsioReactorPool()
+{
+    stop();
+}
+
+void AsioReactorPool::run()
+{
+    FunctionLog(AsioReactorPoolLog);
+
+    for (size_t i = 0; i < reactors_.size(); ++i) {
+        Reactor& reactor(*reactors_[i]);
+        if (reactor.thread.joinable()) continue;
+
+        reactor.thread = std::thread([this, &reactor, i] {
+            if (pinToCores_ && !pinThread(i)) {
+                WarnLog(AsioReactorPoolLog) << "reactor " << i << " could not be pinned" << std::endl;
+            }
+
+            try {
+                reactor.ctx.run();
+            } catch (std::exception& e) {
+                ErrorLog(AsioReactorPoolLog) << "reactor " << i << ": " << e.what() << std::endl;
+            }
+        });
+    }
+}
+
+void AsioReactorPool::stop()
+{
+    FunctionLog(AsioReactorPoolLog);
+
+    for (auto& reactor : reactors_) {
+        reactor->work.reset();
+        reactor->ctx.stop();
+    }
+
+    for (auto& reactor : reactors_) {
+        if (reactor->thread.joinable()) reactor->thread.join();
+    }
+}
+
+size_t AsioReactorPool::select()
+{
+    if (policy_ == RoundRobin) return next_++ % reactors_.size();
+
+    // ties go round robin, so an idle pool still spreads connections
+    size_t const start = next_++ % reactors_.size();
+
+    size_t selected = start;
+    for (size_t i = 1; i < reactors_.size(); ++i) {
+        size_t const candidate = (start + i) % reactors_.size();
+        if (reactors_[candidate]->connections < reactors_[selected]->connections) selected = candidate;
+    }
+
+    return selected;
+}
+
+void AsioReactorPool::connectionOpened(size_t const reactor)
+{
+    ++reactors_[reactor]->connections;
+    ++reactors_[reactor]->accepted;
+}
+
+void AsioReactorPool::connectionClosed(size_t const reactor)
+{
+    --reactors_[reactor]->connections;
+}
+
+std::vector<AsioReactorPool::Stats> AsioReactorPool::stats() const
+{
+    std::vector<Stats> stats;
+    stats.reserve(reactors_.size());
+
+    for (auto const& reactor : reactors_) stats.push_back({reactor->connections, reactor->accepted});
+
+    return stats;
+}
+
+bool AsioReactorPool::pinThread(size_t const core)
+{
+    unsigned const cores = std::max(1u, std::thread::hardware_concurrency());
+
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(core % cores, &cpuSet);
+
+    return ::pthread_setaffinity_np(::pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+}
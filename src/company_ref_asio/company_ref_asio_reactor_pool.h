@@ -0,0 +1,112 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_asio_reactor_pool.h
+ @brief Pool of single threaded io_contexts servicing connections
+ */
+#ifndef __company_ref_ASIO_REACTOR_POOL_H__
+#define __company_ref_ASIO_REACTOR_POOL_H__
+
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace Compan{
+namespace Edge {
+
+/*!
+ * @brief Reactor per core
+ *
+ * Owns N io_contexts, each run by a single thread, optionally pinned to
+ * a core. Servers given a pool place every accepted connection, it's
+ * handler and strands, on one reactor; connections on different reactors
+ * don't contend on a scheduler.
+ *
+ * The VariantValueStore keeps running on the application's io_context,
+ * value changes reach the connections through their handler's strands.
+ */
+class AsioReactorPool {
+public:
+    /// How a reactor is picked for a new connection
+    enum Policy { RoundRobin, LeastLoaded };
+
+    /// Per reactor load
+    struct Stats {
+        size_t connections; //!< open connections
+        uint64_t accepted;  //!< connections placed on the reactor
+    };
+
+    AsioReactorPool(size_t const reactorCount, Policy const policy = RoundRobin, bool const pinToCores = false);
+    virtual ~AsioReactorPool();
+
+    /// Starts a thread per reactor
+    void run();
+
+    /// Stops the reactors and joins their threads
+    void stop();
+
+    /// Picks the reactor for a new connection
+    size_t select();
+
+    /// io_context of a reactor
+    boost::asio::io_context& ioContext(size_t const reactor);
+
+    /// Bookkeeping of the connections on a reactor
+    void connectionOpened(size_t const reactor);
+    void connectionClosed(size_t const reactor);
+
+    size_t size() const;
+    Policy policy() const;
+
+    std::vector<Stats> stats() const;
+
+protected:
+    AsioReactorPool(AsioReactorPool const&) = delete;
+    AsioReactorPool& operator=(AsioReactorPool const&) = delete;
+
+    /// Pins the calling thread, returns false if the core isn't available
+    static bool pinThread(size_t const core);
+
+private:
+    using WorkGuard = boost::asio::executor_work_guard<boost::asio::io_context::executor_type>;
+
+    struct Reactor {
+        Reactor();
+
+        boost::asio::io_context ctx;
+        std::unique_ptr<WorkGuard> work; //!< keeps run() going without connections
+        std::thread thread;
+
+        std::atomic<size_t> connections;
+        std::atomic<uint64_t> accepted;
+    };
+
+    Policy const policy_;
+    bool const pinToCores_;
+
+    std::vector<std::unique_ptr<Reactor>> reactors_;
+    std::atomic<size_t> next_; //!< round robin cursor
+};
+
+inline boost::asio::io_context& AsioReactorPool::ioContext(size_t const reactor)
+{
+    return reactors_[reactor]->ctx;
+}
+
+inline size_t AsioReactorPool::size() const
+{
+    return reactors_.size();
+}
+
+inline AsioReactorPool::Policy AsioReactorPool::policy() const
+{
+    return policy_;
+}
+
+} // namespace Edge
+} // namespace Compan
+
+#endif // __company_ref_ASIO_REACTOR_POOL_H__
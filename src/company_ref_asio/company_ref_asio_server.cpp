@@ -6,6 +6,8 @@
 #include "company_ref_asio_server.h"
 #include "company_ref_asio_connection.h"
 #include "company_ref_asio_msg_handler_factory.h"
+#include "company_ref_asio_reactor_pool.h"
+#include "company_ref_asio_uring.h"
 
 #include <Compan_logger/Compan_logger.h>
 
@@ -14,11 +16,12 @@ using namespace Compan::Edge;
 CompanLogger AsioServerLog("asio.server", LogLevel::Information);
 
 template <typename T>
-AsioServer<T>::AsioServer(boost::asio::io_context& ctx, AsioMsgHandlerFactory& factory)
+AsioServer<T>::AsioServer(boost::asio::io_context& ctx, AsioMsgHandlerFactory& factory, AsioReactorPool* reactors)
     : ctx_(ctx)
     , socket_(ctx_)
     , acceptor_(ctx_)
     , factory_(factory)
+    , reactors_(reactors)
 {
 }
 
@@ -37,6 +40,11 @@ void AsioServer<T>::close()
     for (auto& conn : connections_) conn.second->close();
 
     connections_.clear();
+
+    if (reactors_) {
+        for (auto& connReactor : connectionReactors_) reactors_->connectionClosed(connReactor.second);
+    }
+    connectionReactors_.clear();
 }
 
 template <typename T>
@@ -70,6 +78,45 @@ bool AsioServer<T>::empty() const
     return connections_.empty();
 }
 
+template <typename T>
+bool AsioServer<T>::enableUring()
+{
+    if (!AsioUring::isSupported()) return false;
+
+    std::vector<AsioUringPtr> rings;
+
+    // a ring is serviced by one io_context, the connections on it share it
+    for (size_t reactor = 0; reactor < (reactors_ ? reactors_->size() : 1); ++reactor) {
+        AsioUringPtr ring(AsioUring::create(reactorContext(reactor)));
+        if (!ring) return false;
+
+        rings.push_back(ring);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    rings_ = std::move(rings);
+
+    return true;
+}
+
+template <typename T>
+AsioUringStats AsioServer<T>::uringStats()
+{
+    AsioUringStats total = {0, 0, 0, 0};
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto const& ring : rings_) {
+        AsioUringStats const stats(ring->stats());
+
+        total.enters += stats.enters;
+        total.wakeups += stats.wakeups;
+        total.submitted += stats.submitted;
+        total.completed += stats.completed;
+    }
+
+    return total;
+}
+
 template <typename T>
 void AsioServer<T>::doAccept(typename SocketType::endpoint_type const& endpoint)
 {
@@ -84,10 +131,14 @@ void AsioServer<T>::doAccept(typename SocketType::endpoint_type const& endpoint)
 template <typename T>
 void AsioServer<T>::doAccept()
 {
-    acceptor_.async_accept([this](boost::system::error_code ec, SocketType socket) {
+    // the socket is accepted straight onto it's reactor
+    size_t const reactor = reactors_ ? reactors_->select() : 0;
+    socket_ = SocketType(reactorContext(reactor));
+
+    acceptor_.async_accept(socket_, [this, reactor](boost::system::error_code ec) {
         if (ec) { return; }
 
-        createConnection(std::move(socket));
+        createConnection(std::move(socket_), reactor);
         doAccept();
     });
 }
@@ -98,6 +149,42 @@ void AsioServer<T>::onDisconnection(uint32_t const connectionId)
     std::lock_guard<std::mutex> lock(mutex_);
     connections_.erase(connectionId);
     signalConnections_.erase(connectionId);
+
+    auto reactorIter = connectionReactors_.find(connectionId);
+    if (reactorIter != connectionReactors_.end()) {
+        reactors_->connectionClosed(reactorIter->second);
+        connectionReactors_.erase(reactorIter);
+    }
+}
+
+template <typename T>
+void AsioServer<T>::addConnection(uint32_t const connectionId, AsioConnectionPtr connPtr, size_t const reactor)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    SignalScopedConnection disconnectSignal(connPtr->connectOnDisconnection(
+            std::bind(&AsioServer<T>::onDisconnection, this, std::placeholders::_1)));
+
+    connections_.emplace(connectionId, connPtr);
+    signalConnections_.emplace(connectionId, std::move(disconnectSignal));
+
+    if (reactors_) {
+        connectionReactors_.emplace(connectionId, reactor);
+        reactors_->connectionOpened(reactor);
+    }
+}
+
+template <typename T>
+boost::asio::io_context& AsioServer<T>::reactorContext(size_t const reactor)
+{
+    return reactors_ ? reactors_->ioContext(reactor) : ctx_;
+}
+
+template <typename T>
+AsioUringPtr AsioServer<T>::uring(size_t const reactor)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return reactor < rings_.size() ? rings_[reactor] : nullptr;
 }
 
 #include <boost/asio/ip/tcp.hpp>
@@ -14,6 +14,7 @@
 
 #include <map>
 #include <thread>
+#include <vector>
 
 namespace Compan{
 namespace Edge {
@@ -22,10 +23,21 @@ class AsioConnectionBase;
 using AsioConnectionPtr = std::shared_ptr<AsioConnectionBase>;
 
 class AsioMsgHandlerFactory;
+class AsioReactorPool;
+
+class AsioUring;
+using AsioUringPtr = std::shared_ptr<AsioUring>;
+struct AsioUringStats;
 
 /*!
  * Handles incoming connections and tracks lifetime of the
  * connection
+ *
+ * Given an AsioReactorPool, each accepted connection is placed on one
+ * of the pool's reactors instead of ctx.
+ *
+ * With enableUring, connections are serviced by an io_uring per reactor
+ * instead of the reactor's epoll based socket operations.
  */
 template <typename T>
 class AsioServer {
@@ -39,7 +51,7 @@ public:
     /// Signal for connection/disconnection
     using ConnectionSignal = SignalAsio<void(uint32_t const)>;
 
-    AsioServer(boost::asio::io_context& ctx, AsioMsgHandlerFactory& factory);
+    AsioServer(boost::asio::io_context& ctx, AsioMsgHandlerFactory& factory, AsioReactorPool* reactors = nullptr);
     virtual ~AsioServer();
 
     /// Closes and disconnects all connections
@@ -55,6 +67,12 @@ public:
     /// Returns true if no connections exist
     bool empty() const;
 
+    /// Services the connections accepted from now on with io_uring, false if the kernel can't
+    bool enableUring();
+
+    /// io_uring system calls made, summed over the reactors
+    AsioUringStats uringStats();
+
 protected:
     /// Accepts a connection from an endpoint
     void doAccept(typename SocketType::endpoint_type const& endpoint);
@@ -67,7 +85,16 @@ protected:
     void onDisconnection(uint32_t const);
 
     /// Creates a connection AsioConnection and adds to the server list
-    virtual void createConnection(SocketType&& socket) = 0;
+    virtual void createConnection(SocketType&& socket, size_t const reactor) = 0;
+
+    /// Adds a connection to the server list
+    void addConnection(uint32_t const connectionId, AsioConnectionPtr connPtr, size_t const reactor);
+
+    /// io_context servicing connections of a reactor, ctx without a pool
+    boost::asio::io_context& reactorContext(size_t const reactor);
+
+    /// io_uring of a reactor, nullptr unless enabled
+    AsioUringPtr uring(size_t const reactor);
 
 protected:
     boost::asio::io_context& ctx_;
@@ -75,11 +102,15 @@ protected:
     AcceptorType acceptor_;
 
     AsioMsgHandlerFactory& factory_;
+    AsioReactorPool* reactors_;
 
     ConnectionMapType connections_;
 
     mutable std::mutex mutex_; // mutable allows for ignoring CV in size() and empty()
     std::map<uint32_t, SignalScopedConnection> signalConnections_;
+    std::map<uint32_t, size_t> connectionReactors_;
+
+    std::vector<AsioUringPtr> rings_; //!< one per reactor
 };
 
 } // namespace Edge
@@ -0,0 +1,487 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_asio_shm_connection.cpp
+ @brief Shared memory connection, bootstrapped over a UDS socket
+ */
+#include "company_ref_asio_shm_connection.h"
+
+#include "company_ref_asio_msg_handler.h"
+
+#include <company_ref_utils/company_ref_weak_bind.h>
+#include <Compan_logger/Compan_logger.h>
+
+#include <boost/asio/bind_executor.hpp>
+#include <boost/asio/post.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace Compan::Edge;
+
+CompanLogger AsioShmConnectionLog("asio.shm.connection", LogLevel::Information);
+
+namespace {
+/// memfd followed by the eventfds
+size_t const HandshakeFdCount(5);
+} // namespace
+
+AsioShmConnection::AsioShmConnection(
+        boost::asio::io_context& ctx,
+        uint32_t const connId,
+        AsioMsgHandlerPtr msgHandler,
+        SocketType socket,
+        uint64_t const ringCapacity)
+    : AsioConnectionBase(ctx, connId, AsioConnectionBase::Server)
+    , socket_(std::move(socket))
+    , ringCapacity_(ringCapacity)
+    , dataHandler_(msgHandler)
+    , txRing_(nullptr)
+    , rxRing_(nullptr)
+    , txDataFd_(-1)
+    , txSpaceFd_(-1)
+    , rxSpaceFd_(-1)
+    , rxData_(ctx)
+    , rxEventCount_(0)
+    , watchByte_(0)
+    , doClose_(false)
+{
+    FunctionArgLog(AsioShmConnectionLog) << "ctor server - " << connectionId_ << std::endl;
+
+    eventFds_.fill(-1);
+
+    if (dataHandler_ == nullptr) {
+        ErrorLog(AsioShmConnectionLog) << "missing MsgHandler - " << connectionId_ << std::endl;
+    }
+}
+
+AsioShmConnection::AsioShmConnection(
+        boost::asio::io_context& ctx,
+        uint32_t const connId,
+        AsioMsgHandlerPtr msgHandler,
+        std::string const& udsPath)
+    : AsioConnectionBase(ctx, connId, AsioConnectionBase::Client)
+    , socket_(ctx)
+    , endPoint_(udsPath)
+    , ringCapacity_(0)
+    , dataHandler_(msgHandler)
+    , txRing_(nullptr)
+    , rxRing_(nullptr)
+    , txDataFd_(-1)
+    , txSpaceFd_(-1)
+    , rxSpaceFd_(-1)
+    , rxData_(ctx)
+    , rxEventCount_(0)
+    , watchByte_(0)
+    , doClose_(false)
+{
+    FunctionArgLog(AsioShmConnectionLog) << "ctor client - " << connectionId_ << std::endl;
+
+    eventFds_.fill(-1);
+
+    if (dataHandler_ == nullptr) {
+        ErrorLog(AsioShmConnectionLog) << "missing MsgHandler - " << connectionId_ << std::endl;
+    }
+}
+
+AsioShmConnection::~AsioShmConnection()
+{
+    FunctionLog(AsioShmConnectionLog);
+
+    release();
+}
+
+void AsioShmConnection::connect()
+{
+    FunctionArgLog(AsioShmConnectionLog) << loggerIdentity() << std::endl;
+
+    {
+        // a reconnect gets a fresh segment from the server
+        std::lock_guard<std::mutex> lock(sendLock_);
+        release();
+    }
+
+    doClose_ = false;
+    socket_.async_connect(
+            endPoint_, WeakBind(&AsioShmConnection::onConnect, shared_from_this(), std::placeholders::_1));
+}
+
+void AsioShmConnection::close()
+{
+    FunctionArgLog(AsioShmConnectionLog) << loggerIdentity() << std::endl;
+
+    // This will invoke the cancellation wrappers for the waits
+    if (socket_.is_open()) socket_.cancel();
+    if (rxData_.is_open()) rxData_.cancel();
+}
+
+bool AsioShmConnection::isConnected()
+{
+    return socket_.is_open() && !doClose_;
+}
+
+void AsioShmConnection::onConnect(boost::system::error_code const& error)
+{
+    FunctionArgLog(AsioShmConnectionLog) << loggerIdentity() << std::endl;
+
+    if (error) {
+        ErrorLog(AsioShmConnectionLog) << loggerIdentity() << " onConnect " << error.message() << std::endl;
+        return;
+    }
+
+    if (connectionType_ == Client) {
+        socket_.async_wait(
+                SocketType::wait_read,
+                WeakBind(&AsioShmConnection::onRings, shared_from_this(), std::placeholders::_1));
+        return;
+    }
+
+    if (!sendRings()) {
+        doClose();
+        return;
+    }
+
+    start();
+}
+
+bool AsioShmConnection::sendRings()
+{
+    FunctionArgLog(AsioShmConnectionLog) << loggerIdentity() << std::endl;
+
+    if (!segment_.create(ringCapacity_)) return false;
+
+    for (int& fd : eventFds_) {
+        fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (fd < 0) {
+            ErrorLog(AsioShmConnectionLog) << loggerIdentity() << " eventfd: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+    }
+
+    int fds[HandshakeFdCount] = {segment_.fd(),
+                                 eventFds_[ServerToClientData],
+                                 eventFds_[ServerToClientSpace],
+                                 eventFds_[ClientToServerData],
+                                 eventFds_[ClientToServerSpace]};
+
+    char payload('S');
+    struct iovec iov = {&payload, sizeof(payload)};
+
+    union {
+        char buf[CMSG_SPACE(sizeof(fds))];
+        struct cmsghdr align;
+    } control;
+    std::memset(&control, 0, sizeof(control));
+
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    std::memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    if (::sendmsg(socket_.native_handle(), &msg, MSG_NOSIGNAL) != sizeof(payload)) {
+        ErrorLog(AsioShmConnectionLog) << loggerIdentity() << " sendmsg: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    txRing_ = &segment_.ring(AsioShmSegment::ServerToClient);
+    rxRing_ = &segment_.ring(AsioShmSegment::ClientToServer);
+
+    txDataFd_ = eventFds_[ServerToClientData];
+    txSpaceFd_ = eventFds_[ServerToClientSpace];
+    rxSpaceFd_ = eventFds_[ClientToServerSpace];
+
+    rxData_.assign(::dup(eventFds_[ClientToServerData]));
+
+    return true;
+}
+
+void AsioShmConnection::onRings(boost::system::error_code const& error)
+{
+    FunctionArgLog(AsioShmConnectionLog) << loggerIdentity() << std::endl;
+
+    if (error) {
+        DebugLog(AsioShmConnectionLog) << loggerIdentity() << " onRings " << error.message() << std::endl;
+        doClose();
+        return;
+    }
+
+    char payload(0);
+    struct iovec iov = {&payload, sizeof(payload)};
+
+    union {
+        char buf[CMSG_SPACE(sizeof(int) * HandshakeFdCount)];
+        struct cmsghdr align;
+    } control;
+    std::memset(&control, 0, sizeof(control));
+
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    ssize_t const received = ::recvmsg(socket_.native_handle(), &msg, MSG_CMSG_CLOEXEC);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (received != sizeof(payload) || cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET
+        || cmsg->cmsg_type != SCM_RIGHTS || cmsg->cmsg_len != CMSG_LEN(sizeof(int) * HandshakeFdCount)) {
+        ErrorLog(AsioShmConnectionLog) << loggerIdentity() << " onRings invalid handshake" << std::endl;
+
+        if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            size_t const count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            int fds[HandshakeFdCount];
+            std::memcpy(fds, CMSG_DATA(cmsg), std::min(count, HandshakeFdCount) * sizeof(int));
+            for (size_t i = 0; i < std::min(count, HandshakeFdCount); ++i) ::close(fds[i]);
+        }
+
+        doClose();
+        return;
+    }
+
+    int fds[HandshakeFdCount];
+    std::memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+
+    for (size_t i = 0; i < eventFds_.size(); ++i) eventFds_[i] = fds[i + 1];
+
+    if (!segment_.attach(fds[0])) {
+        doClose();
+        return;
+    }
+
+    txRing_ = &segment_.ring(AsioShmSegment::ClientToServer);
+    rxRing_ = &segment_.ring(AsioShmSegment::ServerToClient);
+
+    txDataFd_ = eventFds_[ClientToServerData];
+    txSpaceFd_ = eventFds_[ClientToServerSpace];
+    rxSpaceFd_ = eventFds_[ServerToClientSpace];
+
+    rxData_.assign(::dup(eventFds_[ServerToClientData]));
+
+    start();
+}
+
+void AsioShmConnection::start()
+{
+    FunctionArgLog(AsioShmConnectionLog) << loggerIdentity() << std::endl;
+
+    onConnected_(connectionId_);
+
+    if (!dataHandler_) {
+        ErrorLog(AsioShmConnectionLog) << loggerIdentity() << " start missing MsgHandler" << std::endl;
+        return;
+    }
+
+    dataHandler_->start();
+
+    onSend_ = dataHandler_->connectSendData(
+            WeakBind(&AsioShmConnection::doSend, shared_from_this(), std::placeholders::_1));
+    onClose_ = dataHandler_->connectClose(WeakBind(&AsioShmConnection::close, shared_from_this()));
+
+    doWatchSocket();
+
+    // anything written before we armed the eventfd is picked up by the first read
+    doReadEvent();
+}
+
+void AsioShmConnection::doClose()
+{
+    FunctionArgLog(AsioShmConnectionLog) << __FUNCTION__ << loggerIdentity() << std::endl;
+
+    // the socket watch and the eventfd read both end up here
+    if (doClose_.exchange(true)) return;
+
+    boost::system::error_code ec;
+
+    if (socket_.is_open()) {
+        socket_.close(ec);
+        if (ec) { ErrorLog(AsioShmConnectionLog) << loggerIdentity() << " close " << ec.message() << std::endl; }
+    }
+
+    if (rxData_.is_open()) rxData_.close(ec);
+
+    onSend_.reset();
+    onClose_.reset();
+
+    if (dataHandler_) { boost::asio::post(readerStrand_, WeakBind(&AsioMsgHandler::stop, dataHandler_)); }
+
+    onDisconnected_(connectionId_);
+}
+
+void AsioShmConnection::release()
+{
+    txRing_ = nullptr;
+    rxRing_ = nullptr;
+
+    txDataFd_ = -1;
+    txSpaceFd_ = -1;
+    rxSpaceFd_ = -1;
+
+    boost::system::error_code ec;
+    if (rxData_.is_open()) rxData_.close(ec);
+
+    for (int& fd : eventFds_) {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+
+    segment_.close();
+}
+
+void AsioShmConnection::doReadEvent()
+{
+    FunctionArgLog(AsioShmConnectionLog) << loggerIdentity() << std::endl;
+
+    rxData_.async_read_some(
+            boost::asio::buffer(&rxEventCount_, sizeof(rxEventCount_)),
+            boost::asio::bind_executor(
+                    readerStrand_,
+                    WeakBind(
+                            &AsioShmConnection::onReadEvent,
+                            shared_from_this(),
+                            std::placeholders::_1,
+                            std::placeholders::_2)));
+}
+
+void AsioShmConnection::onReadEvent(boost::system::error_code const& ec, std::size_t)
+{
+    FunctionArgLog(AsioShmConnectionLog) << loggerIdentity() << std::endl;
+
+    if (ec || doClose_) {
+        DebugLog(AsioShmConnectionLog) << loggerIdentity() << " onReadEvent Closing connection" << std::endl;
+        doClose();
+        return;
+    }
+
+    if (!dataHandler_) {
+        ErrorLog(AsioShmConnectionLog) << loggerIdentity() << " onReadEvent Lost data handler?" << std::endl;
+        doClose();
+        return;
+    }
+
+    BufferType recvBuffer;
+
+    // the eventfd is reset before draining, a write racing us signals again
+    for (size_t readable = rxRing_->readable(); readable != 0; readable = rxRing_->readable()) {
+        size_t const offset = recvBuffer.size();
+        recvBuffer.resize(offset + readable);
+        recvBuffer.resize(offset + rxRing_->read(recvBuffer.data() + offset, readable));
+    }
+
+    // the peer shares the ring's counters, they aren't read past once inconsistent
+    if (rxRing_->isCorrupted()) {
+        ErrorLog(AsioShmConnectionLog) << loggerIdentity() << " onReadEvent corrupted ring, closing connection"
+                                       << std::endl;
+        doClose();
+        return;
+    }
+
+    if (!recvBuffer.empty()) {
+        signal(rxSpaceFd_);
+        dataHandler_->recvData(std::move(recvBuffer));
+    }
+
+    doReadEvent();
+}
+
+void AsioShmConnection::doWatchSocket()
+{
+    FunctionArgLog(AsioShmConnectionLog) << loggerIdentity() << std::endl;
+
+    // nothing is sent on the socket past the handshake, completing means the peer is gone
+    socket_.async_read_some(
+            boost::asio::buffer(&watchByte_, sizeof(watchByte_)),
+            boost::asio::bind_executor(
+                    readerStrand_,
+                    WeakBind(
+                            &AsioShmConnection::onWatchSocket,
+                            shared_from_this(),
+                            std::placeholders::_1,
+                            std::placeholders::_2)));
+}
+
+void AsioShmConnection::onWatchSocket(boost::system::error_code const& ec, std::size_t)
+{
+    FunctionArgLog(AsioShmConnectionLog) << loggerIdentity() << std::endl;
+
+    DebugLog(AsioShmConnectionLog) << loggerIdentity() << " onWatchSocket Closing connection " << ec.message()
+                                   << std::endl;
+
+    doClose();
+}
+
+void AsioShmConnection::doSend(boost::asio::const_buffer const& buffer)
+{
+    FunctionArgLog(AsioShmConnectionLog) << loggerIdentity() << std::endl;
+
+    if (!isConnected()) return;
+
+    std::lock_guard<std::mutex> lock(sendLock_);
+
+    if (txRing_ == nullptr) return;
+
+    uint8_t const* data = static_cast<uint8_t const*>(buffer.data());
+    size_t remaining = buffer.size();
+
+    while (remaining) {
+        size_t const written = txRing_->write(data, remaining);
+
+        if (written) {
+            data += written;
+            remaining -= written;
+
+            signal(txDataFd_);
+            continue;
+        }
+
+        if (!waitForSpace()) {
+            DebugLog(AsioShmConnectionLog) << loggerIdentity() << " doSend peer stalled" << std::endl;
+            doClose();
+            return;
+        }
+    }
+}
+
+bool AsioShmConnection::waitForSpace()
+{
+    while (txRing_->writable() == 0) {
+        if (doClose_ || txRing_->isCorrupted()) return false;
+
+        struct pollfd fds[2] = {{txSpaceFd_, POLLIN, 0}, {socket_.native_handle(), POLLIN, 0}};
+
+        int const ready = ::poll(fds, 2, SendTimeoutMs);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0) return false;
+
+        // the peer never writes to the socket, it is hanging up
+        if (fds[1].revents) return false;
+
+        uint64_t count;
+        if (::read(txSpaceFd_, &count, sizeof(count)) < 0 && errno != EAGAIN) return false;
+    }
+
+    return true;
+}
+
+void AsioShmConnection::signal(int const fd)
+{
+    uint64_t const count(1);
+
+    // EAGAIN only when the counter is saturated, the peer is already awake
+    if (::write(fd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+        ErrorLog(AsioShmConnectionLog) << "eventfd write: " << std::strerror(errno) << std::endl;
+    }
+}
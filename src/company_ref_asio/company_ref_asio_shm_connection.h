@@ -0,0 +1,143 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_asio_shm_connection.h
+ @brief Shared memory connection, bootstrapped over a UDS socket
+ */
+#ifndef __company_ref_ASIO_SHM_CONNECTION_H__
+#define __company_ref_ASIO_SHM_CONNECTION_H__
+
+#include "company_ref_asio_connection.h"
+#include "company_ref_asio_shm_ring.h"
+
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+
+#include <array>
+#include <atomic>
+#include <mutex>
+
+namespace Compan{
+namespace Edge {
+
+/*!
+ * @brief Connection carrying the AEC byte stream over shared memory rings
+ *
+ * The client connects to the server's UDS socket; the server answers with
+ * a memfd holding a pair of SPSC rings and the eventfds used to signal
+ * them (SCM_RIGHTS). From then on data is copied into and out of the
+ * rings, the socket is only kept to detect the peer going away.
+ *
+ * Each direction has two eventfds; data, written by the producer after
+ * writing, and space, written by the consumer after reading so a producer
+ * facing a full ring can wait.
+ *
+ * The same AsioMsgHandler objects are used as with a socket.
+ */
+class AsioShmConnection : public AsioConnectionBase, public std::enable_shared_from_this<AsioShmConnection> {
+public:
+    using Ptr = std::shared_ptr<AsioShmConnection>;
+
+    using BufferType = std::vector<uint8_t>;
+    using SocketType = boost::asio::local::stream_protocol::socket;
+    using EndPointType = boost::asio::local::stream_protocol::endpoint;
+
+    /// Time a writer waits for the peer to make room in a full ring
+    static int const SendTimeoutMs = 5000;
+
+    /// Server connection, created by a listen
+    AsioShmConnection(
+            boost::asio::io_context& ctx,
+            uint32_t const connId,
+            AsioMsgHandlerPtr msgHandler,
+            SocketType socket,
+            uint64_t const ringCapacity = AsioShmSegment::DefaultCapacity);
+
+    /// Client connection
+    AsioShmConnection(
+            boost::asio::io_context& ctx,
+            uint32_t const connId,
+            AsioMsgHandlerPtr msgHandler,
+            std::string const& udsPath);
+
+    virtual ~AsioShmConnection();
+
+    /// Connects
+    virtual void connect();
+
+    /// Stops servicing data
+    virtual void close();
+
+    /// Checks if connection is open
+    virtual bool isConnected();
+
+    /// Server: creates and hands over the rings, Client: waits for them
+    void onConnect(boost::system::error_code const&);
+
+protected:
+    enum EventFd { ServerToClientData, ServerToClientSpace, ClientToServerData, ClientToServerSpace, EventFdCount };
+
+    /// Server side of the handshake
+    bool sendRings();
+
+    /// Client side of the handshake
+    void onRings(boost::system::error_code const&);
+
+    /// Starts servicing data
+    void start();
+
+    void doClose();
+
+    /// Releases the rings and eventfds
+    void release();
+
+    void doReadEvent();
+    void onReadEvent(boost::system::error_code const&, std::size_t);
+
+    /// Watches the socket for the peer closing
+    void doWatchSocket();
+    void onWatchSocket(boost::system::error_code const&, std::size_t);
+
+    void doSend(boost::asio::const_buffer const&);
+
+    /// Waits for the peer to read from a full ring
+    bool waitForSpace();
+
+    /// Wakes up the peer
+    static void signal(int const fd);
+
+private:
+    SocketType socket_;
+    EndPointType endPoint_;
+
+    uint64_t const ringCapacity_;
+
+    AsioMsgHandlerPtr dataHandler_;
+
+    AsioShmSegment segment_;
+    AsioShmRing* txRing_;
+    AsioShmRing* rxRing_;
+
+    std::array<int, EventFdCount> eventFds_;
+    int txDataFd_;  //!< signaled after writing
+    int txSpaceFd_; //!< waited on when the ring is full
+    int rxSpaceFd_; //!< signaled after reading
+
+    boost::asio::posix::stream_descriptor rxData_; //!< the peer's data eventfd
+    uint64_t rxEventCount_;
+
+    using SendFunction = std::function<void(boost::asio::const_buffer const&)>;
+    using SendConnection = std::shared_ptr<SendFunction>;
+
+    std::mutex sendLock_;
+    SendConnection onSend_;                          //!< Token for dataHandler's sending
+    std::shared_ptr<std::function<void()>> onClose_; //!< Token for dataHandler's close requests
+
+    uint8_t watchByte_;
+
+    std::atomic<bool> doClose_;
+};
+
+} // namespace Edge
+} // namespace Compan
+
+#endif // __company_ref_ASIO_SHM_CONNECTION_H__
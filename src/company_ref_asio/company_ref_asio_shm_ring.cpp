@@ -0,0 +1,300 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_asio_shm_ring.cpp
+ @brief Shared memory SPSC byte rings
+ */
+#include "company_ref_asio_shm_ring.h"
+
+#include <Compan_logger/Compan_logger.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace Compan::Edge;
+
+CompanLogger AsioShmRingLog("asio.shm", LogLevel::Information);
+
+namespace {
+/// Leads the segment, lets the client size it's mapping
+struct SegmentHeader {
+    alignas(64) uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+};
+
+uint32_t const SegmentMagic(0x41454353); // AECS
+uint32_t const SegmentVersion(1);
+
+/// The segment's size is fixed once created, neither peer can truncate it under the other's mapping
+int const SegmentSeals(F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+
+uint64_t roundUpPow2(uint64_t value)
+{
+    uint64_t pow2(4096);
+    while (pow2 < value) pow2 <<= 1;
+    return pow2;
+}
+} // namespace
+
+AsioShmRing::AsioShmRing()
+    : header_(nullptr)
+    , data_(nullptr)
+    , mask_(0)
+    , head_(0)
+    , tail_(0)
+    , corrupted_(false)
+{
+}
+
+AsioShmRing::AsioShmRing(void* base, uint64_t const capacity, bool const initialize)
+    : header_(static_cast<Header*>(base))
+    , data_(static_cast<uint8_t*>(base) + sizeof(Header))
+    , mask_(capacity - 1)
+    , head_(0)
+    , tail_(0)
+    , corrupted_(false)
+{
+    if (initialize) {
+        new (header_) Header();
+        header_->head.store(0, std::memory_order_relaxed);
+        header_->tail.store(0, std::memory_order_relaxed);
+        header_->capacity = capacity;
+    }
+
+    head_ = header_->head.load(std::memory_order_acquire);
+    tail_ = header_->tail.load(std::memory_order_acquire);
+
+    if (head_ - tail_ > this->capacity()) {
+        ErrorLog(AsioShmRingLog) << "attach: ring counters out of bounds" << std::endl;
+        corrupted_ = true;
+    }
+}
+
+size_t AsioShmRing::footprint(uint64_t const capacity)
+{
+    return sizeof(Header) + capacity;
+}
+
+size_t AsioShmRing::write(uint8_t const* data, size_t const len)
+{
+    uint64_t const head = head_;
+
+    uint64_t tail;
+    if (!loadTail(tail)) return 0;
+
+    size_t const count = std::min<uint64_t>(len, capacity() - (head - tail));
+    if (count == 0) return 0;
+
+    // may wrap around the end of the data
+    size_t const offset = head & mask_;
+    size_t const first = std::min<size_t>(count, capacity() - offset);
+
+    std::memcpy(data_ + offset, data, first);
+    std::memcpy(data_, data + first, count - first);
+
+    head_ = head + count;
+    header_->head.store(head_, std::memory_order_release);
+
+    return count;
+}
+
+size_t AsioShmRing::read(uint8_t* data, size_t const len)
+{
+    uint64_t const tail = tail_;
+
+    uint64_t head;
+    if (!loadHead(head)) return 0;
+
+    size_t const count = std::min<uint64_t>(len, head - tail);
+    if (count == 0) return 0;
+
+    size_t const offset = tail & mask_;
+    size_t const first = std::min<size_t>(count, capacity() - offset);
+
+    std::memcpy(data, data_ + offset, first);
+    std::memcpy(data + first, data_, count - first);
+
+    tail_ = tail + count;
+    header_->tail.store(tail_, std::memory_order_release);
+
+    return count;
+}
+
+size_t AsioShmRing::readable()
+{
+    uint64_t head;
+    if (!loadHead(head)) return 0;
+
+    return head - tail_;
+}
+
+size_t AsioShmRing::writable()
+{
+    uint64_t tail;
+    if (!loadTail(tail)) return 0;
+
+    return capacity() - (head_ - tail);
+}
+
+bool AsioShmRing::loadHead(uint64_t& head)
+{
+    if (corrupted_) return false;
+
+    head = header_->head.load(std::memory_order_acquire);
+
+    // unsigned, a head behind the tail is out of bounds too
+    if (head - head_ > capacity() || head - tail_ > capacity()) {
+        ErrorLog(AsioShmRingLog) << "read: head " << head << " out of bounds, tail " << tail_ << std::endl;
+        corrupted_ = true;
+        return false;
+    }
+
+    head_ = head;
+
+    return true;
+}
+
+bool AsioShmRing::loadTail(uint64_t& tail)
+{
+    if (corrupted_) return false;
+
+    tail = header_->tail.load(std::memory_order_acquire);
+
+    if (tail - tail_ > capacity() || head_ - tail > capacity()) {
+        ErrorLog(AsioShmRingLog) << "write: tail " << tail << " out of bounds, head " << head_ << std::endl;
+        corrupted_ = true;
+        return false;
+    }
+
+    tail_ = tail;
+
+    return true;
+}
+
+AsioShmSegment::AsioShmSegment()
+    : fd_(-1)
+    , base_(nullptr)
+    , size_(0)
+{
+}
+
+AsioShmSegment::~AsioShmSegment()
+{
+    close();
+}
+
+bool AsioShmSegment::create(uint64_t const capacity)
+{
+    close();
+
+    uint64_t const ringCapacity = roundUpPow2(capacity);
+
+    fd_ = ::memfd_create("company_ref_shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd_ < 0) {
+        ErrorLog(AsioShmRingLog) << "memfd_create: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    size_ = sizeof(SegmentHeader) + 2 * AsioShmRing::footprint(ringCapacity);
+    if (::ftruncate(fd_, size_) != 0) {
+        ErrorLog(AsioShmRingLog) << "ftruncate: " << std::strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+
+    if (::fcntl(fd_, F_ADD_SEALS, SegmentSeals) != 0) {
+        ErrorLog(AsioShmRingLog) << "F_ADD_SEALS: " << std::strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+
+    base_ = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (base_ == MAP_FAILED) {
+        ErrorLog(AsioShmRingLog) << "mmap: " << std::strerror(errno) << std::endl;
+        base_ = nullptr;
+        close();
+        return false;
+    }
+
+    SegmentHeader* header = new (base_) SegmentHeader();
+    header->magic = SegmentMagic;
+    header->version = SegmentVersion;
+    header->capacity = ringCapacity;
+
+    return map(true);
+}
+
+bool AsioShmSegment::attach(int const fd)
+{
+    close();
+
+    fd_ = fd;
+
+    // an unsealed segment could be shrunk by the peer, faulting our accesses past it's end
+    int const seals = ::fcntl(fd_, F_GET_SEALS);
+    if (seals < 0 || (seals & SegmentSeals) != SegmentSeals) {
+        ErrorLog(AsioShmRingLog) << "attach: segment not sealed" << std::endl;
+        close();
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(fd_, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SegmentHeader)) {
+        ErrorLog(AsioShmRingLog) << "attach: invalid segment" << std::endl;
+        close();
+        return false;
+    }
+
+    size_ = st.st_size;
+
+    base_ = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (base_ == MAP_FAILED) {
+        ErrorLog(AsioShmRingLog) << "mmap: " << std::strerror(errno) << std::endl;
+        base_ = nullptr;
+        close();
+        return false;
+    }
+
+    SegmentHeader const* header = static_cast<SegmentHeader const*>(base_);
+    if (header->magic != SegmentMagic || header->version != SegmentVersion || header->capacity == 0
+        || (header->capacity & (header->capacity - 1)) != 0
+        || size_ < sizeof(SegmentHeader) + 2 * AsioShmRing::footprint(header->capacity)) {
+        ErrorLog(AsioShmRingLog) << "attach: segment mismatch" << std::endl;
+        close();
+        return false;
+    }
+
+    return map(false);
+}
+
+void AsioShmSegment::close()
+{
+    rings_[ServerToClient] = AsioShmRing();
+    rings_[ClientToServer] = AsioShmRing();
+
+    if (base_) ::munmap(base_, size_);
+    base_ = nullptr;
+    size_ = 0;
+
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+}
+
+bool AsioShmSegment::map(bool const initialize)
+{
+    uint64_t const capacity = static_cast<SegmentHeader const*>(base_)->capacity;
+
+    uint8_t* ringBase = static_cast<uint8_t*>(base_) + sizeof(SegmentHeader);
+
+    rings_[ServerToClient] = AsioShmRing(ringBase, capacity, initialize);
+    rings_[ClientToServer] = AsioShmRing(ringBase + AsioShmRing::footprint(capacity), capacity, initialize);
+
+    return true;
+}
@@ -0,0 +1,155 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_asio_shm_ring.h
+ @brief Shared memory SPSC byte rings
+ */
+#ifndef __company_ref_ASIO_SHM_RING_H__
+#define __company_ref_ASIO_SHM_RING_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Compan{
+namespace Edge {
+
+/*!
+ * @brief Single producer, single consumer byte ring
+ *
+ * A view over a ring placed in shared memory; one process writes, the
+ * other reads. The ring carries the same AEC framed byte stream a socket
+ * would, so the message handlers are unaware of the transport.
+ *
+ * head and tail are free running byte counters, the capacity is a power
+ * of two. Each side keeps it's own counter privately and only trusts the
+ * peer's once it's checked: it may not go backwards, nor have more than the
+ * capacity in flight. A ring failing this is corrupted, and no longer used.
+ */
+class AsioShmRing {
+public:
+    /// Shared memory layout of the ring's control block, followed by the data
+    struct Header {
+        alignas(64) std::atomic<uint64_t> head; //!< bytes written, producer owned
+        alignas(64) std::atomic<uint64_t> tail; //!< bytes read, consumer owned
+        alignas(64) uint64_t capacity;
+    };
+
+    static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shared memory rings require lock free 64 bit atomics");
+
+    AsioShmRing();
+
+    /// Attaches to a ring at base, initialize is done once by the creator
+    AsioShmRing(void* base, uint64_t const capacity, bool const initialize);
+
+    /// Bytes of shared memory required by a ring
+    static size_t footprint(uint64_t const capacity);
+
+    /// Copies up to len bytes in, returns the number of bytes written
+    size_t write(uint8_t const* data, size_t const len);
+
+    /// Copies up to len bytes out, returns the number of bytes read
+    size_t read(uint8_t* data, size_t const len);
+
+    /// Bytes waiting to be read
+    size_t readable();
+
+    /// Room left for writing
+    size_t writable();
+
+    uint64_t capacity() const;
+
+    bool isValid() const;
+
+    /// Whether the peer's counter was found inconsistent
+    bool isCorrupted() const;
+
+private:
+    /// Loads and checks the peer's head, when reading
+    bool loadHead(uint64_t& head);
+
+    /// Loads and checks the peer's tail, when writing
+    bool loadTail(uint64_t& tail);
+
+private:
+    Header* header_;
+    uint8_t* data_;
+    uint64_t mask_;
+
+    uint64_t head_; //!< last head written or checked
+    uint64_t tail_; //!< last tail read or checked
+    bool corrupted_;
+};
+
+/*!
+ * @brief memfd backed shared memory holding the two rings of a connection
+ *
+ * The server creates the segment and hands the descriptor to the client
+ * over the UDS socket; ring 0 carries server to client, ring 1 client to
+ * server.
+ */
+class AsioShmSegment {
+public:
+    enum Direction { ServerToClient = 0, ClientToServer = 1 };
+
+    static uint64_t const DefaultCapacity = 1 << 20;
+
+    AsioShmSegment();
+    virtual ~AsioShmSegment();
+
+    /// Creates and maps a new segment, capacity is rounded up to a power of two
+    bool create(uint64_t const capacity = DefaultCapacity);
+
+    /// Maps a sealed segment received from the server, takes ownership of fd
+    bool attach(int const fd);
+
+    /// Unmaps and closes the segment
+    void close();
+
+    /// The memfd, to be passed to the peer
+    int fd() const;
+
+    AsioShmRing& ring(Direction const direction);
+
+protected:
+    AsioShmSegment(AsioShmSegment const&) = delete;
+    AsioShmSegment& operator=(AsioShmSegment const&) = delete;
+
+    /// Maps fd and attaches to it's rings
+    bool map(bool const initialize);
+
+private:
+    int fd_;
+    void* base_;
+    size_t size_;
+    AsioShmRing rings_[2];
+};
+
+inline uint64_t AsioShmRing::capacity() const
+{
+    return mask_ + 1;
+}
+
+inline bool AsioShmRing::isValid() const
+{
+    return header_ != nullptr;
+}
+
+inline bool AsioShmRing::isCorrupted() const
+{
+    return corrupted_;
+}
+
+inline int AsioShmSegment::fd() const
+{
+    return fd_;
+}
+
+inline AsioShmRing& AsioShmSegment::ring(Direction const direction)
+{
+    return rings_[direction];
+}
+
+} // namespace Edge
+} // namespace Compan
+
+#endif // __company_ref_ASIO_SHM_RING_H__
@@ -0,0 +1,50 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_asio_shm_server.cpp
+ @brief Derived Server for shared memory connections
+ */
+#include "company_ref_asio_shm_server.h"
+#include "company_ref_asio_shm_connection.h"
+
+#include "company_ref_asio_msg_handler.h"
+#include "company_ref_asio_msg_handler_factory.h"
+
+using namespace Compan::Edge;
+
+uint32_t AsioShmServer::connectionId_(3000);
+
+AsioShmServer::AsioShmServer(
+        boost::asio::io_context& ctx,
+        AsioMsgHandlerFactory& factory,
+        std::string const& udsPath,
+        uint64_t const ringCapacity,
+        AsioReactorPool* reactors)
+    : AsioServer<boost::asio::local::stream_protocol>(ctx, factory, reactors)
+    , ringCapacity_(ringCapacity)
+{
+    if (!udsPath.empty()) {
+        ::unlink(udsPath.c_str()); // Remove previous binding.
+    }
+
+    boost::asio::local::stream_protocol::endpoint endpoint(udsPath);
+
+    doAccept(endpoint);
+}
+
+AsioShmServer::~AsioShmServer() = default;
+
+void AsioShmServer::createConnection(SocketType&& socket, size_t const reactor)
+{
+    ++connectionId_;
+
+    boost::asio::io_context& ctx = reactorContext(reactor);
+
+    AsioMsgHandlerPtr msgHandler = factory_.makeWithContext(connectionId_, ctx);
+
+    AsioShmConnection::Ptr connPtr(std::make_shared<AsioShmConnection>(
+            ctx, connectionId_, msgHandler, std::move(socket), ringCapacity_));
+
+    addConnection(connectionId_, connPtr, reactor);
+
+    connPtr->onConnect(boost::system::error_code());
+}
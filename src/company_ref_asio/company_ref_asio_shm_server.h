@@ -0,0 +1,43 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_asio_shm_server.h
+ @brief Derived Server for shared memory connections
+ */
+#ifndef __company_ref_ASIO_SHM_SERVER_H__
+#define __company_ref_ASIO_SHM_SERVER_H__
+
+#include "company_ref_asio_server.h"
+#include "company_ref_asio_shm_ring.h"
+
+#include <boost/asio/local/stream_protocol.hpp>
+
+namespace Compan{
+namespace Edge {
+
+/*!
+ * Listens on a UDS socket and hands each connecting client it's own
+ * pair of shared memory rings
+ */
+class AsioShmServer : public AsioServer<boost::asio::local::stream_protocol> {
+public:
+    AsioShmServer(
+            boost::asio::io_context& ctx,
+            AsioMsgHandlerFactory& factory,
+            std::string const& udsPath,
+            uint64_t const ringCapacity = AsioShmSegment::DefaultCapacity,
+            AsioReactorPool* reactors = nullptr);
+    virtual ~AsioShmServer();
+
+protected:
+    virtual void createConnection(SocketType&& socket, size_t const reactor);
+
+private:
+    uint64_t const ringCapacity_;
+
+    static uint32_t connectionId_;
+};
+
+} // namespace Edge
+} // namespace Compan
+
+#endif // __company_ref_ASIO_SHM_SERVER_H__
@@ -5,47 +5,110 @@
  */
 #include "company_ref_asio_tcp_server.h"
 #include "company_ref_asio_tcp_connection.h"
+#include "company_ref_asio_uring_connection.h"
 
 #include "company_ref_asio_msg_handler.h"
 #include "company_ref_asio_msg_handler_factory.h"
+#include "company_ref_asio_reactor_pool.h"
+
+#include <boost/asio/detail/socket_option.hpp>
 
 using namespace Compan::Edge;
 
-uint32_t AsioTcpServer::connectionId_(100);
+std::atomic<uint32_t> AsioTcpServer::connectionId_(100);
+
+namespace {
+using ReusePort = boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+} // namespace
+
+AsioTcpServer::AcceptShard::AcceptShard(boost::asio::io_context& ctx)
+    : acceptor(ctx)
+    , socket(ctx)
+{
+}
 
 AsioTcpServer::AsioTcpServer(
         boost::asio::io_context& ctx,
         AsioMsgHandlerFactory& factory,
         std::string const& address,
-        std::string const& port)
-    : AsioServer<boost::asio::ip::tcp>(ctx, factory)
+        std::string const& port,
+        AsioReactorPool* reactors)
+    : AsioServer<boost::asio::ip::tcp>(ctx, factory, reactors)
 {
     boost::asio::ip::tcp::resolver resolver(ctx);
     boost::asio::ip::tcp::resolver::query query(address, port);
     boost::asio::ip::tcp::endpoint endpoint = *resolver.resolve(query);
 
-    doAccept(endpoint);
+    if (reactors_)
+        doAcceptShards(endpoint);
+    else
+        doAccept(endpoint);
 }
 
-AsioTcpServer::~AsioTcpServer() = default;
+AsioTcpServer::~AsioTcpServer()
+{
+    for (auto& shard : shards_) {
+        boost::system::error_code ec;
+        shard->acceptor.close(ec);
+    }
+}
 
-void AsioTcpServer::createConnection(SocketType&& socket)
+void AsioTcpServer::createConnection(SocketType&& socket, size_t const reactor)
 {
-    ++connectionId_;
+    // shards accept concurrently
+    uint32_t const connectionId = ++connectionId_;
 
-    AsioMsgHandlerPtr msgHandler = factory_.make(connectionId_);
-    AsioTcpConnection::Ptr connPtr(
-            std::make_shared<AsioTcpConnection>(ctx_, connectionId_, msgHandler, std::move(socket)));
+    boost::asio::io_context& ctx = reactorContext(reactor);
 
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
+    AsioMsgHandlerPtr msgHandler = factory_.makeWithContext(connectionId, ctx);
 
-        SignalScopedConnection disconnectSignal(connPtr->connectOnDisconnection(
-                std::bind(&AsioTcpServer::onDisconnection, this, std::placeholders::_1)));
+    if (AsioUringPtr ring = uring(reactor)) {
+        AsioTcpUringConnection::Ptr connPtr(std::make_shared<AsioTcpUringConnection>(
+                ctx, connectionId, msgHandler, std::move(socket), ring));
 
-        connections_.emplace(connectionId_, connPtr);
-        signalConnections_.emplace(connectionId_, std::move(disconnectSignal));
+        addConnection(connectionId, connPtr, reactor);
+
+        connPtr->onConnect(boost::system::error_code());
+        return;
     }
 
+    AsioTcpConnection::Ptr connPtr(
+            std::make_shared<AsioTcpConnection>(ctx, connectionId, msgHandler, std::move(socket)));
+
+    addConnection(connectionId, connPtr, reactor);
+
     connPtr->onConnect(boost::system::error_code());
 }
+
+void AsioTcpServer::doAcceptShards(EndPointType const& endpoint)
+{
+    for (size_t reactor = 0; reactor < reactors_->size(); ++reactor) {
+        shards_.emplace_back(std::make_unique<AcceptShard>(reactors_->ioContext(reactor)));
+
+        AcceptorType& acceptor(shards_.back()->acceptor);
+
+        acceptor.open(endpoint.protocol());
+        acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+        acceptor.set_option(ReusePort(true));
+        acceptor.bind(endpoint);
+        acceptor.listen();
+    }
+
+    for (size_t reactor = 0; reactor < shards_.size(); ++reactor) doAcceptShard(reactor);
+}
+
+void AsioTcpServer::doAcceptShard(size_t const reactor)
+{
+    AcceptShard& shard(*shards_[reactor]);
+
+    shard.acceptor.async_accept(shard.socket, [this, reactor](boost::system::error_code ec) {
+        if (ec) { return; }
+
+        AcceptShard& shard(*shards_[reactor]);
+
+        createConnection(std::move(shard.socket), reactor);
+
+        shard.socket = SocketType(reactorContext(reactor));
+        doAcceptShard(reactor);
+    });
+}
@@ -10,23 +10,50 @@
 
 #include <boost/asio/ip/tcp.hpp>
 
+#include <atomic>
+#include <vector>
+
 namespace Compan{
 namespace Edge {
 
+/*!
+ * With an AsioReactorPool every reactor gets it's own acceptor bound to the
+ * same endpoint with SO_REUSEPORT; the kernel spreads the incoming
+ * connections over the reactors, each accepting on it's own thread.
+ */
 class AsioTcpServer : public AsioServer<boost::asio::ip::tcp> {
 public:
+    using EndPointType = SocketType::endpoint_type;
+
     AsioTcpServer(
             boost::asio::io_context& ctx,
             AsioMsgHandlerFactory& factory,
             std::string const& address,
-            std::string const& port);
+            std::string const& port,
+            AsioReactorPool* reactors = nullptr);
     virtual ~AsioTcpServer();
 
 protected:
-    virtual void createConnection(SocketType&& socket);
+    virtual void createConnection(SocketType&& socket, size_t const reactor);
+
+    /// Opens an acceptor per reactor
+    void doAcceptShards(EndPointType const& endpoint);
+
+    /// Listens to connections being made on a reactor's acceptor
+    void doAcceptShard(size_t const reactor);
 
 private:
-    static uint32_t connectionId_;
+    /// A reactor's acceptor
+    struct AcceptShard {
+        AcceptShard(boost::asio::io_context& ctx);
+
+        AcceptorType acceptor;
+        SocketType socket;
+    };
+
+    std::vector<std::unique_ptr<AcceptShard>> shards_;
+
+    static std::atomic<uint32_t> connectionId_;
 };
 
 } // namespace Edge
@@ -5,6 +5,7 @@
  */
 #include "company_ref_asio_uds_server.h"
 #include "company_ref_asio_uds_connection.h"
+#include "company_ref_asio_uring_connection.h"
 
 #include "company_ref_asio_msg_handler.h"
 #include "company_ref_asio_msg_handler_factory.h"
@@ -13,8 +14,12 @@ using namespace Compan::Edge;
 
 uint32_t AsioUdsServer::connectionId_(1000);
 
-AsioUdsServer::AsioUdsServer(boost::asio::io_context& ctx, AsioMsgHandlerFactory& factory, std::string const& udsPath)
-    : AsioServer<boost::asio::local::stream_protocol>(ctx, factory)
+AsioUdsServer::AsioUdsServer(
+        boost::asio::io_context& ctx,
+        AsioMsgHandlerFactory& factory,
+        std::string const& udsPath,
+        AsioReactorPool* reactors)
+    : AsioServer<boost::asio::local::stream_protocol>(ctx, factory, reactors)
 {
     if (!udsPath.empty()) {
         ::unlink(udsPath.c_str()); // Remove previous binding.
@@ -27,24 +32,28 @@ AsioUdsServer::AsioUdsServer(boost::asio::io_context& ctx, AsioMsgHandlerFactory
 
 AsioUdsServer::~AsioUdsServer() = default;
 
-void AsioUdsServer::createConnection(SocketType&& socket)
+void AsioUdsServer::createConnection(SocketType&& socket, size_t const reactor)
 {
     ++connectionId_;
 
-    AsioMsgHandlerPtr msgHandler = factory_.make(connectionId_);
+    boost::asio::io_context& ctx = reactorContext(reactor);
 
-    AsioUdsConnection::Ptr connPtr(
-            std::make_shared<AsioUdsConnection>(ctx_, connectionId_, msgHandler, std::move(socket)));
+    AsioMsgHandlerPtr msgHandler = factory_.makeWithContext(connectionId_, ctx);
 
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
+    if (AsioUringPtr ring = uring(reactor)) {
+        AsioUdsUringConnection::Ptr connPtr(std::make_shared<AsioUdsUringConnection>(
+                ctx, connectionId_, msgHandler, std::move(socket), ring));
 
-        SignalScopedConnection disconnectSignal(connPtr->connectOnDisconnection(
-                std::bind(&AsioUdsServer::onDisconnection, this, std::placeholders::_1)));
+        addConnection(connectionId_, connPtr, reactor);
 
-        connections_.emplace(connectionId_, connPtr);
-        signalConnections_.emplace(connectionId_, std::move(disconnectSignal));
+        connPtr->onConnect(boost::system::error_code());
+        return;
     }
 
+    AsioUdsConnection::Ptr connPtr(
+            std::make_shared<AsioUdsConnection>(ctx, connectionId_, msgHandler, std::move(socket)));
+
+    addConnection(connectionId_, connPtr, reactor);
+
     connPtr->onConnect(boost::system::error_code());
 }
@@ -15,11 +15,15 @@ namespace Edge {
 
 class AsioUdsServer : public AsioServer<boost::asio::local::stream_protocol> {
 public:
-    AsioUdsServer(boost::asio::io_context& ctx, AsioMsgHandlerFactory& factory, std::string const& udsPath);
+    AsioUdsServer(
+            boost::asio::io_context& ctx,
+            AsioMsgHandlerFactory& factory,
+            std::string const& udsPath,
+            AsioReactorPool* reactors = nullptr);
     virtual ~AsioUdsServer();
 
 protected:
-    virtual void createConnection(SocketType&& socket);
+    virtual void createConnection(SocketType&& socket, size_t const reactor);
 
 private:
     static uint32_t connectionId_;
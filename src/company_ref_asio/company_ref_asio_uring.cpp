@@ -0,0 +1,508 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_asio_uring.cpp
+ @brief io_uring instance serviced by an io_context
+ */
+#include "company_ref_asio_uring.h"
+
+#include <company_ref_utils/company_ref_weak_bind.h>
+#include <Compan_logger/Compan_logger.h>
+
+#include <boost/asio/post.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace Compan::Edge;
+
+CompanLogger AsioUringLog("asio.uring", LogLevel::Information);
+
+namespace {
+/// Group of the provided receive buffers
+uint16_t const BufferGroup(0);
+
+/// Completion queue size, relative to the submission queue; multishot receives complete many times
+unsigned const CqEntriesFactor(8);
+
+int uringSetup(unsigned const entries, io_uring_params* params)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int uringEnter(int const fd, unsigned const toSubmit, unsigned const minComplete, unsigned const flags)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int uringRegister(int const fd, unsigned const opcode, void* arg, unsigned const args)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, args));
+}
+} // namespace
+
+bool AsioUring::isSupported()
+{
+    static bool const supported = [] {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+
+        int const fd = uringSetup(4, &params);
+        if (fd < 0) return false;
+
+        bool multishot(false);
+        bool const ops = probe(fd, multishot);
+
+        ::close(fd);
+
+        return ops && (params.features & IORING_FEAT_SINGLE_MMAP) && (params.features & IORING_FEAT_NODROP);
+    }();
+
+    return supported;
+}
+
+AsioUring::Ptr AsioUring::create(boost::asio::io_context& ctx, unsigned const entries)
+{
+    FunctionLog(AsioUringLog);
+
+    if (!isSupported()) return nullptr;
+
+    Ptr ring(new AsioUring(ctx));
+    if (!ring->setup(entries)) return nullptr;
+
+    ring->doWakeup();
+
+    return ring;
+}
+
+AsioUring::AsioUring(boost::asio::io_context& ctx)
+    : ctx_(ctx)
+    , fd_(-1)
+    , ringPtr_(MAP_FAILED)
+    , ringSize_(0)
+    , sqesPtr_(MAP_FAILED)
+    , sqesSize_(0)
+    , sqHead_(nullptr)
+    , sqTail_(nullptr)
+    , sqFlags_(nullptr)
+    , sqMask_(0)
+    , sqEntries_(0)
+    , sqArray_(nullptr)
+    , sqes_(nullptr)
+    , cqHead_(nullptr)
+    , cqTail_(nullptr)
+    , cqMask_(0)
+    , cqes_(nullptr)
+    , bufRing_(nullptr)
+    , bufTail_(nullptr)
+    , bufRingSize_(0)
+    , multishot_(false)
+    , toSubmit_(0)
+    , flushPending_(false)
+    , nextOp_(0)
+    , wakeup_(ctx)
+    , wakeupCount_(0)
+    , enters_(0)
+    , wakeups_(0)
+    , submitted_(0)
+    , completed_(0)
+{
+}
+
+AsioUring::~AsioUring()
+{
+    FunctionLog(AsioUringLog);
+
+    boost::system::error_code ec;
+    if (wakeup_.is_open()) wakeup_.close(ec);
+
+    // tears down the kernel side, outstanding operations included
+    if (fd_ >= 0) ::close(fd_);
+
+    if (sqesPtr_ != MAP_FAILED) ::munmap(sqesPtr_, sqesSize_);
+    if (ringPtr_ != MAP_FAILED) ::munmap(ringPtr_, ringSize_);
+    if (bufRing_) ::munmap(bufRing_, bufRingSize_);
+}
+
+bool AsioUring::setup(unsigned const entries)
+{
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = entries * CqEntriesFactor;
+
+    fd_ = uringSetup(entries, &params);
+    if (fd_ < 0) {
+        ErrorLog(AsioUringLog) << "io_uring_setup: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    bool multishot(false);
+    if (!probe(fd_, multishot)) return false;
+    multishot_ = multishot;
+
+    // one mapping for both rings
+    ringSize_ = std::max<size_t>(
+            params.sq_off.array + params.sq_entries * sizeof(unsigned),
+            params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+
+    ringPtr_ = ::mmap(nullptr, ringSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+    if (ringPtr_ == MAP_FAILED) {
+        ErrorLog(AsioUringLog) << "mmap rings: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqesPtr_ = ::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+    if (sqesPtr_ == MAP_FAILED) {
+        ErrorLog(AsioUringLog) << "mmap sqes: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    uint8_t* ring = static_cast<uint8_t*>(ringPtr_);
+
+    sqHead_ = reinterpret_cast<unsigned*>(ring + params.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned*>(ring + params.sq_off.tail);
+    sqFlags_ = reinterpret_cast<unsigned*>(ring + params.sq_off.flags);
+    sqMask_ = *reinterpret_cast<unsigned*>(ring + params.sq_off.ring_mask);
+    sqEntries_ = params.sq_entries;
+    sqArray_ = reinterpret_cast<unsigned*>(ring + params.sq_off.array);
+    sqes_ = static_cast<io_uring_sqe*>(sqesPtr_);
+
+    cqHead_ = reinterpret_cast<unsigned*>(ring + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned*>(ring + params.cq_off.tail);
+    cqMask_ = *reinterpret_cast<unsigned*>(ring + params.cq_off.ring_mask);
+    cqes_ = ring + params.cq_off.cqes;
+
+    // provided buffers, the kernel picks one when data arrives
+    bufRingSize_ = RecvBufferCount * sizeof(io_uring_buf);
+    void* bufRing = ::mmap(nullptr, bufRingSize_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (bufRing == MAP_FAILED) {
+        ErrorLog(AsioUringLog) << "mmap buffer ring: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    // io_uring_buf_ring's flexible array doesn't lay out the same in C++, it's an array of io_uring_buf
+    bufRing_ = static_cast<io_uring_buf*>(bufRing);
+    bufTail_ = &bufRing_[0].resv;
+
+    buffers_.resize(size_t(RecvBufferCount) * RecvBufferSize);
+
+    io_uring_buf_reg reg;
+    std::memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(bufRing_);
+    reg.ring_entries = RecvBufferCount;
+    reg.bgid = BufferGroup;
+
+    if (uringRegister(fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        ErrorLog(AsioUringLog) << "register buffer ring: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    for (uint16_t bufferId = 0; bufferId < RecvBufferCount; ++bufferId) releaseBuffer(bufferId);
+
+    int eventFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (eventFd < 0) {
+        ErrorLog(AsioUringLog) << "eventfd: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    wakeup_.assign(eventFd);
+
+    if (uringRegister(fd_, IORING_REGISTER_EVENTFD, &eventFd, 1) < 0) {
+        ErrorLog(AsioUringLog) << "register eventfd: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    InfoLog(AsioUringLog) << "io_uring entries: " << sqEntries_ << (multishot_ ? " multishot" : "") << std::endl;
+
+    return true;
+}
+
+bool AsioUring::probe(int const fd, bool& multishot)
+{
+    unsigned const opCount(256);
+
+    std::vector<uint8_t> probeBuffer(sizeof(io_uring_probe) + opCount * sizeof(io_uring_probe_op));
+    io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(probeBuffer.data());
+
+    if (uringRegister(fd, IORING_REGISTER_PROBE, probe, opCount) < 0) return false;
+
+    auto supported = [probe](unsigned const op) {
+        return op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+    };
+
+    multishot = supported(IORING_OP_SEND_ZC);
+
+    return supported(IORING_OP_RECV) && supported(IORING_OP_SEND) && supported(IORING_OP_ASYNC_CANCEL);
+}
+
+uint64_t AsioUring::recv(int const fd, CompletionHandler handler)
+{
+    uint64_t const op = addOperation(handler);
+
+    io_uring_sqe sqe;
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = IORING_OP_RECV;
+    sqe.fd = fd;
+    sqe.flags = IOSQE_BUFFER_SELECT;
+    sqe.buf_group = BufferGroup;
+    sqe.ioprio = multishot_ ? IORING_RECV_MULTISHOT : 0;
+    sqe.user_data = op;
+
+    if (!queue(sqe)) {
+        forget(op);
+        return 0;
+    }
+
+    scheduleFlush();
+    return op;
+}
+
+uint64_t AsioUring::send(int const fd, void const* data, size_t const size, CompletionHandler handler)
+{
+    uint64_t const op = addOperation(handler);
+
+    io_uring_sqe sqe;
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = IORING_OP_SEND;
+    sqe.fd = fd;
+    sqe.addr = reinterpret_cast<uint64_t>(data);
+    sqe.len = static_cast<uint32_t>(size);
+    sqe.msg_flags = MSG_NOSIGNAL;
+    sqe.user_data = op;
+
+    if (!queue(sqe)) {
+        forget(op);
+        return 0;
+    }
+
+    scheduleFlush();
+    return op;
+}
+
+void AsioUring::cancel(uint64_t const op)
+{
+    io_uring_sqe sqe;
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = IORING_OP_ASYNC_CANCEL;
+    sqe.fd = -1;
+    sqe.addr = op;
+    sqe.user_data = 0; // nobody waits for the cancellation itself
+
+    if (queue(sqe)) scheduleFlush();
+}
+
+void AsioUring::forget(uint64_t const op)
+{
+    std::lock_guard<std::mutex> lock(opsLock_);
+    ops_.erase(op);
+}
+
+uint8_t const* AsioUring::buffer(uint16_t const bufferId) const
+{
+    return buffers_.data() + size_t(bufferId) * RecvBufferSize;
+}
+
+void AsioUring::releaseBuffer(uint16_t const bufferId)
+{
+    std::lock_guard<std::mutex> lock(bufferLock_);
+
+    // we are the only producer, the kernel reads the tail
+    uint16_t const tail = *bufTail_;
+
+    io_uring_buf& buf = bufRing_[tail & (RecvBufferCount - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(buffer(bufferId));
+    buf.len = RecvBufferSize;
+    buf.bid = bufferId;
+
+    __atomic_store_n(bufTail_, uint16_t(tail + 1), __ATOMIC_RELEASE);
+}
+
+bool AsioUring::waitFor(std::function<bool()> const& pred, int const timeoutMs)
+{
+    auto const deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+    while (!pred()) {
+        {
+            std::lock_guard<std::mutex> lock(submitLock_);
+            if (toSubmit_) {
+                int const submitted = enter(toSubmit_, 0, 0);
+                if (submitted > 0) toSubmit_ -= submitted;
+            }
+        }
+
+        if (reap()) continue;
+
+        auto const remaining =
+                std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0) return false;
+
+        // the ring's fd is readable with completions queued
+        struct pollfd fds = {fd_, POLLIN, 0};
+        if (::poll(&fds, 1, static_cast<int>(remaining.count())) < 0 && errno != EINTR) return false;
+    }
+
+    return true;
+}
+
+AsioUring::Stats AsioUring::stats() const
+{
+    return {enters_, wakeups_, submitted_, completed_};
+}
+
+bool AsioUring::queue(io_uring_sqe const& sqe)
+{
+    std::lock_guard<std::mutex> lock(submitLock_);
+
+    unsigned const tail = *sqTail_;
+
+    if (tail - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= sqEntries_) {
+        // full, hand what's queued to the kernel
+        int const submitted = enter(toSubmit_, 0, 0);
+        if (submitted > 0) toSubmit_ -= submitted;
+
+        if (tail - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= sqEntries_) {
+            ErrorLog(AsioUringLog) << "submission queue full" << std::endl;
+            return false;
+        }
+    }
+
+    unsigned const index = tail & sqMask_;
+
+    sqes_[index] = sqe;
+    sqArray_[index] = index;
+
+    __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+
+    ++toSubmit_;
+    ++submitted_;
+
+    return true;
+}
+
+uint64_t AsioUring::addOperation(CompletionHandler handler)
+{
+    std::lock_guard<std::mutex> lock(opsLock_);
+
+    // 0 is reserved for operations without a handler
+    uint64_t const op = ++nextOp_;
+    ops_.emplace(op, std::make_shared<CompletionHandler>(std::move(handler)));
+
+    return op;
+}
+
+void AsioUring::scheduleFlush()
+{
+    // everything queued until the flush runs goes in with one system call
+    if (!flushPending_.exchange(true)) boost::asio::post(ctx_, WeakBind(&AsioUring::flush, shared_from_this()));
+}
+
+void AsioUring::flush()
+{
+    flushPending_ = false;
+
+    std::lock_guard<std::mutex> lock(submitLock_);
+
+    if (toSubmit_ == 0) return;
+
+    int const submitted = enter(toSubmit_, 0, 0);
+
+    if (submitted < 0) {
+        // EBUSY/EAGAIN clear up once completions are reaped
+        DebugLog(AsioUringLog) << "io_uring_enter: " << std::strerror(-submitted) << std::endl;
+    } else {
+        toSubmit_ -= submitted;
+    }
+
+    if (toSubmit_) scheduleFlush();
+}
+
+int AsioUring::enter(unsigned const toSubmit, unsigned const minComplete, unsigned const flags)
+{
+    ++enters_;
+
+    int const ret = uringEnter(fd_, toSubmit, minComplete, flags);
+    return ret < 0 ? -errno : ret;
+}
+
+void AsioUring::doWakeup()
+{
+    wakeup_.async_read_some(
+            boost::asio::buffer(&wakeupCount_, sizeof(wakeupCount_)),
+            WeakBind(&AsioUring::onWakeup, shared_from_this(), std::placeholders::_1, std::placeholders::_2));
+}
+
+void AsioUring::onWakeup(boost::system::error_code const& ec, std::size_t)
+{
+    if (ec) {
+        if (ec != boost::asio::error::operation_aborted) {
+            ErrorLog(AsioUringLog) << "onWakeup " << ec.message() << std::endl;
+        }
+        return;
+    }
+
+    ++wakeups_;
+
+    // the eventfd was reset first, completions racing the reap signal again
+    reap();
+
+    doWakeup();
+}
+
+size_t AsioUring::reap()
+{
+    std::lock_guard<std::mutex> lock(reapLock_);
+
+    io_uring_cqe const* cqes = static_cast<io_uring_cqe const*>(cqes_);
+
+    size_t count(0);
+    unsigned head = *cqHead_;
+
+    for (;;) {
+        if (head == __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE)) {
+            // completions the CQ had no room for are kept by the kernel until asked for
+            if (!(__atomic_load_n(sqFlags_, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW)) break;
+
+            std::lock_guard<std::mutex> submitLock(submitLock_);
+            enter(0, 0, IORING_ENTER_GETEVENTS);
+
+            if (head == __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE)) break;
+        }
+
+        io_uring_cqe const& cqe = cqes[head & cqMask_];
+
+        uint64_t const op = cqe.user_data;
+        int const result = cqe.res;
+        uint32_t const flags = cqe.flags;
+
+        __atomic_store_n(cqHead_, ++head, __ATOMIC_RELEASE);
+        ++count;
+
+        std::shared_ptr<CompletionHandler> handler;
+        {
+            std::lock_guard<std::mutex> opsLock(opsLock_);
+
+            auto opIter = ops_.find(op);
+            if (opIter != ops_.end()) {
+                handler = opIter->second;
+                if (!(flags & IORING_CQE_F_MORE)) ops_.erase(opIter);
+            }
+        }
+
+        // in order, a connection's receive completions are delivered in sequence
+        if (handler) (*handler)(result, flags);
+    }
+
+    completed_ += count;
+
+    return count;
+}
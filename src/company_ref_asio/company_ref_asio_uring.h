@@ -0,0 +1,200 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_asio_uring.h
+ @brief io_uring instance serviced by an io_context
+ */
+#ifndef __company_ref_ASIO_URING_H__
+#define __company_ref_ASIO_URING_H__
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_buf;
+
+namespace Compan{
+namespace Edge {
+
+/// Kernel transitions, for comparing with the reactor backend
+struct AsioUringStats {
+    uint64_t enters;    //!< io_uring_enter calls
+    uint64_t wakeups;   //!< eventfd reads
+    uint64_t submitted; //!< SQEs
+    uint64_t completed; //!< CQEs
+};
+
+/*!
+ * @brief io_uring, driven from an io_context
+ *
+ * Talks to the kernel through the raw system calls, no liburing.
+ *
+ * Receives are multishot into a ring of buffers registered with the
+ * kernel (provided buffers); one submission keeps delivering data until
+ * the socket closes. Submissions are batched, everything queued while
+ * the io_context is busy goes in with one io_uring_enter.
+ *
+ * Completions are signaled on an eventfd watched by the io_context; a
+ * single read of the eventfd reaps every completion queued.
+ *
+ * One instance per io_context, connections share it.
+ */
+class AsioUring : public std::enable_shared_from_this<AsioUring> {
+public:
+    using Ptr = std::shared_ptr<AsioUring>;
+
+    /// Called with the CQE result and flags
+    using CompletionHandler = std::function<void(int const result, uint32_t const flags)>;
+
+    /// Submission queue size
+    static unsigned const DefaultEntries = 256;
+
+    /// Provided receive buffers, the count is a power of 2
+    static uint16_t const RecvBufferCount = 256;
+    static uint32_t const RecvBufferSize = 16384;
+
+    using Stats = AsioUringStats;
+
+    /// Checks the kernel has io_uring with the operations used
+    static bool isSupported();
+
+    /// Creates a ring serviced by ctx, nullptr if io_uring isn't usable
+    static Ptr create(boost::asio::io_context& ctx, unsigned const entries = DefaultEntries);
+
+    virtual ~AsioUring();
+
+    /// Queues a (multishot when supported) receive into the provided buffers, returns the operation
+    uint64_t recv(int const fd, CompletionHandler handler);
+
+    /// Queues a send, data has to stay valid until the completion
+    uint64_t send(int const fd, void const* data, size_t const size, CompletionHandler handler);
+
+    /// Queues the cancellation of an operation, it's handler is still called
+    void cancel(uint64_t const op);
+
+    /// Drops the handler of an operation, nothing is called for it anymore
+    void forget(uint64_t const op);
+
+    /// Data of a receive completion
+    uint8_t const* buffer(uint16_t const bufferId) const;
+
+    /// Hands a receive buffer back to the kernel
+    void releaseBuffer(uint16_t const bufferId);
+
+    /// Submits and reaps on the calling thread until pred holds, false on timeout
+    bool waitFor(std::function<bool()> const& pred, int const timeoutMs);
+
+    /// Returns true if receives are multishot
+    bool multishot() const;
+
+    /// Falls back to a receive per completion, the kernel refused multishot
+    void disableMultishot();
+
+    Stats stats() const;
+
+protected:
+    AsioUring(boost::asio::io_context& ctx);
+
+    AsioUring(AsioUring const&) = delete;
+    AsioUring& operator=(AsioUring const&) = delete;
+
+    /// Creates and maps the rings
+    bool setup(unsigned const entries);
+
+    /// Copies an SQE into the submission ring
+    bool queue(io_uring_sqe const& sqe);
+
+    /// Keeps the handler of an operation
+    uint64_t addOperation(CompletionHandler handler);
+
+    /// Posts a flush, unless one is already pending
+    void scheduleFlush();
+
+    /// Submits the queued SQEs
+    void flush();
+
+    /// io_uring_enter, submitLock_ held
+    int enter(unsigned const toSubmit, unsigned const minComplete, unsigned const flags);
+
+    void doWakeup();
+    void onWakeup(boost::system::error_code const&, std::size_t);
+
+    /// Dispatches the completions queued, returns the count
+    size_t reap();
+
+    /// Checks the operations used, multishot receives came with zero copy sends (6.0)
+    static bool probe(int const fd, bool& multishot);
+
+private:
+    boost::asio::io_context& ctx_;
+
+    int fd_;
+
+    void* ringPtr_;
+    size_t ringSize_;
+    void* sqesPtr_;
+    size_t sqesSize_;
+
+    // submission ring
+    unsigned* sqHead_;
+    unsigned* sqTail_;
+    unsigned* sqFlags_;
+    unsigned sqMask_;
+    unsigned sqEntries_;
+    unsigned* sqArray_;
+    io_uring_sqe* sqes_;
+
+    // completion ring
+    unsigned* cqHead_;
+    unsigned* cqTail_;
+    unsigned cqMask_;
+    void* cqes_;
+
+    // provided buffers
+    io_uring_buf* bufRing_; //!< the tail overlays the first entry
+    uint16_t* bufTail_;
+    size_t bufRingSize_;
+    std::vector<uint8_t> buffers_;
+    std::mutex bufferLock_;
+
+    std::atomic<bool> multishot_;
+
+    std::mutex submitLock_;
+    unsigned toSubmit_;
+    std::atomic<bool> flushPending_;
+
+    std::mutex reapLock_;
+
+    std::mutex opsLock_;
+    uint64_t nextOp_;
+    std::unordered_map<uint64_t, std::shared_ptr<CompletionHandler>> ops_;
+
+    boost::asio::posix::stream_descriptor wakeup_;
+    uint64_t wakeupCount_;
+
+    std::atomic<uint64_t> enters_;
+    std::atomic<uint64_t> wakeups_;
+    std::atomic<uint64_t> submitted_;
+    std::atomic<uint64_t> completed_;
+};
+
+inline bool AsioUring::multishot() const
+{
+    return multishot_;
+}
+
+inline void AsioUring::disableMultishot()
+{
+    multishot_ = false;
+}
+
+} // namespace Edge
+} // namespace Compan
+
+#endif // __company_ref_ASIO_URING_H__
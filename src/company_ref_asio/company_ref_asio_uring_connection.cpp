@@ -0,0 +1,308 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_asio_uring_connection.cpp
+ @brief Server connection serviced by io_uring
+ */
+#include "company_ref_asio_uring_connection.h"
+
+#include "company_ref_asio_msg_handler.h"
+
+#include <company_ref_utils/company_ref_weak_bind.h>
+#include <Compan_logger/Compan_logger.h>
+
+#include <boost/asio/post.hpp>
+
+#include <cerrno>
+#include <cstring>
+
+#include <linux/io_uring.h>
+
+using namespace Compan::Edge;
+
+CompanLogger AsioUringConnectionLog("asio.uring.connection", LogLevel::Information);
+
+template <typename T>
+AsioUringConnection<T>::AsioUringConnection(
+        boost::asio::io_context& ctx,
+        uint32_t const connId,
+        AsioMsgHandlerPtr msgHandler,
+        SocketType socket,
+        AsioUring::Ptr ring)
+    : AsioConnectionBase(ctx, connId, AsioConnectionBase::Server)
+    , socket_(std::move(socket))
+    , ring_(ring)
+    , dataHandler_(msgHandler)
+    , recvOp_(0)
+    , sendOffset_(0)
+    , sendInFlight_(false)
+    , doClose_(false)
+{
+    FunctionArgLog(AsioUringConnectionLog) << "ctor - " << connectionId_ << std::endl;
+
+    if (dataHandler_ == nullptr) {
+        ErrorLog(AsioUringConnectionLog) << "missing MsgHandler - " << connectionId_ << std::endl;
+    }
+}
+
+template <typename T>
+AsioUringConnection<T>::~AsioUringConnection()
+{
+    FunctionLog(AsioUringConnectionLog);
+
+    uint64_t const recvOp = recvOp_.exchange(0);
+    if (recvOp) {
+        ring_->forget(recvOp);
+        ring_->cancel(recvOp);
+    }
+}
+
+template <typename T>
+void AsioUringConnection<T>::connect()
+{
+    ErrorLog(AsioUringConnectionLog) << loggerIdentity() << " connect: accepted connections only" << std::endl;
+}
+
+template <typename T>
+void AsioUringConnection<T>::close()
+{
+    FunctionArgLog(AsioUringConnectionLog) << loggerIdentity() << std::endl;
+
+    // the receive completes with 0, which closes the connection
+    boost::system::error_code ec;
+    if (socket_.is_open()) socket_.shutdown(SocketType::shutdown_both, ec);
+}
+
+template <typename T>
+bool AsioUringConnection<T>::isConnected()
+{
+    return socket_.is_open() && !doClose_;
+}
+
+template <typename T>
+void AsioUringConnection<T>::onConnect(boost::system::error_code const& error)
+{
+    FunctionArgLog(AsioUringConnectionLog) << loggerIdentity() << std::endl;
+
+    if (error) {
+        ErrorLog(AsioUringConnectionLog) << loggerIdentity() << " onConnect " << error.message() << std::endl;
+        return;
+    }
+
+    onConnected_(connectionId_);
+
+    if (!dataHandler_) {
+        ErrorLog(AsioUringConnectionLog) << loggerIdentity() << " onConnect missing MsgHandler" << std::endl;
+        return;
+    }
+
+    dataHandler_->start();
+
+    onSend_ = dataHandler_->connectSendDataQueued(WeakBind(
+            &AsioUringConnection<T>::doSend, this->shared_from_this(), std::placeholders::_1, std::placeholders::_2));
+    onClose_ = dataHandler_->connectClose(WeakBind(&AsioUringConnection<T>::close, this->shared_from_this()));
+
+    doRecv();
+}
+
+template <typename T>
+void AsioUringConnection<T>::doClose()
+{
+    FunctionArgLog(AsioUringConnectionLog) << __FUNCTION__ << loggerIdentity() << std::endl;
+
+    if (doClose_.exchange(true)) return;
+
+    // the descriptor is closed with the connection, a queued send can't
+    // end up on a reused descriptor
+    boost::system::error_code ec;
+    if (socket_.is_open()) socket_.shutdown(SocketType::shutdown_both, ec);
+
+    onSend_.reset();
+    onClose_.reset();
+
+    if (dataHandler_) { boost::asio::post(readerStrand_, WeakBind(&AsioMsgHandler::stop, dataHandler_)); }
+
+    onDisconnected_(connectionId_);
+}
+
+template <typename T>
+void AsioUringConnection<T>::doRecv()
+{
+    FunctionArgLog(AsioUringConnectionLog) << loggerIdentity() << std::endl;
+
+    uint64_t const recvOp = ring_->recv(
+            socket_.native_handle(),
+            WeakBind(
+                    &AsioUringConnection<T>::onRecv,
+                    this->shared_from_this(),
+                    std::placeholders::_1,
+                    std::placeholders::_2));
+
+    if (recvOp == 0) {
+        boost::asio::post(readerStrand_, WeakBind(&AsioUringConnection<T>::doClose, this->shared_from_this()));
+        return;
+    }
+
+    recvOp_ = recvOp;
+}
+
+template <typename T>
+void AsioUringConnection<T>::onRecv(int const result, uint32_t const flags)
+{
+    bool const more(flags & IORING_CQE_F_MORE);
+
+    if (result > 0) {
+        if (flags & IORING_CQE_F_BUFFER) {
+            uint16_t const bufferId = flags >> IORING_CQE_BUFFER_SHIFT;
+            uint8_t const* data = ring_->buffer(bufferId);
+
+            // the strand keeps the order, the buffer goes straight back to the kernel
+            std::shared_ptr<BufferType> buffer(std::make_shared<BufferType>(data, data + result));
+            ring_->releaseBuffer(bufferId);
+
+            boost::asio::post(
+                    readerStrand_,
+                    WeakBind(&AsioUringConnection<T>::onRecvData, this->shared_from_this(), buffer));
+        }
+
+        if (!more && !doClose_) doRecv();
+        return;
+    }
+
+    // every buffer was in use, they have been handed back since
+    if (result == -ENOBUFS && !doClose_) {
+        doRecv();
+        return;
+    }
+
+    if (result == -EINVAL && ring_->multishot()) {
+        WarnLog(AsioUringConnectionLog) << loggerIdentity() << " multishot receive refused" << std::endl;
+        ring_->disableMultishot();
+        doRecv();
+        return;
+    }
+
+    DebugLog(AsioUringConnectionLog) << loggerIdentity() << " onRecv Closing connection "
+                                     << (result ? std::strerror(-result) : "") << std::endl;
+
+    boost::asio::post(readerStrand_, WeakBind(&AsioUringConnection<T>::doClose, this->shared_from_this()));
+}
+
+template <typename T>
+void AsioUringConnection<T>::onRecvData(std::shared_ptr<BufferType> buffer)
+{
+    FunctionArgLog(AsioUringConnectionLog) << loggerIdentity() << std::endl;
+
+    if (!dataHandler_) {
+        ErrorLog(AsioUringConnectionLog) << loggerIdentity() << " onRecvData Lost data handler?" << std::endl;
+        doClose();
+        return;
+    }
+
+    dataHandler_->recvData(std::move(*buffer));
+}
+
+template <typename T>
+void AsioUringConnection<T>::doSend(boost::asio::const_buffer const& buffer, WrittenFunction const& onWritten)
+{
+    FunctionArgLog(AsioUringConnectionLog) << loggerIdentity() << std::endl;
+
+    if (!isConnected()) return;
+
+    std::unique_lock<std::mutex> lock(sendLock_);
+
+    uint8_t const* data = static_cast<uint8_t const*>(buffer.data());
+    pending_.insert(pending_.end(), data, data + buffer.size());
+    if (onWritten) pendingWritten_.push_back(onWritten);
+
+    if (!sendInFlight_) {
+        doSendPending();
+        return;
+    }
+
+    if (pending_.size() <= MaxPendingSend) return;
+
+    // the peer is behind, hold the sender back as a blocking write would
+    lock.unlock();
+
+    bool const drained = ring_->waitFor(
+            [this] {
+                std::lock_guard<std::mutex> lock(sendLock_);
+                return pending_.size() <= MaxPendingSend || doClose_;
+            },
+            SendTimeoutMs);
+
+    if (!drained) {
+        DebugLog(AsioUringConnectionLog) << loggerIdentity() << " doSend peer stalled" << std::endl;
+        doClose();
+    }
+}
+
+template <typename T>
+void AsioUringConnection<T>::doSendPending()
+{
+    sending_.swap(pending_);
+    pending_.clear();
+    sendOffset_ = 0;
+
+    sendingWritten_.swap(pendingWritten_);
+    pendingWritten_.clear();
+
+    submitSend();
+}
+
+template <typename T>
+void AsioUringConnection<T>::submitSend()
+{
+    sendInFlight_ = true;
+
+    // holding on to the connection keeps sending_ valid until the kernel is done with it
+    Ptr self(this->shared_from_this());
+
+    uint64_t const sendOp = ring_->send(
+            socket_.native_handle(),
+            sending_.data() + sendOffset_,
+            sending_.size() - sendOffset_,
+            [self](int const result, uint32_t const) { self->onSent(result); });
+
+    if (sendOp == 0) {
+        sendInFlight_ = false;
+        boost::asio::post(readerStrand_, WeakBind(&AsioUringConnection<T>::doClose, self));
+    }
+}
+
+template <typename T>
+void AsioUringConnection<T>::onSent(int const result)
+{
+    std::unique_lock<std::mutex> lock(sendLock_);
+
+    if (result < 0) {
+        DebugLog(AsioUringConnectionLog) << loggerIdentity() << " onSent " << std::strerror(-result) << std::endl;
+
+        sendInFlight_ = false;
+        boost::asio::post(readerStrand_, WeakBind(&AsioUringConnection<T>::doClose, this->shared_from_this()));
+        return;
+    }
+
+    sendOffset_ += result;
+
+    if (sendOffset_ < sending_.size()) {
+        submitSend();
+        return;
+    }
+
+    // called without the lock, a handler may send from it
+    std::vector<WrittenFunction> written;
+    written.swap(sendingWritten_);
+
+    if (!pending_.empty() && !doClose_)
+        doSendPending();
+    else
+        sendInFlight_ = false;
+
+    lock.unlock();
+
+    for (auto& onWritten : written) onWritten();
+}
+
+template class Compan::Edge::AsioUringConnection<boost::asio::ip::tcp>;
+template class Compan::Edge::AsioUringConnection<boost::asio::local::stream_protocol>;
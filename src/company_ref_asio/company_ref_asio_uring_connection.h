@@ -0,0 +1,123 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_asio_uring_connection.h
+ @brief Server connection serviced by io_uring
+ */
+#ifndef __company_ref_ASIO_URING_CONNECTION_H__
+#define __company_ref_ASIO_URING_CONNECTION_H__
+
+#include "company_ref_asio_connection.h"
+#include "company_ref_asio_uring.h"
+
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+
+#include <atomic>
+#include <mutex>
+
+namespace Compan{
+namespace Edge {
+
+/*!
+ * @brief Accepted connection serviced by an AsioUring
+ *
+ * Data is received with a single multishot receive; every chunk the
+ * kernel delivers is handed to the AsioMsgHandler on the reader strand.
+ *
+ * Sends are queued instead of written in place; data sent while a send is
+ * in flight is appended and goes out with the next one. Past MaxPendingSend
+ * the sender waits for the peer, as it would on a blocking write. The
+ * handler is told once it's data has been written, see
+ * AsioMsgHandler::connectSendDataQueued.
+ *
+ * The same AsioMsgHandler objects are used as with AsioConnection.
+ */
+template <typename T>
+class AsioUringConnection : public AsioConnectionBase, public std::enable_shared_from_this<AsioUringConnection<T>> {
+public:
+    using Ptr = std::shared_ptr<AsioUringConnection<T>>;
+
+    using BufferType = std::vector<uint8_t>;
+    using SocketType = boost::asio::basic_stream_socket<T>;
+
+    /// Queued bytes before a sender waits
+    static size_t const MaxPendingSend = 4 * 1024 * 1024;
+
+    /// Time a sender waits for the peer to catch up
+    static int const SendTimeoutMs = 5000;
+
+    AsioUringConnection(
+            boost::asio::io_context& ctx,
+            uint32_t const connId,
+            AsioMsgHandlerPtr msgHandler,
+            SocketType socket,
+            AsioUring::Ptr ring);
+
+    virtual ~AsioUringConnection();
+
+    /// Server connections only, accepted by an AsioServer
+    virtual void connect();
+
+    /// Stops servicing data
+    virtual void close();
+
+    /// Checks if connection is open
+    virtual bool isConnected();
+
+    /// Starts servicing data
+    void onConnect(boost::system::error_code const&);
+
+protected:
+    void doClose();
+
+    void doRecv();
+
+    /// Called by the ring, on whichever thread reaps
+    void onRecv(int const result, uint32_t const flags);
+
+    void onRecvData(std::shared_ptr<BufferType> buffer);
+
+    void doSend(boost::asio::const_buffer const&, std::function<void()> const& onWritten);
+
+    /// Moves the pending data in flight, sendLock_ held
+    void doSendPending();
+
+    /// Submits what's left of the data in flight, sendLock_ held
+    void submitSend();
+
+    void onSent(int const result);
+
+private:
+    SocketType socket_;
+    AsioUring::Ptr ring_;
+
+    AsioMsgHandlerPtr dataHandler_;
+
+    std::atomic<uint64_t> recvOp_;
+
+    using WrittenFunction = std::function<void()>;
+    using SendFunction = std::function<void(boost::asio::const_buffer const&, WrittenFunction const&)>;
+    using SendConnection = std::shared_ptr<SendFunction>;
+
+    std::mutex sendLock_;
+    SendConnection onSend_;                          //!< Token for dataHandler's sending
+    std::shared_ptr<std::function<void()>> onClose_; //!< Token for dataHandler's close requests
+
+    BufferType sending_; //!< in flight
+    size_t sendOffset_;  //!< sent so far
+    BufferType pending_; //!< sent while a send was in flight
+
+    std::vector<WrittenFunction> sendingWritten_; //!< called once sending_ is written
+    std::vector<WrittenFunction> pendingWritten_; //!< of the data in pending_
+    bool sendInFlight_;
+
+    std::atomic<bool> doClose_;
+};
+
+using AsioUdsUringConnection = AsioUringConnection<boost::asio::local::stream_protocol>;
+using AsioTcpUringConnection = AsioUringConnection<boost::asio::ip::tcp>;
+
+} // namespace Edge
+} // namespace Compan
+
+#endif // __company_ref_ASIO_URING_CONNECTION_H__
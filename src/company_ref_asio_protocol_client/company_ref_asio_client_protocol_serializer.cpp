@@ -23,7 +23,8 @@ CompanLogger ClientProtocolSerializerLog("client.protocol.serializer", LogLevel:
 ClientProtocolSerializer::ClientProtocolSerializer(
         boost::asio::io_context& ctx,
         ClientProtocolHandlerPtr clientProtocolHandler,
-        uint32_t connectionId)
+        uint32_t connectionId,
+        bool const compression)
     : ctx_(ctx)
     , connectionId_(connectionId)
     , clientProtocolHandler_(clientProtocolHandler)
@@ -37,6 +38,8 @@ ClientProtocolSerializer::ClientProtocolSerializer(
                        onDecodeClientMessage(&(*begin), std::distance(begin, end));
                    }
                }}))
+    , compression_(compression)
+    , arenas_(MessageArenaPool::create())
 {
     FunctionLog(ClientProtocolSerializerLog);
 }
@@ -50,6 +53,15 @@ void ClientProtocolSerializer::start()
 {
     onEncodeServerMessage_ = clientProtocolHandler_->connectSendCallback(
             WeakBind(&ClientProtocolSerializer::onEncodeServerMessage, shared_from_this(), std::placeholders::_1));
+
+    {
+        std::lock_guard<std::mutex> lock(bufferLock_);
+        decompressor_.reset();
+    }
+
+    // the connection hooks up sending once start returns
+    if (compression_)
+        boost::asio::post(ctx_, WeakBind(&ClientProtocolSerializer::requestCompression, shared_from_this()));
 }
 
 void ClientProtocolSerializer::stop()
@@ -91,13 +103,25 @@ void ClientProtocolSerializer::onDecodeClientMessage(char const* data, size_t co
 
     if (!isConnected()) return;
 
-    ClientMessagePtr msgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+    ClientMessagePtr msgPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
     if (!msgPtr->ParseFromArray(data, len)) {
         ErrorLog(ClientProtocolSerializerLog)
                 << "[" << connectionId_ << "] onDecodeServerMessage, parse error" << std::endl;
         return;
     }
 
+    // negotiated by the transport, the protocol handler never sees it
+    if (msgPtr->has_vscompressionresult()) {
+        decompressor_ = ClientFrameCompressor::accept(msgPtr->vscompressionresult());
+        return;
+    }
+
+    if (msgPtr->has_compressedmessage() && (!decompressor_ || !decompressor_->expand(*msgPtr))) {
+        ErrorLog(ClientProtocolSerializerLog)
+                << "[" << connectionId_ << "] onDecodeClientMessage, decompress error" << std::endl;
+        return;
+    }
+
     boost::asio::post(ctx_, WeakBind(&ClientProtocolHandler::doHandleMessage, clientProtocolHandler_, msgPtr));
 }
 
@@ -141,3 +165,11 @@ void ClientProtocolSerializer::onEncodeServerMessage(ServerMessagePtr msgPtr)
 
     sendData(std::move(buffer));
 }
+
+void ClientProtocolSerializer::requestCompression()
+{
+    ServerMessagePtr msgPtr = std::make_shared<CompanEdgeProtocol::ServerMessage>();
+    ClientFrameCompressor::makeRequest(*msgPtr);
+
+    onEncodeServerMessage(msgPtr);
+}
@@ -7,6 +7,8 @@
 #define __company_ref_ASIO_CLIENT_PROTOCOL_SERIALIZER_H__
 
 #include <company_ref_asio/company_ref_asio_msg_handler.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_client_frame_compressor.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_message_arena.h>
 
 #include <company_ref_utils/company_ref_signals.h>
 
@@ -39,10 +41,14 @@ class ClientProtocolSerializer : public AsioMsgHandler, public std::enable_share
 public:
     using Ptr = std::shared_ptr<ClientProtocolSerializer>;
 
+    /*!
+     * @param compression   Asks the server to compress large frames once connected
+     */
     ClientProtocolSerializer(
             boost::asio::io_context& ctx,
             ClientProtocolHandlerPtr clientProtocolHandler,
-            uint32_t connectionId);
+            uint32_t connectionId,
+            bool const compression = true);
 
     virtual ~ClientProtocolSerializer();
 
@@ -56,6 +62,10 @@ public:
     void onDecodeClientMessage(char const* data, size_t const len);
     void onEncodeServerMessage(ServerMessagePtr rspMsg);
 
+protected:
+    /// Sends the VsCompression request
+    void requestCompression();
+
 private:
     boost::asio::io_context& ctx_;
     uint32_t connectionId_;
@@ -68,6 +78,11 @@ private:
 
     bool bNewFraming_;
     std::unique_ptr<AecCallbacks<std::string>> pAecCallbacks_; //!< Parser callbacks
+
+    bool const compression_;
+    ClientFrameCompressor::Ptr decompressor_; //!< set by the server's VsCompressionResult
+
+    MessageArenaPool::Ptr const arenas_; //!< received messages are parsed into a recycled arena
 };
 
 } // namespace Edge
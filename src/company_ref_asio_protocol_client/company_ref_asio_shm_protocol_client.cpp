@@ -0,0 +1,22 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_asio_shm_protocol_client.cpp
+ @brief Client class for shared memory connections
+ */
+#include "company_ref_asio_shm_protocol_client.h"
+#include "company_ref_asio_client_protocol_serializer.h"
+
+using namespace Compan::Edge;
+
+AsioShmProtocolClient::AsioShmProtocolClient(
+        boost::asio::io_context& ctx,
+        ClientProtocolHandlerPtr clientProtocolHandler,
+        std::string const& udsPath)
+    : AsioShmConnection(
+            ctx,
+            0,
+            // frames are copied between processes, compressing them only costs time
+            std::make_shared<ClientProtocolSerializer>(ctx, clientProtocolHandler, 0, false),
+            udsPath)
+{
+}
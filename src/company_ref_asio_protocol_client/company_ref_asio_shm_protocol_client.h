@@ -0,0 +1,30 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_asio_shm_protocol_client.h
+ @brief Client class for shared memory connections
+ */
+#ifndef __company_ref_ASIO_SHM_PROTOCOL_CLIENT_H__
+#define __company_ref_ASIO_SHM_PROTOCOL_CLIENT_H__
+
+#include <company_ref_asio/company_ref_asio_shm_connection.h>
+
+namespace Compan{
+namespace Edge {
+
+class ClientProtocolHandler;
+using ClientProtocolHandlerPtr = std::shared_ptr<ClientProtocolHandler>;
+
+/*!
+ * MicroService client side of a shared memory connection
+ */
+class AsioShmProtocolClient : public AsioShmConnection {
+public:
+    AsioShmProtocolClient(boost::asio::io_context&, ClientProtocolHandlerPtr clientProtocolHandler, std::string const&);
+
+    virtual ~AsioShmProtocolClient() = default;
+};
+
+} // namespace Edge
+} // namespace Compan
+
+#endif // __company_ref_ASIO_SHM_PROTOCOL_CLIENT_H__
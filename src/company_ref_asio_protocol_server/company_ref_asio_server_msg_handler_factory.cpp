@@ -6,6 +6,7 @@
 
 #include "company_ref_asio_server_msg_handler_factory.h"
 #include "company_ref_asio_server_protocol_serializer.h"
+#include "company_ref_asio_server_request_scheduler.h"
 
 using namespace Compan::Edge;
 
@@ -21,5 +22,20 @@ ServerMsgHandlerFactory::~ServerMsgHandlerFactory() = default;
 
 AsioMsgHandlerPtr ServerMsgHandlerFactory::make(uint32_t const connectionId)
 {
-    return std::make_shared<ServerProtocolSerializer>(ctx_, ws_, dmo_, wsContainerMutex_, connectionId);
+    return std::make_shared<ServerProtocolSerializer>(ctx_, ws_, dmo_, containerLocks_, scheduler(ctx_), connectionId);
+}
+
+AsioMsgHandlerPtr ServerMsgHandlerFactory::makeWithContext(uint32_t const connectionId, boost::asio::io_context& ctx)
+{
+    return std::make_shared<ServerProtocolSerializer>(ctx, ws_, dmo_, containerLocks_, scheduler(ctx), connectionId);
+}
+
+ServerRequestScheduler& ServerMsgHandlerFactory::scheduler(boost::asio::io_context& ctx)
+{
+    std::lock_guard<std::mutex> lock(schedulersLock_);
+
+    std::unique_ptr<ServerRequestScheduler>& scheduler(schedulers_[&ctx]);
+    if (!scheduler) scheduler = std::make_unique<ServerRequestScheduler>(ctx);
+
+    return *scheduler;
 }
@@ -7,6 +7,8 @@
 #define __company_ref_ASIO_SERVER_MSG_HANDLER_FACTORY_H_
 
 #include <company_ref_asio/company_ref_asio_msg_handler_factory.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_container_locks.h>
+#include <map>
 #include <memory>
 #include <mutex>
 
@@ -19,6 +21,7 @@ class io_context;
 namespace Compan{
 namespace Edge {
 
+class ServerRequestScheduler;
 class VariantValueStore;
 class DmoContainer;
 
@@ -37,13 +40,23 @@ public:
 
     virtual AsioMsgHandlerPtr make(uint32_t const connectionId);
 
+    /// Handler serviced by a reactor's io_context, the VariantValueStore stays on the main one
+    virtual AsioMsgHandlerPtr makeWithContext(uint32_t const connectionId, boost::asio::io_context& ctx);
+
+protected:
+    /// Scheduler of the connections serviced by ctx, made on first use
+    ServerRequestScheduler& scheduler(boost::asio::io_context& ctx);
+
 private:
     boost::asio::io_context& ctx_;
     VariantValueStore& ws_;
     DmoContainer& dmo_;
 
-    std::mutex wsContainerMutex_; // used to make sure two connections aren't attempting to
-                                  // add/remove elements
+    VariantContainerLocks containerLocks_; // used to make sure two connections aren't attempting to
+                                           // add/remove elements of the same container
+
+    std::mutex schedulersLock_;
+    std::map<boost::asio::io_context*, std::unique_ptr<ServerRequestScheduler>> schedulers_; //!< one per io_context
 };
 
 } // namespace Edge
@@ -10,6 +10,10 @@
 #include <company_ref_protocol/company_ref_protocol.pb.h>
 #include <company_ref_variant_valuestore/company_ref_variant_container_util.h>
 #include <company_ref_variant_valuestore/company_ref_variant_valuestore.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_batch.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_chunker.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_resume.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_subscription_index.h>
 
 #include <company_ref_dmo/company_ref_dmo_helper.h>
 #include <company_ref_protocol/company_ref_protocol.pb.h>
@@ -48,12 +52,18 @@ CompanLogger ServerProtocolHandlerLog("server.protocol.handler", LogLevel::Infor
 ServerProtocolHandler::ServerProtocolHandler(
         VariantValueStore& variantValueStore,
         DmoContainer& dmo,
-        std::mutex& wsContainerMutex,
+        VariantContainerLocks& containerLocks,
         uint32_t connectionId)
     : ws_(variantValueStore)
     , dmo_(dmo)
-    , wsContainerMutex_(wsContainerMutex)
+    , containerLocks_(containerLocks)
     , connectionId_(connectionId)
+    , arenas_(MessageArenaPool::create())
+    , subscriberId_(VariantValueSubscriptionIndex::InvalidSubscriber)
+    , invalidateSubscriberId_(VariantValueSubscriptionIndex::InvalidSubscriber)
+    , chunkInFlight_(nullptr)
+    , chunkMaxValues_(VariantValueChunker::DefaultMaxValues)
+    , chunkMaxBytes_(VariantValueChunker::DefaultMaxBytes)
 {
     FunctionArgLog(ServerProtocolHandlerLog) << __FUNCTION__ << " [" << connectionId_ << "]" << std::endl;
 }
@@ -66,8 +76,45 @@ ServerProtocolHandler::~ServerProtocolHandler()
 
 void ServerProtocolHandler::disconnect()
 {
-    wsSubscriberConnection_.clear();
+    if (subscriberId_ != VariantValueSubscriptionIndex::InvalidSubscriber) {
+        ws_.subscriptions().disconnect(subscriberId_);
+        subscriberId_ = VariantValueSubscriptionIndex::InvalidSubscriber;
+    }
+    if (invalidateSubscriberId_ != VariantValueSubscriptionIndex::InvalidSubscriber) {
+        ws_.subscriptions().disconnect(invalidateSubscriberId_);
+        invalidateSubscriberId_ = VariantValueSubscriptionIndex::InvalidSubscriber;
+    }
+    invalidateRemovedListener_.disconnect();
     disconnectListeners();
+
+    std::lock_guard<std::mutex> lock(chunkMutex_);
+    chunkedResponses_.clear();
+    chunkInFlight_ = nullptr;
+}
+
+void ServerProtocolHandler::setChunkLimits(size_t const maxValues, size_t const maxBytes)
+{
+    std::lock_guard<std::mutex> lock(chunkMutex_);
+    chunkMaxValues_ = maxValues;
+    chunkMaxBytes_ = maxBytes;
+}
+
+bool ServerProtocolHandler::isStreamChunk(ClientMessagePtr const& msgPtr)
+{
+    std::lock_guard<std::mutex> lock(chunkMutex_);
+    return msgPtr && msgPtr.get() == chunkInFlight_;
+}
+
+void ServerProtocolHandler::onMessageDrained(ClientMessagePtr msgPtr)
+{
+    {
+        std::lock_guard<std::mutex> lock(chunkMutex_);
+        if (!msgPtr || msgPtr.get() != chunkInFlight_) return;
+
+        chunkInFlight_ = nullptr;
+    }
+
+    sendNextChunk();
 }
 
 void ServerProtocolHandler::doHandleMessage(ServerMessagePtr msgPtr)
@@ -97,7 +144,7 @@ ClientMessagePtr ServerProtocolHandler::doMessage(CompanEdgeProtocol::VsSync con
 {
     FunctionArgLog(ServerProtocolHandlerLog) << "[" << connectionId_ << "]" << std::endl;
 
-    ClientMessagePtr msgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+    ClientMessagePtr msgPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
 
     disconnectListeners();
 
@@ -105,16 +152,17 @@ ClientMessagePtr ServerProtocolHandler::doMessage(CompanEdgeProtocol::VsSync con
     // VsSyncCompleted service update
     msgPtr->mutable_vssynccompleted()->set_services(CompanEdgeProtocol::ValueStore);
 
-    // ValueChanged values update
-    CompanEdgeProtocol::ValueChanged* pValueChanged = msgPtr->mutable_valuechanged();
-
     if ((vsSyncValue.ids_size() <= 0)) {
-        copyValueStoreToRepeated(pValueChanged->mutable_value());
+        // streamed as ValueChanged chunks, the last carries the VsSyncCompleted
+        queueStoreResponse(ChunkedResponse::Sync, 0);
         connectAllListeners();
 
-        return msgPtr;
+        return nullptr;
     }
 
+    // ValueChanged values update
+    CompanEdgeProtocol::ValueChanged* pValueChanged = msgPtr->mutable_valuechanged();
+
     for (auto& valueId : vsSyncValue.ids()) {
 
         VariantValue::Ptr valuePtr = ws_.get(valueId);
@@ -139,7 +187,7 @@ ClientMessagePtr ServerProtocolHandler::doMessage(CompanEdgeProtocol::ValueChang
 {
     FunctionArgLog(ServerProtocolHandlerLog) << "[" << connectionId_ << "]" << std::endl;
 
-    ClientMessagePtr msgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+    ClientMessagePtr msgPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
 
     // ValueChanged values update
     CompanEdgeProtocol::ValueChanged responseValueChanged;
@@ -189,24 +237,24 @@ ClientMessagePtr ServerProtocolHandler::doMessage(CompanEdgeProtocol::VsSubscrib
     FunctionArgLog(ServerProtocolHandlerLog)
             << "[" << connectionId_ << "] seq#:" << vsSubscribeValue.sequenceno() << std::endl;
 
-    if ((vsSubscribeValue.ids_size() <= 0)) {
-
-        ClientMessagePtr msgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
-
-        // Populate response message (ClientMessage); it has ValuedChanged, ValueRemoved, VsResult and vsSyncCompleted
-        // VsResult 'sequenceNo', 'status' and 'values' update
-        CompanEdgeProtocol::VsResult* pVsResult =
-                addVsResult(*msgPtr, vsSubscribeValue, CompanEdgeProtocol::VsResult::success);
+    if (vsSubscribeValue.invalidate()) return invalidateSubscription(vsSubscribeValue);
 
-        copyValueStoreToRepeated(pVsResult->mutable_values());
+    if ((vsSubscribeValue.ids_size() <= 0)) {
+        // streamed as VsResult chunks, all but the last are flagged with 'more'
+        queueStoreResponse(ChunkedResponse::Result, vsSubscribeValue.sequenceno());
         connectAllListeners();
 
-        return msgPtr;
+        return nullptr;
+    }
+
+    if (vsSubscribeValue.epoch()) {
+        resumeSubscription(vsSubscribeValue);
+        return nullptr;
     }
 
     // we return two different results based on a good/bad subscription
-    ClientMessagePtr rspMsgSuccessPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
-    ClientMessagePtr rspMsgNotFoundPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+    ClientMessagePtr rspMsgSuccessPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
+    ClientMessagePtr rspMsgNotFoundPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
 
     // send discreete messages about the subscription status
     CompanEdgeProtocol::VsResult* vsResultSuccess =
@@ -215,6 +263,14 @@ ClientMessagePtr ServerProtocolHandler::doMessage(CompanEdgeProtocol::VsSubscrib
     CompanEdgeProtocol::VsResult* vsResultNotFound =
             addVsResult(*rspMsgNotFoundPtr, vsSubscribeValue, CompanEdgeProtocol::VsResult::error_not_found);
 
+    // the version is taken first, the values are at least as current
+    uint64_t const version(ws_.version());
+
+    vsResultSuccess->set_epoch(ws_.epoch());
+    vsResultSuccess->set_version(version);
+    vsResultNotFound->set_epoch(ws_.epoch());
+    vsResultNotFound->set_version(version);
+
     // VsResult values update
     for (auto& valueId : vsSubscribeValue.ids()) {
 
@@ -244,16 +300,71 @@ ClientMessagePtr ServerProtocolHandler::doMessage(CompanEdgeProtocol::VsSubscrib
     return nullptr;
 }
 
+void ServerProtocolHandler::resumeSubscription(CompanEdgeProtocol::VsSubscribe const& vsSubscribeValue)
+{
+    ClientMessagePtr rspMsgSuccessPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
+    ClientMessagePtr rspMsgNotFoundPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
+
+    CompanEdgeProtocol::VsResult* vsResultSuccess =
+            addVsResult(*rspMsgSuccessPtr, vsSubscribeValue, CompanEdgeProtocol::VsResult::success);
+
+    bool const resumed = VariantValueResume::resume(
+            ws_,
+            vsSubscribeValue,
+            *vsResultSuccess,
+            *rspMsgNotFoundPtr->mutable_vsresult(),
+            [this](VariantValue::Ptr const& valuePtr) {
+                insertSubscriberFilter(valuePtr);
+                connectAddRemoveListeners();
+            });
+
+    if (!resumed) {
+        DebugLog(ServerProtocolHandlerLog) << "[" << connectionId_ << "] can't resume epoch "
+                                           << vsSubscribeValue.epoch() << std::endl;
+    }
+
+    // always sent, it completes the resume
+    onSendCallback_(rspMsgSuccessPtr);
+
+    if (rspMsgNotFoundPtr->vsresult().values_size()) onSendCallback_(rspMsgNotFoundPtr);
+}
+
+ClientMessagePtr ServerProtocolHandler::invalidateSubscription(CompanEdgeProtocol::VsSubscribe const& vsSubscribeValue)
+{
+    ClientMessagePtr msgPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
+
+    addVsResult(*msgPtr, vsSubscribeValue, CompanEdgeProtocol::VsResult::success);
+
+    if (invalidateSubscriberId_ == VariantValueSubscriptionIndex::InvalidSubscriber) {
+        invalidateSubscriberId_ = ws_.subscriptions().connect(
+                WeakBind(&ServerProtocolHandler::onValueInvalidated, shared_from_this(), std::placeholders::_1));
+    }
+
+    for (auto& valueId : vsSubscribeValue.ids()) {
+        VariantValue::Ptr valuePtr = ws_.get(valueId);
+        if (valuePtr) ws_.subscriptions().subscribe(invalidateSubscriberId_, valuePtr);
+    }
+
+    if (!invalidateRemovedListener_.connected() && ws_.subscriptions().hasSubscriptions(invalidateSubscriberId_)) {
+        invalidateRemovedListener_ = ws_.connectValueRemovedListener(
+                WeakBind(&ServerProtocolHandler::onInvalidatedRemoved, shared_from_this(), std::placeholders::_1));
+    }
+
+    return msgPtr;
+}
+
 ClientMessagePtr ServerProtocolHandler::doMessage(CompanEdgeProtocol::VsUnsubscribe const& vsUnsubscribeValue)
 {
     FunctionArgLog(ServerProtocolHandlerLog)
             << "[" << connectionId_ << "] seq#:" << vsUnsubscribeValue.sequenceno() << std::endl;
 
-    ClientMessagePtr msgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+    ClientMessagePtr msgPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
 
     addVsResult(*msgPtr, vsUnsubscribeValue, CompanEdgeProtocol::VsResult::success);
 
-    wsSubscriberConnection_.clear();
+    ws_.subscriptions().unsubscribeAll(subscriberId_);
+    ws_.subscriptions().unsubscribeAll(invalidateSubscriberId_);
+    invalidateRemovedListener_.disconnect();
     disconnectListeners();
 
     return msgPtr;
@@ -264,24 +375,17 @@ ClientMessagePtr ServerProtocolHandler::doMessage(CompanEdgeProtocol::VsGetAll c
     FunctionArgLog(ServerProtocolHandlerLog)
             << "[" << connectionId_ << "] seq#:" << vsGetAllValue.sequenceno() << std::endl;
 
-    ClientMessagePtr msgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
-
-    CompanEdgeProtocol::VsResult* pVsResult = addVsResult(*msgPtr, vsGetAllValue, CompanEdgeProtocol::VsResult::success);
+    if (ws_.size() <= 0) DebugLog(ServerProtocolHandlerLog) << "WsMap is empty, size:" << ws_.size() << std::endl;
 
-    if (ws_.size() <= 0) {
-        DebugLog(ServerProtocolHandlerLog) << "WsMap is empty, size:" << ws_.size() << std::endl;
-        return msgPtr;
-    }
-
-    copyValueStoreToRepeated(pVsResult->mutable_values());
-    return msgPtr;
+    queueStoreResponse(ChunkedResponse::Result, vsGetAllValue.sequenceno());
+    return nullptr;
 }
 
 ClientMessagePtr ServerProtocolHandler::doMessage(CompanEdgeProtocol::VsGetValue const& vsGetValue)
 {
     FunctionArgLog(ServerProtocolHandlerLog) << "[" << connectionId_ << "] valueId:" << vsGetValue.id() << std::endl;
 
-    ClientMessagePtr msgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+    ClientMessagePtr msgPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
 
     CompanEdgeProtocol::VsResult* pVsResult =
             addVsResult(*msgPtr, vsGetValue, CompanEdgeProtocol::VsResult::error_not_found);
@@ -317,7 +421,7 @@ ClientMessagePtr ServerProtocolHandler::doMessage(CompanEdgeProtocol::VsSetValue
 {
     FunctionArgLog(ServerProtocolHandlerLog) << "[" << connectionId_ << "] valueId:" << vsSetValue.id() << std::endl;
 
-    ClientMessagePtr msgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+    ClientMessagePtr msgPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
 
     CompanEdgeProtocol::VsResult* pVsResult =
             addVsResult(*msgPtr, vsSetValue, CompanEdgeProtocol::VsResult::error_not_found);
@@ -375,31 +479,9 @@ ClientMessagePtr ServerProtocolHandler::doMessage(CompanEdgeProtocol::VsMultiGet
 {
     FunctionArgLog(ServerProtocolHandlerLog) << "[" << connectionId_ << "]" << std::endl;
 
-    ClientMessagePtr msgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+    ClientMessagePtr msgPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
 
-    CompanEdgeProtocol::VsMultiGetResult* vsMultiGetResult = msgPtr->mutable_vsmultigetresult();
-    vsMultiGetResult->set_sequenceno(msg.sequenceno());
-
-    for (auto& id : msg.ids()) {
-
-        CompanEdgeProtocol::VsMultiGetResult_Result* result = vsMultiGetResult->add_results();
-
-        VariantValue::Ptr valuePtr = ws_.get(id);
-        if (valuePtr == nullptr) {
-            result->set_error(CompanEdgeProtocol::VsMultiGetResult::ValueNotFound);
-            result->set_description("Value not found");
-            continue;
-        }
-
-        result->set_error(CompanEdgeProtocol::VsMultiGetResult::Success);
-        *result->add_values() = valuePtr->get();
-
-        if (valuePtr->type() == CompanEdgeProtocol::Container) {
-            VariantValueVisitor::visitChildren(valuePtr, [&result](VariantValue::Ptr const& visitPtr) {
-                *result->add_values() = visitPtr->get();
-            });
-        }
-    }
+    VariantValueBatch::multiGet(ws_, msg, *msgPtr->mutable_vsmultigetresult());
 
     return msgPtr;
 }
@@ -408,35 +490,9 @@ ClientMessagePtr ServerProtocolHandler::doMessage(CompanEdgeProtocol::VsMultiSet
 {
     FunctionArgLog(ServerProtocolHandlerLog) << "[" << connectionId_ << "]" << std::endl;
 
-    ClientMessagePtr msgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
-
-    CompanEdgeProtocol::VsMultiSetResult* vsMultiSetResult = msgPtr->mutable_vsmultisetresult();
-    vsMultiSetResult->set_sequenceno(msg.sequenceno());
-
-    for (auto& setValue : msg.values()) {
-        CompanEdgeProtocol::VsMultiSetResult_Result* result = vsMultiSetResult->add_results();
-
-        VariantValue::Ptr valuePtr = ws_.get(setValue.id());
+    ClientMessagePtr msgPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
 
-        result->set_id(setValue.id());
-
-        if (valuePtr == nullptr) {
-            result->set_error(CompanEdgeProtocol::VsMultiSetResult::ValueNotFound);
-            result->set_description("Value not found");
-            continue;
-        }
-
-        ValueDataSet::Results setResult = valuePtr->set(setValue.value());
-        if (setResult == ValueDataSet::Success || setResult == ValueDataSet::SameValue) {
-            result->set_error(CompanEdgeProtocol::VsMultiSetResult::Success);
-            continue;
-        }
-
-        result->set_error(CompanEdgeProtocol::VsMultiSetResult::UnknownError);
-        std::stringstream ss;
-        ss << "Failed to set value: " << ValueDataSet::resultStr(setResult);
-        result->set_description(ss.str());
-    }
+    VariantValueBatch::multiSet(ws_, msg, *msgPtr->mutable_vsmultisetresult());
 
     return msgPtr;
 }
@@ -445,7 +501,7 @@ ClientMessagePtr ServerProtocolHandler::doMessage(CompanEdgeProtocol::VsGetObjec
 {
     FunctionArgLog(ServerProtocolHandlerLog) << "[" << connectionId_ << "]" << std::endl;
 
-    ClientMessagePtr msgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+    ClientMessagePtr msgPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
 
     CompanEdgeProtocol::VsResult* pVsResult = addVsResult(*msgPtr, msg, CompanEdgeProtocol::VsResult::error_not_found);
 
@@ -488,29 +544,9 @@ bool ServerProtocolHandler::isParentSubscribed(VariantValue::Ptr const valuePtr)
 {
     if (valuePtr == nullptr) return false;
 
-    if (wsSubscriberConnection_.empty()) return true;
-
-    if (wsSubscriberConnection_.has(valuePtr->hashToken())) return true;
+    if (!ws_.subscriptions().hasSubscriptions(subscriberId_)) return true;
 
-    ValueId valuePath(valuePtr->id());
-
-    while (!valuePath.empty()) {
-        VariantValue::Ptr parentPtr = ws_.get(valuePath.parent().name());
-        if (parentPtr == nullptr) return false;
-
-        valuePath = valuePath.parent();
-
-        if (!wsSubscriberConnection_.has(parentPtr->hashToken())) continue;
-
-        wsSubscriberConnection_.insert(
-                valuePtr->hashToken(),
-                valuePtr->connectChangedListener(
-                        WeakBind(&ServerProtocolHandler::onValueChanged, shared_from_this(), std::placeholders::_1)));
-
-        return true;
-    }
-
-    return false;
+    return ws_.subscriptions().isSubscribed(subscriberId_, valuePtr);
 }
 
 void ServerProtocolHandler::onValueAdded(VariantValue::Ptr const valuePtr)
@@ -526,30 +562,27 @@ void ServerProtocolHandler::onValueAdded(VariantValue::Ptr const valuePtr)
     //  AddToContainer handler can send the values in a single pass
     if (valuePtr->setUpdateType() == VariantValue::Remote) return;
 
-    ClientMessagePtr msgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+    ClientMessagePtr msgPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
 
     CompanEdgeProtocol::ValueChanged* valueChanged = msgPtr->mutable_valuechanged();
+    valueChanged->set_version(valuePtr->version());
     *valueChanged->add_value() = valuePtr->get();
 
     onSendCallback_(msgPtr);
 }
 
-void ServerProtocolHandler::onValueChanged(VariantValue::Ptr const valuePtr)
+void ServerProtocolHandler::onValueChanged(ClientMessageFrame::Ptr const framePtr)
 {
     FunctionArgLog(ServerProtocolHandlerLog) << "[" << connectionId_ << "]" << std::endl;
 
-    if (valuePtr == nullptr) return;
+    if (framePtr == nullptr || framePtr->value() == nullptr) return;
 
     // containers are handled else where
-    if (valuePtr->type() == CompanEdgeProtocol::ContainerAddTo
-        || valuePtr->type() == CompanEdgeProtocol::ContainerRemoveFrom)
+    if (framePtr->value()->type() == CompanEdgeProtocol::ContainerAddTo
+        || framePtr->value()->type() == CompanEdgeProtocol::ContainerRemoveFrom)
         return;
 
-    ClientMessagePtr msgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
-    CompanEdgeProtocol::ValueChanged* valueChanged = msgPtr->mutable_valuechanged();
-    *valueChanged->add_value() = valuePtr->get();
-
-    onSendCallback_(msgPtr);
+    sendFrame(framePtr);
 }
 
 void ServerProtocolHandler::onValueRemoved(VariantValue::Ptr const valuePtr)
@@ -559,18 +592,18 @@ void ServerProtocolHandler::onValueRemoved(VariantValue::Ptr const valuePtr)
     if (valuePtr == nullptr) return;
 
     // make sure we aren't sending out a remove notification for something we arent' subscribed to
-    if (!wsSubscriberConnection_.empty()) {
+    if (ws_.subscriptions().hasSubscriptions(subscriberId_)) {
 
-        if (!wsSubscriberConnection_.has(valuePtr->hashToken())) { return; }
+        if (!ws_.subscriptions().isSubscribed(subscriberId_, valuePtr)) { return; }
 
-        wsSubscriberConnection_.remove(valuePtr->hashToken());
+        ws_.subscriptions().unsubscribe(subscriberId_, valuePtr);
 
-        if (wsSubscriberConnection_.empty()) {
+        if (!ws_.subscriptions().hasSubscriptions(subscriberId_)) {
             if (removedListener_.connected()) { removedListener_.disconnect(); }
         }
     }
 
-    ClientMessagePtr msgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+    ClientMessagePtr msgPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
     CompanEdgeProtocol::ValueRemoved* valueRemoved = msgPtr->mutable_valueremoved();
     valueRemoved->add_id(valuePtr->id());
     valueRemoved->add_hashtoken(valuePtr->hashToken());
@@ -578,6 +611,37 @@ void ServerProtocolHandler::onValueRemoved(VariantValue::Ptr const valuePtr)
     onSendCallback_(msgPtr);
 }
 
+void ServerProtocolHandler::onValueInvalidated(ClientMessageFrame::Ptr const framePtr)
+{
+    FunctionArgLog(ServerProtocolHandlerLog) << "[" << connectionId_ << "]" << std::endl;
+
+    if (framePtr == nullptr || framePtr->value() == nullptr) return;
+
+    // container add/remove included, any change invalidates
+    sendInvalidated(framePtr->value());
+}
+
+void ServerProtocolHandler::onInvalidatedRemoved(VariantValue::Ptr const valuePtr)
+{
+    if (valuePtr == nullptr || !ws_.subscriptions().isSubscribed(invalidateSubscriberId_, valuePtr)) return;
+
+    sendInvalidated(valuePtr);
+}
+
+void ServerProtocolHandler::sendInvalidated(VariantValue::Ptr const valuePtr)
+{
+    // the client subscribes again with it's next fetch
+    for (VariantValue::Ptr parentPtr = valuePtr; parentPtr && !parentPtr->id().empty(); parentPtr = parentPtr->parent())
+        ws_.subscriptions().unsubscribe(invalidateSubscriberId_, parentPtr);
+
+    if (!ws_.subscriptions().hasSubscriptions(invalidateSubscriberId_)) invalidateRemovedListener_.disconnect();
+
+    ClientMessagePtr msgPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
+    msgPtr->mutable_valueinvalidated()->add_id(valuePtr->id());
+
+    onSendCallback_(msgPtr);
+}
+
 void ServerProtocolHandler::onValueAddToContainer(VariantValue::Ptr const valuePtr)
 {
     FunctionArgLog(ServerProtocolHandlerLog) << "[" << connectionId_ << "]" << std::endl;
@@ -596,7 +660,7 @@ void ServerProtocolHandler::onValueAddToContainer(VariantValue::Ptr const valueP
         return;
     }
 
-    ClientMessagePtr msgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+    ClientMessagePtr msgPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
 
     CompanEdgeProtocol::ValueChanged* valueChanged = msgPtr->mutable_valuechanged();
 
@@ -628,18 +692,18 @@ void ServerProtocolHandler::onValueRemoveFromContainer(VariantValue::Ptr const v
     if (valuePtr == nullptr) return;
 
     // make sure we aren't sending out a remove notification for something we arent' subscribed to
-    if (!wsSubscriberConnection_.empty()) {
+    if (ws_.subscriptions().hasSubscriptions(subscriberId_)) {
 
-        if (!wsSubscriberConnection_.has(valuePtr->hashToken())) { return; }
+        if (!ws_.subscriptions().isSubscribed(subscriberId_, valuePtr)) { return; }
 
-        wsSubscriberConnection_.remove(valuePtr->hashToken());
+        ws_.subscriptions().unsubscribe(subscriberId_, valuePtr);
 
-        if (wsSubscriberConnection_.empty()) {
+        if (!ws_.subscriptions().hasSubscriptions(subscriberId_)) {
             if (removedListener_.connected()) { removedListener_.disconnect(); }
         }
     }
 
-    ClientMessagePtr msgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+    ClientMessagePtr msgPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
 
     CompanEdgeProtocol::ValueChanged* valueChanged = msgPtr->mutable_valuechanged();
 
@@ -653,10 +717,8 @@ void ServerProtocolHandler::connectAllListeners()
 {
     connectAddRemoveListeners();
 
-    if (!changedListener_.connected()) {
-        changedListener_ = ws_.connectValueChangedListener(
-                WeakBind(&ServerProtocolHandler::onValueChanged, shared_from_this(), std::placeholders::_1));
-    }
+    connectSubscriber();
+    ws_.subscriptions().subscribeStore(subscriberId_);
 }
 
 void ServerProtocolHandler::connectAddRemoveListeners()
@@ -682,7 +744,7 @@ void ServerProtocolHandler::connectAddRemoveListeners()
 
 void ServerProtocolHandler::disconnectListeners()
 {
-    changedListener_.disconnect();
+    ws_.subscriptions().unsubscribeStore(subscriberId_);
     addToContainerListener_.disconnect();
     removeFromContainerListener_.disconnect();
     addedListener_.disconnect();
@@ -701,8 +763,8 @@ bool ServerProtocolHandler::doAddToContainer(std::string const& id, AddToContain
         return false;
     }
 
-    /// Make sure that another process doesn't attempt to add/remove from a container in parallel
-    std::lock_guard<std::mutex> lock(wsContainerMutex_);
+    /// Make sure that another process doesn't attempt to add/remove from this container in parallel
+    VariantContainerLocks::Guard lock(containerLocks_.lock(containerId));
 
     /// In the event we aren't subscribed to this, we need to signal back completion
     ///  eg - CLI needs notification
@@ -725,9 +787,6 @@ bool ServerProtocolHandler::doAddToContainer(std::string const& id, AddToContain
 
         DebugLog(ServerProtocolHandlerLog) << __FUNCTION__ << " - Container added: " << keyId << std::endl;
 
-        VariantValueVisitor::visitChildren(
-                containerPtr, [this](VariantValue::Ptr const& visitPtr) { insertSubscriberFilter(visitPtr); });
-
         if (!addToContainerListener_.connected()) {
             VariantValue::Ptr addValuePtr =
                     VariantContainerUtil::makeAddToContainer(containerPtr, msg.key(), VariantValue::Local);
@@ -750,8 +809,8 @@ bool ServerProtocolHandler::doRemoveFromContainer(std::string const& id, RemoveF
         return false;
     }
 
-    /// Make sure that another process doesn't attempt to add/remove from a container in parallel
-    std::lock_guard<std::mutex> lock(wsContainerMutex_);
+    /// Make sure that another process doesn't attempt to add/remove from this container in parallel
+    VariantContainerLocks::Guard lock(containerLocks_.lock(containerId));
 
     ValueId keyId(containerId, msg.key());
     VariantValue::Ptr valuePtr = ws_.get(keyId);
@@ -767,10 +826,74 @@ bool ServerProtocolHandler::doRemoveFromContainer(std::string const& id, RemoveF
     return true;
 }
 
-void ServerProtocolHandler::copyValueStoreToRepeated(
-        google::protobuf::RepeatedPtrField<CompanEdgeProtocol::Value>* repeatedValues)
+void ServerProtocolHandler::queueStoreResponse(ChunkedResponse::Type const type, uint32_t const sequenceNo)
+{
+    {
+        std::lock_guard<std::mutex> lock(chunkMutex_);
+
+        ChunkedResponse response{
+                type, sequenceNo, std::make_shared<VariantValueChunker>(ws_, chunkMaxValues_, chunkMaxBytes_)};
+
+        // only the VariantValue pointers are captured here
+        response.chunker->insertStore();
+
+        chunkedResponses_.push_back(std::move(response));
+    }
+
+    sendNextChunk();
+}
+
+void ServerProtocolHandler::sendNextChunk()
+{
+    ClientMessagePtr msgPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
+
+    {
+        std::lock_guard<std::mutex> lock(chunkMutex_);
+
+        if (chunkInFlight_ || chunkedResponses_.empty()) return;
+
+        ChunkedResponse& response = chunkedResponses_.front();
+
+        bool more(false);
+
+        if (response.type == ChunkedResponse::Sync) {
+            more = response.chunker->fill(msgPtr->mutable_valuechanged()->mutable_value());
+            if (!more) msgPtr->mutable_vssynccompleted()->set_services(CompanEdgeProtocol::ValueStore);
+        } else {
+            CompanEdgeProtocol::VsResult* pVsResult = msgPtr->mutable_vsresult();
+            pVsResult->set_sequenceno(response.sequenceNo);
+            pVsResult->set_status(CompanEdgeProtocol::VsResult::success);
+
+            more = response.chunker->fill(pVsResult->mutable_values());
+            pVsResult->set_more(more);
+        }
+
+        DebugLog(ServerProtocolHandlerLog) << "[" << connectionId_ << "] chunk seq#:" << response.sequenceNo
+                                           << ", remaining:" << response.chunker->remaining() << std::endl;
+
+        if (!more) chunkedResponses_.pop_front();
+
+        // wait for the transport to drain this chunk before producing the next
+        chunkInFlight_ = chunkedResponses_.empty() ? nullptr : msgPtr.get();
+    }
+
+    onSendCallback_(msgPtr);
+}
+
+void ServerProtocolHandler::connectSubscriber()
 {
-    ws_.visitValues([&repeatedValues](VariantValue::Ptr const& value) { *repeatedValues->Add() = value->get(); });
+    if (subscriberId_ != VariantValueSubscriptionIndex::InvalidSubscriber) return;
+
+    subscriberId_ = ws_.subscriptions().connect(
+            WeakBind(&ServerProtocolHandler::onValueChanged, shared_from_this(), std::placeholders::_1));
+}
+
+void ServerProtocolHandler::sendFrame(ClientMessageFrame::Ptr framePtr)
+{
+    if (onSendFrameCallback_.empty())
+        onSendCallback_(framePtr->message());
+    else
+        onSendFrameCallback_(framePtr);
 }
 
 void ServerProtocolHandler::insertSubscriberFilter(VariantValue::Ptr valuePtr)
@@ -779,11 +902,10 @@ void ServerProtocolHandler::insertSubscriberFilter(VariantValue::Ptr valuePtr)
 
     if (valuePtr == nullptr) return;
 
-    if (wsSubscriberConnection_.has(valuePtr->hashToken())) return;
+    connectSubscriber();
 
-    SignalScopedConnection connection = valuePtr->connectChangedListener(
-            WeakBind(&ServerProtocolHandler::onValueChanged, shared_from_this(), std::placeholders::_1));
-    wsSubscriberConnection_.insert(valuePtr->hashToken(), std::move(connection));
+    // the subscription covers the value's children, including those added later
+    ws_.subscriptions().subscribe(subscriberId_, valuePtr);
 }
 
 void ServerProtocolHandler::copyValueChildrenToRepeated(
@@ -797,10 +919,7 @@ void ServerProtocolHandler::copyValueChildrenToRepeated(
 
     *repeatedValues->Add() = valuePtr->get();
 
-    VariantValueVisitor::visitChildren(
-            valuePtr, [this, &repeatedValues, &subscribe](VariantValue::Ptr const& visitPtr) {
-                if (subscribe) insertSubscriberFilter(visitPtr);
-
-                *repeatedValues->Add() = visitPtr->get();
-            });
+    VariantValueVisitor::visitChildren(valuePtr, [&repeatedValues](VariantValue::Ptr const& visitPtr) {
+        *repeatedValues->Add() = visitPtr->get();
+    });
 }
@@ -8,8 +8,11 @@
 
 #include <company_ref_utils/company_ref_callbacks.h>
 #include <company_ref_utils/company_ref_signals.h>
-#include <company_ref_variant_valuestore/company_ref_variant_valuestore_hashtoken_map.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_container_locks.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_message_arena.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_subscription_index.h>
 #include <google/protobuf/repeated_field.h>
+#include <deque>
 #include <mutex>
 
 namespace CompanValueTypes {
@@ -40,6 +43,7 @@ namespace Edge {
 class SignalScopedConnection;
 class VariantValue;
 class VariantValueStore;
+class VariantValueChunker;
 class DmoContainer;
 
 using ClientMessagePtr = std::shared_ptr<CompanEdgeProtocol::ClientMessage>;
@@ -54,12 +58,15 @@ public:
     /// Callback function to signal message processing has completed
     using SendCallback = Signal<void(ClientMessagePtr)>;
 
+    /// Callback function for value changes shared with other connections
+    using SendFrameCallback = Signal<void(ClientMessageFrame::Ptr)>;
+
     /*!
      * @param   Application's VariantValueStore object
      * @param   Response Message Queue to insert response messages
      * @param   Unique connection identifier
      */
-    ServerProtocolHandler(VariantValueStore&, DmoContainer&, std::mutex&, uint32_t);
+    ServerProtocolHandler(VariantValueStore&, DmoContainer&, VariantContainerLocks&, uint32_t);
     virtual ~ServerProtocolHandler();
 
     virtual void disconnect();
@@ -72,6 +79,35 @@ public:
 
     SignalConnection connectSendCallback(SendCallback::SlotType const& cb);
 
+    /*!
+     * Connects a listener for shared, encoded once, value changes
+     *
+     * Without a listener these are sent through the SendCallback
+     */
+    SignalConnection connectSendFrameCallback(SendFrameCallback::SlotType const& cb);
+
+    /*!
+     * Sets the bounds of a single chunk for streamed responses
+     *
+     * VsSync, VsGetAll and subscribe-all are streamed; a value of 0
+     * uses the VariantValueChunker default
+     */
+    void setChunkLimits(size_t const maxValues, size_t const maxBytes);
+
+    /// Returns true if a streamed response is waiting for this message to drain
+    bool isStreamChunk(ClientMessagePtr const& msgPtr);
+
+    /*!
+     * Notification that a message has been written to the transport
+     *
+     * A streamed response only produces it's next chunk once the
+     * previous chunk has drained
+     */
+    void onMessageDrained(ClientMessagePtr msgPtr);
+
+    /// Arenas of the connection's requests and responses
+    MessageArenaPool::Ptr const& arenas() const;
+
 protected:
     ServerProtocolHandler(ServerProtocolHandler const&) = delete;
     ServerProtocolHandler& operator=(ServerProtocolHandler const&) = delete;
@@ -83,6 +119,7 @@ protected:
      * Subscribes to either a list of value.ids or all values
      *
      * Responds with VsSyncCompleted and a populated ValueChanged array of requested values
+     * A sync of all values is streamed in chunks, see setChunkLimits
      *
      * @param VsSync request
      */
@@ -104,7 +141,7 @@ protected:
      *
      * Subscriptions are cumulative until reset by a VsUnsubscribe request
      *
-     * Responds with VsResult
+     * Responds with VsResult, a request with an epoch resumes a previous subscription
      *
      * @param VsSubscribe request
      */
@@ -122,7 +159,7 @@ protected:
     /*!
      * Retrieves all values from the Variant Value store
      *
-     * Responds with VsResult
+     * Responds with VsResult, streamed in chunks
      *
      * @param VsGetAll request
      */
@@ -195,13 +232,13 @@ protected:
     virtual void onValueAdded(VariantValuePtr const);
 
     /*!
-     * Value changed callback handler from the Value Store
+     * Value changed callback handler from the subscription index
      *
-     * Generates a ValueChanged notification
+     * Forwards the ValueChanged notification shared by all subscribers
      *
-     * @param VariantValuePtr with the changed value
+     * @param ClientMessageFrame::Ptr with the changed value
      */
-    virtual void onValueChanged(VariantValuePtr const);
+    virtual void onValueChanged(ClientMessageFrame::Ptr const);
 
     /*!
      * Value removed callback handler from the Value Store
@@ -215,55 +252,119 @@ protected:
     virtual void onValueAddToContainer(VariantValuePtr const);
     virtual void onValueRemoveFromContainer(VariantValuePtr const);
 
+    /*!
+     * Value changed callback handler from the subscription index, for invalidate subscriptions
+     *
+     * Generates a ValueInvalidated notification
+     *
+     * @param ClientMessageFrame::Ptr with the changed value
+     */
+    virtual void onValueInvalidated(ClientMessageFrame::Ptr const);
+
+    /// Value removed callback handler from the Value Store, for invalidate subscriptions
+    virtual void onInvalidatedRemoved(VariantValuePtr const);
+
 private:
     void connectAllListeners();
     void connectAddRemoveListeners();
     void disconnectListeners();
 
+    /// Registers with the store's subscription index on first use
+    void connectSubscriber();
+
+    /// Sends a shared frame, or it's message if no frame listener is connected
+    void sendFrame(ClientMessageFrame::Ptr framePtr);
+
     bool doAddToContainer(std::string const&, CompanValueTypes::AddToContainer const&);
     bool doRemoveFromContainer(std::string const&, CompanValueTypes::RemoveFromContainer const&);
 
     /// Checks if the VariantValue or it's parent is in the subscriber list
     bool isParentSubscribed(VariantValuePtr const valuePtr);
 
-    /// Copies the VariantValueStore elements into a repeated field accepting CompanEdgeProtocol::Value
-    void copyValueStoreToRepeated(google::protobuf::RepeatedPtrField<CompanEdgeProtocol::Value>*);
-
     /*!
      * Walks the children of a value and adds it to the RepeatedPtrField
      *
-     * If doing a discrete subscription, adds it to the  wsSubscriberConnection_
+     * If doing a discrete subscription, subscribes to the value's subtree
      * @param valuePtr          Value to walk the child of
      * @param repeatedValues    RepeatedPtrField to add values to
-     * @param subscribe         Whether to add the value to wsSubscriberConnection_
+     * @param subscribe         Whether to subscribe to the value and it's children
      */
     void copyValueChildrenToRepeated(
             VariantValuePtr valuePtr,
             google::protobuf::RepeatedPtrField<CompanEdgeProtocol::Value>* repeatedValues,
             bool const subscribe = false);
 
-    /// Inserts the VariantValuePtr into the subscription connection filter
+    /// Subscribes to the VariantValuePtr's subtree in the store's subscription index
     void insertSubscriberFilter(VariantValuePtr valuePtr);
 
+    /*!
+     * Resumes a reconnecting client's subscription
+     *
+     * Responds with a delta VsResult of the values changed since the request's
+     * version, or resync_required if the store can't resume it
+     *
+     * @param VsSubscribe request, with the epoch and version the client is current to
+     */
+    void resumeSubscription(CompanEdgeProtocol::VsSubscribe const&);
+
+    /*!
+     * Subscribes a caching client's ids for invalidation
+     *
+     * Responds with a VsResult without values, ids not found aren't subscribed
+     *
+     * @param VsSubscribe request, flagged invalidate
+     */
+    ClientMessagePtr invalidateSubscription(CompanEdgeProtocol::VsSubscribe const&);
+
+    /// Sends a ValueInvalidated, once; the subscription covering the value is dropped
+    void sendInvalidated(VariantValuePtr const valuePtr);
+
+    /// Streamed response waiting for it's chunks to be sent
+    struct ChunkedResponse {
+        enum Type { Sync, Result };
+
+        Type type;
+        uint32_t sequenceNo;
+        std::shared_ptr<VariantValueChunker> chunker;
+    };
+
+    /// Queues a response of the whole VariantValueStore and kicks off sending
+    void queueStoreResponse(ChunkedResponse::Type const type, uint32_t const sequenceNo);
+
+    /// Sends the next chunk, unless a previous chunk hasn't drained
+    void sendNextChunk();
+
 private:
     VariantValueStore& ws_;
     DmoContainer& dmo_;
-    std::mutex& wsContainerMutex_; // used to make sure two connections aren't attempting to
-                                   // add/remove elements
+    VariantContainerLocks& containerLocks_; // used to make sure two connections aren't attempting to
+                                            // add/remove elements of the same container
 
     uint32_t const connectionId_;
+    MessageArenaPool::Ptr const arenas_;
+
     SendCallback onSendCallback_;
+    SendFrameCallback onSendFrameCallback_;
+
+    // discrete subscriptions, held in the VariantValueStore's subscription index
+    VariantValueSubscriptionIndex::SubscriberId subscriberId_;
 
-    // map of hashToken and value changed signal for discrete value connection
-    HashTokenMap<SignalScopedConnection> wsSubscriberConnection_;
+    // invalidate subscriptions, a second subscriber of the index
+    VariantValueSubscriptionIndex::SubscriberId invalidateSubscriberId_;
+    SignalScopedConnection invalidateRemovedListener_;
 
-    // listen for Variant ValueStore global connections
+    // listen for Variant ValueStore global connections, changes come from the subscription index
     SignalScopedConnection addedListener_;
-    SignalScopedConnection changedListener_;
     SignalScopedConnection removedListener_;
 
     SignalScopedConnection addToContainerListener_;
     SignalScopedConnection removeFromContainerListener_;
+
+    std::mutex chunkMutex_;
+    std::deque<ChunkedResponse> chunkedResponses_;
+    CompanEdgeProtocol::ClientMessage const* chunkInFlight_; //!< Chunk waiting to drain
+    size_t chunkMaxValues_;
+    size_t chunkMaxBytes_;
 };
 
 inline SignalConnection ServerProtocolHandler::connectSendCallback(SendCallback::SlotType const& cb)
@@ -271,6 +372,16 @@ inline SignalConnection ServerProtocolHandler::connectSendCallback(SendCallback:
     return onSendCallback_.connect(cb);
 }
 
+inline SignalConnection ServerProtocolHandler::connectSendFrameCallback(SendFrameCallback::SlotType const& cb)
+{
+    return onSendFrameCallback_.connect(cb);
+}
+
+inline MessageArenaPool::Ptr const& ServerProtocolHandler::arenas() const
+{
+    return arenas_;
+}
+
 } // namespace Edge
 } // namespace Compan
 
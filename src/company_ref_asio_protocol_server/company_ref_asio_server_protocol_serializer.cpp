@@ -26,11 +26,15 @@ ServerProtocolSerializer::ServerProtocolSerializer(
         boost::asio::io_context& ctx,
         VariantValueStore& ws,
         DmoContainer& dmo,
-        std::mutex& wsContainerMutex,
+        VariantContainerLocks& containerLocks,
+        ServerRequestScheduler& scheduler,
         uint32_t connectionId)
     : ctx_(ctx)
     , connectionId_(connectionId)
-    , serverProtocolHandler_(std::make_shared<ServerProtocolHandler>(ws, dmo, wsContainerMutex, connectionId))
+    , ws_(ws)
+    , scheduler_(scheduler)
+    , sendStrand_(ctx)
+    , serverProtocolHandler_(std::make_shared<ServerProtocolHandler>(ws, dmo, containerLocks, connectionId))
     , bNewFraming_(true)
     , pAecCallbacks_(new AecCallbacks<std::string>(
               {[]() { ErrorLog(ServerProtocolSerializerLog) << "Parse error..." << std::endl; },
@@ -54,12 +58,20 @@ void ServerProtocolSerializer::start()
 {
     onEncodeClientMessage_ = serverProtocolHandler_->connectSendCallback(
             WeakBind(&ServerProtocolSerializer::onEncodeClientMessage, shared_from_this(), std::placeholders::_1));
+    onEncodeClientFrame_ = serverProtocolHandler_->connectSendFrameCallback(
+            WeakBind(&ServerProtocolSerializer::onEncodeClientFrame, shared_from_this(), std::placeholders::_1));
 }
 
 void ServerProtocolSerializer::stop()
 {
     onEncodeClientMessage_.disconnect();
+    onEncodeClientFrame_.disconnect();
     serverProtocolHandler_->disconnect();
+
+    scheduler_.remove(connectionId_);
+
+    std::lock_guard<std::mutex> lock(sendQueueLock_);
+    sendQueue_.clear();
 }
 
 void ServerProtocolSerializer::recvData(BufferType&& buffer)
@@ -95,53 +107,146 @@ void ServerProtocolSerializer::onDecodeServerMessage(char const* data, size_t co
 
     if (!isConnected()) return;
 
-    ServerMessagePtr msgPtr = std::make_shared<CompanEdgeProtocol::ServerMessage>();
+    // the request and it's fields live in one recycled arena
+    ServerMessagePtr msgPtr = serverProtocolHandler_->arenas()->make<CompanEdgeProtocol::ServerMessage>();
     if (!msgPtr->ParseFromArray(data, len)) {
         ErrorLog(ServerProtocolSerializerLog)
                 << "[" << connectionId_ << "] onDecodeServerMessage, parse error" << std::endl;
         return;
     }
 
-    boost::asio::post(ctx_, WeakBind(&ServerProtocolHandler::doHandleMessage, serverProtocolHandler_, msgPtr));
+    // negotiated by the transport, the protocol handler never sees it
+    if (msgPtr->has_vscompression()) {
+        onCompression(msgPtr->vscompression());
+        return;
+    }
+
+    scheduler_.schedule(
+            connectionId_,
+            ServerRequestScheduler::lane(*msgPtr),
+            len,
+            WeakBind(&ServerProtocolHandler::doHandleMessage, serverProtocolHandler_, msgPtr));
 }
 
 void ServerProtocolSerializer::onEncodeClientMessage(ClientMessagePtr msgPtr)
 {
     FunctionArgLog(ServerProtocolSerializerLog) << " [" << connectionId_ << "]" << std::endl;
 
-    /// serialize the message back
     if (!isConnected() || !msgPtr) return;
 
-    std::size_t pbSize = msgPtr->ByteSizeLong();
+    queueFrame(std::make_shared<ClientMessageFrame>(msgPtr));
+}
 
-    if (!pbSize) return;
+void ServerProtocolSerializer::onEncodeClientFrame(ClientMessageFrame::Ptr framePtr)
+{
+    FunctionArgLog(ServerProtocolSerializerLog) << " [" << connectionId_ << "]" << std::endl;
 
-    BufferType buffer(pbSize + 64);
+    if (!isConnected() || !framePtr) return;
 
-    if (bNewFraming_) {
-        std::string hdr(AECv10::makeHeader<std::string>(pbSize));
-        std::size_t hdrSize = hdr.length();
-        std::move(cbegin(hdr), cend(hdr), buffer.begin());
-        if (!msgPtr->SerializeToArray(&buffer[hdrSize], pbSize)) {
-            ErrorLog(ServerProtocolSerializerLog)
-                    << "[" << connectionId_ << "] failed to serialize : " << *msgPtr << std::endl;
-            return;
-        }
+    queueFrame(framePtr);
+}
 
-        buffer.resize(hdrSize + pbSize);
-    } else {
-        std::string hdr(std::to_string(pbSize) + ' ');
-        std::size_t hdrSize = hdr.length();
-        std::move(std::cbegin(hdr), std::cend(hdr), std::begin(buffer));
-
-        if (!msgPtr->SerializeToArray(&buffer[hdrSize], pbSize)) {
-            ErrorLog(ServerProtocolSerializerLog)
-                    << "[" << connectionId_ << "] failed to serialize : " << *msgPtr << std::endl;
-            return;
-        }
+void ServerProtocolSerializer::setOutboundLimits(ClientFrameQueue::Limits const& limits)
+{
+    std::lock_guard<std::mutex> lock(sendQueueLock_);
+    sendQueue_.limits(limits);
+}
 
-        buffer.resize(hdrSize + pbSize);
+ClientFrameQueue::Stats ServerProtocolSerializer::outboundStats()
+{
+    std::lock_guard<std::mutex> lock(sendQueueLock_);
+    return sendQueue_.stats();
+}
+
+ServerRequestScheduler::Stats ServerProtocolSerializer::requestStats()
+{
+    return scheduler_.stats(connectionId_);
+}
+
+void ServerProtocolSerializer::onCompression(CompanEdgeProtocol::VsCompression const& request)
+{
+    FunctionArgLog(ServerProtocolSerializerLog) << " [" << connectionId_ << "]" << std::endl;
+
+    ClientMessagePtr msgPtr = serverProtocolHandler_->arenas()->make<CompanEdgeProtocol::ClientMessage>();
+    ClientFrameCompressor::Ptr compressor = ClientFrameCompressor::negotiate(ws_.frameCompressor(), request, *msgPtr);
+
+    {
+        std::lock_guard<std::mutex> lock(sendQueueLock_);
+        negotiated_ = compressor;
+    }
+
+    queueFrame(std::make_shared<ClientMessageFrame>(msgPtr));
+}
+
+void ServerProtocolSerializer::queueFrame(ClientMessageFrame::Ptr framePtr)
+{
+    ClientFrameQueue::PushResult result;
+    ClientFrameQueue::Stats stats;
+
+    {
+        std::lock_guard<std::mutex> lock(sendQueueLock_);
+        result = sendQueue_.push(framePtr);
+
+        // the first entry kicks off writing, doSendQueue burns down the queue
+        if (result == ClientFrameQueue::Queued && sendQueue_.size() == 1)
+            boost::asio::post(sendStrand_, WeakBind(&ServerProtocolSerializer::doSendQueue, shared_from_this()));
+
+        if (result == ClientFrameQueue::Queued) return;
+
+        stats = sendQueue_.stats();
+    }
+
+    if (result == ClientFrameQueue::Conflated) {
+        if (stats.conflated == 1)
+            WarnLog(ServerProtocolSerializerLog) << "[" << connectionId_ << "] slow consumer, conflating value changes"
+                                                 << " - pending " << stats.pending << std::endl;
+        return;
+    }
+
+    // last resort, the client can't keep up even with it's changes conflated
+    if (stats.overflows == 1) {
+        ErrorLog(ServerProtocolSerializerLog) << "[" << connectionId_ << "] outbound limit reached, closing - pending "
+                                              << stats.pending << " conflated " << stats.conflated << std::endl;
+        requestClose();
+    }
+}
+
+void ServerProtocolSerializer::doSendQueue()
+{
+    FunctionArgLog(ServerProtocolSerializerLog) << " [" << connectionId_ << "]" << std::endl;
+
+    ClientMessageFrame::Ptr framePtr;
+
+    {
+        std::lock_guard<std::mutex> lock(sendQueueLock_);
+        framePtr = sendQueue_.pop();
+    }
+
+    if (!framePtr || !isConnected()) return;
+
+    ClientMessagePtr msgPtr = framePtr->message();
+
+    // a streamed response produces it's next chunk once this one is written, which
+    //  a connection queueing it's sends does after sendData returns
+    WrittenFunction onWritten;
+    if (serverProtocolHandler_->isStreamChunk(msgPtr)) {
+        auto drained = WeakBind(&ServerProtocolHandler::onMessageDrained, serverProtocolHandler_, msgPtr);
+        onWritten = [&ctx = ctx_, drained]() { boost::asio::post(ctx, drained); };
+    }
+
+    // the first connection to send the frame encodes it, the rest share the buffer
+    ClientMessageFrame::BufferPtr encoded = framePtr->encoded(bNewFraming_, compressor_.get());
+    if (encoded && !encoded->empty() && sendData(boost::asio::buffer(encoded->data(), encoded->size()), onWritten)) {
+        // the client decompresses the frames that follow
+        if (msgPtr->has_vscompressionresult()) {
+            std::lock_guard<std::mutex> lock(sendQueueLock_);
+            compressor_ = negotiated_;
+        }
+    } else {
+        ErrorLog(ServerProtocolSerializerLog) << "[" << connectionId_ << "] failed to send frame" << std::endl;
     }
 
-    sendData(std::move(buffer));
+    std::lock_guard<std::mutex> lock(sendQueueLock_);
+    if (!sendQueue_.empty())
+        boost::asio::post(sendStrand_, WeakBind(&ServerProtocolSerializer::doSendQueue, shared_from_this()));
 }
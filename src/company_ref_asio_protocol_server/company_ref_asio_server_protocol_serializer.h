@@ -7,8 +7,11 @@
 #define __company_ref_ASIO_SERVER_PROTOCOL_SERIALIZER_H__
 
 #include "company_ref_asio_server_protocol_handler.h"
+#include "company_ref_asio_server_request_scheduler.h"
 
 #include <company_ref_asio/company_ref_asio_msg_handler.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_client_frame_compressor.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_client_frame_queue.h>
 
 #include <functional>
 #include <memory>
@@ -26,6 +29,7 @@
 namespace CompanEdgeProtocol {
 class ServerMessage;
 class ClientMessage;
+class VsCompression;
 } // namespace CompanEdgeProtocol
 
 namespace Compan{
@@ -51,7 +55,8 @@ public:
             boost::asio::io_context& ctx,
             VariantValueStore& variantValueStore,
             DmoContainer& dmo,
-            std::mutex&,
+            VariantContainerLocks&,
+            ServerRequestScheduler& scheduler,
             uint32_t connectionId);
 
     virtual ~ServerProtocolSerializer();
@@ -66,12 +71,46 @@ public:
     void onDecodeServerMessage(char const* data, size_t const len);
     void onEncodeClientMessage(ClientMessagePtr rspMsg);
 
+    /// Sends a frame shared with other connections, encoded at most once per framing
+    void onEncodeClientFrame(ClientMessageFrame::Ptr framePtr);
+
+    /// Sets the outbound limits, frames already queued are kept
+    void setOutboundLimits(ClientFrameQueue::Limits const& limits);
+
+    /// Returns the outbound queue counters
+    ClientFrameQueue::Stats outboundStats();
+
+    /// Returns the request scheduling counters
+    ServerRequestScheduler::Stats requestStats();
+
+protected:
+    /// Answers the client's VsCompression, compression starts once the answer is written
+    void onCompression(CompanEdgeProtocol::VsCompression const& request);
+
+    /// Queues a frame, closes the connection if the outbound limit is reached
+    void queueFrame(ClientMessageFrame::Ptr framePtr);
+
+    /// Writes the pending frames, runs on sendStrand_
+    void doSendQueue();
+
 private:
     boost::asio::io_context& ctx_;
     uint32_t connectionId_;
 
+    VariantValueStore& ws_;
+    ServerRequestScheduler& scheduler_; //!< shared with the connections on ctx_
+
+    boost::asio::io_context::strand sendStrand_;
+
+    std::mutex sendQueueLock_;
+    ClientFrameQueue sendQueue_; //!< bounded, a slow consumer has it's value changes conflated
+    ClientFrameCompressor::Ptr negotiated_; //!< guarded by sendQueueLock_, used once the result is written
+
+    ClientFrameCompressor::Ptr compressor_; //!< sendStrand_ only
+
     ServerProtocolHandler::Ptr serverProtocolHandler_;
     SignalScopedConnection onEncodeClientMessage_;
+    SignalScopedConnection onEncodeClientFrame_;
 
     std::mutex bufferLock_;
     std::string buffer_;
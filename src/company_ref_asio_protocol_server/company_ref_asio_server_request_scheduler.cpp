@@ -0,0 +1,239 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_asio_server_request_scheduler.cpp
+ @brief Fair scheduling of decoded requests across connections
+ */
+#include "company_ref_asio_server_request_scheduler.h"
+
+#include <company_ref_protocol/company_ref_protocol.pb.h>
+#include <Compan_logger/Compan_logger.h>
+
+#include <boost/asio/post.hpp>
+
+#include <algorithm>
+
+using namespace Compan::Edge;
+
+CompanLogger ServerRequestSchedulerLog("server.protocol.scheduler", LogLevel::Information);
+
+ServerRequestScheduler::ServerRequestScheduler(boost::asio::io_context& ctx, size_t const quantum)
+    : ctx_(ctx)
+    , quantum_(std::max<size_t>(1, quantum))
+    , priorityRun_(0)
+    , pending_(0)
+{
+}
+
+ServerRequestScheduler::Lane ServerRequestScheduler::lane(CompanEdgeProtocol::ServerMessage const& msg)
+{
+    // anything that writes, or reads a subtree, waits its turn
+    if (msg.has_vssetvalue() || msg.has_vsmultiset() || msg.has_valuechanged() || msg.has_valueremoved()
+        || msg.has_vsgetobject() || msg.has_vsgetall())
+        return Normal;
+
+    if (msg.has_vsmultiget() && msg.vsmultiget().ids_size() > SmallReadIds) return Normal;
+
+    // VsGetValue, small VsMultiGet, VsSync, VsSubscribe and VsUnsubscribe
+    return Priority;
+}
+
+void ServerRequestScheduler::schedule(uint32_t const connectionId, Lane const lane, size_t const cost, Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto queueIter = queues_.find(connectionId);
+        if (queueIter == queues_.end()) {
+            ConnectionQueue queue;
+            queue.deficit = 0;
+            queue.credited = false;
+            queue.stats = {0, 0, 0, 0, 0, std::chrono::microseconds(0), std::chrono::microseconds(0)};
+
+            queueIter = queues_.emplace(connectionId, std::move(queue)).first;
+        }
+
+        ConnectionQueue& queue(queueIter->second);
+
+        // a read may not overtake the connection's waiting writes
+        Lane const actual = queue.lanes[Normal].empty() ? lane : Normal;
+
+        if (queue.lanes[actual].empty()) active_[actual].push_back(connectionId);
+        queue.lanes[actual].push_back({std::move(task), cost, Clock::now()});
+
+        ++queue.stats.queued;
+        ++queue.stats.pending;
+        queue.stats.highWater = std::max(queue.stats.highWater, queue.stats.pending);
+
+        ++pending_;
+    }
+
+    boost::asio::post(ctx_, [this] { dispatch(); });
+}
+
+void ServerRequestScheduler::remove(uint32_t const connectionId)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto queueIter = queues_.find(connectionId);
+    if (queueIter == queues_.end()) return;
+
+    DebugLog(ServerRequestSchedulerLog) << "[" << connectionId << "] remove, dropping "
+                                        << queueIter->second.stats.pending << " requests" << std::endl;
+
+    pending_ -= queueIter->second.stats.pending;
+
+    // stale active_ entries are skipped when they come up
+    queues_.erase(queueIter);
+}
+
+ServerRequestScheduler::Stats ServerRequestScheduler::stats(uint32_t const connectionId)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto queueIter = queues_.find(connectionId);
+    if (queueIter == queues_.end())
+        return {0, 0, 0, 0, 0, std::chrono::microseconds(0), std::chrono::microseconds(0)};
+
+    return queueIter->second.stats;
+}
+
+void ServerRequestScheduler::dispatch()
+{
+    Request request;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        Lane lane;
+        ConnectionQueue* queue = next(request, lane);
+
+        // the connection went away, its requests with it
+        if (!queue) return;
+
+        auto const waited = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - request.queued);
+
+        Stats& stats(queue->stats);
+        ++stats.dispatched;
+        if (lane == Priority) ++stats.prioritized;
+        --stats.pending;
+        stats.waited += waited;
+        stats.maxWait = std::max(stats.maxWait, waited);
+
+        --pending_;
+    }
+
+    request.task();
+}
+
+ServerRequestScheduler::ConnectionQueue* ServerRequestScheduler::next(Request& request, Lane& lane)
+{
+    bool const normalWaiting = !active_[Normal].empty();
+
+    if (!normalWaiting || priorityRun_ < PriorityBurst) {
+        lane = Priority;
+        if (ConnectionQueue* queue = nextPriority(request)) {
+            ++priorityRun_;
+            return queue;
+        }
+    }
+
+    priorityRun_ = 0;
+
+    if (ConnectionQueue* queue = nextNormal(request, lane)) return queue;
+
+    // the burst limit only applies while normal requests wait
+    lane = Priority;
+    return nextPriority(request);
+}
+
+ServerRequestScheduler::ConnectionQueue* ServerRequestScheduler::nextPriority(Request& request)
+{
+    std::deque<uint32_t>& active(active_[Priority]);
+
+    while (!active.empty()) {
+        uint32_t const connectionId = active.front();
+        active.pop_front();
+
+        auto queueIter = queues_.find(connectionId);
+        if (queueIter == queues_.end() || queueIter->second.lanes[Priority].empty()) continue;
+
+        ConnectionQueue& queue(queueIter->second);
+        std::deque<Request>& lane(queue.lanes[Priority]);
+
+        request = std::move(lane.front());
+        lane.pop_front();
+
+        // one request per turn
+        if (!lane.empty()) active.push_back(connectionId);
+
+        return &queue;
+    }
+
+    return nullptr;
+}
+
+ServerRequestScheduler::ConnectionQueue* ServerRequestScheduler::nextNormal(Request& request, Lane& lane)
+{
+    std::deque<uint32_t>& active(active_[Normal]);
+
+    while (!active.empty()) {
+        uint32_t const connectionId = active.front();
+
+        auto queueIter = queues_.find(connectionId);
+        if (queueIter == queues_.end() || queueIter->second.lanes[Normal].empty()) {
+            active.pop_front();
+            continue;
+        }
+
+        ConnectionQueue& queue(queueIter->second);
+
+        // the priority requests were queued first, a write may not overtake them
+        std::deque<Request>& priority(queue.lanes[Priority]);
+        if (!priority.empty()) {
+            request = std::move(priority.front());
+            priority.pop_front();
+
+            if (priority.empty()) {
+                std::deque<uint32_t>& priorityActive(active_[Priority]);
+                priorityActive.erase(
+                        std::remove(priorityActive.begin(), priorityActive.end(), connectionId),
+                        priorityActive.end());
+            }
+
+            lane = Priority;
+            return &queue;
+        }
+
+        std::deque<Request>& normal(queue.lanes[Normal]);
+
+        if (!queue.credited) {
+            queue.deficit += quantum_;
+            queue.credited = true;
+        }
+
+        if (normal.front().cost > queue.deficit) {
+            // out of credit, the rest is kept for its next turn
+            queue.credited = false;
+            active.pop_front();
+            active.push_back(connectionId);
+            continue;
+        }
+
+        queue.deficit -= normal.front().cost;
+
+        request = std::move(normal.front());
+        normal.pop_front();
+
+        // an idle connection doesn't bank credit
+        if (normal.empty()) {
+            queue.deficit = 0;
+            queue.credited = false;
+            active.pop_front();
+        }
+
+        lane = Normal;
+        return &queue;
+    }
+
+    return nullptr;
+}
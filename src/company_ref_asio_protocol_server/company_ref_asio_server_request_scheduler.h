@@ -0,0 +1,137 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_asio_server_request_scheduler.h
+ @brief Fair scheduling of decoded requests across connections
+ */
+#ifndef __company_ref_ASIO_SERVER_REQUEST_SCHEDULER_H__
+#define __company_ref_ASIO_SERVER_REQUEST_SCHEDULER_H__
+
+#include <boost/asio/io_context.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+namespace CompanEdgeProtocol {
+class ServerMessage;
+} // namespace CompanEdgeProtocol
+
+namespace Compan{
+namespace Edge {
+
+/*!
+ * @brief Orders the decoded requests of the connections sharing an io_context
+ *
+ * Each request still gets its own post to the io_context, which request
+ * runs is decided when the post executes:
+ *
+ * - The priority lane, small reads and sync control messages, goes first,
+ *   round robin across connections. After PriorityBurst requests in a row
+ *   a waiting normal request gets its turn.
+ * - The normal lane is deficit round robin across connections, a request
+ *   costs its encoded size; a connection flooding large VsMultiSet
+ *   requests gets the same share of bytes as everyone else.
+ *
+ * Requests of a connection keep their order; a request only goes to the
+ * priority lane if none of the connection's normal requests are waiting,
+ * and the connection's normal requests only run once it's priority lane,
+ * queued ahead of them, is empty.
+ */
+class ServerRequestScheduler {
+public:
+    using Task = std::function<void()>;
+
+    enum Lane { Normal, Priority, LaneCount };
+
+    /// Per connection counters
+    struct Stats {
+        uint64_t queued;                   //!< requests accepted
+        uint64_t dispatched;               //!< requests run
+        uint64_t prioritized;              //!< requests run from the priority lane
+        size_t pending;                    //!< requests waiting
+        size_t highWater;                  //!< most requests waiting at once
+        std::chrono::microseconds waited;  //!< summed time spent waiting
+        std::chrono::microseconds maxWait; //!< longest wait
+    };
+
+    /// Bytes a connection may dispatch per round
+    static size_t const DefaultQuantum = 16384;
+
+    /// Consecutive priority requests while normal ones wait
+    static size_t const PriorityBurst = 8;
+
+    /// VsMultiGet of up to this many ids is a small read
+    static int const SmallReadIds = 16;
+
+    explicit ServerRequestScheduler(boost::asio::io_context& ctx, size_t const quantum = DefaultQuantum);
+    virtual ~ServerRequestScheduler() = default;
+
+    /// Lane of a request
+    static Lane lane(CompanEdgeProtocol::ServerMessage const& msg);
+
+    /// Queues a request of a connection, cost is its encoded size
+    void schedule(uint32_t const connectionId, Lane const lane, size_t const cost, Task task);
+
+    /// Drops the waiting requests of a connection
+    void remove(uint32_t const connectionId);
+
+    /// Returns the counters of a connection, zeroes if unknown
+    Stats stats(uint32_t const connectionId);
+
+    /// Requests waiting, all connections
+    size_t pending();
+
+protected:
+    ServerRequestScheduler(ServerRequestScheduler const&) = delete;
+    ServerRequestScheduler& operator=(ServerRequestScheduler const&) = delete;
+
+    /// Runs the next request, posted once per scheduled request
+    void dispatch();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Request {
+        Task task;
+        size_t cost;
+        Clock::time_point queued;
+    };
+
+    struct ConnectionQueue {
+        std::deque<Request> lanes[LaneCount];
+        size_t deficit;
+        bool credited; //!< quantum added for the current round
+        Stats stats;
+    };
+
+    /// Takes the next request to run, mutex_ held; nullptr if none are waiting
+    ConnectionQueue* next(Request& request, Lane& lane);
+
+    ConnectionQueue* nextPriority(Request& request);
+    ConnectionQueue* nextNormal(Request& request, Lane& lane);
+
+private:
+    boost::asio::io_context& ctx_;
+    size_t const quantum_;
+
+    std::mutex mutex_;
+    std::unordered_map<uint32_t, ConnectionQueue> queues_;
+    std::deque<uint32_t> active_[LaneCount]; //!< connections with requests waiting, in serving order
+
+    size_t priorityRun_; //!< priority requests run in a row
+    size_t pending_;
+};
+
+inline size_t ServerRequestScheduler::pending()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_;
+}
+
+} // namespace Edge
+} // namespace Compan
+
+#endif // __company_ref_ASIO_SERVER_REQUEST_SCHEDULER_H__
@@ -29,6 +29,63 @@ CompanLogger AebClientLog("client.connection.core", LogLevel::Information);
 
 using namespace Compan::Edge;
 
+namespace {
+/// Sets the request's sequenceNo, returns false if the message isn't a request
+bool setSequenceNo(CompanEdgeProtocol::ServerMessage& msg, uint32_t const sequenceNo)
+{
+    if (msg.has_vssubscribe())
+        msg.mutable_vssubscribe()->set_sequenceno(sequenceNo);
+    else if (msg.has_vsunsubscribe())
+        msg.mutable_vsunsubscribe()->set_sequenceno(sequenceNo);
+    else if (msg.has_vsgetall())
+        msg.mutable_vsgetall()->set_sequenceno(sequenceNo);
+    else if (msg.has_vsgetvalue())
+        msg.mutable_vsgetvalue()->set_sequenceno(sequenceNo);
+    else if (msg.has_vssetvalue())
+        msg.mutable_vssetvalue()->set_sequenceno(sequenceNo);
+    else if (msg.has_vsgetobject())
+        msg.mutable_vsgetobject()->set_sequenceno(sequenceNo);
+    else if (msg.has_vsmultiget())
+        msg.mutable_vsmultiget()->set_sequenceno(sequenceNo);
+    else if (msg.has_vsmultiset())
+        msg.mutable_vsmultiset()->set_sequenceno(sequenceNo);
+    else
+        return false;
+
+    return true;
+}
+
+/// Returns the sequenceNo of a response, 0 if the message isn't one
+uint32_t getSequenceNo(CompanEdgeProtocol::ClientMessage const& msg)
+{
+    if (msg.has_vsresult()) return msg.vsresult().sequenceno();
+    if (msg.has_vsmultigetresult()) return msg.vsmultigetresult().sequenceno();
+    if (msg.has_vsmultisetresult()) return msg.vsmultisetresult().sequenceno();
+
+    return 0;
+}
+
+/// Takes a queue's consumer flag, false if it's held
+bool takeConsumer(std::atomic<bool>& consumer)
+{
+    // pairs with releaseConsumer, a push never goes unseen
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return !consumer.exchange(true);
+}
+
+/// Gives up a queue's consumer flag, true if it was taken back for values pushed meanwhile
+template <typename Queue>
+bool releaseConsumer(std::atomic<bool>& consumer, Queue const& queue)
+{
+    consumer.store(false);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    return queue.pending() && takeConsumer(consumer);
+}
+} // namespace
+
+size_t const CompanEdgeBoostClientBase::QueueBatch(64);
+
 CompanEdgeBoostClientBase::CompanEdgeBoostClientBase(boost::asio::io_context& ioContext)
     : ioContext_(ioContext)
     , readerStrand_(ioContext_)
@@ -36,6 +93,12 @@ CompanEdgeBoostClientBase::CompanEdgeBoostClientBase(boost::asio::io_context& io
     , onClientConnectedSignal_(ioContext)
     , onClientDisconnectedSignal_(ioContext)
     , onClientMessageSignal_(ioContext)
+    , writerStrand_(ioContext_)
+    , writing_(false)
+    , discardWrites_(false)
+    , arenas_(MessageArenaPool::create())
+    , dispatching_(false)
+    , discardReads_(false)
     , bNewFraming_(true)
     , pAecCallbacks_(new AecCallbacks<std::string>(
               {[this]() {
@@ -51,6 +114,7 @@ CompanEdgeBoostClientBase::CompanEdgeBoostClientBase(boost::asio::io_context& io
                        ErrorLog(AebClientLog) << "Received unknown frameId (" << frameId.str() << ')' << std::endl;
                    }
                }}))
+    , sequenceNo_(0)
 {
     Protobuf::instance();
 }
@@ -64,6 +128,7 @@ void CompanEdgeBoostClientBase::connect()
     /// Do clear readBuffer_ here because the application will be crashed if doing it at doClose.
     readBuffer_.erase();
     bNewFraming_ = true;
+    decompressor_.reset();
     doConnect();
 }
 
@@ -81,19 +146,18 @@ void CompanEdgeBoostClientBase::setWantRead(fnWantRead wantRead)
 
 void CompanEdgeBoostClientBase::write(CompanEdgeProtocol::ServerMessage const& msg)
 {
-    FunctionLog(AebClientLog);
-
-    boost::asio::post(ioContext_, [this, msg]() {
-        size_t queueSize = 0;
+    write(CompanEdgeProtocol::ServerMessage(msg));
+}
 
-        {
-            std::lock_guard<std::mutex> lock(serverMutex_);
-            serverQueue_.push(msg);
+void CompanEdgeBoostClientBase::write(CompanEdgeProtocol::ServerMessage&& msg)
+{
+    FunctionLog(AebClientLog);
 
-            queueSize = serverQueue_.size();
-        }
+    // the strand keeps a single producer, whatever thread writes
+    boost::asio::post(writerStrand_, [this, msg = std::move(msg)]() mutable {
+        serverQueue_.push(std::move(msg));
 
-        if (queueSize == 1) asyncDoWrite();
+        if (takeConsumer(writing_)) asyncDoWrite();
     });
 }
 
@@ -112,6 +176,7 @@ void CompanEdgeBoostClientBase::onConnect(boost::system::error_code const& ec)
     }
 
     onClientConnectedSignal_();
+    requestCompression();
     if (fnWantRead_()) doRead();
 }
 
@@ -146,47 +211,151 @@ void CompanEdgeBoostClientBase::onRead(boost::system::error_code const& ec, std:
 
 void CompanEdgeBoostClientBase::parseResponseMessage(char const* data, size_t const len)
 {
-    CompanEdgeProtocol::ClientMessage msg;
-    if (!msg.ParseFromArray(data, len)) {
+    std::shared_ptr<CompanEdgeProtocol::ClientMessage> msgPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
+    if (!msgPtr->ParseFromArray(data, len)) {
         ErrorLog(AebClientLog) << "onRead, parse error - closing connection" << std::endl;
         return doClose();
     }
 
-    size_t queueSize = 0;
-
-    {
-        std::lock_guard<std::mutex> lock(clientMutex_);
-        clientQueue_.push(msg);
+    // negotiated by the transport, listeners never see it
+    if (msgPtr->has_vscompressionresult()) {
+        decompressor_ = ClientFrameCompressor::accept(msgPtr->vscompressionresult());
+        return;
+    }
 
-        queueSize = clientQueue_.size();
+    if (msgPtr->has_compressedmessage() && (!decompressor_ || !decompressor_->expand(*msgPtr))) {
+        ErrorLog(AebClientLog) << "onRead, decompress error - closing connection" << std::endl;
+        return doClose();
     }
 
-    if (queueSize == 1)
+    clientQueue_.push(std::move(msgPtr));
+
+    if (takeConsumer(dispatching_))
         boost::asio::post(ioContext_, std::bind(&CompanEdgeBoostClientBase::doClientQueue, this->shared_from_this()));
 }
 
 void CompanEdgeBoostClientBase::doClientQueue()
 {
-    CompanEdgeProtocol::ClientMessage msg;
-
-    {
-        std::lock_guard<std::mutex> lock(clientMutex_);
+    if (discardReads_.exchange(false)) clientQueue_.clear();
 
-        if (clientQueue_.empty()) { return; }
+    bool wantRead(true);
 
-        msg = clientQueue_.front();
-        clientQueue_.pop();
-    }
+    clientQueue_.consume(
+            [this, &wantRead](std::shared_ptr<CompanEdgeProtocol::ClientMessage>& msgPtr) {
+                completeRequest(*msgPtr);
+                onClientMessageSignal_(*msgPtr);
 
-    onClientMessageSignal_(msg);
+                wantRead = fnWantRead_();
+                return wantRead;
+            },
+            QueueBatch);
 
     /// want read needs to get deprecated, in favor of just calling a cancellation
-    if (!fnWantRead_()) {
+    if (!wantRead) {
+        // the rest waits for the next message
+        dispatching_.store(false);
         doCancel();
         return;
     }
 
-    boost::asio::post(ioContext_, std::bind(&CompanEdgeBoostClientBase::doClientQueue, this->shared_from_this()));
+    // other handlers get their turn between batches
+    if (!clientQueue_.empty() || releaseConsumer(dispatching_, clientQueue_))
+        boost::asio::post(ioContext_, std::bind(&CompanEdgeBoostClientBase::doClientQueue, this->shared_from_this()));
+}
+
+void CompanEdgeBoostClientBase::clearQueues()
+{
+    // the running consumer drops them
+    if (takeConsumer(writing_)) {
+        serverQueue_.clear();
+        if (releaseConsumer(writing_, serverQueue_)) asyncDoWrite();
+    } else {
+        discardWrites_ = true;
+    }
+
+    if (takeConsumer(dispatching_)) {
+        clientQueue_.clear();
+        if (releaseConsumer(dispatching_, clientQueue_))
+            boost::asio::post(
+                    ioContext_, std::bind(&CompanEdgeBoostClientBase::doClientQueue, this->shared_from_this()));
+    } else {
+        discardReads_ = true;
+    }
+}
+
+void CompanEdgeBoostClientBase::requestCompression()
+{
+    // write only clients never receive a large frame
+    if (!fnWantRead_()) return;
+
+    CompanEdgeProtocol::ServerMessage msg;
+    ClientFrameCompressor::makeRequest(msg);
+
+    write(msg);
+}
+
+bool CompanEdgeBoostClientBase::sendRequest(CompanEdgeProtocol::ServerMessage& msg, RequestCompleteCb const& cb)
+{
+    FunctionLog(AebClientLog);
+
+    {
+        std::lock_guard<std::mutex> lock(requestMutex_);
+
+        // 0 is never a request's
+        uint32_t const sequenceNo = ++sequenceNo_ ? sequenceNo_ : ++sequenceNo_;
+        if (!setSequenceNo(msg, sequenceNo)) return false;
+
+        requests_[sequenceNo].cb = cb;
+    }
+
+    write(msg);
+
+    return true;
+}
+
+void CompanEdgeBoostClientBase::completeRequest(CompanEdgeProtocol::ClientMessage const& msg)
+{
+    uint32_t const sequenceNo = getSequenceNo(msg);
+    if (sequenceNo == 0) return;
+
+    OutstandingRequest request;
+
+    {
+        std::lock_guard<std::mutex> lock(requestMutex_);
+
+        auto it = requests_.find(sequenceNo);
+        if (it == requests_.end()) return;
+
+        it->second.response.MergeFrom(msg);
+
+        // streamed, wait for the final chunk
+        if (msg.has_vsresult() && msg.vsresult().more()) return;
+
+        request = std::move(it->second);
+        requests_.erase(it);
+    }
+
+    // default values aren't merged
+    if (request.response.has_vsresult()) request.response.mutable_vsresult()->set_more(false);
+
+    request.cb(boost::system::error_code(), request.response);
+}
+
+void CompanEdgeBoostClientBase::failRequests(boost::system::error_code const& ec)
+{
+    std::unordered_map<uint32_t, OutstandingRequest> requests;
+
+    {
+        std::lock_guard<std::mutex> lock(requestMutex_);
+        requests.swap(requests_);
+    }
+
+    if (requests.empty()) return;
+
+    DebugLog(AebClientLog) << __FUNCTION__ << ": " << requests.size() << ", " << ec.message() << std::endl;
+
+    CompanEdgeProtocol::ClientMessage const emptyMsg;
+    for (auto& request : requests) request.second.cb(ec, emptyMsg);
 }
 
 template <typename T>
@@ -223,15 +392,10 @@ void CompanEdgeBoostClient<T>::doClose()
         return;
     }
 
-    {
-        std::lock_guard<std::mutex> lock(serverMutex_);
-        while (!serverQueue_.empty()) serverQueue_.pop();
-    }
+    clearQueues();
 
-    {
-        std::lock_guard<std::mutex> lock(clientMutex_);
-        while (!clientQueue_.empty()) clientQueue_.pop();
-    }
+    // their responses are lost with the connection
+    failRequests(boost::asio::error::connection_aborted);
 }
 
 template <typename T>
@@ -240,6 +404,7 @@ void CompanEdgeBoostClient<T>::doClientConnected()
     FunctionLog(AebClientLog);
 
     onClientConnectedSignal_();
+    requestCompression();
     if (fnWantRead_()) doRead();
 }
 
@@ -266,41 +431,42 @@ void CompanEdgeBoostClient<T>::doWrite()
 {
     FunctionLog(AebClientLog);
 
-    if (!socket_.is_open()) return doClose();
-
-    CompanEdgeProtocol::ServerMessage msg;
-
-    size_t queueSize = 0;
-
-    {
-        std::lock_guard<std::mutex> lock(serverMutex_);
+    if (discardWrites_.exchange(false)) serverQueue_.clear();
 
-        if (serverQueue_.empty()) { return; }
+    if (!socket_.is_open()) {
+        serverQueue_.clear();
+        writing_.store(false);
+        return doClose();
+    }
 
-        msg = serverQueue_.front();
-        serverQueue_.pop();
+    // a batch of frames goes out in a single write
+    writeBuffer_.clear();
 
-        queueSize = serverQueue_.size();
-    }
+    serverQueue_.consume(
+            [this](CompanEdgeProtocol::ServerMessage& msg) {
+                msg.SerializeToString(&payload_);
 
-    std::string reqBuffer;
-    msg.SerializeToString(&reqBuffer);
+                if (bNewFraming_)
+                    writeBuffer_.append(AECv10::makeHeader<std::string>(payload_.cbegin(), payload_.cend()));
+                else
+                    writeBuffer_.append(AECv09::makeHeader<std::string>(payload_.cbegin(), payload_.cend()));
 
-    if (bNewFraming_) {
-        reqBuffer.insert(0, AECv10::makeHeader<std::string>(reqBuffer.cbegin(), reqBuffer.cend()));
-    } else {
-        reqBuffer.insert(0, AECv09::makeHeader<std::string>(reqBuffer.cbegin(), reqBuffer.cend()));
-    }
+                writeBuffer_.append(payload_);
+                return true;
+            },
+            QueueBatch);
 
     boost::system::error_code ec;
 
-    boost::asio::write(socket_, boost::asio::buffer(reqBuffer.data(), reqBuffer.size()), ec);
+    if (!writeBuffer_.empty()) boost::asio::write(socket_, boost::asio::buffer(writeBuffer_), ec);
     if (ec) {
         DebugLog(AebClientLog) << " Closing connection" << std::endl;
+        serverQueue_.clear();
+        writing_.store(false);
         return doClose();
     }
 
-    if (queueSize) asyncDoWrite();
+    if (!serverQueue_.empty() || releaseConsumer(writing_, serverQueue_)) asyncDoWrite();
 }
 
 template <typename T>
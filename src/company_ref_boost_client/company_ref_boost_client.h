@@ -7,18 +7,29 @@
 #ifndef __company_ref_BOOST_CLIENT_company_ref_BOOST_CLIENT_H__
 #define __company_ref_BOOST_CLIENT_company_ref_BOOST_CLIENT_H__
 
+#include "company_ref_boost_spsc_queue.h"
+
 #include <company_ref_protocol/company_ref_protocol.pb.h>
 #include <company_ref_utils/company_ref_signals.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_client_frame_compressor.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_message_arena.h>
 
+#include <atomic>
 #include <functional>
-#include <queue>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
 #include <boost/asio/basic_stream_socket.hpp>
+#include <boost/asio/error.hpp>
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/io_context_strand.hpp>
+#include <boost/asio/post.hpp>
 
 #include <memory>
+#include <type_traits>
 
 namespace Compan{
 namespace Edge {
@@ -43,6 +54,13 @@ public:
     /// Signal for when the client has received a CompanEdgeProtocol::ClientMessage
     using ClientMessageSignal = SignalAsio<void(CompanEdgeProtocol::ClientMessage const&)>;
 
+    /// Completion signature of asyncRequest, the error is set if the response is lost
+    using RequestSignature = void(boost::system::error_code, CompanEdgeProtocol::ClientMessage);
+    using RequestCompleteCb =
+            std::function<void(boost::system::error_code const&, CompanEdgeProtocol::ClientMessage const&)>;
+
+    static size_t const QueueBatch; //!< messages taken from a queue per handler invocation
+
 public:
     CompanEdgeBoostClientBase(boost::asio::io_context&);
     virtual ~CompanEdgeBoostClientBase();
@@ -62,8 +80,28 @@ public:
     /// Transmits a CompanEdgeProtocol::ServerMessage to the server
     virtual void write(CompanEdgeProtocol::ServerMessage const&);
 
+    /// Transmits a CompanEdgeProtocol::ServerMessage to the server, without a copy
+    void write(CompanEdgeProtocol::ServerMessage&&);
+
     boost::asio::io_context& getIoContext();
 
+    /*!
+     * Sends a request, completed by the response carrying it's sequenceNo
+     *
+     * Takes any asio completion token, with boost::asio::use_awaitable the
+     * request is co_awaited; concurrent requests pipeline on the connection.
+     * Streamed VsResults are merged into a single response.
+     *
+     * Completes with connection_aborted if the connection is lost, and
+     * invalid_argument if the message isn't a request.
+     *
+     * @param msg   VsSubscribe, VsUnsubscribe, VsGetAll, VsGetValue, VsSetValue,
+     *              VsGetObject, VsMultiGet or VsMultiSet request
+     * @param token Completion token, RequestSignature
+     */
+    template <typename CompletionToken>
+    auto asyncRequest(CompanEdgeProtocol::ServerMessage msg, CompletionToken&& token);
+
 public:
     /// Connects a listener to receive a Connection notification
     SignalConnection connectClientConnectedListener(ClientConnectedSignal::SlotType const&);
@@ -91,8 +129,24 @@ protected:
 
     void parseResponseMessage(char const* data, size_t const len);
 
+    /// Hands a batch of received messages to the listeners
     void doClientQueue();
 
+    /// Drops the queued messages of both directions
+    void clearQueues();
+
+    /// Asks the server to compress large frames, readers only
+    void requestCompression();
+
+    /// Assigns the request's sequenceNo and writes it, returns false if the message isn't a request
+    bool sendRequest(CompanEdgeProtocol::ServerMessage& msg, RequestCompleteCb const& cb);
+
+    /// Completes the request with the response's sequenceNo
+    void completeRequest(CompanEdgeProtocol::ClientMessage const& msg);
+
+    /// Completes all outstanding requests with the error
+    void failRequests(boost::system::error_code const& ec);
+
 protected:
     boost::asio::io_context& ioContext_;
     boost::asio::io_context::strand readerStrand_; //!< used by doRead
@@ -103,14 +157,33 @@ protected:
     ClientConnectedSignal onClientDisconnectedSignal_;
     ClientMessageSignal onClientMessageSignal_;
 
-    std::mutex serverMutex_;
-    std::queue<CompanEdgeProtocol::ServerMessage> serverQueue_;
+    // each queue has a single producer and consumer, the consumer is whoever holds the queue's flag
+    boost::asio::io_context::strand writerStrand_;              //!< serverQueue_'s producer
+    SpscQueue<CompanEdgeProtocol::ServerMessage> serverQueue_;  //!< messages moved in, written by doWrite
+    std::atomic<bool> writing_;                                 //!< doWrite is scheduled or running
+    std::atomic<bool> discardWrites_;                           //!< closed while doWrite was running
+    std::string writeBuffer_;                                   //!< a batch of frames, doWrite only
+    std::string payload_;                                       //!< a frame's message, doWrite only
+
+    MessageArenaPool::Ptr const arenas_; //!< received messages are parsed into a recycled arena
 
-    std::mutex clientMutex_;
-    std::queue<CompanEdgeProtocol::ClientMessage> clientQueue_;
+    SpscQueue<std::shared_ptr<CompanEdgeProtocol::ClientMessage>> clientQueue_; //!< readerStrand_ produces
+    std::atomic<bool> dispatching_;   //!< doClientQueue is scheduled or running
+    std::atomic<bool> discardReads_;  //!< closed while doClientQueue was running
 
     bool bNewFraming_;
     std::unique_ptr<AecCallbacks<std::string>> pAecCallbacks_; //!< Parser callbacks
+
+    ClientFrameCompressor::Ptr decompressor_; //!< set by the server's VsCompressionResult, readerStrand_ only
+
+    struct OutstandingRequest {
+        RequestCompleteCb cb;
+        CompanEdgeProtocol::ClientMessage response; //!< streamed chunks are merged
+    };
+
+    std::mutex requestMutex_;
+    uint32_t sequenceNo_;                                      //!< guarded by requestMutex_
+    std::unordered_map<uint32_t, OutstandingRequest> requests_; //!< by sequenceNo, guarded by requestMutex_
 };
 
 template <typename T>
@@ -142,6 +215,30 @@ inline boost::asio::io_context& CompanEdgeBoostClientBase::getIoContext()
 {
     return ioContext_;
 }
+template <typename CompletionToken>
+auto CompanEdgeBoostClientBase::asyncRequest(CompanEdgeProtocol::ServerMessage msg, CompletionToken&& token)
+{
+    return boost::asio::async_initiate<CompletionToken, RequestSignature>(
+            [this](auto handler, CompanEdgeProtocol::ServerMessage msg) {
+                // asio handlers may be move only
+                using HandlerType = typename std::decay<decltype(handler)>::type;
+                std::shared_ptr<HandlerType> handlerPtr(std::make_shared<HandlerType>(std::move(handler)));
+
+                auto executor = boost::asio::get_associated_executor(*handlerPtr, ioContext_.get_executor());
+
+                RequestCompleteCb cb = [handlerPtr, executor](
+                                               boost::system::error_code const& ec,
+                                               CompanEdgeProtocol::ClientMessage const& rspMsg) {
+                    boost::asio::post(executor, [handlerPtr, ec, rspMsg]() mutable {
+                        std::move(*handlerPtr)(ec, std::move(rspMsg));
+                    });
+                };
+
+                if (!sendRequest(msg, cb)) cb(boost::asio::error::invalid_argument, CompanEdgeProtocol::ClientMessage());
+            },
+            token,
+            std::move(msg));
+}
 inline SignalConnection CompanEdgeBoostClientBase::connectClientConnectedListener(
         ClientConnectedSignal::SlotType const& cb)
 {
@@ -0,0 +1,203 @@
+/**
+  Copyright © 2024 COMPAN REF
+  @file company_ref_boost_spsc_queue.h
+  @brief CompanEdge Boost - single producer, single consumer queue
+*/
+
+#ifndef __company_ref_BOOST_CLIENT_company_ref_BOOST_SPSC_QUEUE_H__
+#define __company_ref_BOOST_CLIENT_company_ref_BOOST_SPSC_QUEUE_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace Compan{
+namespace Edge {
+
+/*!
+ * @brief Bounded lock free ring between one producer and one consumer
+ *
+ * Values are moved in and out of preallocated slots. A push never fails;
+ * past a full ring values spill to a locked overflow, and keep spilling
+ * until the consumer has taken them, so the order is kept.
+ *
+ * Either role may change threads as long as it's handed over with
+ * acquire/release ordering, as an asio strand or handler chain does.
+ */
+template <typename T>
+class SpscQueue {
+public:
+    static size_t const DefaultCapacity = 1024;
+
+    /// capacity is rounded up to a power of 2
+    explicit SpscQueue(size_t const capacity = DefaultCapacity);
+
+    SpscQueue(SpscQueue const&) = delete;
+    SpscQueue& operator=(SpscQueue const&) = delete;
+
+    /// Producer only
+    void push(T&& value);
+
+    /*!
+     * Consumer only, takes up to max values in order
+     *
+     * @param fn    called with each value, returns false to stop after it
+     * @returns number of values taken
+     */
+    template <typename Function>
+    size_t consume(Function&& fn, size_t const max);
+
+    /// Consumer only, drops all values
+    size_t clear();
+
+    /// Consumer only
+    bool empty() const;
+
+    /// Any thread, whether values wait to be consumed; the consumer's own are only seen by empty()
+    bool pending() const;
+
+    size_t capacity() const;
+
+    /// Values that found the ring full
+    uint64_t spilled() const;
+
+private:
+    static size_t roundUp(size_t const capacity);
+
+private:
+    std::vector<T> slots_;
+    size_t const mask_;
+
+    alignas(64) std::atomic<size_t> head_; //!< next slot written, producer
+    alignas(64) std::atomic<size_t> tail_; //!< next slot read, consumer
+
+    alignas(64) std::atomic<bool> spilling_; //!< set by the producer, cleared by the consumer
+    std::mutex spillMutex_;
+    std::deque<T> spill_;          //!< guarded by spillMutex_
+    std::deque<T> spillConsuming_; //!< taken from spill_, consumer only
+    std::atomic<uint64_t> spilled_;
+};
+
+template <typename T>
+SpscQueue<T>::SpscQueue(size_t const capacity)
+    : slots_(roundUp(capacity))
+    , mask_(slots_.size() - 1)
+    , head_(0)
+    , tail_(0)
+    , spilling_(false)
+    , spilled_(0)
+{
+}
+
+template <typename T>
+void SpscQueue<T>::push(T&& value)
+{
+    if (!spilling_.load(std::memory_order_acquire)) {
+        size_t const head = head_.load(std::memory_order_relaxed);
+
+        if (head - tail_.load(std::memory_order_acquire) < slots_.size()) {
+            slots_[head & mask_] = std::move(value);
+            head_.store(head + 1, std::memory_order_release);
+            return;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(spillMutex_);
+    spill_.push_back(std::move(value));
+    spilling_.store(true, std::memory_order_release);
+    spilled_.fetch_add(1, std::memory_order_relaxed);
+}
+
+template <typename T>
+template <typename Function>
+size_t SpscQueue<T>::consume(Function&& fn, size_t const max)
+{
+    size_t count(0);
+
+    while (count < max) {
+        // spilled values are older than anything pushed since
+        if (!spillConsuming_.empty()) {
+            T value(std::move(spillConsuming_.front()));
+            spillConsuming_.pop_front();
+
+            ++count;
+            if (!fn(value)) break;
+            continue;
+        }
+
+        size_t const tail = tail_.load(std::memory_order_relaxed);
+        if (tail != head_.load(std::memory_order_acquire)) {
+            T value(std::move(slots_[tail & mask_]));
+            tail_.store(tail + 1, std::memory_order_release);
+
+            ++count;
+            if (!fn(value)) break;
+            continue;
+        }
+
+        // the ring is drained, only then are the spilled values next
+        if (!spilling_.load(std::memory_order_acquire)) break;
+
+        // it may have filled up before the producer spilled
+        if (tail != head_.load(std::memory_order_acquire)) continue;
+
+        std::lock_guard<std::mutex> lock(spillMutex_);
+        spillConsuming_.swap(spill_);
+        spilling_.store(false, std::memory_order_release);
+    }
+
+    return count;
+}
+
+template <typename T>
+size_t SpscQueue<T>::clear()
+{
+    return consume([](T&) { return true; }, SIZE_MAX);
+}
+
+template <typename T>
+bool SpscQueue<T>::empty() const
+{
+    return spillConsuming_.empty()
+           && tail_.load(std::memory_order_relaxed) == head_.load(std::memory_order_acquire)
+           && !spilling_.load(std::memory_order_acquire);
+}
+
+template <typename T>
+bool SpscQueue<T>::pending() const
+{
+    return tail_.load(std::memory_order_acquire) != head_.load(std::memory_order_acquire)
+           || spilling_.load(std::memory_order_acquire);
+}
+
+template <typename T>
+size_t SpscQueue<T>::capacity() const
+{
+    return slots_.size();
+}
+
+template <typename T>
+uint64_t SpscQueue<T>::spilled() const
+{
+    return spilled_.load(std::memory_order_relaxed);
+}
+
+template <typename T>
+size_t SpscQueue<T>::roundUp(size_t const capacity)
+{
+    size_t size(1);
+    while (size < capacity) size <<= 1;
+
+    return size;
+}
+
+template <typename T>
+size_t const SpscQueue<T>::DefaultCapacity;
+
+} // namespace Edge
+} // namespace Compan
+
+#endif /*__company_ref_BOOST_CLIENT_company_ref_BOOST_SPSC_QUEUE_H__*/
@@ -0,0 +1,42 @@
+/**
+  Copyright © 2024 COMPAN REF
+  @file company_ref_boost_broadcast_groups.h
+  @brief CompanEdge Boost Server - named groups of connections
+*/
+
+#ifndef __company_ref_BOOST_BROADCAST_GROUPS_H__
+#define __company_ref_BOOST_BROADCAST_GROUPS_H__
+
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_client_frame.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Compan{
+namespace Edge {
+
+/*!
+ * @brief Named groups of connections
+ *
+ * A frame sent to a group is shared by it's members, it is encoded
+ * once per framing whatever the size of the group.
+ */
+class CompanEdgeBoostBroadcastGroups {
+public:
+    virtual ~CompanEdgeBoostBroadcastGroups() = default;
+
+    /// Adds a connection to a group, false if the connection is unknown
+    virtual bool joinGroup(std::string const& group, uint32_t const connectionId) = 0;
+
+    /// Removes a connection from a group
+    virtual void leaveGroup(std::string const& group, uint32_t const connectionId) = 0;
+
+    /// Sends a frame to every connection of a group, returns the number of connections
+    virtual size_t broadcast(std::string const& group, ClientMessageFrame::Ptr framePtr) = 0;
+};
+
+} // namespace Edge
+} // namespace Compan
+
+#endif // __company_ref_BOOST_BROADCAST_GROUPS_H__
@@ -10,11 +10,51 @@ using namespace Compan::Edge;
 
 CompanEdgeBoostMessageHandler::CompanEdgeBoostMessageHandler(boost::asio::io_context& ctx, uint32_t const connectionId)
     : connectionId_(connectionId)
+    , arenas_(MessageArenaPool::create())
     , onClientMessageSignal_(ctx)
+    , onClientFrameSignal_(ctx)
+    , groups_(nullptr)
 {
 }
 
 void CompanEdgeBoostMessageHandler::disconnect()
 {
     onClientMessageSignal_.disconnectAll();
+    onClientFrameSignal_.disconnectAll();
+}
+
+void CompanEdgeBoostMessageHandler::onMessageDrained(ClientMessagePtr)
+{
+}
+
+ClientFrameCompressor::Ptr CompanEdgeBoostMessageHandler::frameCompressor()
+{
+    return nullptr;
+}
+
+void CompanEdgeBoostMessageHandler::sendClientFrame(ClientMessageFrame::Ptr framePtr)
+{
+    if (!framePtr) return;
+
+    if (onClientFrameSignal_.empty())
+        onClientMessageSignal_(framePtr->message());
+    else
+        onClientFrameSignal_(framePtr);
+}
+
+bool CompanEdgeBoostMessageHandler::joinGroup(std::string const& group)
+{
+    CompanEdgeBoostBroadcastGroups* groups = groups_;
+    return groups && groups->joinGroup(group, connectionId_);
+}
+
+void CompanEdgeBoostMessageHandler::leaveGroup(std::string const& group)
+{
+    if (CompanEdgeBoostBroadcastGroups* groups = groups_) groups->leaveGroup(group, connectionId_);
+}
+
+size_t CompanEdgeBoostMessageHandler::sendGroupFrame(std::string const& group, ClientMessageFrame::Ptr framePtr)
+{
+    CompanEdgeBoostBroadcastGroups* groups = groups_;
+    return groups ? groups->broadcast(group, framePtr) : 0;
 }
@@ -7,12 +7,18 @@
 #ifndef __company_ref_BOOST_MESSAGE_HANDLER_H__
 #define __company_ref_BOOST_MESSAGE_HANDLER_H__
 
+#include "company_ref_boost_broadcast_groups.h"
+
 #include <company_ref_dmo/company_ref_dmo_container.h>
 #include <company_ref_protocol/company_ref_protocol.pb.h>
 #include <company_ref_variant_valuestore/company_ref_variant_valuestore.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_client_frame.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_client_frame_compressor.h>
 #include <company_ref_variant_valuestore/company_ref_variant_valuestore_hashtoken_map.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_message_arena.h>
 
 #include <company_ref_utils/company_ref_signals.h>
+#include <atomic>
 #include <functional>
 #include <map>
 #include <queue>
@@ -36,6 +42,9 @@ public:
     /// Callback function to signal message processing has completed
     using ClientMessageSignal = SignalAsio<void(ClientMessagePtr)>;
 
+    /// Callback function for value changes shared with other connections
+    using ClientFrameSignal = SignalAsio<void(ClientMessageFrame::Ptr)>;
+
     CompanEdgeBoostMessageHandler(CompanEdgeBoostMessageHandler const&) = delete;
     CompanEdgeBoostMessageHandler& operator=(CompanEdgeBoostMessageHandler const&) = delete;
 
@@ -55,20 +64,68 @@ public:
     /// Request message handler
     virtual void handleMessage(CompanEdgeProtocol::ServerMessage const& requestMessage) = 0;
 
+    /// Notification that a response message has been written to the socket
+    virtual void onMessageDrained(ClientMessagePtr);
+
+    /// Compressor offered to clients asking for compression, nullptr if frames aren't compressed
+    virtual ClientFrameCompressor::Ptr frameCompressor();
+
+    /// Arenas of the connection's requests and responses
+    MessageArenaPool::Ptr const& arenas() const;
+
     /// Sets the completion callback function
     SignalConnection connectClientMessageListener(ClientMessageSignal::SlotType const&);
 
+    /// Sets the shared frame callback, without one frames are sent as a ClientMessage
+    SignalConnection connectClientFrameListener(ClientFrameSignal::SlotType const&);
+
+    /// Sets the groups of the server's connections, nullptr once the connection stops
+    void broadcastGroups(CompanEdgeBoostBroadcastGroups* groups);
+
+protected:
+    /// Sends a frame shared with other connections
+    void sendClientFrame(ClientMessageFrame::Ptr framePtr);
+
+    /// Adds this connection to a group
+    bool joinGroup(std::string const& group);
+
+    /// Removes this connection from a group
+    void leaveGroup(std::string const& group);
+
+    /// Sends a frame to every connection of a group, returns the number of connections
+    size_t sendGroupFrame(std::string const& group, ClientMessageFrame::Ptr framePtr);
+
 protected:
     uint32_t const connectionId_;
+    MessageArenaPool::Ptr const arenas_;
+
     ClientMessageSignal onClientMessageSignal_;
+    ClientFrameSignal onClientFrameSignal_;
+
+    std::atomic<CompanEdgeBoostBroadcastGroups*> groups_; //!< owned by the connection manager
 };
 
+inline MessageArenaPool::Ptr const& CompanEdgeBoostMessageHandler::arenas() const
+{
+    return arenas_;
+}
+
 inline SignalConnection CompanEdgeBoostMessageHandler::connectClientMessageListener(
         ClientMessageSignal::SlotType const& cb)
 {
     return onClientMessageSignal_.connect(cb);
 }
 
+inline SignalConnection CompanEdgeBoostMessageHandler::connectClientFrameListener(ClientFrameSignal::SlotType const& cb)
+{
+    return onClientFrameSignal_.connect(cb);
+}
+
+inline void CompanEdgeBoostMessageHandler::broadcastGroups(CompanEdgeBoostBroadcastGroups* groups)
+{
+    groups_ = groups;
+}
+
 } // namespace Edge
 } // namespace Compan
 
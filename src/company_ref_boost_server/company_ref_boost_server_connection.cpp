@@ -20,6 +20,8 @@
 #include <boost/asio/read_until.hpp>
 #include <boost/asio/write.hpp>
 
+#include <algorithm>
+#include <iterator>
 #include <utility>
 
 namespace Compan{
@@ -31,6 +33,9 @@ CompanLogger AebServerConnectionLog("server.connection.core", LogLevel::Informat
 namespace Compan{
 namespace Edge {
 
+template <typename T>
+size_t const CompanEdgeBoostServerConnection<T>::ReadSize(65536);
+
 template <typename T>
 CompanEdgeBoostServerConnection<T>::CompanEdgeBoostServerConnection(
         uint32_t connectionId,
@@ -42,6 +47,8 @@ CompanEdgeBoostServerConnection<T>::CompanEdgeBoostServerConnection(
     , socket_(std::move(socket))
     , connectionId_(connectionId)
     , messageHandlerPtr_(handlerFactory.makeHandler(connectionId))
+    , drainListener_(messageHandlerPtr_)
+    , arenas_(messageHandlerPtr_ ? messageHandlerPtr_->arenas() : MessageArenaPool::create())
     , bNewFraming_(true)
     , pAecCallbacks_(new AecCallbacks<std::string>(
               {[this]() {
@@ -58,6 +65,8 @@ CompanEdgeBoostServerConnection<T>::CompanEdgeBoostServerConnection(
                }}))
 {
     FunctionArgLog(AebServerConnectionLog) << "[" << connectionId_ << "]" << std::endl;
+
+    readBuffer_.reserve(ReadSize * 2);
 }
 
 template <typename T>
@@ -75,6 +84,8 @@ void CompanEdgeBoostServerConnection<T>::start()
     //  make sure to call CompanEdgeBoostMessageHandler::diconnect on tear down
     messageHandlerConnection_ = messageHandlerPtr_->connectClientMessageListener(std::bind(
             &CompanEdgeBoostServerConnection::sendClientMessage, this->shared_from_this(), std::placeholders::_1));
+    frameHandlerConnection_ = messageHandlerPtr_->connectClientFrameListener(std::bind(
+            &CompanEdgeBoostServerConnection::sendClientFrame, this->shared_from_this(), std::placeholders::_1));
 
     doRead();
 }
@@ -89,22 +100,33 @@ void CompanEdgeBoostServerConnection<T>::stop()
     // dump queues to stop the post handlers
     {
         std::lock_guard<std::mutex> lock(rspMsgMutex_);
-        rspMsgQueue_ = std::queue<ClientMessagePtr>();
+        rspMsgQueue_.clear();
     }
 
     {
         std::lock_guard<std::mutex> lock(serverMutex_);
 
         messageHandlerConnection_.disconnect();
+        frameHandlerConnection_.disconnect();
 
-        if (messageHandlerPtr_) messageHandlerPtr_->disconnect();
+        if (messageHandlerPtr_) {
+            messageHandlerPtr_->broadcastGroups(nullptr);
+            messageHandlerPtr_->disconnect();
+        }
 
         messageHandlerPtr_.reset();
 
-        serverQueue_ = std::queue<CompanEdgeProtocol::ServerMessage>();
+        serverQueue_.clear();
     }
 }
 
+template <typename T>
+void CompanEdgeBoostServerConnection<T>::broadcastGroups(CompanEdgeBoostBroadcastGroups* groups)
+{
+    std::lock_guard<std::mutex> lock(serverMutex_);
+    if (messageHandlerPtr_) messageHandlerPtr_->broadcastGroups(groups);
+}
+
 template <typename T>
 void CompanEdgeBoostServerConnection<T>::sendClientMessage(ClientMessagePtr rspMsg)
 {
@@ -115,13 +137,62 @@ void CompanEdgeBoostServerConnection<T>::sendClientMessage(ClientMessagePtr rspM
         return;
     }
 
-    std::lock_guard<std::mutex> lock(rspMsgMutex_);
-    rspMsgQueue_.push(rspMsg);
+    sendClientFrame(std::make_shared<ClientMessageFrame>(rspMsg));
+}
+
+template <typename T>
+void CompanEdgeBoostServerConnection<T>::sendClientFrame(ClientMessageFrame::Ptr framePtr)
+{
+    if (!framePtr) return;
+
+    ClientFrameQueue::PushResult result;
+    ClientFrameQueue::Stats stats;
+
+    {
+        std::lock_guard<std::mutex> lock(rspMsgMutex_);
+        result = rspMsgQueue_.push(framePtr);
+
+        // if it's the FIRST entry, kick of writing
+        //  doWrite burns down the queue
+        if (result == ClientFrameQueue::Queued && rspMsgQueue_.size() == 1)
+            boost::asio::post(
+                    ioContext_, std::bind(&CompanEdgeBoostServerConnection::doWrite, this->shared_from_this()));
+
+        if (result == ClientFrameQueue::Queued) return;
+
+        stats = rspMsgQueue_.stats();
+    }
+
+    if (result == ClientFrameQueue::Conflated) {
+        if (stats.conflated == 1)
+            WarnLog(AebServerConnectionLog) << "[" << connectionId_ << "] slow consumer, conflating value changes"
+                                            << " - pending " << stats.pending << std::endl;
+        return;
+    }
 
-    // if it's the FIRST entry, kick of writing
-    //  doWrite burns down the queue
-    if (rspMsgQueue_.size() == 1)
-        boost::asio::post(ioContext_, std::bind(&CompanEdgeBoostServerConnection::doWrite, this->shared_from_this()));
+    // last resort, the client can't keep up even with it's changes conflated
+    if (stats.overflows == 1) {
+        ErrorLog(AebServerConnectionLog) << "[" << connectionId_ << "] outbound limit reached, closing - pending "
+                                         << stats.pending << " conflated " << stats.conflated << std::endl;
+        doClose();
+    }
+}
+
+template <typename T>
+void CompanEdgeBoostServerConnection<T>::onCompression(CompanEdgeProtocol::VsCompression const& request)
+{
+    FunctionArgLog(AebServerConnectionLog) << "[" << connectionId_ << "]" << std::endl;
+
+    ClientMessagePtr rspMsg = arenas_->make<CompanEdgeProtocol::ClientMessage>();
+    ClientFrameCompressor::Ptr compressor =
+            ClientFrameCompressor::negotiate(messageHandlerPtr_->frameCompressor(), request, *rspMsg);
+
+    {
+        std::lock_guard<std::mutex> lock(rspMsgMutex_);
+        negotiated_ = compressor;
+    }
+
+    sendClientFrame(std::make_shared<ClientMessageFrame>(rspMsg));
 }
 
 template <typename T>
@@ -146,7 +217,7 @@ void CompanEdgeBoostServerConnection<T>::doWrite()
 {
     FunctionArgLog(AebServerConnectionLog) << "[" << connectionId_ << "]" << std::endl;
 
-    ClientMessagePtr rspMsg;
+    ClientMessageFrame::Ptr framePtr;
 
     {
         std::lock_guard<std::mutex> lock(rspMsgMutex_);
@@ -156,10 +227,10 @@ void CompanEdgeBoostServerConnection<T>::doWrite()
             return;
         }
 
-        rspMsg = rspMsgQueue_.front();
-        rspMsgQueue_.pop();
+        framePtr = rspMsgQueue_.pop();
     }
 
+    ClientMessagePtr rspMsg = framePtr->message();
     if (!rspMsg) {
 
         ErrorLog(AebServerConnectionLog) << "[" << connectionId_ << "] rspMsg empty?" << std::endl;
@@ -170,8 +241,9 @@ void CompanEdgeBoostServerConnection<T>::doWrite()
         return;
     }
 
-    std::string rspBuffer;
-    if (!rspMsg->SerializeToString(&rspBuffer)) {
+    // encoded by the first connection to write a shared frame
+    ClientMessageFrame::BufferPtr rspBuffer = framePtr->encoded(bNewFraming_, compressor_.get());
+    if (!rspBuffer) {
         ErrorLog(AebServerConnectionLog) << "[" << connectionId_ << "] failed to serialize : " << *rspMsg << std::endl;
 
         std::lock_guard<std::mutex> lock(rspMsgMutex_);
@@ -180,21 +252,24 @@ void CompanEdgeBoostServerConnection<T>::doWrite()
         return;
     }
 
-    if (bNewFraming_) {
-        rspBuffer.insert(0, AECv10::makeHeader<std::string>(rspBuffer.cbegin(), rspBuffer.cend()));
-    } else {
-        rspBuffer.insert(0, AECv09::makeHeader<std::string>(rspBuffer.cbegin(), rspBuffer.cend()));
-    }
-
     boost::system::error_code ec;
 
-    boost::asio::write(socket_, boost::asio::buffer(rspBuffer.data(), rspBuffer.size()), ec);
+    boost::asio::write(socket_, boost::asio::buffer(rspBuffer->data(), rspBuffer->size()), ec);
     if (ec) {
         ErrorLog(AebServerConnectionLog) << "[" << connectionId_ << "] write payload failed, closing: " << ec.message()
                                          << std::endl;
         return doClose();
     }
 
+    // the client decompresses the frames that follow
+    if (rspMsg->has_vscompressionresult()) {
+        std::lock_guard<std::mutex> lock(rspMsgMutex_);
+        compressor_ = negotiated_;
+    }
+
+    // streamed responses wait for the previous chunk to be written
+    if (CompanEdgeBoostMessageHandler::Ptr handler = drainListener_.lock()) handler->onMessageDrained(rspMsg);
+
     boost::asio::post(ioContext_, std::bind(&CompanEdgeBoostServerConnection::doWrite, this->shared_from_this()));
 }
 
@@ -203,10 +278,12 @@ void CompanEdgeBoostServerConnection<T>::doRead()
 {
     FunctionArgLog(AebServerConnectionLog) << "[" << connectionId_ << "]" << std::endl;
 
-    boost::asio::async_read(
-            socket_,
-            boost::asio::dynamic_buffer(readBuffer_),
-            boost::asio::transfer_at_least(1),
+    // read after the partial frame left by the last read
+    size_t const used = readBuffer_.size();
+    readBuffer_.resize(used + ReadSize);
+
+    socket_.async_read_some(
+            boost::asio::buffer(&readBuffer_[used], ReadSize),
             std::bind(
                     &CompanEdgeBoostServerConnection::onRead,
                     this->shared_from_this(),
@@ -219,6 +296,9 @@ void CompanEdgeBoostServerConnection<T>::onRead(boost::system::error_code const&
 {
     FunctionArgLog(AebServerConnectionLog) << "[" << connectionId_ << "] len=" << length << ", ec=" << ec << std::endl;
 
+    // drop the part of the read space not filled
+    readBuffer_.resize(readBuffer_.size() - ReadSize + length);
+
     if (ec) {
         DebugLog(AebServerConnectionLog) << "[" << connectionId_ << "] Closing connection" << std::endl;
         return doClose();
@@ -230,6 +310,16 @@ void CompanEdgeBoostServerConnection<T>::onRead(boost::system::error_code const&
         return doClose();
     }
 
+    parseReadBuffer();
+
+    // don't get smart and try to put this at the top
+    //  * we aren't ready for scatter gather - yet
+    doRead();
+}
+
+template <typename T>
+void CompanEdgeBoostServerConnection<T>::parseReadBuffer()
+{
     while (!readBuffer_.empty()) {
         if (readBuffer_[0] == AECv10::cSeparator) {
             bNewFraming_ = true;
@@ -240,33 +330,39 @@ void CompanEdgeBoostServerConnection<T>::onRead(boost::system::error_code const&
         }
     }
 
-    // don't get smart and try to put this at the top
-    //  * we aren't ready for scatter gather - yet
-    doRead();
+    if (parsed_.empty()) return;
+
+    // one hand over per read, not per frame
+    bool kick = false;
+
+    {
+        std::lock_guard<std::mutex> lock(serverMutex_);
+
+        kick = serverQueue_.empty();
+        if (kick)
+            serverQueue_.swap(parsed_);
+        else
+            std::move(parsed_.begin(), parsed_.end(), std::back_inserter(serverQueue_));
+    }
+
+    parsed_.clear();
+
+    if (kick)
+        boost::asio::post(
+                ioContext_, std::bind(&CompanEdgeBoostServerConnection::doServerQueue, this->shared_from_this()));
 }
 
 template <typename T>
 void CompanEdgeBoostServerConnection<T>::parseRequestMessage(char const* data, size_t const len)
 {
-    CompanEdgeProtocol::ServerMessage msg;
-    if (!msg.ParseFromArray(data, len)) {
+    ServerMessagePtr msgPtr = arenas_->make<CompanEdgeProtocol::ServerMessage>();
+    if (!msgPtr->ParseFromArray(data, len)) {
         ErrorLog(AebServerConnectionLog) << "[" << connectionId_ << "] onPayload, parse error - closing connection"
                                          << std::endl;
         return doClose();
     }
 
-    size_t queueSize = 0;
-
-    {
-        std::lock_guard<std::mutex> lock(serverMutex_);
-        serverQueue_.push(msg);
-
-        queueSize = serverQueue_.size();
-    }
-
-    if (queueSize == 1)
-        boost::asio::post(
-                ioContext_, std::bind(&CompanEdgeBoostServerConnection::doServerQueue, this->shared_from_this()));
+    parsed_.push_back(std::move(msgPtr));
 }
 
 template <typename T>
@@ -274,10 +370,6 @@ void CompanEdgeBoostServerConnection<T>::doServerQueue()
 {
     FunctionArgLog(AebServerConnectionLog) << "[" << connectionId_ << "]" << std::endl;
 
-    CompanEdgeProtocol::ServerMessage msg;
-
-    size_t queueSize = 0;
-
     // We hold onto the lock for this whole process
     // - or the messageHandlerPtr_ might go out of scope
     //  Perhaps we should "post" to it?
@@ -286,23 +378,27 @@ void CompanEdgeBoostServerConnection<T>::doServerQueue()
 
     if (serverQueue_.empty()) { return; }
 
-    msg = serverQueue_.front();
-    serverQueue_.pop();
-
-    queueSize = serverQueue_.size();
+    // the next read's batch queues up behind the lock, and is posted once this one is done
+    handling_.swap(serverQueue_);
 
     if (!messageHandlerPtr_) {
         ErrorLog(AebServerConnectionLog) << "[" << connectionId_ << "]"
                                          << " Message Handler disappeared?" << std::endl;
 
+        handling_.clear();
         return;
     }
 
-    messageHandlerPtr_->handleMessage(msg);
+    for (auto const& msgPtr : handling_) {
+        // negotiated by the connection, the message handler never sees it
+        if (msgPtr->has_vscompression())
+            onCompression(msgPtr->vscompression());
+        else
+            messageHandlerPtr_->handleMessage(*msgPtr);
+    }
 
-    if (queueSize)
-        boost::asio::post(
-                ioContext_, std::bind(&CompanEdgeBoostServerConnection::doServerQueue, this->shared_from_this()));
+    // back to their arenas, the vector keeps it's capacity
+    handling_.clear();
 }
 
 template <typename T>
@@ -325,6 +421,20 @@ typename CompanEdgeBoostServerConnection<T>::EndPointType CompanEdgeBoostServerC
     return socket_.remote_endpoint();
 }
 
+template <typename T>
+void CompanEdgeBoostServerConnection<T>::setOutboundLimits(ClientFrameQueue::Limits const& limits)
+{
+    std::lock_guard<std::mutex> lock(rspMsgMutex_);
+    rspMsgQueue_.limits(limits);
+}
+
+template <typename T>
+ClientFrameQueue::Stats CompanEdgeBoostServerConnection<T>::outboundStats()
+{
+    std::lock_guard<std::mutex> lock(rspMsgMutex_);
+    return rspMsgQueue_.stats();
+}
+
 template <typename T>
 SignalConnection CompanEdgeBoostServerConnection<T>::connectDisconnectListener(
         typename DisconnectSignal::SlotType const& cb)
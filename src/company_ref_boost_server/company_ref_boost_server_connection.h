@@ -13,6 +13,7 @@
 #include <company_ref_dmo/company_ref_dmo_container.h>
 #include <company_ref_protocol/company_ref_protocol.pb.h>
 #include <company_ref_utils/company_ref_signals.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_client_frame_queue.h>
 
 #include <boost/asio/basic_stream_socket.hpp>
 #include <boost/asio/buffer.hpp>
@@ -47,10 +48,13 @@ public:
     using EndPointType = typename SocketType::endpoint_type;
 
     using ClientMessagePtr = std::shared_ptr<CompanEdgeProtocol::ClientMessage>;
+    using ServerMessagePtr = std::shared_ptr<CompanEdgeProtocol::ServerMessage>;
 
     using Ptr = std::shared_ptr<CompanEdgeBoostServerConnection<T>>;
     using DisconnectSignal = SignalAsio<void(CompanEdgeBoostServerConnection<T>::Ptr)>;
 
+    static size_t const ReadSize; //!< bytes asked of each socket read
+
 public:
     // class cannot be copied; delete copy constructor and copy assignment
     CompanEdgeBoostServerConnection(CompanEdgeBoostServerConnection const&) = delete;
@@ -75,19 +79,39 @@ public:
 
     EndPointType endpoint();
 
+    /// Sets the outbound limits, frames already queued are kept
+    void setOutboundLimits(ClientFrameQueue::Limits const& limits);
+
+    /// Returns the outbound queue counters
+    ClientFrameQueue::Stats outboundStats();
+
     /// Sets the completion callback function
     SignalConnection connectDisconnectListener(typename DisconnectSignal::SlotType const&);
 
+    /// Queues a frame, possibly shared with other connections
+    void sendClientFrame(ClientMessageFrame::Ptr framePtr);
+
+    /// Hands the server's connection groups to the message handler
+    void broadcastGroups(CompanEdgeBoostBroadcastGroups* groups);
+
 protected:
     // Perform an asynchronous read operation.
     void doRead();
     void onRead(boost::system::error_code const& ec, size_t const length);
 
+    /// Decodes a frame's payload, straight from the read buffer
     void parseRequestMessage(char const* data, size_t const len);
-    void parseReadBuffer(std::string const& buffer);
+
+    /// Parses the complete frames of readBuffer_ in place, the requests are handed over as one batch
+    void parseReadBuffer();
+
+    /// Handles a batch of requests
     void doServerQueue();
 
     void sendClientMessage(ClientMessagePtr rspMsg);
+
+    /// Answers the client's VsCompression, compression starts once the answer is written
+    void onCompression(CompanEdgeProtocol::VsCompression const& request);
     void sendUnknownFrameId(COMPAN::REF::AECFrameId const& frameId);
 
     void doWrite();
@@ -103,19 +127,30 @@ private:
 
     uint32_t connectionId_;
 
-    std::queue<ClientMessagePtr> rspMsgQueue_;
+    // frames may be shared with other connections, they are encoded once per framing
+    //  bounded, a slow consumer has it's value changes conflated
+    ClientFrameQueue rspMsgQueue_;
     std::mutex rspMsgMutex_;
 
+    ClientFrameCompressor::Ptr negotiated_; //!< guarded by rspMsgMutex_, used once the result is written
+    ClientFrameCompressor::Ptr compressor_; //!< doWrite only
+
     std::mutex serverMutex_;
-    std::queue<CompanEdgeProtocol::ServerMessage> serverQueue_;
+    std::vector<ServerMessagePtr> serverQueue_; //!< parsed straight into their arena, never copied
+    std::vector<ServerMessagePtr> handling_;    //!< batch being handled, swapped with serverQueue_
+    std::vector<ServerMessagePtr> parsed_;      //!< requests of the current read, read path only
 
     // The handler used to process the incoming request and outgoing response
     // ServerMessage is RequestMessage from client to server
     // ClientMessage is ResponseMessage from server to client
     CompanEdgeBoostMessageHandler::Ptr messageHandlerPtr_;
+    std::weak_ptr<CompanEdgeBoostMessageHandler> drainListener_; //!< Notified as responses are written
+    MessageArenaPool::Ptr const arenas_;                          //!< the handler's, outlives it
 
     SignalScopedConnection messageHandlerConnection_;
+    SignalScopedConnection frameHandlerConnection_;
 
+    // reused across reads, keeps it's capacity; only a partial frame is carried over
     std::string readBuffer_; //!< Incoming buffer
 
     bool bNewFraming_;
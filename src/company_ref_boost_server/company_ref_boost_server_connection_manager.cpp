@@ -14,6 +14,10 @@
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/local/stream_protocol.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+
 using namespace Compan::Edge;
 
 namespace Compan{
@@ -25,6 +29,7 @@ CompanLogger AebServerConnectionManagerLog("server.connection.manager", LogLevel
 template <typename T>
 CompanEdgeBoostServerConnectionManager<T>::CompanEdgeBoostServerConnectionManager(boost::asio::io_context& ctx)
     : ctx_(ctx)
+    , registry_(std::make_shared<Registry>())
     , onConnectonAddSignal_(ctx)
     , onConnectonRemoveSignal_(ctx)
 {
@@ -37,14 +42,24 @@ void CompanEdgeBoostServerConnectionManager<T>::start(BoostServerConnectionPtr c
 
     if (!con) return;
 
-    std::lock_guard<std::mutex> lock(mutex_);
-    connections_.insert(con);
+    size_t count = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        std::shared_ptr<Registry> registry(std::make_shared<Registry>(*registry_));
+        registry->connections[con->getConnectionId()] = con;
+        count = registry->connections.size();
+        publish(registry);
+    }
+
+    // outside the lock - a handler holding the connection's lock may join a group
     onConnectonAddSignal_(con);
     con->connectDisconnectListener(std::bind(&CompanEdgeBoostServerConnectionManager::stop, this, std::placeholders::_1));
+    con->broadcastGroups(this);
     con->start();
 
-    if (connections_.size() > 5)
-        WarnLog(AebServerConnectionManagerLog) << "warning: " << connections_.size() << std::endl;
+    if (count > 5) WarnLog(AebServerConnectionManagerLog) << "warning: " << count << std::endl;
 }
 
 template <typename T>
@@ -54,10 +69,29 @@ void CompanEdgeBoostServerConnectionManager<T>::stop(BoostServerConnectionPtr co
 
     if (!con) return;
 
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (connections_.count(con) == 0) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto it = registry_->connections.find(con->getConnectionId());
+        if (it == registry_->connections.end() || it->second != con) return;
+
+        std::shared_ptr<Registry> registry(std::make_shared<Registry>(*registry_));
+        registry->connections.erase(con->getConnectionId());
+
+        // a stopped connection leaves all it's groups
+        for (auto groupIt = registry->groups.begin(); groupIt != registry->groups.end();) {
+            ConnectionVector& members = groupIt->second;
+            members.erase(std::remove(members.begin(), members.end(), con), members.end());
+
+            if (members.empty())
+                groupIt = registry->groups.erase(groupIt);
+            else
+                ++groupIt;
+        }
+
+        publish(registry);
+    }
 
-    connections_.erase(con);
     onConnectonRemoveSignal_(con);
 
     con->stop();
@@ -68,9 +102,16 @@ void CompanEdgeBoostServerConnectionManager<T>::stopAll()
 {
     FunctionLog(AebServerConnectionManagerLog);
 
-    for (auto con : connections_) con->stop();
+    RegistryPtr stopped;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        stopped = registry_;
+        publish(std::make_shared<Registry>());
+    }
 
-    connections_.clear();
+    for (auto const& entry : stopped->connections) entry.second->stop();
 }
 
 template <typename T>
@@ -89,25 +130,88 @@ SignalConnection CompanEdgeBoostServerConnectionManager<T>::connectConnectionRem
 
 template <typename T>
 typename CompanEdgeBoostServerConnectionManager<T>::BoostServerConnectionPtr CompanEdgeBoostServerConnectionManager<T>::get(
-        uint32_t const connectionId)
+        uint32_t const connectionId) const
 {
-    for (auto con : connections_) {
-        if (con->getConnectionId() == connectionId) return con;
-    }
+    RegistryPtr registry(snapshot());
+
+    auto it = registry->connections.find(connectionId);
+    if (it == registry->connections.end()) return typename CompanEdgeBoostServerConnectionManager<T>::BoostServerConnectionPtr();
+
+    return it->second;
+}
+
+template <typename T>
+typename CompanEdgeBoostServerConnectionManager<T>::RegistryPtr CompanEdgeBoostServerConnectionManager<T>::snapshot() const
+{
+    return std::atomic_load(&registry_);
+}
+
+template <typename T>
+bool CompanEdgeBoostServerConnectionManager<T>::joinGroup(std::string const& group, uint32_t const connectionId)
+{
+    FunctionArgLog(AebServerConnectionManagerLog) << group << " [" << connectionId << "]" << std::endl;
+
+    std::lock_guard<std::mutex> lock(mutex_);
 
-    return typename CompanEdgeBoostServerConnectionManager<T>::BoostServerConnectionPtr();
+    auto it = registry_->connections.find(connectionId);
+    if (it == registry_->connections.end()) return false;
+
+    auto groupIt = registry_->groups.find(group);
+    if (groupIt != registry_->groups.end()
+        && std::find(groupIt->second.begin(), groupIt->second.end(), it->second) != groupIt->second.end())
+        return true;
+
+    std::shared_ptr<Registry> registry(std::make_shared<Registry>(*registry_));
+    registry->groups[group].push_back(it->second);
+    publish(registry);
+
+    return true;
 }
 
 template <typename T>
-typename CompanEdgeBoostServerConnectionManager<T>::Iterator CompanEdgeBoostServerConnectionManager<T>::begin() const
+void CompanEdgeBoostServerConnectionManager<T>::leaveGroup(std::string const& group, uint32_t const connectionId)
 {
-    return connections_.begin();
+    FunctionArgLog(AebServerConnectionManagerLog) << group << " [" << connectionId << "]" << std::endl;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto groupIt = registry_->groups.find(group);
+    if (groupIt == registry_->groups.end()) return;
+
+    auto memberIt = std::find_if(
+            groupIt->second.begin(), groupIt->second.end(), [connectionId](BoostServerConnectionPtr const& con) {
+                return con->getConnectionId() == connectionId;
+            });
+    if (memberIt == groupIt->second.end()) return;
+
+    std::shared_ptr<Registry> registry(std::make_shared<Registry>(*registry_));
+    ConnectionVector& members = registry->groups[group];
+    members.erase(members.begin() + std::distance(groupIt->second.begin(), memberIt));
+    if (members.empty()) registry->groups.erase(group);
+
+    publish(registry);
+}
+
+template <typename T>
+size_t CompanEdgeBoostServerConnectionManager<T>::broadcast(std::string const& group, ClientMessageFrame::Ptr framePtr)
+{
+    if (!framePtr) return 0;
+
+    RegistryPtr registry(snapshot());
+
+    auto groupIt = registry->groups.find(group);
+    if (groupIt == registry->groups.end()) return 0;
+
+    // one frame, encoded by the first member to write it
+    for (auto const& con : groupIt->second) con->sendClientFrame(framePtr);
+
+    return groupIt->second.size();
 }
 
 template <typename T>
-typename CompanEdgeBoostServerConnectionManager<T>::Iterator CompanEdgeBoostServerConnectionManager<T>::end() const
+void CompanEdgeBoostServerConnectionManager<T>::publish(std::shared_ptr<Registry> registry)
 {
-    return connections_.end();
+    std::atomic_store(&registry_, RegistryPtr(std::move(registry)));
 }
 
 template class COMPAN::REF::CompanEdgeBoostServerConnectionManager<boost::asio::ip::tcp>;
@@ -7,13 +7,16 @@
 #ifndef __company_ref_BOOST_SERVER_CONNECTION_MANAGER_H__
 #define __company_ref_BOOST_SERVER_CONNECTION_MANAGER_H__
 
+#include "company_ref_boost_broadcast_groups.h"
 #include "company_ref_boost_server_connection.h"
 #include <company_ref_utils/company_ref_signals.h>
 #include <company_ref_variant_valuestore/company_ref_variant_valuestore.h>
 
 #include <memory>
 #include <mutex>
-#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace CompanEdgeProtocol {
 class ServerMessage;
@@ -23,13 +26,30 @@ class ClientMessage;
 namespace Compan{
 namespace Edge {
 
+/*!
+ * @brief Registry of a server's connections
+ *
+ * Connections are indexed by id, and may join named broadcast groups.
+ *
+ * Readers take the current Registry snapshot without a lock and keep
+ * it for as long as they use it. Writers, a connection starting or
+ * stopping or a group change, copy the registry under mutex_ and publish
+ * the copy. Connections come and go far less often than they are looked
+ * up or broadcast to.
+ */
 template <typename T>
-class CompanEdgeBoostServerConnectionManager {
+class CompanEdgeBoostServerConnectionManager : public CompanEdgeBoostBroadcastGroups {
 public:
     using BoostServerConnectionPtr = std::shared_ptr<CompanEdgeBoostServerConnection<T>>;
-    using ConnectionSet = std::set<BoostServerConnectionPtr>;
-    using Iterator = typename ConnectionSet::const_iterator;
-    ;
+    using ConnectionVector = std::vector<BoostServerConnectionPtr>;
+
+    /// Immutable once published
+    struct Registry {
+        std::unordered_map<uint32_t, BoostServerConnectionPtr> connections; //!< by connection id
+        std::unordered_map<std::string, ConnectionVector> groups;           //!< members by group name
+    };
+
+    using RegistryPtr = std::shared_ptr<Registry const>;
 
     using ConnectionAddSignal = SignalAsio<void(BoostServerConnectionPtr const)>;
     using ConnectionRemoveSignal = SignalAsio<void(BoostServerConnectionPtr const)>;
@@ -49,21 +69,30 @@ public:
     // Stop all connections.
     void stopAll();
 
-    BoostServerConnectionPtr get(uint32_t const connectionId);
+    /// Returns the connection, nullptr if it isn't managed
+    BoostServerConnectionPtr get(uint32_t const connectionId) const;
+
+    /// Returns the current connections and groups
+    RegistryPtr snapshot() const;
+
+    virtual bool joinGroup(std::string const& group, uint32_t const connectionId);
+    virtual void leaveGroup(std::string const& group, uint32_t const connectionId);
+    virtual size_t broadcast(std::string const& group, ClientMessageFrame::Ptr framePtr);
 
     SignalConnection connectConnectionAddedListener(typename ConnectionAddSignal::SlotType const&);
     SignalConnection connectConnectionRemovedListener(typename ConnectionRemoveSignal::SlotType const&);
 
-    Iterator begin() const;
-    Iterator end() const;
+private:
+    /// Publishes a new registry, mutex_ must be held
+    void publish(std::shared_ptr<Registry> registry);
 
 private:
     boost::asio::io_context& ctx_;
 
-    // The managed connections.
+    // serializes the writers, readers use the snapshot
     std::mutex mutex_;
 
-    ConnectionSet connections_;
+    RegistryPtr registry_; //!< accessed with the std::atomic_ shared_ptr functions
 
     ConnectionAddSignal onConnectonAddSignal_;
     ConnectionRemoveSignal onConnectonRemoveSignal_;
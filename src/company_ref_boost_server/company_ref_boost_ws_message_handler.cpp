@@ -14,6 +14,9 @@ using namespace Compan::Edge;
 #include <company_ref_utils/company_ref_regex_utils.h>
 
 #include <company_ref_variant_valuestore/company_ref_variant_container_util.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_batch.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_chunker.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_resume.h>
 #include <company_ref_variant_valuestore/company_ref_variant_valuestore_visitor.h>
 
 #include <Compan_logger/Compan_logger.h>
@@ -53,6 +56,11 @@ CompanEdgeBoostWsMessageHandler::CompanEdgeBoostWsMessageHandler(
     : CompanEdgeBoostMessageHandler(ctx, connectionId)
     , variantValueStore_(variantValueStore)
     , dmo_(dmo)
+    , subscriberId_(VariantValueSubscriptionIndex::InvalidSubscriber)
+    , invalidateSubscriberId_(VariantValueSubscriptionIndex::InvalidSubscriber)
+    , chunkInFlight_(nullptr)
+    , chunkMaxValues_(VariantValueChunker::DefaultMaxValues)
+    , chunkMaxBytes_(VariantValueChunker::DefaultMaxBytes)
 {
 }
 
@@ -64,8 +72,44 @@ void CompanEdgeBoostWsMessageHandler::disconnect()
 {
     CompanEdgeBoostMessageHandler::disconnect();
 
-    wsSubscriberConnection_.clear();
+    if (subscriberId_ != VariantValueSubscriptionIndex::InvalidSubscriber) {
+        variantValueStore_.subscriptions().disconnect(subscriberId_);
+        subscriberId_ = VariantValueSubscriptionIndex::InvalidSubscriber;
+    }
+    if (invalidateSubscriberId_ != VariantValueSubscriptionIndex::InvalidSubscriber) {
+        variantValueStore_.subscriptions().disconnect(invalidateSubscriberId_);
+        invalidateSubscriberId_ = VariantValueSubscriptionIndex::InvalidSubscriber;
+    }
+    invalidateRemovedListener_.disconnect();
     disconnectListeners();
+
+    std::lock_guard<std::mutex> lock(chunkMutex_);
+    chunkedResponses_.clear();
+    chunkInFlight_ = nullptr;
+}
+
+void CompanEdgeBoostWsMessageHandler::setChunkLimits(size_t const maxValues, size_t const maxBytes)
+{
+    std::lock_guard<std::mutex> lock(chunkMutex_);
+    chunkMaxValues_ = maxValues;
+    chunkMaxBytes_ = maxBytes;
+}
+
+void CompanEdgeBoostWsMessageHandler::onMessageDrained(ClientMessagePtr rspMsgPtr)
+{
+    {
+        std::lock_guard<std::mutex> lock(chunkMutex_);
+        if (!rspMsgPtr || rspMsgPtr.get() != chunkInFlight_) return;
+
+        chunkInFlight_ = nullptr;
+    }
+
+    sendNextChunk();
+}
+
+ClientFrameCompressor::Ptr CompanEdgeBoostWsMessageHandler::frameCompressor()
+{
+    return variantValueStore_.frameCompressor();
 }
 
 void CompanEdgeBoostWsMessageHandler::handleMessage(CompanEdgeProtocol::ServerMessage const& serverMessage)
@@ -73,7 +117,7 @@ void CompanEdgeBoostWsMessageHandler::handleMessage(CompanEdgeProtocol::ServerMe
     FunctionArgLog(AebMessageHandlerLog) << "[" << connectionId_ << "]" << std::endl;
 
     // All onMessage() is using member variable responseMessagePtr
-    ClientMessagePtr rspMsgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+    ClientMessagePtr rspMsgPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
 
     // ValueChanged are VsSyncComplete are not needed because they are server to client msg only
     if (serverMessage.has_vssync()) onMessage(serverMessage.vssync(), rspMsgPtr);
@@ -105,6 +149,13 @@ void CompanEdgeBoostWsMessageHandler::onMessage(CompanEdgeProtocol::VsSync const
 
     disconnectListeners();
 
+    if ((vsSyncValue.ids_size() <= 0)) {
+        // streamed as ValueChanged chunks, the last carries the VsSyncCompleted
+        queueStoreResponse(ChunkedResponse::Sync, 0);
+        connectAllListeners();
+        return;
+    }
+
     // Populate response message (ClientMessage); it has ValuedChanged, ValueRemoved, VsResult and VsSyncCompleted
     // VsSyncCompleted service update
     rspMsgPtr->mutable_vssynccompleted()->set_services(CompanEdgeProtocol::ValueStore);
@@ -112,12 +163,6 @@ void CompanEdgeBoostWsMessageHandler::onMessage(CompanEdgeProtocol::VsSync const
     // ValueChanged values update
     CompanEdgeProtocol::ValueChanged* pValueChanged = rspMsgPtr->mutable_valuechanged();
 
-    if ((vsSyncValue.ids_size() <= 0)) {
-        copyValueStoreToRepeated(pValueChanged->mutable_value());
-        connectAllListeners();
-        return;
-    }
-
     for (auto& valueId : vsSyncValue.ids()) {
 
         VariantValue::Ptr valuePtr = variantValueStore_.get(valueId);
@@ -182,31 +227,34 @@ void CompanEdgeBoostWsMessageHandler::onMessage(
     if (responseValueChanged.value_size()) *rspMsgPtr->mutable_valuechanged() = std::move(responseValueChanged);
 }
 
-void CompanEdgeBoostWsMessageHandler::onMessage(CompanEdgeProtocol::VsSubscribe const& vsSubscribeValue, ClientMessagePtr)
+void CompanEdgeBoostWsMessageHandler::onMessage(
+        CompanEdgeProtocol::VsSubscribe const& vsSubscribeValue,
+        ClientMessagePtr rspMsgPtr)
 {
     FunctionArgLog(AebMessageHandlerLog) << "[" << connectionId_ << "] seq#:" << vsSubscribeValue.sequenceno()
                                          << std::endl;
 
-    if ((vsSubscribeValue.ids_size() <= 0)) {
-
-        ClientMessagePtr rspMsgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
-
-        // Populate response message (ClientMessage); it has ValuedChanged, ValueRemoved, VsResult and vsSyncCompleted
-        // VsResult 'sequenceNo', 'status' and 'values' update
-        CompanEdgeProtocol::VsResult* pVsResult =
-                addVsResult(*rspMsgPtr, vsSubscribeValue, CompanEdgeProtocol::VsResult::success);
+    if (vsSubscribeValue.invalidate()) {
+        invalidateSubscription(vsSubscribeValue, rspMsgPtr);
+        return;
+    }
 
-        copyValueStoreToRepeated(pVsResult->mutable_values());
+    if ((vsSubscribeValue.ids_size() <= 0)) {
+        // streamed as VsResult chunks, all but the last are flagged with 'more'
+        queueStoreResponse(ChunkedResponse::Result, vsSubscribeValue.sequenceno());
         connectAllListeners();
 
-        onClientMessageSignal_(rspMsgPtr);
+        return;
+    }
 
+    if (vsSubscribeValue.epoch()) {
+        resumeSubscription(vsSubscribeValue);
         return;
     }
 
     // we return two different results based on a good/bad subscription
-    ClientMessagePtr rspMsgSuccessPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
-    ClientMessagePtr rspMsgNotFoundPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+    ClientMessagePtr rspMsgSuccessPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
+    ClientMessagePtr rspMsgNotFoundPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
 
     // send discreete messages about the subscription status
     CompanEdgeProtocol::VsResult* vsResultSuccess =
@@ -215,6 +263,14 @@ void CompanEdgeBoostWsMessageHandler::onMessage(CompanEdgeProtocol::VsSubscribe
     CompanEdgeProtocol::VsResult* vsResultNotFound =
             addVsResult(*rspMsgNotFoundPtr, vsSubscribeValue, CompanEdgeProtocol::VsResult::error_not_found);
 
+    // the version is taken first, the values are at least as current
+    uint64_t const version(variantValueStore_.version());
+
+    vsResultSuccess->set_epoch(variantValueStore_.epoch());
+    vsResultSuccess->set_version(version);
+    vsResultNotFound->set_epoch(variantValueStore_.epoch());
+    vsResultNotFound->set_version(version);
+
     // VsResult values update
     for (auto& valueId : vsSubscribeValue.ids()) {
 
@@ -242,6 +298,58 @@ void CompanEdgeBoostWsMessageHandler::onMessage(CompanEdgeProtocol::VsSubscribe
     if (vsResultNotFound->values_size()) onClientMessageSignal_(rspMsgNotFoundPtr);
 }
 
+void CompanEdgeBoostWsMessageHandler::resumeSubscription(CompanEdgeProtocol::VsSubscribe const& vsSubscribeValue)
+{
+    ClientMessagePtr rspMsgSuccessPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
+    ClientMessagePtr rspMsgNotFoundPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
+
+    CompanEdgeProtocol::VsResult* vsResultSuccess =
+            addVsResult(*rspMsgSuccessPtr, vsSubscribeValue, CompanEdgeProtocol::VsResult::success);
+
+    bool const resumed = VariantValueResume::resume(
+            variantValueStore_,
+            vsSubscribeValue,
+            *vsResultSuccess,
+            *rspMsgNotFoundPtr->mutable_vsresult(),
+            [this](VariantValue::Ptr const& valuePtr) {
+                insertSubscriberFilter(valuePtr);
+                connectAddRemoveListeners();
+            });
+
+    if (!resumed) {
+        DebugLog(AebMessageHandlerLog) << "[" << connectionId_ << "] can't resume epoch " << vsSubscribeValue.epoch()
+                                       << std::endl;
+    }
+
+    // always sent, it completes the resume
+    onClientMessageSignal_(rspMsgSuccessPtr);
+
+    if (rspMsgNotFoundPtr->vsresult().values_size()) onClientMessageSignal_(rspMsgNotFoundPtr);
+}
+
+void CompanEdgeBoostWsMessageHandler::invalidateSubscription(
+        CompanEdgeProtocol::VsSubscribe const& vsSubscribeValue,
+        ClientMessagePtr rspMsgPtr)
+{
+    addVsResult(*rspMsgPtr, vsSubscribeValue, CompanEdgeProtocol::VsResult::success);
+
+    if (invalidateSubscriberId_ == VariantValueSubscriptionIndex::InvalidSubscriber) {
+        invalidateSubscriberId_ = variantValueStore_.subscriptions().connect(std::bind(
+                &CompanEdgeBoostWsMessageHandler::handleValueInvalidated, shared_from_this(), std::placeholders::_1));
+    }
+
+    for (auto& valueId : vsSubscribeValue.ids()) {
+        VariantValue::Ptr valuePtr = variantValueStore_.get(valueId);
+        if (valuePtr) variantValueStore_.subscriptions().subscribe(invalidateSubscriberId_, valuePtr);
+    }
+
+    if (!invalidateRemovedListener_.connected()
+        && variantValueStore_.subscriptions().hasSubscriptions(invalidateSubscriberId_)) {
+        invalidateRemovedListener_ = variantValueStore_.connectValueRemovedListener(std::bind(
+                &CompanEdgeBoostWsMessageHandler::handleInvalidatedRemoved, shared_from_this(), std::placeholders::_1));
+    }
+}
+
 void CompanEdgeBoostWsMessageHandler::onMessage(
         CompanEdgeProtocol::VsUnsubscribe const& vsUnsubscribeValue,
         ClientMessagePtr rspMsgPtr)
@@ -251,25 +359,23 @@ void CompanEdgeBoostWsMessageHandler::onMessage(
 
     addVsResult(*rspMsgPtr, vsUnsubscribeValue, CompanEdgeProtocol::VsResult::success);
 
-    wsSubscriberConnection_.clear();
+    variantValueStore_.subscriptions().unsubscribeAll(subscriberId_);
+    variantValueStore_.subscriptions().unsubscribeAll(invalidateSubscriberId_);
+    invalidateRemovedListener_.disconnect();
     disconnectListeners();
 }
 
 void CompanEdgeBoostWsMessageHandler::onMessage(
         CompanEdgeProtocol::VsGetAll const& vsGetAllValue,
-        ClientMessagePtr rspMsgPtr)
+        ClientMessagePtr)
 {
     FunctionArgLog(AebMessageHandlerLog) << "[" << connectionId_ << "] seq#:" << vsGetAllValue.sequenceno()
                                          << std::endl;
 
-    CompanEdgeProtocol::VsResult* pVsResult = addVsResult(*rspMsgPtr, vsGetAllValue, CompanEdgeProtocol::VsResult::success);
-
-    if (variantValueStore_.size() <= 0) {
+    if (variantValueStore_.size() <= 0)
         DebugLog(AebMessageHandlerLog) << "WsMap is empty, size:" << variantValueStore_.size() << std::endl;
-        return;
-    }
 
-    copyValueStoreToRepeated(pVsResult->mutable_values());
+    queueStoreResponse(ChunkedResponse::Result, vsGetAllValue.sequenceno());
 }
 
 void CompanEdgeBoostWsMessageHandler::onMessage(
@@ -360,62 +466,14 @@ void CompanEdgeBoostWsMessageHandler::onMessage(CompanEdgeProtocol::VsMultiGet c
 {
     FunctionArgLog(AebMessageHandlerLog) << "[" << connectionId_ << "]" << std::endl;
 
-    CompanEdgeProtocol::VsMultiGetResult* vsMultiGetResult = rspMsgPtr->mutable_vsmultigetresult();
-    vsMultiGetResult->set_sequenceno(msg.sequenceno());
-
-    for (auto& id : msg.ids()) {
-
-        CompanEdgeProtocol::VsMultiGetResult_Result* result = vsMultiGetResult->add_results();
-
-        VariantValue::Ptr valuePtr = variantValueStore_.get(id);
-        if (valuePtr == nullptr) {
-            result->set_error(CompanEdgeProtocol::VsMultiGetResult::ValueNotFound);
-            result->set_description("Value not found");
-            continue;
-        }
-
-        result->set_error(CompanEdgeProtocol::VsMultiGetResult::Success);
-        *result->add_values() = valuePtr->get();
-
-        if (valuePtr->type() == CompanEdgeProtocol::Container) {
-            VariantValueVisitor::visitChildren(valuePtr, [&result](VariantValue::Ptr const& visitPtr) {
-                *result->add_values() = visitPtr->get();
-            });
-        }
-    }
+    VariantValueBatch::multiGet(variantValueStore_, msg, *rspMsgPtr->mutable_vsmultigetresult());
 }
 
 void CompanEdgeBoostWsMessageHandler::onMessage(CompanEdgeProtocol::VsMultiSet const& msg, ClientMessagePtr rspMsgPtr)
 {
     FunctionArgLog(AebMessageHandlerLog) << "[" << connectionId_ << "]" << std::endl;
 
-    CompanEdgeProtocol::VsMultiSetResult* vsMultiSetResult = rspMsgPtr->mutable_vsmultisetresult();
-    vsMultiSetResult->set_sequenceno(msg.sequenceno());
-
-    for (auto& setValue : msg.values()) {
-        CompanEdgeProtocol::VsMultiSetResult_Result* result = vsMultiSetResult->add_results();
-
-        VariantValue::Ptr valuePtr = variantValueStore_.get(setValue.id());
-
-        result->set_id(setValue.id());
-
-        if (valuePtr == nullptr) {
-            result->set_error(CompanEdgeProtocol::VsMultiSetResult::ValueNotFound);
-            result->set_description("Value not found");
-            continue;
-        }
-
-        ValueDataSet::Results setResult = valuePtr->set(setValue.value());
-        if (setResult == ValueDataSet::Success || setResult == ValueDataSet::SameValue) {
-            result->set_error(CompanEdgeProtocol::VsMultiSetResult::Success);
-            continue;
-        }
-
-        result->set_error(CompanEdgeProtocol::VsMultiSetResult::UnknownError);
-        std::stringstream ss;
-        ss << "Failed to set value: " << ValueDataSet::resultStr(setResult);
-        result->set_description(ss.str());
-    }
+    VariantValueBatch::multiSet(variantValueStore_, msg, *rspMsgPtr->mutable_vsmultisetresult());
 }
 
 void CompanEdgeBoostWsMessageHandler::onMessage(CompanEdgeProtocol::VsGetObject const& msg, ClientMessagePtr rspMsgPtr)
@@ -459,30 +517,9 @@ void CompanEdgeBoostWsMessageHandler::onMessage(CompanEdgeProtocol::VsGetObject
 
 bool CompanEdgeBoostWsMessageHandler::isParentSubscribed(VariantValue::Ptr const valuePtr)
 {
-    if (wsSubscriberConnection_.empty()) return true;
-
-    if (wsSubscriberConnection_.has(valuePtr->hashToken())) return true;
-
-    ValueId valuePath(valuePtr->id());
-
-    while (!valuePath.empty()) {
-        VariantValue::Ptr parentPtr = variantValueStore_.get(valuePath.parent().name());
-        if (parentPtr == nullptr) return false;
-
-        valuePath = valuePath.parent();
-
-        if (!wsSubscriberConnection_.has(parentPtr->hashToken())) continue;
-
-        wsSubscriberConnection_.insert(
-                valuePtr->hashToken(),
-                valuePtr->connectChangedListener(std::bind(
-                        &CompanEdgeBoostWsMessageHandler::handleValueChanged,
-                        shared_from_this(),
-                        std::placeholders::_1)));
-        return true;
-    }
+    if (!variantValueStore_.subscriptions().hasSubscriptions(subscriberId_)) return true;
 
-    return false;
+    return variantValueStore_.subscriptions().isSubscribed(subscriberId_, valuePtr);
 }
 
 void CompanEdgeBoostWsMessageHandler::handleValueAdded(VariantValue::Ptr const value)
@@ -497,16 +534,21 @@ void CompanEdgeBoostWsMessageHandler::handleValueAdded(VariantValue::Ptr const v
     //  AddToContainer handler can send the values in a single pass
     if (value->setUpdateType() == VariantValue::Remote) return;
 
-    ClientMessagePtr rspMsgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+    ClientMessagePtr rspMsgPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
 
     CompanEdgeProtocol::ValueChanged* valueChanged = rspMsgPtr->mutable_valuechanged();
+    valueChanged->set_version(value->version());
     *valueChanged->add_value() = value->get();
 
     onClientMessageSignal_(rspMsgPtr);
 }
 
-void CompanEdgeBoostWsMessageHandler::handleValueChanged(VariantValue::Ptr const value)
+void CompanEdgeBoostWsMessageHandler::handleValueChanged(ClientMessageFrame::Ptr const framePtr)
 {
+    if (framePtr == nullptr || framePtr->value() == nullptr) return;
+
+    VariantValue::Ptr const& value = framePtr->value();
+
     FunctionArgLog(AebMessageHandlerLog) << "[" << connectionId_ << "] valueId:" << value->id()
                                          << ", hash:" << value->hashToken() << std::endl;
 
@@ -514,11 +556,7 @@ void CompanEdgeBoostWsMessageHandler::handleValueChanged(VariantValue::Ptr const
     if (value->type() == CompanEdgeProtocol::ContainerAddTo || value->type() == CompanEdgeProtocol::ContainerRemoveFrom)
         return;
 
-    ClientMessagePtr rspMsgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
-    CompanEdgeProtocol::ValueChanged* valueChanged = rspMsgPtr->mutable_valuechanged();
-    *valueChanged->add_value() = value->get();
-
-    onClientMessageSignal_(rspMsgPtr);
+    sendClientFrame(framePtr);
 }
 
 void CompanEdgeBoostWsMessageHandler::handleValueRemoved(VariantValue::Ptr const value)
@@ -526,18 +564,18 @@ void CompanEdgeBoostWsMessageHandler::handleValueRemoved(VariantValue::Ptr const
     FunctionArgLog(AebMessageHandlerLog) << "[" << connectionId_ << "] valueId:" << value->id() << std::endl;
 
     // make sure we aren't sending out a remove notification for something we arent' subscribed to
-    if (!wsSubscriberConnection_.empty()) {
+    if (variantValueStore_.subscriptions().hasSubscriptions(subscriberId_)) {
 
-        if (!wsSubscriberConnection_.has(value->hashToken())) { return; }
+        if (!variantValueStore_.subscriptions().isSubscribed(subscriberId_, value)) { return; }
 
-        wsSubscriberConnection_.remove(value->hashToken());
+        variantValueStore_.subscriptions().unsubscribe(subscriberId_, value);
 
-        if (wsSubscriberConnection_.empty()) {
+        if (!variantValueStore_.subscriptions().hasSubscriptions(subscriberId_)) {
             if (removedListener_.connected()) { removedListener_.disconnect(); }
         }
     }
 
-    ClientMessagePtr rspMsgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+    ClientMessagePtr rspMsgPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
     CompanEdgeProtocol::ValueRemoved* valueRemoved = rspMsgPtr->mutable_valueremoved();
     valueRemoved->add_id(value->id());
     valueRemoved->add_hashtoken(value->hashToken());
@@ -561,7 +599,7 @@ void CompanEdgeBoostWsMessageHandler::handleValueAddToContainer(VariantValue::Pt
         return;
     }
 
-    ClientMessagePtr rspMsgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+    ClientMessagePtr rspMsgPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
 
     CompanEdgeProtocol::ValueChanged* valueChanged = rspMsgPtr->mutable_valuechanged();
 
@@ -589,18 +627,18 @@ void CompanEdgeBoostWsMessageHandler::handleValueRemoveFromContainer(VariantValu
                                          << ", hash:" << valuePtr->hashToken() << std::endl;
 
     // make sure we aren't sending out a remove notification for something we arent' subscribed to
-    if (!wsSubscriberConnection_.empty()) {
+    if (variantValueStore_.subscriptions().hasSubscriptions(subscriberId_)) {
 
-        if (!wsSubscriberConnection_.has(valuePtr->hashToken())) { return; }
+        if (!variantValueStore_.subscriptions().isSubscribed(subscriberId_, valuePtr)) { return; }
 
-        wsSubscriberConnection_.remove(valuePtr->hashToken());
+        variantValueStore_.subscriptions().unsubscribe(subscriberId_, valuePtr);
 
-        if (wsSubscriberConnection_.empty()) {
+        if (!variantValueStore_.subscriptions().hasSubscriptions(subscriberId_)) {
             if (removedListener_.connected()) { removedListener_.disconnect(); }
         }
     }
 
-    ClientMessagePtr rspMsgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+    ClientMessagePtr rspMsgPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
 
     CompanEdgeProtocol::ValueChanged* valueChanged = rspMsgPtr->mutable_valuechanged();
 
@@ -610,14 +648,45 @@ void CompanEdgeBoostWsMessageHandler::handleValueRemoveFromContainer(VariantValu
     onClientMessageSignal_(rspMsgPtr);
 }
 
+void CompanEdgeBoostWsMessageHandler::handleValueInvalidated(ClientMessageFrame::Ptr const framePtr)
+{
+    if (framePtr == nullptr || framePtr->value() == nullptr) return;
+
+    FunctionArgLog(AebMessageHandlerLog) << "[" << connectionId_ << "] valueId:" << framePtr->value()->id()
+                                         << std::endl;
+
+    // container add/remove included, any change invalidates
+    sendInvalidated(framePtr->value());
+}
+
+void CompanEdgeBoostWsMessageHandler::handleInvalidatedRemoved(VariantValue::Ptr const value)
+{
+    if (value == nullptr || !variantValueStore_.subscriptions().isSubscribed(invalidateSubscriberId_, value)) return;
+
+    sendInvalidated(value);
+}
+
+void CompanEdgeBoostWsMessageHandler::sendInvalidated(VariantValue::Ptr const valuePtr)
+{
+    // the client subscribes again with it's next fetch
+    for (VariantValue::Ptr parentPtr = valuePtr; parentPtr && !parentPtr->id().empty(); parentPtr = parentPtr->parent())
+        variantValueStore_.subscriptions().unsubscribe(invalidateSubscriberId_, parentPtr);
+
+    if (!variantValueStore_.subscriptions().hasSubscriptions(invalidateSubscriberId_))
+        invalidateRemovedListener_.disconnect();
+
+    ClientMessagePtr rspMsgPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
+    rspMsgPtr->mutable_valueinvalidated()->add_id(valuePtr->id());
+
+    onClientMessageSignal_(rspMsgPtr);
+}
+
 void CompanEdgeBoostWsMessageHandler::connectAllListeners()
 {
     connectAddRemoveListeners();
 
-    if (!changedListener_.connected()) {
-        changedListener_ = variantValueStore_.connectValueChangedListener(std::bind(
-                &CompanEdgeBoostWsMessageHandler::handleValueChanged, shared_from_this(), std::placeholders::_1));
-    }
+    connectSubscriber();
+    variantValueStore_.subscriptions().subscribeStore(subscriberId_);
 }
 
 void CompanEdgeBoostWsMessageHandler::connectAddRemoveListeners()
@@ -645,7 +714,7 @@ void CompanEdgeBoostWsMessageHandler::connectAddRemoveListeners()
 
 void CompanEdgeBoostWsMessageHandler::disconnectListeners()
 {
-    if (changedListener_.connected()) { changedListener_.disconnect(); }
+    variantValueStore_.subscriptions().unsubscribeStore(subscriberId_);
     if (addToContainerListener_.connected()) { addToContainerListener_.disconnect(); }
     if (removeFromContainerListener_.connected()) { removeFromContainerListener_.disconnect(); }
     if (addedListener_.connected()) { addedListener_.disconnect(); }
@@ -688,9 +757,6 @@ bool CompanEdgeBoostWsMessageHandler::handleAddToContainer(std::string const& id
 
         DebugLog(AebMessageHandlerLog) << __FUNCTION__ << " - Container added: " << keyId << std::endl;
 
-        VariantValueVisitor::visitChildren(
-                containerPtr, [this](VariantValue::Ptr const& visitPtr) { insertSubscriberFilter(visitPtr); });
-
         if (!addToContainerListener_.connected()) {
             VariantValue::Ptr addValuePtr =
                     VariantContainerUtil::makeAddToContainer(containerPtr, msg.key(), VariantValue::Local);
@@ -735,21 +801,73 @@ bool CompanEdgeBoostWsMessageHandler::handleRemoveFromContainer(std::string cons
     return true;
 }
 
-void CompanEdgeBoostWsMessageHandler::copyValueStoreToRepeated(
-        google::protobuf::RepeatedPtrField<CompanEdgeProtocol::Value>* repeatedValues)
+void CompanEdgeBoostWsMessageHandler::queueStoreResponse(ChunkedResponse::Type const type, uint32_t const sequenceNo)
 {
-    variantValueStore_.visitValues(
-            [&repeatedValues](VariantValue::Ptr const& value) { *repeatedValues->Add() = value->get(); });
+    {
+        std::lock_guard<std::mutex> lock(chunkMutex_);
+
+        ChunkedResponse response{
+                type,
+                sequenceNo,
+                std::make_shared<VariantValueChunker>(variantValueStore_, chunkMaxValues_, chunkMaxBytes_)};
+
+        // only the VariantValue pointers are captured here
+        response.chunker->insertStore();
+
+        chunkedResponses_.push_back(std::move(response));
+    }
+
+    sendNextChunk();
+}
+
+void CompanEdgeBoostWsMessageHandler::sendNextChunk()
+{
+    ClientMessagePtr rspMsgPtr = arenas_->make<CompanEdgeProtocol::ClientMessage>();
+
+    {
+        std::lock_guard<std::mutex> lock(chunkMutex_);
+
+        if (chunkInFlight_ || chunkedResponses_.empty()) return;
+
+        ChunkedResponse& response = chunkedResponses_.front();
+
+        bool more(false);
+
+        if (response.type == ChunkedResponse::Sync) {
+            more = response.chunker->fill(rspMsgPtr->mutable_valuechanged()->mutable_value());
+            if (!more) rspMsgPtr->mutable_vssynccompleted()->set_services(CompanEdgeProtocol::ValueStore);
+        } else {
+            CompanEdgeProtocol::VsResult* pVsResult = rspMsgPtr->mutable_vsresult();
+            pVsResult->set_sequenceno(response.sequenceNo);
+            pVsResult->set_status(CompanEdgeProtocol::VsResult::success);
+
+            more = response.chunker->fill(pVsResult->mutable_values());
+            pVsResult->set_more(more);
+        }
+
+        if (!more) chunkedResponses_.pop_front();
+
+        // the connection calls onMessageDrained once this chunk is written
+        chunkInFlight_ = chunkedResponses_.empty() ? nullptr : rspMsgPtr.get();
+    }
+
+    onClientMessageSignal_(rspMsgPtr);
+}
+
+void CompanEdgeBoostWsMessageHandler::connectSubscriber()
+{
+    if (subscriberId_ != VariantValueSubscriptionIndex::InvalidSubscriber) return;
+
+    subscriberId_ = variantValueStore_.subscriptions().connect(std::bind(
+            &CompanEdgeBoostWsMessageHandler::handleValueChanged, shared_from_this(), std::placeholders::_1));
 }
 
 void CompanEdgeBoostWsMessageHandler::insertSubscriberFilter(VariantValue::Ptr valuePtr)
 {
-    if (wsSubscriberConnection_.has(valuePtr->hashToken())) return;
+    connectSubscriber();
 
-    wsSubscriberConnection_.insert(
-            valuePtr->hashToken(),
-            valuePtr->connectChangedListener(std::bind(
-                    &CompanEdgeBoostWsMessageHandler::handleValueChanged, shared_from_this(), std::placeholders::_1)));
+    // the subscription covers the value's children, including those added later
+    variantValueStore_.subscriptions().subscribe(subscriberId_, valuePtr);
 }
 
 void CompanEdgeBoostWsMessageHandler::copyValueChildrenToRepeated(
@@ -761,10 +879,7 @@ void CompanEdgeBoostWsMessageHandler::copyValueChildrenToRepeated(
 
     *repeatedValues->Add() = valuePtr->get();
 
-    VariantValueVisitor::visitChildren(
-            valuePtr, [this, &repeatedValues, &subscribe](VariantValue::Ptr const& visitPtr) {
-                if (subscribe) insertSubscriberFilter(visitPtr);
-
-                *repeatedValues->Add() = visitPtr->get();
-            });
+    VariantValueVisitor::visitChildren(valuePtr, [&repeatedValues](VariantValue::Ptr const& visitPtr) {
+        *repeatedValues->Add() = visitPtr->get();
+    });
 }
@@ -8,9 +8,15 @@
 
 #include "company_ref_boost_message_handler.h"
 
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_subscription_index.h>
+
+#include <deque>
+
 namespace Compan{
 namespace Edge {
 
+class VariantValueChunker;
+
 /// Message handler that interfaces with VariantValueStore
 class CompanEdgeBoostWsMessageHandler : public CompanEdgeBoostMessageHandler,
                                       public std::enable_shared_from_this<CompanEdgeBoostWsMessageHandler> {
@@ -28,6 +34,20 @@ public:
     /// Request message handler
     virtual void handleMessage(CompanEdgeProtocol::ServerMessage const& requestMessage);
 
+    /// Produces the next chunk of a streamed response, once the previous has drained
+    virtual void onMessageDrained(ClientMessagePtr);
+
+    /// The VariantValueStore's compressor, shared by all connections
+    virtual ClientFrameCompressor::Ptr frameCompressor();
+
+    /*!
+     * Sets the bounds of a single chunk for streamed responses
+     *
+     * VsSync, VsGetAll and subscribe-all are streamed; a value of 0
+     * uses the VariantValueChunker default
+     */
+    void setChunkLimits(size_t const maxValues, size_t const maxBytes);
+
 protected:
     CompanEdgeBoostWsMessageHandler(CompanEdgeBoostWsMessageHandler const&) = delete;
     CompanEdgeBoostWsMessageHandler& operator=(CompanEdgeBoostWsMessageHandler const&) = delete;
@@ -60,7 +80,7 @@ protected:
      *
      * Subscriptions are cumulative until reset by a VsUnsubscribe request
      *
-     * Responds with VsResult
+     * Responds with VsResult, a request with an epoch resumes a previous subscription
      *
      * @param VsSubscribe request
      */
@@ -151,13 +171,13 @@ protected:
     virtual void handleValueAdded(VariantValue::Ptr const);
 
     /*!
-     * Value changed callback handler from the Value Store
+     * Value changed callback handler from the subscription index
      *
-     * Generates a ValueChanged notification
+     * Forwards the ValueChanged notification shared by all subscribers
      *
-     * @param VariantValue::Ptr with the changed value
+     * @param ClientMessageFrame::Ptr with the changed value
      */
-    virtual void handleValueChanged(VariantValue::Ptr const);
+    virtual void handleValueChanged(ClientMessageFrame::Ptr const);
 
     /*!
      * Value removed callback handler from the Value Store
@@ -171,50 +191,108 @@ protected:
     virtual void handleValueAddToContainer(VariantValue::Ptr const);
     virtual void handleValueRemoveFromContainer(VariantValue::Ptr const);
 
+    /*!
+     * Value changed callback handler from the subscription index, for invalidate subscriptions
+     *
+     * Generates a ValueInvalidated notification
+     *
+     * @param ClientMessageFrame::Ptr with the changed value
+     */
+    virtual void handleValueInvalidated(ClientMessageFrame::Ptr const);
+
+    /// Value removed callback handler from the Value Store, for invalidate subscriptions
+    virtual void handleInvalidatedRemoved(VariantValue::Ptr const);
+
 private:
     void connectAllListeners();
     void connectAddRemoveListeners();
     void disconnectListeners();
 
+    /// Registers with the store's subscription index on first use
+    void connectSubscriber();
+
     bool handleAddToContainer(std::string const&, AddToContainer const&);
     bool handleRemoveFromContainer(std::string const&, RemoveFromContainer const&);
 
     /// Checks if the VariantValue or it's parent is in the subscriber list
     bool isParentSubscribed(VariantValue::Ptr const valuePtr);
 
-    /// Copies the VariantValueStore elements into a repeated field accepting CompanEdgeProtocol::Value
-    void copyValueStoreToRepeated(google::protobuf::RepeatedPtrField<CompanEdgeProtocol::Value>*);
+    /// Streamed response waiting for it's chunks to be sent
+    struct ChunkedResponse {
+        enum Type { Sync, Result };
+
+        Type type;
+        uint32_t sequenceNo;
+        std::shared_ptr<VariantValueChunker> chunker;
+    };
+
+    /// Queues a response of the whole VariantValueStore and kicks off sending
+    void queueStoreResponse(ChunkedResponse::Type const type, uint32_t const sequenceNo);
+
+    /// Sends the next chunk, unless a previous chunk hasn't drained
+    void sendNextChunk();
 
     /*!
      * Walks the children of a value and adds it to the RepeatedPtrField
      *
-     * If doing a discrete subscription, adds it to the  wsSubscriberConnection_
+     * If doing a discrete subscription, subscribes to the value's subtree
      * @param valuePtr          Value to walk the child of
      * @param repeatedValues    RepeatedPtrField to add values to
-     * @param subscribe         Whether to add the value to wsSubscriberConnection_
+     * @param subscribe         Whether to subscribe to the value and it's children
      */
     void copyValueChildrenToRepeated(
             VariantValue::Ptr valuePtr,
             google::protobuf::RepeatedPtrField<CompanEdgeProtocol::Value>* repeatedValues,
             bool const subscribe = false);
 
-    /// Inserts the VariantValue::Ptr into the subscription connection filter
+    /// Subscribes to the VariantValue::Ptr's subtree in the store's subscription index
     void insertSubscriberFilter(VariantValue::Ptr valuePtr);
 
+    /*!
+     * Resumes a reconnecting client's subscription
+     *
+     * Responds with a delta VsResult of the values changed since the request's
+     * version, or resync_required if the store can't resume it
+     *
+     * @param VsSubscribe request, with the epoch and version the client is current to
+     */
+    void resumeSubscription(CompanEdgeProtocol::VsSubscribe const&);
+
+    /*!
+     * Subscribes a caching client's ids for invalidation
+     *
+     * Responds with a VsResult without values, ids not found aren't subscribed
+     *
+     * @param VsSubscribe request, flagged invalidate
+     */
+    void invalidateSubscription(CompanEdgeProtocol::VsSubscribe const&, ClientMessagePtr);
+
+    /// Sends a ValueInvalidated, once; the subscription covering the value is dropped
+    void sendInvalidated(VariantValue::Ptr const valuePtr);
+
 private:
     VariantValueStore& variantValueStore_;
     DmoContainer& dmo_;
 
-    // map of hashToken and value changed signal for discrete value connection
-    HashTokenMap<SignalScopedConnection> wsSubscriberConnection_;
+    // discrete subscriptions, held in the VariantValueStore's subscription index
+    VariantValueSubscriptionIndex::SubscriberId subscriberId_;
 
-    // listen for Variant ValueStore global connections
+    // invalidate subscriptions, a second subscriber of the index
+    VariantValueSubscriptionIndex::SubscriberId invalidateSubscriberId_;
+    SignalScopedConnection invalidateRemovedListener_;
+
+    // listen for Variant ValueStore global connections, changes come from the subscription index
     SignalScopedConnection addedListener_;
-    SignalScopedConnection changedListener_;
     SignalScopedConnection removedListener_;
 
     SignalScopedConnection addToContainerListener_;
     SignalScopedConnection removeFromContainerListener_;
+
+    std::mutex chunkMutex_;
+    std::deque<ChunkedResponse> chunkedResponses_;
+    CompanEdgeProtocol::ClientMessage const* chunkInFlight_; //!< Chunk waiting to drain
+    size_t chunkMaxValues_;
+    size_t chunkMaxBytes_;
 };
 
 } // namespace Edge
@@ -21,7 +21,7 @@ CompanLogger DmoFileLog("dmo.file", LogLevel::Information);
 
 namespace {
 
-void readDmoMessage(CompanEdgeDataModel::DataModelMessage& dmoData, DmoContainer& container)
+void readDmoMessage(CompanEdgeDataModel::DataModelMessage const& dmoData, DmoContainer& container)
 {
     for (auto& metaDataTypeDefs : dmoData.metadatadefs().metadatatypedefs()) {
 
@@ -83,6 +83,11 @@ bool DmoFile::read(std::istream& strm, DmoContainer& container, VariantValueStor
         return false;
     }
 
+    return DmoFile::read(dmoData, container, ws);
+}
+
+bool DmoFile::read(CompanEdgeDataModel::DataModelMessage const& dmoData, DmoContainer& container, VariantValueStore& ws)
+{
     if (dmoData.has_metadatadefs()) { readDmoMessage(dmoData, container); }
 
     // build up the structures required for meta data
@@ -94,49 +99,48 @@ bool DmoFile::read(std::istream& strm, DmoContainer& container, VariantValueStor
 
     if (!dmoData.has_dataentities()) return true;
 
-    DmoValueStoreHelper dmoHelper(container, ws);
-
     for (auto& value : dmoData.dataentities().value()) {
 
         if (value.type() == CompanEdgeProtocol::Container || value.type() == CompanEdgeProtocol::Struct) continue;
 
-        bool metaDataCorrect = true;
-
         // Here we validate that the element being added has
         // the correct entries in the WS - meaning, if it is from
         // meta data, it needs to have the meta data parent fully created
 
         ValueId id(value.id());
 
-        if (container.isInstance(id) && !ws.has(id)) {
-
-            // walk the ValueId path and insert key elements
-            ValueId metaPath = container.getMetaDataPath(id);
-            auto iterMeta = metaPath.begin();
-            auto iterId = id.begin();
+        if (container.isInstance(id) && !ws.has(id) && !insertKeys(id, container, ws)) continue;
 
-            ValueId parentId;
-            for (; iterId != id.end(); ++iterId, ++iterMeta) {
-                if (*iterMeta == DmoContainer::MetaContainerDelim) {
-                    if (!dmoHelper.insertChild(parentId, *iterId)) {
-                        ErrorLog(DmoFileLog)
-                                << "Failed to insert key: " << parentId << "[" << *iterId << "]" << std::endl;
+        ws.set(value);
+    }
 
-                        metaDataCorrect = false;
-                        break;
-                    }
-                }
+    return true;
+}
 
-                parentId += *iterId;
-            }
+bool DmoFile::insertKeys(ValueId const& valueId, DmoContainer const& container, VariantValueStore& ws)
+{
+    DmoValueStoreHelper dmoHelper(container, ws);
 
-            if (!ws.has(id)) {
-                WarnLog(DmoFileLog) << "Value is not present in metaData: " << id << std::endl;
-                metaDataCorrect = false;
+    // walk the ValueId path and insert key elements
+    ValueId metaPath = container.getMetaDataPath(valueId);
+    auto iterMeta = metaPath.begin();
+    auto iterId = valueId.begin();
+
+    ValueId parentId;
+    for (; iterId != valueId.end(); ++iterId, ++iterMeta) {
+        if (*iterMeta == DmoContainer::MetaContainerDelim) {
+            if (!dmoHelper.insertChild(parentId, *iterId)) {
+                ErrorLog(DmoFileLog) << "Failed to insert key: " << parentId << "[" << *iterId << "]" << std::endl;
+                break;
             }
         }
 
-        if (metaDataCorrect) ws.set(value);
+        parentId += *iterId;
+    }
+
+    if (!ws.has(valueId)) {
+        WarnLog(DmoFileLog) << "Value is not present in metaData: " << valueId << std::endl;
+        return false;
     }
 
     return true;
@@ -161,6 +165,13 @@ bool DmoFile::read(std::istream& strm, VariantValueStore& ws)
 bool DmoFile::write(std::ostream& strm, DmoContainer const& container)
 {
     CompanEdgeDataModel::DataModelMessage dmoData;
+    if (!DmoFile::write(container, dmoData)) return false;
+
+    return dmoData.SerializeToOstream(&strm);
+}
+
+bool DmoFile::write(DmoContainer const& container, CompanEdgeDataModel::DataModelMessage& dmoData)
+{
     CompanEdgeProtocol::ValueChanged* entities = dmoData.mutable_dataentities();
 
     container.visitValues([entities](CompanEdgeProtocol::Value const& value) { *entities->add_value() = value; });
@@ -214,7 +225,7 @@ bool DmoFile::write(std::ostream& strm, DmoContainer const& container)
         *metaDataDefs->add_metadatatypedefs() = metaDataTypeDefs;
     }
 
-    return dmoData.SerializeToOstream(&strm);
+    return true;
 }
 
 bool DmoFile::read(std::string const& path, DmoContainer& container)
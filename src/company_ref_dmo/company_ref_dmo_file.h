@@ -11,6 +11,10 @@
 #include <istream>
 #include <ostream>
 
+namespace CompanEdgeDataModel {
+class DataModelMessage;
+} // namespace CompanEdgeDataModel
+
 namespace Compan{
 namespace Edge {
 
@@ -26,6 +30,22 @@ struct DmoFile {
     static bool read(std::string const& path, DmoContainer& container, VariantValueStore& ws);
     static bool read(std::string const& path, VariantValueStore& ws);
     static bool write(std::string const& path, DmoContainer const& container);
+
+    /// Loads an already parsed datamodel, as restored with it's write ahead log
+    static bool read(
+            CompanEdgeDataModel::DataModelMessage const& dmoData,
+            DmoContainer& container,
+            VariantValueStore& ws);
+
+    /*!
+     * Inserts the container keys a meta data instance's value is under
+     *
+     * @returns false if the value is still missing from the store
+     */
+    static bool insertKeys(ValueId const& valueId, DmoContainer const& container, VariantValueStore& ws);
+
+    /// Builds the datamodel of a container, as written to a file
+    static bool write(DmoContainer const& container, CompanEdgeDataModel::DataModelMessage& dmoData);
 };
 
 } // namespace Edge
@@ -0,0 +1,174 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_dmo_shards.cpp
+ @brief datamodel persisted in shards
+ */
+
+#include "company_ref_dmo_shards.h"
+#include "company_ref_dmo_wal.h"
+
+#include <company_ref_protocol/company_ref_datamodel.pb.h>
+#include <Compan_logger/Compan_logger.h>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <future>
+#include <set>
+#include <sstream>
+#include <thread>
+
+using namespace Compan::Edge;
+
+CompanLogger DmoShardsLog("dmo.shards", LogLevel::Information);
+
+DmoShards::DmoShards(std::string const& persistPath)
+    : persistPath_(persistPath)
+    , dirPath_(boost::filesystem::path(persistPath).parent_path().generic_string())
+    , shards_()
+    , dirty_(false)
+{
+}
+
+std::string DmoShards::manifestPath(std::string const& persistPath)
+{
+    return persistPath + ".manifest";
+}
+
+bool DmoShards::exists(std::string const& persistPath)
+{
+    boost::system::error_code ec;
+    return boost::filesystem::exists(manifestPath(persistPath), ec);
+}
+
+std::string DmoShards::subtree(std::string const& valueId)
+{
+    return valueId.substr(0, valueId.find('.'));
+}
+
+bool DmoShards::read()
+{
+    FunctionArgLog(DmoShardsLog) << persistPath_ << std::endl;
+
+    std::string const path(manifestPath(persistPath_));
+
+    boost::system::error_code ec;
+    if (!boost::filesystem::exists(path, ec)) return true;
+
+    std::ifstream iFile(path.c_str());
+    if (!iFile.is_open()) {
+        ErrorLog(DmoShardsLog) << "Failed to open file: " << path << std::endl;
+        return false;
+    }
+
+    shards_.clear();
+
+    std::string line;
+    while (std::getline(iFile, line)) {
+        if (line.empty()) continue;
+
+        // subtrees don't hold spaces, the file name follows the first one
+        std::string::size_type const pos(line.find(' '));
+        if (pos == std::string::npos || pos + 1 == line.size()) {
+            ErrorLog(DmoShardsLog) << "Malformed line in " << path << ": " << line << std::endl;
+            return false;
+        }
+
+        shards_[line.substr(0, pos)] = line.substr(pos + 1);
+    }
+
+    dirty_ = false;
+
+    return true;
+}
+
+bool DmoShards::write()
+{
+    if (!dirty_) return true;
+
+    FunctionArgLog(DmoShardsLog) << persistPath_ << std::endl;
+
+    std::ostringstream oStr;
+    for (auto& shard : shards_) oStr << shard.first << ' ' << shard.second << '\n';
+
+    if (!DmoWal::replaceFile(manifestPath(persistPath_), oStr.str())) return false;
+
+    dirty_ = false;
+
+    return true;
+}
+
+std::string DmoShards::shardPath(std::string const& subtree)
+{
+    auto iter = shards_.find(subtree);
+
+    if (iter == shards_.end()) {
+        std::set<std::string> names;
+        for (auto& shard : shards_) names.insert(shard.second);
+
+        std::string const fileName(boost::filesystem::path(persistPath_).filename().generic_string());
+
+        // names are numbered, never reused for another subtree
+        size_t index(shards_.size());
+        std::string name(fileName + "." + std::to_string(index));
+        while (names.count(name)) name = fileName + "." + std::to_string(++index);
+
+        DebugLog(DmoShardsLog) << __FUNCTION__ << ": " << subtree << " in " << name << std::endl;
+
+        iter = shards_.emplace(subtree, name).first;
+        dirty_ = true;
+    }
+
+    return (boost::filesystem::path(dirPath_) / iter->second).generic_string();
+}
+
+std::vector<std::string> DmoShards::shardPaths() const
+{
+    std::vector<std::string> paths;
+    paths.reserve(shards_.size());
+
+    for (auto& shard : shards_) paths.push_back((boost::filesystem::path(dirPath_) / shard.second).generic_string());
+
+    return paths;
+}
+
+bool DmoShards::restore(std::string const& persistPath, std::vector<CompanEdgeDataModel::DataModelMessage>& dmoData)
+{
+    FunctionArgLog(DmoShardsLog) << persistPath << std::endl;
+
+    DmoShards shards(persistPath);
+    if (!shards.read()) return false;
+
+    std::vector<std::string> const paths(shards.shardPaths());
+
+    dmoData.clear();
+    dmoData.resize(paths.size());
+
+    // shards are parsed and replayed by a pool of workers, each takes the next one
+    size_t const workers(
+            std::min<size_t>(paths.size(), std::max<unsigned>(1, std::thread::hardware_concurrency())));
+
+    std::atomic<size_t> next(0);
+    std::vector<std::future<bool>> results;
+
+    for (size_t i = 0; i < workers; ++i) {
+        results.push_back(std::async(std::launch::async, [&paths, &dmoData, &next]() {
+            bool restored(true);
+
+            for (size_t shard = next++; shard < paths.size(); shard = next++)
+                restored = DmoWal::restore(paths[shard], dmoData[shard]) && restored;
+
+            return restored;
+        }));
+    }
+
+    bool restored(true);
+    for (auto& result : results) restored = result.get() && restored;
+
+    DebugLog(DmoShardsLog) << __FUNCTION__ << ": " << paths.size() << " shards, " << workers << " workers"
+                           << std::endl;
+
+    return restored;
+}
@@ -0,0 +1,93 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_dmo_shards.h
+ @brief datamodel persisted in shards
+ */
+#ifndef __company_ref_DMO_company_ref_DMO_SHARDS_H__
+#define __company_ref_DMO_company_ref_DMO_SHARDS_H__
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace CompanEdgeDataModel {
+class DataModelMessage;
+} // namespace CompanEdgeDataModel
+
+namespace Compan{
+namespace Edge {
+
+/*!
+ * @brief Manifest of a persisted datamodel split in shards
+ *
+ * Values are partitioned by their top level subtree; each shard is a
+ * persisted file of it's own, with it's own write ahead log (DmoWal), so
+ * changes only touch the shards holding them.
+ *
+ * The manifest, <persistPath>.manifest, lists a line per shard:
+ *
+ *      <subtree> <file name>
+ *
+ * file names being relative to the manifest's directory. It's rewritten
+ * to a temporary file and renamed when a shard is added.
+ */
+class DmoShards {
+public:
+    using ShardMap = std::map<std::string, std::string>; //!< file name by subtree
+
+    explicit DmoShards(std::string const& persistPath);
+    virtual ~DmoShards() = default;
+
+    static std::string manifestPath(std::string const& persistPath);
+
+    /// Whether the persisted file is sharded
+    static bool exists(std::string const& persistPath);
+
+    /// Shard of a value
+    static std::string subtree(std::string const& valueId);
+
+    /// Reads the manifest, true if there's none yet
+    bool read();
+
+    /// Writes the manifest, if shards were added
+    bool write();
+
+    /// Path of the subtree's shard, added if it's new
+    std::string shardPath(std::string const& subtree);
+
+    /// Paths of all the shards
+    std::vector<std::string> shardPaths() const;
+
+    bool dirty() const;
+    ShardMap const& shards() const;
+
+    /*!
+     * Restores all the shards, in parallel
+     *
+     * @param persistPath   the persisted file, it's manifest is read
+     * @param dmoData       a datamodel per shard
+     */
+    static bool restore(std::string const& persistPath, std::vector<CompanEdgeDataModel::DataModelMessage>& dmoData);
+
+private:
+    std::string const persistPath_;
+    std::string const dirPath_;
+
+    ShardMap shards_;
+    bool dirty_; //!< shards added since the manifest was written
+};
+
+inline bool DmoShards::dirty() const
+{
+    return dirty_;
+}
+
+inline DmoShards::ShardMap const& DmoShards::shards() const
+{
+    return shards_;
+}
+
+} // namespace Edge
+} // namespace Compan
+
+#endif // __company_ref_DMO_company_ref_DMO_SHARDS_H__
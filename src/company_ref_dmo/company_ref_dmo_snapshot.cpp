@@ -0,0 +1,478 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_dmo_snapshot.cpp
+ @brief datamodel binary snapshot
+ */
+
+#include "company_ref_dmo_snapshot.h"
+#include "company_ref_dmo_file.h"
+#include "company_ref_dmo_wal.h"
+
+#include <company_ref_protocol/company_ref_datamodel.pb.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_hash_methods.h>
+#include <Compan_logger/Compan_logger.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+using namespace Compan::Edge;
+
+CompanLogger DmoSnapshotLog("dmo.snapshot", LogLevel::Information);
+
+uint32_t const DmoSnapshot::Version(1);
+
+namespace {
+
+char const Magic[8] = {'C', 'E', 'D', 'M', 'O', 'S', 'N', 'P'};
+
+size_t const Alignment(8);
+
+void putUint32(std::string& buffer, uint32_t const value)
+{
+    for (int i = 0; i < 4; ++i) buffer.push_back(static_cast<char>((value >> (i * 8)) & 0xff));
+}
+
+void putUint64(std::string& buffer, uint64_t const value)
+{
+    for (int i = 0; i < 8; ++i) buffer.push_back(static_cast<char>((value >> (i * 8)) & 0xff));
+}
+
+uint32_t getUint32(char const* data)
+{
+    uint32_t value(0);
+    for (int i = 0; i < 4; ++i) value |= static_cast<uint32_t>(static_cast<uint8_t>(data[i])) << (i * 8);
+
+    return value;
+}
+
+uint64_t getUint64(char const* data)
+{
+    uint64_t value(0);
+    for (int i = 0; i < 8; ++i) value |= static_cast<uint64_t>(static_cast<uint8_t>(data[i])) << (i * 8);
+
+    return value;
+}
+
+/// Pads the buffer up to the next section
+void align(std::string& buffer)
+{
+    buffer.resize((buffer.size() + Alignment - 1) / Alignment * Alignment, '\0');
+}
+
+/// Columns are read in place, in the host's byte order
+bool isLittleEndian()
+{
+    uint16_t const probe(1);
+    return *reinterpret_cast<uint8_t const*>(&probe) == 1;
+}
+
+} // namespace
+
+/// Section offsets and sizes, in bytes from the start of the file
+struct DmoSnapshot::Header {
+    static size_t const Size = 96;
+
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t valueCount;
+    uint64_t metaDataOffset;
+    uint64_t metaDataSize;
+    uint64_t idTableOffset;
+    uint64_t typesOffset;
+    uint64_t valueOffsetsOffset;
+    uint64_t idHeapOffset;
+    uint64_t idHeapSize;
+    uint64_t valueHeapOffset;
+    uint64_t valueHeapSize;
+
+    void encode(std::string& buffer) const
+    {
+        buffer.append(Magic, sizeof(Magic));
+        putUint32(buffer, version);
+        putUint32(buffer, headerSize);
+        putUint64(buffer, valueCount);
+        putUint64(buffer, metaDataOffset);
+        putUint64(buffer, metaDataSize);
+        putUint64(buffer, idTableOffset);
+        putUint64(buffer, typesOffset);
+        putUint64(buffer, valueOffsetsOffset);
+        putUint64(buffer, idHeapOffset);
+        putUint64(buffer, idHeapSize);
+        putUint64(buffer, valueHeapOffset);
+        putUint64(buffer, valueHeapSize);
+    }
+
+    void decode(char const* data)
+    {
+        data += sizeof(Magic);
+        version = getUint32(data);
+        headerSize = getUint32(data + 4);
+        valueCount = getUint64(data + 8);
+        metaDataOffset = getUint64(data + 16);
+        metaDataSize = getUint64(data + 24);
+        idTableOffset = getUint64(data + 32);
+        typesOffset = getUint64(data + 40);
+        valueOffsetsOffset = getUint64(data + 48);
+        idHeapOffset = getUint64(data + 56);
+        idHeapSize = getUint64(data + 64);
+        valueHeapOffset = getUint64(data + 72);
+        valueHeapSize = getUint64(data + 80);
+    }
+};
+
+DmoSnapshot::DmoSnapshot()
+    : path_()
+    , data_(nullptr)
+    , dataSize_(0)
+    , size_(0)
+    , metaData_(nullptr)
+    , metaDataSize_(0)
+    , idTable_(nullptr)
+    , types_(nullptr)
+    , valueOffsets_(nullptr)
+    , idHeap_(nullptr)
+    , idHeapSize_(0)
+    , valueHeap_(nullptr)
+    , valueHeapSize_(0)
+{
+}
+
+DmoSnapshot::~DmoSnapshot()
+{
+    close();
+}
+
+bool DmoSnapshot::open(std::string const& path)
+{
+    FunctionArgLog(DmoSnapshotLog) << path << std::endl;
+
+    close();
+
+    if (!isLittleEndian()) {
+        ErrorLog(DmoSnapshotLog) << "Snapshots are only read on little endian hosts: " << path << std::endl;
+        return false;
+    }
+
+    int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        ErrorLog(DmoSnapshotLog) << "Failed to open file: " << path << " - " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < Header::Size) {
+        ErrorLog(DmoSnapshotLog) << "Not a snapshot: " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    void* const data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (data == MAP_FAILED) {
+        ErrorLog(DmoSnapshotLog) << "Failed to map file: " << path << " - " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // values are read front to back, once
+    ::madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+    path_ = path;
+    data_ = static_cast<char const*>(data);
+    dataSize_ = st.st_size;
+
+    if (!validate()) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void DmoSnapshot::close()
+{
+    if (data_) ::munmap(const_cast<char*>(data_), dataSize_);
+
+    data_ = nullptr;
+    dataSize_ = 0;
+    size_ = 0;
+    metaData_ = nullptr;
+    metaDataSize_ = 0;
+    idTable_ = nullptr;
+    types_ = nullptr;
+    valueOffsets_ = nullptr;
+    idHeap_ = nullptr;
+    idHeapSize_ = 0;
+    valueHeap_ = nullptr;
+    valueHeapSize_ = 0;
+}
+
+bool DmoSnapshot::validate()
+{
+    if (memcmp(data_, Magic, sizeof(Magic)) != 0) {
+        ErrorLog(DmoSnapshotLog) << "Not a snapshot: " << path_ << std::endl;
+        return false;
+    }
+
+    Header header;
+    header.decode(data_);
+
+    if (header.version != Version) {
+        ErrorLog(DmoSnapshotLog) << "Unsupported snapshot version " << header.version << ": " << path_ << std::endl;
+        return false;
+    }
+
+    // sections lie within the file, and the in place columns are aligned
+    auto const inside = [this](uint64_t const offset, uint64_t const size) {
+        return offset % Alignment == 0 && offset <= dataSize_ && size <= dataSize_ - offset;
+    };
+
+    uint64_t const count(header.valueCount);
+    bool const valid = header.headerSize >= Header::Size && count < dataSize_
+                       && inside(header.metaDataOffset, header.metaDataSize)
+                       && inside(header.idTableOffset, count * sizeof(IdEntry))
+                       && inside(header.typesOffset, count)
+                       && inside(header.valueOffsetsOffset, (count + 1) * sizeof(uint64_t))
+                       && inside(header.idHeapOffset, header.idHeapSize)
+                       && inside(header.valueHeapOffset, header.valueHeapSize);
+
+    if (!valid) {
+        ErrorLog(DmoSnapshotLog) << "Corrupted snapshot: " << path_ << std::endl;
+        return false;
+    }
+
+    size_ = count;
+    metaData_ = data_ + header.metaDataOffset;
+    metaDataSize_ = header.metaDataSize;
+    idTable_ = reinterpret_cast<IdEntry const*>(data_ + header.idTableOffset);
+    types_ = reinterpret_cast<uint8_t const*>(data_ + header.typesOffset);
+    valueOffsets_ = reinterpret_cast<uint64_t const*>(data_ + header.valueOffsetsOffset);
+    idHeap_ = data_ + header.idHeapOffset;
+    idHeapSize_ = header.idHeapSize;
+    valueHeap_ = data_ + header.valueHeapOffset;
+    valueHeapSize_ = header.valueHeapSize;
+
+    return true;
+}
+
+std::string DmoSnapshot::id(size_t const index) const
+{
+    if (index >= size_) return std::string();
+
+    IdEntry const& entry(idTable_[index]);
+    if (entry.offset > idHeapSize_ || entry.length > idHeapSize_ - entry.offset) return std::string();
+
+    return std::string(idHeap_ + entry.offset, entry.length);
+}
+
+HashToken::HashIdType DmoSnapshot::hashId(size_t const index) const
+{
+    if (index >= size_) return HashToken::InvalidHashId;
+
+    return idTable_[index].hashId;
+}
+
+CompanEdgeProtocol::Value_Type DmoSnapshot::type(size_t const index) const
+{
+    if (index >= size_) return CompanEdgeProtocol::Unknown;
+
+    return static_cast<CompanEdgeProtocol::Value_Type>(types_[index]);
+}
+
+bool DmoSnapshot::value(size_t const index, CompanEdgeProtocol::Value& value) const
+{
+    if (index >= size_) return false;
+
+    IdEntry const& entry(idTable_[index]);
+    uint64_t const begin(valueOffsets_[index]);
+    uint64_t const end(valueOffsets_[index + 1]);
+
+    if (entry.offset > idHeapSize_ || entry.length > idHeapSize_ - entry.offset || begin > end
+        || end > valueHeapSize_) {
+        ErrorLog(DmoSnapshotLog) << "Corrupted value " << index << ": " << path_ << std::endl;
+        return false;
+    }
+
+    if (!value.ParseFromArray(valueHeap_ + begin, end - begin)) {
+        ErrorLog(DmoSnapshotLog) << "Failed to parse value " << index << ": " << path_ << std::endl;
+        return false;
+    }
+
+    value.set_id(idHeap_ + entry.offset, entry.length);
+
+    return true;
+}
+
+bool DmoSnapshot::metaData(CompanEdgeDataModel::MetaDataDefs& metaDataDefs) const
+{
+    if (!isOpen()) return false;
+
+    if (!metaDataDefs.ParseFromArray(metaData_, metaDataSize_)) {
+        ErrorLog(DmoSnapshotLog) << "Failed to parse meta data: " << path_ << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool DmoSnapshot::isSnapshot(std::string const& path)
+{
+    std::ifstream iFile(path.c_str(), std::ios::binary);
+    if (!iFile.is_open()) return false;
+
+    char magic[sizeof(Magic)];
+    if (!iFile.read(magic, sizeof(magic))) return false;
+
+    return memcmp(magic, Magic, sizeof(Magic)) == 0;
+}
+
+bool DmoSnapshot::write(std::string const& path, CompanEdgeDataModel::DataModelMessage const& dmoData)
+{
+    FunctionArgLog(DmoSnapshotLog) << path << std::endl;
+
+    auto const& values = dmoData.dataentities().value();
+
+    std::vector<int> order(values.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    std::stable_sort(order.begin(), order.end(), [&values](int const lhs, int const rhs) {
+        return values.Get(lhs).id() < values.Get(rhs).id();
+    });
+
+    // the last of a repeated id is kept, the ones kept are moved to the back
+    auto const kept = std::unique(order.rbegin(), order.rend(), [&values](int const lhs, int const rhs) {
+        return values.Get(lhs).id() == values.Get(rhs).id();
+    });
+    order.erase(order.begin(), kept.base());
+
+    std::string idHeap;
+    std::string valueHeap;
+    std::string idTable;
+    std::string types;
+    std::string valueOffsets;
+
+    idTable.reserve(order.size() * sizeof(IdEntry));
+    types.reserve(order.size());
+    valueOffsets.reserve((order.size() + 1) * sizeof(uint64_t));
+
+    CompanEdgeProtocol::Value payload;
+
+    for (int const index : order) {
+        CompanEdgeProtocol::Value const& value(values.Get(index));
+
+        if (idHeap.size() + value.id().size() > std::numeric_limits<uint32_t>::max()) {
+            ErrorLog(DmoSnapshotLog) << "Too many ids for a snapshot: " << path << std::endl;
+            return false;
+        }
+
+        putUint32(idTable, idHeap.size());
+        putUint32(idTable, value.id().size());
+        putUint32(idTable, FnvHash::as32(value.id()));
+        putUint32(idTable, 0);
+        idHeap.append(value.id());
+
+        types.push_back(static_cast<char>(value.type()));
+
+        // the id is in the id heap, and hash tokens are the store's own
+        payload = value;
+        payload.clear_id();
+        payload.clear_hashtoken();
+
+        putUint64(valueOffsets, valueHeap.size());
+        payload.AppendToString(&valueHeap);
+    }
+    putUint64(valueOffsets, valueHeap.size());
+
+    std::string metaData;
+    dmoData.metadatadefs().SerializeToString(&metaData);
+
+    Header header;
+    header.version = Version;
+    header.headerSize = Header::Size;
+    header.valueCount = order.size();
+
+    std::string data;
+    data.reserve(Header::Size + metaData.size() + idTable.size() + types.size() + valueOffsets.size() + idHeap.size()
+                 + valueHeap.size() + 5 * Alignment);
+    data.resize(Header::Size);
+
+    auto const appendSection = [&data](std::string const& section) {
+        uint64_t const offset(data.size());
+        data.append(section);
+        align(data);
+
+        return offset;
+    };
+
+    header.metaDataOffset = appendSection(metaData);
+    header.metaDataSize = metaData.size();
+    header.idTableOffset = appendSection(idTable);
+    header.typesOffset = appendSection(types);
+    header.valueOffsetsOffset = appendSection(valueOffsets);
+    header.idHeapOffset = appendSection(idHeap);
+    header.idHeapSize = idHeap.size();
+    header.valueHeapOffset = appendSection(valueHeap);
+    header.valueHeapSize = valueHeap.size();
+
+    std::string encoded;
+    header.encode(encoded);
+    data.replace(0, encoded.size(), encoded);
+
+    if (!DmoWal::replaceFile(path, data)) return false;
+
+    DebugLog(DmoSnapshotLog) << __FUNCTION__ << ": " << order.size() << " values, " << data.size() << " bytes"
+                             << std::endl;
+
+    return true;
+}
+
+bool DmoSnapshot::read(std::string const& path, DmoContainer& container, VariantValueStore& ws)
+{
+    FunctionArgLog(DmoSnapshotLog) << path << std::endl;
+
+    DmoSnapshot snapshot;
+    if (!snapshot.open(path)) return false;
+
+    // meta data is loaded as a datamodel file's, values are then merged in id order
+    CompanEdgeDataModel::DataModelMessage dmoData;
+    if (!snapshot.metaData(*dmoData.mutable_metadatadefs())) return false;
+
+    if (!DmoFile::read(dmoData, container, ws)) return false;
+
+    size_t index(0);
+
+    size_t const loaded = ws.setSorted([&snapshot, &index, &container, &ws](
+                                               CompanEdgeProtocol::Value& value, HashToken::HashIdType& hashId) {
+        while (index < snapshot.size()) {
+            size_t const current(index++);
+
+            CompanEdgeProtocol::Value_Type const type(snapshot.type(current));
+            if (type == CompanEdgeProtocol::Container || type == CompanEdgeProtocol::Struct) continue;
+
+            if (!snapshot.value(current, value)) continue;
+
+            ValueId const id(value.id());
+            if (container.isInstance(id) && !ws.has(id) && !DmoFile::insertKeys(id, container, ws)) continue;
+
+            hashId = snapshot.hashId(current);
+            return true;
+        }
+
+        return false;
+    });
+
+    DebugLog(DmoSnapshotLog) << __FUNCTION__ << ": " << loaded << " of " << snapshot.size() << " values" << std::endl;
+
+    return true;
+}
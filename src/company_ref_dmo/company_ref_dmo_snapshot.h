@@ -0,0 +1,132 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_dmo_snapshot.h
+ @brief datamodel binary snapshot
+ */
+#ifndef __company_ref_DMO_company_ref_DMO_SNAPSHOT_H__
+#define __company_ref_DMO_company_ref_DMO_SNAPSHOT_H__
+
+#include <company_ref_protocol/company_ref_protocol.pb.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_hash_token.h>
+
+#include <cstdint>
+#include <string>
+
+namespace CompanEdgeDataModel {
+class DataModelMessage;
+class MetaDataDefs;
+} // namespace CompanEdgeDataModel
+
+namespace Compan{
+namespace Edge {
+
+class DmoContainer;
+class VariantValueStore;
+
+/*!
+ * @brief Versioned binary image of a datamodel, read in place through mmap
+ *
+ * Rather than parsing a whole DataModelMessage, the snapshot is mapped and
+ * it's values are handed to the store in id order, in one sequential pass.
+ * The layout is little endian, with every section 8 byte aligned:
+ *
+ *      header          magic "CEDMOSNP", version, section offsets
+ *      meta data       encoded MetaDataDefs
+ *      id table        uint32 id offset | uint32 id length | uint32 hash id | uint32 reserved,
+ *                      per value, sorted by id
+ *      type column     uint8 Value type, per value
+ *      value column    uint64 offsets of the values in the value heap, plus the end
+ *      id heap         the ids, back to back
+ *      value heap      each Value encoded without it's id
+ *
+ * Hash ids are FnvHash::as32 of the ids, the store's default hash function.
+ */
+class DmoSnapshot {
+public:
+    static uint32_t const Version;
+
+    DmoSnapshot();
+    virtual ~DmoSnapshot();
+
+    DmoSnapshot(DmoSnapshot const&) = delete;
+    DmoSnapshot& operator=(DmoSnapshot const&) = delete;
+
+    /// Maps a snapshot, validating it's header and sections
+    bool open(std::string const& path);
+    void close();
+    bool isOpen() const;
+
+    /// Number of values
+    size_t size() const;
+
+    /// Id of a value, by it's index in id order
+    std::string id(size_t const index) const;
+
+    /// Precomputed hash id of a value
+    HashToken::HashIdType hashId(size_t const index) const;
+
+    CompanEdgeProtocol::Value_Type type(size_t const index) const;
+
+    /// Decodes a value, with it's id
+    bool value(size_t const index, CompanEdgeProtocol::Value& value) const;
+
+    /// Decodes the meta data definitions
+    bool metaData(CompanEdgeDataModel::MetaDataDefs& metaDataDefs) const;
+
+    /// Whether a file starts with a snapshot's magic
+    static bool isSnapshot(std::string const& path);
+
+    /*!
+     * Writes a datamodel as a snapshot
+     *
+     * Values are sorted by id, the last one is kept when an id is repeated.
+     */
+    static bool write(std::string const& path, CompanEdgeDataModel::DataModelMessage const& dmoData);
+
+    /// Loads the meta data into the container, and the values into the store in id order
+    static bool read(std::string const& path, DmoContainer& container, VariantValueStore& ws);
+
+private:
+    struct IdEntry {
+        uint32_t offset;
+        uint32_t length;
+        uint32_t hashId;
+        uint32_t reserved;
+    };
+
+    struct Header;
+
+    bool validate();
+
+private:
+    std::string path_;
+
+    char const* data_; //!< the mapped file
+    size_t dataSize_;
+
+    size_t size_;
+    char const* metaData_;
+    size_t metaDataSize_;
+    IdEntry const* idTable_;
+    uint8_t const* types_;
+    uint64_t const* valueOffsets_;
+    char const* idHeap_;
+    size_t idHeapSize_;
+    char const* valueHeap_;
+    size_t valueHeapSize_;
+};
+
+inline bool DmoSnapshot::isOpen() const
+{
+    return data_ != nullptr;
+}
+
+inline size_t DmoSnapshot::size() const
+{
+    return size_;
+}
+
+} // namespace Edge
+} // namespace Compan
+
+#endif // __company_ref_DMO_company_ref_DMO_SNAPSHOT_H__
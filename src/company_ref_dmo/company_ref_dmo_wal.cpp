@@ -0,0 +1,439 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_dmo_wal.cpp
+ @brief datamodel write ahead log
+ */
+
+#include "company_ref_dmo_wal.h"
+
+#include <company_ref_protocol/company_ref_datamodel.pb.h>
+#include <Compan_logger/Compan_logger.h>
+
+#include <boost/crc.hpp>
+#include <boost/filesystem.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+using namespace Compan::Edge;
+
+CompanLogger DmoWalLog("dmo.wal", LogLevel::Information);
+
+namespace {
+
+size_t const RecordHeaderSize(8); //!< length and crc32, the length counts the type and payload
+
+using RecordFunction = std::function<void(DmoWal::RecordType const, std::string const&)>;
+
+void putUint32(std::string& buffer, uint32_t const value)
+{
+    for (int i = 0; i < 4; ++i) buffer.push_back(static_cast<char>((value >> (i * 8)) & 0xff));
+}
+
+uint32_t getUint32(char const* data)
+{
+    uint32_t value(0);
+    for (int i = 0; i < 4; ++i) value |= static_cast<uint32_t>(static_cast<uint8_t>(data[i])) << (i * 8);
+
+    return value;
+}
+
+uint32_t checksum(char const* data, size_t const size)
+{
+    boost::crc_32_type crc;
+    crc.process_bytes(data, size);
+
+    return crc.checksum();
+}
+
+/*!
+ * Reads the records of a log
+ *
+ * @returns the length of the log up to the first torn record
+ */
+uint64_t readRecords(std::string const& logPath, RecordFunction const& fn)
+{
+    std::ifstream iFile(logPath.c_str(), std::ios::binary);
+    if (!iFile.is_open()) return 0;
+
+    iFile.seekg(0, std::ios::end);
+    uint64_t const fileSize(iFile.tellg());
+    iFile.seekg(0, std::ios::beg);
+
+    uint64_t length(0);
+    char header[RecordHeaderSize];
+    std::string record;
+
+    while (iFile.read(header, RecordHeaderSize)) {
+        uint32_t const recordSize(getUint32(header));
+        if (recordSize == 0) break;
+
+        // a length past the end of the log is torn, rather than allocated
+        if (recordSize > fileSize - length - RecordHeaderSize) break;
+
+        record.resize(recordSize);
+        if (!iFile.read(&record[0], recordSize)) break;
+
+        if (checksum(record.data(), record.size()) != getUint32(header + 4)) break;
+
+        DmoWal::RecordType const type(static_cast<DmoWal::RecordType>(record[0]));
+        if (type != DmoWal::SetRecord && type != DmoWal::RemoveRecord) break;
+
+        if (fn) fn(type, record.substr(1));
+
+        length += RecordHeaderSize + recordSize;
+    }
+
+    return length;
+}
+
+/// Writes all of the data, retrying partial writes
+bool writeAll(int const fd, char const* data, size_t size)
+{
+    while (size) {
+        ssize_t const written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+
+        data += written;
+        size -= written;
+    }
+
+    return true;
+}
+
+/// Syncs the directory, so a created or renamed entry survives a crash
+void syncDirectory(std::string const& path)
+{
+    std::string dirPath(boost::filesystem::path(path).parent_path().generic_string());
+    if (dirPath.empty()) dirPath = ".";
+
+    int const fd = ::open(dirPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return;
+
+    ::fsync(fd);
+    ::close(fd);
+}
+
+} // namespace
+
+DmoWal::DmoWal(std::string const& snapshotPath)
+    : snapshotPath_(snapshotPath)
+    , logPath_(logPath(snapshotPath))
+    , fd_(-1)
+    , buffer_()
+    , pending_(0)
+    , logSize_(0)
+    , unsynced_(false)
+{
+}
+
+DmoWal::~DmoWal()
+{
+    close();
+}
+
+bool DmoWal::open()
+{
+    FunctionArgLog(DmoWalLog) << logPath_ << std::endl;
+
+    if (isOpen()) return true;
+
+    boost::system::error_code ec;
+    uint64_t const fileSize = boost::filesystem::exists(logPath_, ec) ? boost::filesystem::file_size(logPath_, ec) : 0;
+
+    logSize_ = readRecords(logPath_, nullptr);
+
+    // appended records must follow the last whole one
+    if (fileSize > logSize_) {
+        WarnLog(DmoWalLog) << __FUNCTION__ << ": truncating " << logPath_ << " from " << fileSize << " to "
+                           << logSize_ << std::endl;
+
+        if (::truncate(logPath_.c_str(), logSize_) != 0) {
+            ErrorLog(DmoWalLog) << "Failed to truncate: " << logPath_ << " - " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+
+    fd_ = ::open(logPath_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        ErrorLog(DmoWalLog) << "Failed to open file for writing: " << logPath_ << " - " << strerror(errno)
+                            << std::endl;
+        return false;
+    }
+
+    if (fileSize == 0) syncDirectory(logPath_);
+
+    return true;
+}
+
+void DmoWal::close()
+{
+    if (!isOpen()) return;
+
+    sync();
+
+    ::close(fd_);
+    fd_ = -1;
+    unsynced_ = false;
+}
+
+void DmoWal::append(CompanEdgeProtocol::Value const& value)
+{
+    appendRecord(SetRecord, value.SerializeAsString());
+}
+
+void DmoWal::appendRemove(std::string const& valueId)
+{
+    appendRecord(RemoveRecord, valueId);
+}
+
+void DmoWal::appendRecord(RecordType const type, std::string const& payload)
+{
+    size_t const offset(buffer_.size());
+
+    // the crc is filled in once the record is in place
+    putUint32(buffer_, static_cast<uint32_t>(payload.size() + 1));
+    putUint32(buffer_, 0);
+    buffer_.push_back(static_cast<char>(type));
+    buffer_.append(payload);
+
+    uint32_t const crc(checksum(&buffer_[offset + RecordHeaderSize], payload.size() + 1));
+    for (int i = 0; i < 4; ++i) buffer_[offset + 4 + i] = static_cast<char>((crc >> (i * 8)) & 0xff);
+
+    ++pending_;
+}
+
+bool DmoWal::write()
+{
+    if (buffer_.empty()) return true;
+
+    if (!isOpen()) {
+        ErrorLog(DmoWalLog) << __FUNCTION__ << ": not open " << logPath_ << std::endl;
+        return false;
+    }
+
+    if (!writeAll(fd_, buffer_.data(), buffer_.size())) {
+        ErrorLog(DmoWalLog) << "Failed to write: " << logPath_ << " - " << strerror(errno) << std::endl;
+
+        // a partial record would hide the ones appended after it
+        if (::ftruncate(fd_, logSize_) != 0)
+            ErrorLog(DmoWalLog) << "Failed to truncate: " << logPath_ << " - " << strerror(errno) << std::endl;
+
+        return false;
+    }
+
+    DebugLog(DmoWalLog) << __FUNCTION__ << ": " << pending_ << " records, " << buffer_.size() << " bytes"
+                        << std::endl;
+
+    logSize_ += buffer_.size();
+    buffer_.clear();
+    pending_ = 0;
+    unsynced_ = true;
+
+    return true;
+}
+
+bool DmoWal::sync()
+{
+    if (!write()) return false;
+
+    if (!unsynced_) return true;
+
+    if (::fdatasync(fd_) != 0) {
+        ErrorLog(DmoWalLog) << "Failed to sync: " << logPath_ << " - " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    unsynced_ = false;
+
+    return true;
+}
+
+bool DmoWal::rotate()
+{
+    FunctionArgLog(DmoWalLog) << logPath_ << std::endl;
+
+    std::string const rotated(rotatedPath(snapshotPath_));
+
+    boost::system::error_code ec;
+    if (boost::filesystem::exists(rotated, ec)) return false;
+
+    if (!sync()) return false;
+
+    close();
+
+    if (::rename(logPath_.c_str(), rotated.c_str()) != 0) {
+        ErrorLog(DmoWalLog) << "Failed to rename: " << logPath_ << " - " << strerror(errno) << std::endl;
+        open();
+        return false;
+    }
+
+    syncDirectory(logPath_);
+
+    logSize_ = 0;
+
+    return open();
+}
+
+std::string DmoWal::logPath(std::string const& snapshotPath)
+{
+    return snapshotPath + ".wal";
+}
+
+std::string DmoWal::rotatedPath(std::string const& snapshotPath)
+{
+    return snapshotPath + ".wal.1";
+}
+
+bool DmoWal::compact(std::string const& snapshotPath)
+{
+    FunctionArgLog(DmoWalLog) << snapshotPath << std::endl;
+
+    std::string const rotated(rotatedPath(snapshotPath));
+
+    boost::system::error_code ec;
+    if (!boost::filesystem::exists(rotated, ec)) return true;
+
+    CompanEdgeDataModel::DataModelMessage dmoData;
+
+    {
+        std::ifstream iFile(snapshotPath.c_str(), std::ios::binary);
+        if (iFile.is_open() && !dmoData.ParseFromIstream(&iFile)) {
+            ErrorLog(DmoWalLog) << "Failed to parse: " << snapshotPath << std::endl;
+            return false;
+        }
+    }
+
+    if (!replay(rotated, dmoData)) return false;
+
+    std::string const data(dmoData.SerializeAsString());
+
+    // the old snapshot and the rotated log stay whole until the new one is
+    if (!replaceFile(snapshotPath, data)) return false;
+
+    ::unlink(rotated.c_str());
+    syncDirectory(snapshotPath);
+
+    DebugLog(DmoWalLog) << __FUNCTION__ << ": " << dmoData.dataentities().value_size() << " values, " << data.size()
+                        << " bytes" << std::endl;
+
+    return true;
+}
+
+bool DmoWal::replay(std::string const& logPath, CompanEdgeDataModel::DataModelMessage& dmoData)
+{
+    FunctionArgLog(DmoWalLog) << logPath << std::endl;
+
+    boost::system::error_code ec;
+    if (!boost::filesystem::exists(logPath, ec)) return true;
+
+    google::protobuf::RepeatedPtrField<CompanEdgeProtocol::Value>* values =
+            dmoData.mutable_dataentities()->mutable_value();
+
+    // indexed once, rather than searched per record
+    std::unordered_map<std::string, int> index;
+    std::vector<bool> removed(values->size(), false);
+
+    for (int i = 0; i < values->size(); ++i) index[values->Get(i).id()] = i;
+
+    size_t records(0);
+    bool parsed(true);
+
+    uint64_t const length = readRecords(
+            logPath,
+            [values, &index, &removed, &records, &parsed](RecordType const type, std::string const& payload) {
+                ++records;
+
+                if (type == RemoveRecord) {
+                    auto iter = index.find(payload);
+                    if (iter != index.end()) removed[iter->second] = true;
+                    return;
+                }
+
+                CompanEdgeProtocol::Value value;
+                if (!value.ParseFromString(payload)) {
+                    parsed = false;
+                    return;
+                }
+
+                auto iter = index.find(value.id());
+                if (iter != index.end()) {
+                    *values->Mutable(iter->second) = std::move(value);
+                    removed[iter->second] = false;
+                    return;
+                }
+
+                index.emplace(value.id(), values->size());
+                removed.push_back(false);
+                *values->Add() = std::move(value);
+            });
+
+    // removed values are dropped in one pass
+    int kept(0);
+    for (int i = 0; i < values->size(); ++i) {
+        if (removed[i]) continue;
+        if (kept != i) values->SwapElements(kept, i);
+        ++kept;
+    }
+    values->DeleteSubrange(kept, values->size() - kept);
+
+    if (!parsed) WarnLog(DmoWalLog) << "Failed to parse a value: " << logPath << std::endl;
+
+    uint64_t const fileSize = boost::filesystem::file_size(logPath, ec);
+    if (!ec && fileSize > length)
+        WarnLog(DmoWalLog) << "Torn record past " << length << " bytes: " << logPath << std::endl;
+
+    DebugLog(DmoWalLog) << __FUNCTION__ << ": " << records << " records" << std::endl;
+
+    return true;
+}
+
+bool DmoWal::restore(std::string const& snapshotPath, CompanEdgeDataModel::DataModelMessage& dmoData)
+{
+    FunctionArgLog(DmoWalLog) << snapshotPath << std::endl;
+
+    {
+        std::ifstream iFile(snapshotPath.c_str(), std::ios::binary);
+        if (iFile.is_open() && !dmoData.ParseFromIstream(&iFile)) {
+            ErrorLog(DmoWalLog) << "Failed to parse: " << snapshotPath << std::endl;
+            return false;
+        }
+    }
+
+    return replay(rotatedPath(snapshotPath), dmoData) && replay(logPath(snapshotPath), dmoData);
+}
+
+bool DmoWal::replaceFile(std::string const& path, std::string const& data)
+{
+    std::string const tmpPath(path + ".tmp");
+
+    int const fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        ErrorLog(DmoWalLog) << "Failed to open file for writing: " << tmpPath << " - " << strerror(errno)
+                            << std::endl;
+        return false;
+    }
+
+    bool const written = writeAll(fd, data.data(), data.size()) && ::fsync(fd) == 0;
+    ::close(fd);
+
+    if (!written || ::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        ErrorLog(DmoWalLog) << "Failed to write: " << path << " - " << strerror(errno) << std::endl;
+        ::unlink(tmpPath.c_str());
+        return false;
+    }
+
+    syncDirectory(path);
+
+    return true;
+}
@@ -0,0 +1,146 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_dmo_wal.h
+ @brief datamodel write ahead log
+ */
+#ifndef __company_ref_DMO_company_ref_DMO_WAL_H__
+#define __company_ref_DMO_company_ref_DMO_WAL_H__
+
+#include <company_ref_protocol/company_ref_protocol.pb.h>
+
+#include <cstdint>
+#include <string>
+
+namespace CompanEdgeDataModel {
+class DataModelMessage;
+} // namespace CompanEdgeDataModel
+
+namespace Compan{
+namespace Edge {
+
+/*!
+ * @brief Append only log of the changes to a persisted datamodel file
+ *
+ * The persisted file is the snapshot; changes to it's data entities are
+ * appended to <snapshot>.wal rather than rewriting it. Each record is
+ *
+ *      uint32 length | uint32 crc32 | uint8 type | payload
+ *
+ * little endian, the payload being an encoded Value or a removed value's id.
+ * Records are buffered, and written with a single fdatasync by sync(); write()
+ * leaves them to the kernel, until the next sync().
+ *
+ * Once the log outgrows the snapshot it's rotated to <snapshot>.wal.1, which
+ * compact() merges into a new snapshot, written to a temporary file and
+ * renamed over the old one. Restoring replays the snapshot, the rotated log
+ * then the log; records are absolute, replaying a merged log again is harmless.
+ */
+class DmoWal {
+public:
+    enum RecordType : uint8_t { SetRecord = 1, RemoveRecord = 2 };
+
+    explicit DmoWal(std::string const& snapshotPath);
+    virtual ~DmoWal();
+
+    DmoWal(DmoWal const&) = delete;
+    DmoWal& operator=(DmoWal const&) = delete;
+
+    /// Opens the log for appending, truncating a record torn by a crash
+    bool open();
+    void close();
+    bool isOpen() const;
+
+    /// Buffers a changed value
+    void append(CompanEdgeProtocol::Value const& value);
+
+    /// Buffers a removed value
+    void appendRemove(std::string const& valueId);
+
+    /// Writes the buffered records, without syncing them
+    bool write();
+
+    /// Writes the buffered records, and syncs them with the ones written before
+    bool sync();
+
+    /// Records buffered since the last sync
+    size_t pending() const;
+
+    /// Bytes written to the log
+    uint64_t logSize() const;
+
+    /// Whether records were written since the last sync
+    bool unsynced() const;
+
+    /*!
+     * Syncs and moves the log to the rotated path, and opens a new log
+     *
+     * @returns false if a rotated log is still waiting to be compacted
+     */
+    bool rotate();
+
+    std::string const& snapshotPath() const;
+
+    static std::string logPath(std::string const& snapshotPath);
+    static std::string rotatedPath(std::string const& snapshotPath);
+
+    /*!
+     * Merges the rotated log into the snapshot
+     *
+     * Only reads and writes files, it's safe to run off the writer's thread.
+     *
+     * @returns false if the new snapshot wasn't written, the rotated log is kept
+     */
+    static bool compact(std::string const& snapshotPath);
+
+    /// Applies a log's records to the data entities, up to the first torn record
+    static bool replay(std::string const& logPath, CompanEdgeDataModel::DataModelMessage& dmoData);
+
+    /// Reads the snapshot, and replays the rotated log and the log onto it
+    static bool restore(std::string const& snapshotPath, CompanEdgeDataModel::DataModelMessage& dmoData);
+
+    /// Replaces a file's content, through a synced temporary file renamed over it
+    static bool replaceFile(std::string const& path, std::string const& data);
+
+private:
+    void appendRecord(RecordType const type, std::string const& payload);
+
+private:
+    std::string const snapshotPath_;
+    std::string const logPath_;
+
+    int fd_;
+    std::string buffer_; //!< records not yet written
+    size_t pending_;
+    uint64_t logSize_;
+    bool unsynced_;
+};
+
+inline bool DmoWal::isOpen() const
+{
+    return fd_ >= 0;
+}
+
+inline size_t DmoWal::pending() const
+{
+    return pending_;
+}
+
+inline uint64_t DmoWal::logSize() const
+{
+    return logSize_;
+}
+
+inline bool DmoWal::unsynced() const
+{
+    return unsynced_;
+}
+
+inline std::string const& DmoWal::snapshotPath() const
+{
+    return snapshotPath_;
+}
+
+} // namespace Edge
+} // namespace Compan
+
+#endif // __company_ref_DMO_company_ref_DMO_WAL_H__
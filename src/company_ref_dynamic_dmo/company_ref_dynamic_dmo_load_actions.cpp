@@ -8,10 +8,16 @@
 
 #include <company_ref_dmo/company_ref_dmo_container.h>
 #include <company_ref_dmo/company_ref_dmo_file.h>
+#include <company_ref_dmo/company_ref_dmo_shards.h>
+#include <company_ref_dmo/company_ref_dmo_snapshot.h>
+#include <company_ref_dmo/company_ref_dmo_wal.h>
+#include <company_ref_protocol/company_ref_datamodel.pb.h>
 
 #include <company_ref_variant_valuestore/company_ref_variant_map_value.h>
 #include <company_ref_variant_valuestore/company_ref_variant_valuestore.h>
 
+#include <boost/filesystem/fstream.hpp>
+
 //
 #include <company_ref_protocol_utils/company_ref_stream.h>
 //
@@ -23,6 +29,52 @@ bool DmoLoadActions::loadDmo(std::istream& strm, DmoContainer& container, Varian
     return DmoFile::read(strm, container, ws);
 }
 
+bool DmoLoadActions::loadDmo(boost::filesystem::path const& path, DmoContainer& container, VariantValueStore& ws)
+{
+    std::string const snapshotPath(path.generic_string());
+
+    // shards are restored in parallel, but applied to the store here
+    if (DmoShards::exists(snapshotPath)) {
+        std::vector<CompanEdgeDataModel::DataModelMessage> shards;
+        if (!DmoShards::restore(snapshotPath, shards)) return false;
+
+        bool loaded(true);
+        for (auto& dmoData : shards) loaded = DmoFile::read(dmoData, container, ws) && loaded;
+
+        return loaded;
+    }
+
+    boost::system::error_code ec;
+    if (!boost::filesystem::exists(DmoWal::logPath(snapshotPath), ec)
+        && !boost::filesystem::exists(DmoWal::rotatedPath(snapshotPath), ec)) {
+        // binary snapshots are mapped, and merged into the store in id order
+        if (DmoSnapshot::isSnapshot(snapshotPath)) return DmoSnapshot::read(snapshotPath, container, ws);
+
+        boost::filesystem::ifstream strm(path);
+        return loadDmo(strm, container, ws);
+    }
+
+    // persisted values, the snapshot and the changes logged since
+    CompanEdgeDataModel::DataModelMessage dmoData;
+    if (!DmoWal::restore(snapshotPath, dmoData)) return false;
+
+    return DmoFile::read(dmoData, container, ws);
+}
+
+bool DmoLoadActions::exists(boost::filesystem::path const& path)
+{
+    boost::system::error_code ec;
+    if (boost::filesystem::is_regular_file(path, ec)) return true;
+
+    // once sharded, a persisted state is it's manifest and shards
+    std::string const snapshotPath(path.generic_string());
+    if (DmoShards::exists(snapshotPath)) return true;
+
+    // and only has it's logs, until the first compaction writes the snapshot
+    return boost::filesystem::exists(DmoWal::logPath(snapshotPath), ec)
+           || boost::filesystem::exists(DmoWal::rotatedPath(snapshotPath), ec);
+}
+
 bool DmoLoadActions::unloadDmo(std::istream& strm, DmoContainer& container, VariantValueStore& ws)
 {
     DmoContainer tmpContainer;
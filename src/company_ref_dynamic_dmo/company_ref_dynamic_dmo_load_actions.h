@@ -26,6 +26,13 @@ public:
     /// Loads MetaData and Values
     static bool loadDmo(std::istream& strm, DmoContainer& container, VariantValueStore& ws);
 
+    /// Loads MetaData and Values from a datamodel file or binary snapshot, replaying it's write ahead log or shards
+    /// if it has them
+    static bool loadDmo(boost::filesystem::path const& path, DmoContainer& container, VariantValueStore& ws);
+
+    /// Whether a datamodel file, it's shards or it's write ahead log exist at a path
+    static bool exists(boost::filesystem::path const& path);
+
     /// Removes MetaData and Values
     static bool unloadDmo(std::istream& strm, DmoContainer& container, VariantValueStore& ws);
 
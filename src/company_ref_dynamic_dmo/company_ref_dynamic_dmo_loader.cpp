@@ -70,7 +70,11 @@ void DynamicDmoLoader::onConfigAction(VariantValuePtr const)
 
     boost::filesystem::path path = boost::filesystem::path(dmoDirPath_->str()) / boost::filesystem::path(path_->str());
 
-    if (!boost::filesystem::is_regular_file(path)) {
+    // only a load restores a persisted state from it's logs, the other actions read the file itself
+    bool const found = configActionEnum == DynamicDmoValueIds::Dmo::Config::Load
+                               ? DmoLoadActions::exists(path)
+                               : boost::filesystem::is_regular_file(path);
+    if (!found) {
 
         WarnLog(DynamicDmoLoaderLog) << path << " doesn't exist" << std::endl;
         status_->set(DynamicDmoValueIds::Dmo::Status::FileNotFound);
@@ -97,14 +101,15 @@ void DynamicDmoLoader::onLoad(boost::filesystem::path const dmoFilePath)
 {
     FunctionArgLog(DynamicDmoLoaderLog) << dmoFilePath << std::endl;
 
-    boost::filesystem::ifstream strm(dmoFilePath);
-
     int statusActionEnum(DynamicDmoValueIds::Dmo::Status::Complete);
 
-    if (!DmoLoadActions::loadDmo(strm, dmo_, ws_)) {
+    if (!DmoLoadActions::loadDmo(dmoFilePath, dmo_, ws_)) {
         ErrorLog(DynamicDmoLoaderLog) << "load " << dmoFilePath << " failed" << std::endl;
 
         statusActionEnum = DynamicDmoValueIds::Dmo::Status::Failed;
+    } else {
+        // train on the loaded values, rather than on whatever was loaded when the first client asked
+        ws_.trainFrameCompressor();
     }
 
     status_->set(statusActionEnum);
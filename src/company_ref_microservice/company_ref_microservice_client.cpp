@@ -13,6 +13,7 @@
 #include <company_ref_sdk_value_ids/microservices_meta_data.h>
 #include <company_ref_sdk_value_ids/microservices_value_ids.h>
 
+#include <company_ref_asio_protocol_client/company_ref_asio_shm_protocol_client.h>
 #include <company_ref_asio_protocol_client/company_ref_asio_tcp_protocol_client.h>
 #include <company_ref_asio_protocol_client/company_ref_asio_uds_protocol_client.h>
 #include <company_ref_protocol/company_ref_protocol.pb.h>
@@ -38,6 +39,33 @@ using namespace Compan::Edge;
 
 CompanLogger MicroServiceClientLog("MsClient.Client", LogLevel::Information);
 
+namespace {
+/// Sets the request's sequenceNo, returns false if the message isn't a request
+bool setSequenceNo(CompanEdgeProtocol::ServerMessage& msg, uint32_t const sequenceNo)
+{
+    if (msg.has_vssubscribe())
+        msg.mutable_vssubscribe()->set_sequenceno(sequenceNo);
+    else if (msg.has_vsunsubscribe())
+        msg.mutable_vsunsubscribe()->set_sequenceno(sequenceNo);
+    else if (msg.has_vsgetall())
+        msg.mutable_vsgetall()->set_sequenceno(sequenceNo);
+    else if (msg.has_vsgetvalue())
+        msg.mutable_vsgetvalue()->set_sequenceno(sequenceNo);
+    else if (msg.has_vssetvalue())
+        msg.mutable_vssetvalue()->set_sequenceno(sequenceNo);
+    else if (msg.has_vsgetobject())
+        msg.mutable_vsgetobject()->set_sequenceno(sequenceNo);
+    else if (msg.has_vsmultiget())
+        msg.mutable_vsmultiget()->set_sequenceno(sequenceNo);
+    else if (msg.has_vsmultiset())
+        msg.mutable_vsmultiset()->set_sequenceno(sequenceNo);
+    else
+        return false;
+
+    return true;
+}
+} // namespace
+
 MicroServiceClient::MicroServiceClient(
         boost::asio::io_context& ctx,
         std::string const& appName,
@@ -47,6 +75,19 @@ MicroServiceClient::MicroServiceClient(
     clientConnection(std::make_shared<AsioUdsProtocolClient>(ctx, messageHandler_, udsPath));
 }
 
+MicroServiceClient::MicroServiceClient(
+        boost::asio::io_context& ctx,
+        std::string const& appName,
+        std::string const& udsPath,
+        TransportType const transport)
+    : MicroServiceClient(ctx, appName)
+{
+    if (transport == SharedMemory)
+        clientConnection(std::make_shared<AsioShmProtocolClient>(ctx, messageHandler_, udsPath));
+    else
+        clientConnection(std::make_shared<AsioUdsProtocolClient>(ctx, messageHandler_, udsPath));
+}
+
 MicroServiceClient::MicroServiceClient(
         boost::asio::io_context& ctx,
         std::string const& appName,
@@ -63,13 +104,25 @@ MicroServiceClient::MicroServiceClient(boost::asio::io_context& ctx, std::string
     , ws_(ctx_)
     , autoReconnect_(true)
     , seqNo_(0)
-    , messageHandler_(std::make_shared<MicroServiceMessageHandler>(ws_, appName_, seqNo_))
+    , messageHandler_(std::make_shared<MicroServiceMessageHandler>(ctx_, ws_, appName_, seqNo_))
     , connected_(false)
     , subscribeCompleteMapCb_()
     , dynamicDmo_(std::make_shared<MicroserviceDynamicDmo>(ws_, appName_))
+    , requestWindow_(DefaultRequestWindow)
+    , outstandingRequests_(0)
+    , resumePoint_({0, 0, 0})
+    , connectedVersion_(0)
+    , resumePointTaken_(false)
+    , resumePending_(false)
 {
     FunctionLog(MicroServiceClientLog);
 
+    onRequestComplete_ = messageHandler_->connectResponseListener(
+            std::bind(&MicroServiceClient::requestComplete, this, std::placeholders::_1));
+
+    onVersion_ = messageHandler_->connectVersionListener(
+            std::bind(&MicroServiceClient::advanceResumePoint, this, std::placeholders::_1));
+
     LoggerMetaData::create(ws_);
     DynamicDmoMetaData::create(ws_);
     MicroservicesMetaData::create(ws_);
@@ -215,6 +268,14 @@ void MicroServiceClient::onClientConnected()
 
     connected_ = true;
 
+    connectedVersion_ = ws_.version();
+    resumePointTaken_ = false;
+
+    if (resumePending_) {
+        resumePending_ = false;
+        resume();
+    }
+
     boost::asio::post(ctx_, std::bind(&MicroServiceClient::writeFromQueue, this));
 }
 
@@ -224,10 +285,17 @@ void MicroServiceClient::onClientDisconnected()
 
     connected_ = false;
 
-    if (!autoReconnect_) return;
+    // invalidations may be missed while disconnected
+    if (cache_) cache_->clear();
 
     /// If the WS server dies and we do a restart anyways
-    while (!requestQueue_.empty()) requestQueue_.pop();
+    // cleared first, a request re-issued by a failure callback is queued for the reconnect
+    if (autoReconnect_) std::queue<CompanEdgeProtocol::ServerMessage>().swap(requestQueue_);
+
+    // the responses of outstanding requests are lost with the connection
+    failRequests();
+
+    if (!autoReconnect_) return;
 
     // re-subscribe to the logger
     {
@@ -269,34 +337,115 @@ void MicroServiceClient::onClientDisconnected()
         insertWriteQueue(std::move(msg));
     }
 
-    {
-        // Now, re-subscribe for all the values
+    // only what changed is exchanged, once connected
+    if (resumePoint_.epoch) {
+        resumePending_ = true;
+        return;
+    }
+
+    resubscribe();
+}
+
+void MicroServiceClient::resubscribe()
+{
+    FunctionLog(MicroServiceClientLog);
+
+    // first, we send what our current information is
+    CompanEdgeProtocol::ServerMessage updateMsg;
+    CompanEdgeProtocol::ValueChanged* valueChanged = updateMsg.mutable_valuechanged();
 
-        // first, we send what our current information is
-        CompanEdgeProtocol::ServerMessage updateMsg;
-        CompanEdgeProtocol::ValueChanged* valueChanged = updateMsg.mutable_valuechanged();
+    // then, we re-subscribe for information
+    CompanEdgeProtocol::ServerMessage subscribeMsg;
+    CompanEdgeProtocol::VsSubscribe* vsSubscribe = subscribeMsg.mutable_vssubscribe();
 
-        // then, we re-subscribe for information
-        CompanEdgeProtocol::ServerMessage subscribeMsg;
-        CompanEdgeProtocol::VsSubscribe* vsSubscribe = subscribeMsg.mutable_vssubscribe();
+    vsSubscribe->set_sequenceno(++seqNo_);
+
+    // we might be reconnection soon - we'll need to resubscribe
+    ws_.visitValues([&valueChanged, &vsSubscribe](VariantValue::Ptr const& valuePtr) {
+        CompanEdgeProtocol::Value value = valuePtr->get();
+
+        vsSubscribe->add_ids(value.id());
+
+        if (!ValueTypeTraits::isValid(value)) return;
+
+        *valueChanged->add_value() = std::move(value);
+    });
+
+    ++seqNo_;
+    insertWriteQueue(std::move(updateMsg));
+    insertWriteQueue(std::move(subscribeMsg));
+}
+
+void MicroServiceClient::resume()
+{
+    FunctionLog(MicroServiceClientLog);
 
-        vsSubscribe->set_sequenceno(++seqNo_);
+    // first, what changed here since the server was last current
+    CompanEdgeProtocol::ServerMessage updateMsg;
+    CompanEdgeProtocol::ValueChanged* valueChanged = updateMsg.mutable_valuechanged();
 
-        // we might be reconnection soon - we'll need to resubscribe
-        ws_.visitValues([&valueChanged, &vsSubscribe](VariantValue::Ptr const& valuePtr) {
-            CompanEdgeProtocol::Value value = valuePtr->get();
+    // then, resume the subscription of all the values
+    CompanEdgeProtocol::ServerMessage subscribeMsg;
+    CompanEdgeProtocol::VsSubscribe* vsSubscribe = subscribeMsg.mutable_vssubscribe();
 
-            vsSubscribe->add_ids(value.id());
+    vsSubscribe->set_epoch(resumePoint_.epoch);
+    vsSubscribe->set_version(resumePoint_.version);
 
-            if (!ValueTypeTraits::isValid(value)) return;
+    uint64_t const localVersion(resumePoint_.localVersion);
 
-            *valueChanged->add_value() = std::move(value);
-        });
+    ws_.visitValues([&valueChanged, &vsSubscribe, localVersion](VariantValue::Ptr const& valuePtr) {
+        vsSubscribe->add_ids(valuePtr->id());
 
-        ++seqNo_;
-        insertWriteQueue(std::move(updateMsg));
-        insertWriteQueue(std::move(subscribeMsg));
+        if (valuePtr->version() <= localVersion || valuePtr->setUpdateType() == VariantValue::Remote) return;
+
+        CompanEdgeProtocol::Value value = valuePtr->get();
+        if (!ValueTypeTraits::isValid(value)) return;
+
+        *valueChanged->add_value() = std::move(value);
+    });
+
+    DebugLog(MicroServiceClientLog) << __FUNCTION__ << ": " << valueChanged->value_size() << " changed, "
+                                    << vsSubscribe->ids_size() << " subscribed" << std::endl;
+
+    if (valueChanged->value_size()) insertWriteQueue(std::move(updateMsg));
+
+    request(std::move(subscribeMsg),
+            std::bind(&MicroServiceClient::onResumeComplete, this, std::placeholders::_1));
+}
+
+void MicroServiceClient::onResumeComplete(CompanEdgeProtocol::ClientMessage const& rspMsg)
+{
+    // the connection was lost again, it's resumed on the next
+    if (!rspMsg.has_vsresult()) return;
+
+    // the changed values are updated by the message handler
+    if (rspMsg.vsresult().status() != CompanEdgeProtocol::VsResult::resync_required) return;
+
+    WarnLog(MicroServiceClientLog) << __FUNCTION__ << ": server restarted, resyncing" << std::endl;
+
+    resumePoint_.epoch = 0;
+    resubscribe();
+}
+
+void MicroServiceClient::resumePoint(CompanEdgeProtocol::VsResult const& vsResult)
+{
+    if (vsResult.epoch() == 0) return;
+    if (vsResult.status() == CompanEdgeProtocol::VsResult::resync_required) return;
+
+    if (resumePointTaken_ && vsResult.epoch() == resumePoint_.epoch) {
+        advanceResumePoint(vsResult.version());
+        return;
     }
+
+    // changes on either side after this point are exchanged on resume
+    resumePoint_ = {vsResult.epoch(), vsResult.version(), connectedVersion_};
+    resumePointTaken_ = true;
+}
+
+void MicroServiceClient::advanceResumePoint(uint64_t const version)
+{
+    // received in order, a change's version is never newer than the changes queued behind it
+    if (resumePointTaken_ && version > resumePoint_.version) resumePoint_.version = version;
 }
 
 void MicroServiceClient::insertWriteQueue(CompanEdgeProtocol::ServerMessage&& msg)
@@ -317,10 +466,217 @@ void MicroServiceClient::writeFromQueue()
     boost::asio::post(ctx_, std::bind(&MicroServiceClient::writeFromQueue, this));
 }
 
+uint32_t MicroServiceClient::request(CompanEdgeProtocol::ServerMessage&& msg, RequestCompleteCb const& cb)
+{
+    FunctionLog(MicroServiceClientLog);
+
+    uint32_t const sequenceNo = ++seqNo_;
+    if (!setSequenceNo(msg, sequenceNo)) {
+        ErrorLog(MicroServiceClientLog) << __FUNCTION__ << ": not a request - " << msg << std::endl;
+        return 0;
+    }
+
+    requestCompleteMapCb_.emplace(sequenceNo, cb);
+
+    // keep the order of the waiting requests
+    if (waitingRequests_.empty() && outstandingRequests_ < requestWindow_) {
+        ++outstandingRequests_;
+        insertWriteQueue(std::move(msg));
+    } else {
+        waitingRequests_.push_back({sequenceNo, std::move(msg)});
+    }
+
+    return sequenceNo;
+}
+
+MicroServiceClient::RequestFuture MicroServiceClient::request(CompanEdgeProtocol::ServerMessage&& msg)
+{
+    std::shared_ptr<std::promise<CompanEdgeProtocol::ClientMessage>> promise =
+            std::make_shared<std::promise<CompanEdgeProtocol::ClientMessage>>();
+    std::shared_ptr<CompanEdgeProtocol::ClientMessage> response = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+
+    RequestFuture future = promise->get_future();
+
+    uint32_t const sequenceNo =
+            request(std::move(msg), [promise, response](CompanEdgeProtocol::ClientMessage const& rspMsg) {
+                response->MergeFrom(rspMsg);
+
+                // streamed, wait for the final chunk
+                if (rspMsg.has_vsresult() && rspMsg.vsresult().more()) return;
+
+                // default values aren't merged
+                if (response->has_vsresult()) response->mutable_vsresult()->set_more(false);
+
+                promise->set_value(std::move(*response));
+            });
+
+    if (sequenceNo == 0) promise->set_value(CompanEdgeProtocol::ClientMessage());
+
+    return future;
+}
+
+uint32_t MicroServiceClient::getValue(std::string const& valueId, RequestCompleteCb const& cb)
+{
+    CompanEdgeProtocol::ServerMessage msg;
+    msg.mutable_vsgetvalue()->set_id(valueId);
+
+    return request(std::move(msg), cb);
+}
+
+uint32_t MicroServiceClient::setValue(std::string const& valueId, std::string const& value, RequestCompleteCb const& cb)
+{
+    CompanEdgeProtocol::ServerMessage msg;
+    msg.mutable_vssetvalue()->set_id(valueId);
+    msg.mutable_vssetvalue()->set_value(value);
+
+    return request(std::move(msg), cb);
+}
+
+uint32_t MicroServiceClient::multiGet(std::vector<std::string> const& valueIds, RequestCompleteCb const& cb)
+{
+    CompanEdgeProtocol::ServerMessage msg;
+    CompanEdgeProtocol::VsMultiGet* vsMultiGet = msg.mutable_vsmultiget();
+
+    for (auto& valueId : valueIds) vsMultiGet->add_ids(valueId);
+
+    return request(std::move(msg), cb);
+}
+
+uint32_t MicroServiceClient::multiSet(
+        std::vector<std::pair<std::string, std::string>> const& values,
+        RequestCompleteCb const& cb)
+{
+    CompanEdgeProtocol::ServerMessage msg;
+    CompanEdgeProtocol::VsMultiSet* vsMultiSet = msg.mutable_vsmultiset();
+
+    for (auto& value : values) {
+        CompanEdgeProtocol::VsMultiSet::Value* setValue = vsMultiSet->add_values();
+        setValue->set_id(value.first);
+        setValue->set_value(value.second);
+    }
+
+    return request(std::move(msg), cb);
+}
+
+void MicroServiceClient::cacheMode(size_t const memoryBudget)
+{
+    FunctionArgLog(MicroServiceClientLog) << memoryBudget << std::endl;
+
+    if (memoryBudget == 0) {
+        onInvalidated_.disconnect();
+        if (cache_) cache_->clear();
+
+        cache_.reset();
+        return;
+    }
+
+    if (cache_) {
+        cache_->memoryBudget(memoryBudget);
+        return;
+    }
+
+    cache_ = std::make_shared<MicroServiceValueCache>(
+            ctx_,
+            ws_,
+            [this](CompanEdgeProtocol::ServerMessage&& msg, RequestCompleteCb const& cb) {
+                return request(std::move(msg), cb);
+            },
+            memoryBudget);
+
+    onInvalidated_ = messageHandler_->connectInvalidatedListener(
+            [this](CompanEdgeProtocol::ValueInvalidated const& valueInvalidated) {
+                for (auto& valueId : valueInvalidated.id()) cache_->invalidate(valueId);
+            });
+}
+
+void MicroServiceClient::cacheGet(
+        std::vector<std::string> const& valueIds,
+        MicroServiceValueCache::GetCompleteCb const& cb)
+{
+    if (cache_ == nullptr) {
+        ErrorLog(MicroServiceClientLog) << __FUNCTION__ << ": not in cache mode" << std::endl;
+        if (cb) cb(std::vector<VariantValue::Ptr>(valueIds.size()));
+        return;
+    }
+
+    cache_->get(valueIds, cb);
+}
+
+VariantValue::Ptr MicroServiceClient::cached(std::string const& valueId)
+{
+    return cache_ ? cache_->cached(valueId) : nullptr;
+}
+
+MicroServiceValueCache::Stats MicroServiceClient::cacheStats() const
+{
+    return cache_ ? cache_->stats() : MicroServiceValueCache::Stats({0, 0, 0, 0, 0, 0, 0});
+}
+
+void MicroServiceClient::requestComplete(CompanEdgeProtocol::ClientMessage const& rspMsg)
+{
+    uint32_t sequenceNo(0);
+    bool more(false);
+
+    if (rspMsg.has_vsresult()) {
+        sequenceNo = rspMsg.vsresult().sequenceno();
+        more = rspMsg.vsresult().more();
+
+        resumePoint(rspMsg.vsresult());
+    } else if (rspMsg.has_vsmultigetresult()) {
+        sequenceNo = rspMsg.vsmultigetresult().sequenceno();
+    } else if (rspMsg.has_vsmultisetresult()) {
+        sequenceNo = rspMsg.vsmultisetresult().sequenceno();
+    }
+
+    auto it = requestCompleteMapCb_.find(sequenceNo);
+    if (it == requestCompleteMapCb_.end()) return;
+
+    // the callback is free to send more requests
+    RequestCompleteCb cb(it->second);
+
+    if (!more) {
+        requestCompleteMapCb_.erase(it);
+        --outstandingRequests_;
+    }
+
+    if (cb) cb(rspMsg);
+
+    if (!more) sendWaitingRequests();
+}
+
+void MicroServiceClient::sendWaitingRequests()
+{
+    while (!waitingRequests_.empty() && outstandingRequests_ < requestWindow_) {
+        ++outstandingRequests_;
+        insertWriteQueue(std::move(waitingRequests_.front().msg));
+        waitingRequests_.pop_front();
+    }
+}
+
+void MicroServiceClient::failRequests()
+{
+    if (requestCompleteMapCb_.empty()) return;
+
+    DebugLog(MicroServiceClientLog) << __FUNCTION__ << ": " << requestCompleteMapCb_.size() << std::endl;
+
+    std::unordered_map<uint32_t, RequestCompleteCb> requestCompleteMapCb;
+    requestCompleteMapCb.swap(requestCompleteMapCb_);
+
+    waitingRequests_.clear();
+    outstandingRequests_ = 0;
+
+    CompanEdgeProtocol::ClientMessage const emptyMsg;
+    for (auto& request : requestCompleteMapCb)
+        if (request.second) request.second(emptyMsg);
+}
+
 void MicroServiceClient::subscribeComplete(CompanEdgeProtocol::VsResult const& vsResult)
 {
     FunctionLog(MicroServiceClientLog);
 
+    // large subscriptions are streamed, wait for the final chunk
+    if (vsResult.more()) return;
+
     auto it = subscribeCompleteMapCb_.find(vsResult.sequenceno());
     if (it == subscribeCompleteMapCb_.end()) { return; }
 
@@ -8,16 +8,29 @@
 
 #include "company_ref_microservice_connection.h"
 #include "company_ref_microservice_message_handler.h"
+#include "company_ref_microservice_value_cache.h"
 #include <company_ref_asio/company_ref_asio_connection.h>
+#include <company_ref_protocol/company_ref_protocol.pb.h>
 #include <company_ref_sdk_value_ids/dynamic_dmo_value_ids.h>
 #include <company_ref_variant_valuestore/company_ref_variant_valuestore_variant.h>
 
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/post.hpp>
+
+#include <chrono>
+#include <deque>
 #include <functional>
+#include <future>
 #include <queue>
+#include <type_traits>
+#include <unordered_map>
 
 namespace CompanEdgeProtocol {
 class ServerMessage;
 class ClientMessage;
+class VsResult;
 } // namespace CompanEdgeProtocol
 
 namespace Compan{
@@ -39,6 +52,25 @@ class MicroservicePersistedDmo;
  *
  * This allows a client to either store the data or simply pass it on to another
  * application.
+ *
+ * Requests (get, set, multi get/set ...) can be pipelined; up to requestWindow
+ * requests are outstanding on the connection, each completed out of order by the
+ * response carrying it's sequenceNo.
+ *
+ * The async requests take an asio completion token; with boost::asio::use_awaitable
+ * they're co_awaited, concurrent ones pipelining on the connection like any other.
+ *
+ * Local value changes can be coalesced; a value changed many times within the
+ * window is written once, with it's latest value.
+ *
+ * On reconnect the subscription is resumed from the server's epoch and version
+ * the local values are current to; only the values changed on either side are
+ * exchanged. A restarted server answers resync_required, and the full local
+ * state is pushed and re-subscribed.
+ *
+ * In cache mode values are fetched on first access rather than subscribed,
+ * and kept in the local VariantValueStore under a memory budget; the server
+ * invalidates them on change. The cache is dropped with the connection.
  */
 class MicroServiceClient {
 public:
@@ -46,7 +78,25 @@ public:
     using LoadDmoCompleteCb = std::function<void(DynamicDmoValueIds::Dmo::Status::ActionEnum const)>;
     using LoadPersistedCompleteCb = std::function<void(DynamicDmoValueIds::Dmo::Persisted::Status::ActionEnum const)>;
 
+    /// Called with every response of a request, streamed VsResults have more set on all but the last
+    using RequestCompleteCb = std::function<void(CompanEdgeProtocol::ClientMessage const&)>;
+    using RequestFuture = std::future<CompanEdgeProtocol::ClientMessage>;
+
+    /// Completion signature of the async requests, the error is set if the response is lost
+    using RequestSignature = void(boost::system::error_code, CompanEdgeProtocol::ClientMessage);
+
+    static size_t const DefaultRequestWindow = 64;
+    static size_t const DefaultCoalesceEntries = 256;
+
+    /// Local transports, SharedMemory needs a server listening with AsioShmServer
+    enum TransportType { Socket, SharedMemory };
+
     MicroServiceClient(boost::asio::io_context& ctx, std::string const& appName, std::string const& udsPath);
+    MicroServiceClient(
+            boost::asio::io_context& ctx,
+            std::string const& appName,
+            std::string const& udsPath,
+            TransportType const transport);
     MicroServiceClient(
             boost::asio::io_context& ctx,
             std::string const& appName,
@@ -120,6 +170,123 @@ public:
     /// inserts a message into the outgoing queue
     void insertWriteQueue(CompanEdgeProtocol::ServerMessage&& msg);
 
+    /*!
+     * Sends a pipelined request
+     *
+     * The request's sequenceNo is assigned by the client. Requests past the
+     * request window wait, in order, for an outstanding one to complete.
+     *
+     * If the connection is lost the callback is called with an empty
+     * ClientMessage.
+     *
+     * @param msg   VsSubscribe, VsUnsubscribe, VsGetAll, VsGetValue, VsSetValue,
+     *              VsGetObject, VsMultiGet or VsMultiSet request
+     * @param cb    Completion callback
+     * @returns the request's sequenceNo, 0 if the message isn't a request
+     */
+    uint32_t request(CompanEdgeProtocol::ServerMessage&& msg, RequestCompleteCb const& cb);
+
+    /*!
+     * Sends a pipelined request, completed through a future
+     *
+     * Streamed VsResults are merged into a single response.
+     *
+     * @note Responses are processed on the client's io_context, don't
+     *       wait on the future from it
+     */
+    RequestFuture request(CompanEdgeProtocol::ServerMessage&& msg);
+
+    /// Pipelined VsGetValue
+    uint32_t getValue(std::string const& valueId, RequestCompleteCb const& cb);
+
+    /// Pipelined VsSetValue
+    uint32_t setValue(std::string const& valueId, std::string const& value, RequestCompleteCb const& cb);
+
+    /// Pipelined VsMultiGet
+    uint32_t multiGet(std::vector<std::string> const& valueIds, RequestCompleteCb const& cb);
+
+    /// Pipelined VsMultiSet of id/value pairs
+    uint32_t multiSet(std::vector<std::pair<std::string, std::string>> const& values, RequestCompleteCb const& cb);
+
+    /*!
+     * Sends a pipelined request, completed through an asio completion token
+     *
+     * Streamed VsResults are merged into a single response. Completes with
+     * connection_aborted if the connection is lost, and invalid_argument if
+     * the message isn't a request.
+     *
+     * @param msg   as request()
+     * @param token Completion token, RequestSignature
+     */
+    template <typename CompletionToken>
+    auto asyncRequest(CompanEdgeProtocol::ServerMessage&& msg, CompletionToken&& token);
+
+    /// Async VsGetValue
+    template <typename CompletionToken>
+    auto asyncGetValue(std::string const& valueId, CompletionToken&& token);
+
+    /// Async VsSetValue
+    template <typename CompletionToken>
+    auto asyncSetValue(std::string const& valueId, std::string const& value, CompletionToken&& token);
+
+    /// Async VsMultiGet
+    template <typename CompletionToken>
+    auto asyncMultiGet(std::vector<std::string> const& valueIds, CompletionToken&& token);
+
+    /// Async VsMultiSet of id/value pairs
+    template <typename CompletionToken>
+    auto asyncMultiSet(std::vector<std::pair<std::string, std::string>> const& values, CompletionToken&& token);
+
+    /// Async VsSubscribe, the values are added to the local VariantValueStore
+    template <typename CompletionToken>
+    auto asyncSubscribe(std::vector<std::string> const& valueIds, CompletionToken&& token);
+
+    /// Maximum number of outstanding requests
+    void requestWindow(size_t const window);
+    size_t requestWindow() const;
+
+    /// Number of requests sent and not yet completed
+    size_t outstandingRequests() const;
+
+    /// Number of requests waiting on the request window
+    size_t waitingRequests() const;
+
+    /*!
+     * Coalesces local value changes written to the server
+     *
+     * Dirty values are kept latest value wins, and written as one ValueChanged every
+     * window, or once maxEntries values are dirty. Removals and container changes are
+     * never coalesced, the dirty values are written ahead of them.
+     *
+     * @param window        0, the default, writes each change as it happens
+     * @param maxEntries    dirty values that force a write
+     */
+    void coalesceWrites(std::chrono::milliseconds const window, size_t const maxEntries = DefaultCoalesceEntries);
+
+    /// Writes the coalesced value changes now, for latency critical writes
+    void flush();
+
+    /*!
+     * Enables the read through value cache
+     *
+     * @param memoryBudget  estimated bytes of cached values, 0 disables the cache
+     *                      and drops it's values
+     */
+    void cacheMode(size_t const memoryBudget);
+
+    /*!
+     * Gets values through the cache, fetching the ones not cached
+     *
+     * @param valueIds  ids of the values
+     * @param cb        called with a value per id, nullptr if it's not found
+     */
+    void cacheGet(std::vector<std::string> const& valueIds, MicroServiceValueCache::GetCompleteCb const& cb);
+
+    /// Returns the cached value, nullptr if it's not cached or there's no cache
+    VariantValue::Ptr cached(std::string const& valueId);
+
+    MicroServiceValueCache::Stats cacheStats() const;
+
     /// Allows the microservice to signal it's start up is complete
     void setStartupCompleted();
 
@@ -137,6 +304,28 @@ protected:
 
     void subscribeComplete(CompanEdgeProtocol::VsResult const&);
 
+    /// Completes the request with the response's sequenceNo
+    void requestComplete(CompanEdgeProtocol::ClientMessage const&);
+
+    /// Sends waiting requests while the window allows
+    void sendWaitingRequests();
+
+    /// Completes all outstanding and waiting requests with an empty response
+    void failRequests();
+
+    /// Takes the resume point from the connection's first VsSubscribe result, later ones advance it
+    void resumePoint(CompanEdgeProtocol::VsResult const&);
+
+    /// Advances the resume point to the server version of the values received
+    void advanceResumePoint(uint64_t const version);
+
+    /// Pushes the values changed locally and resumes the subscription
+    void resume();
+    void onResumeComplete(CompanEdgeProtocol::ClientMessage const&);
+
+    /// Pushes all local values and re-subscribes to them
+    void resubscribe();
+
     void onMicroserviceSubcriptionComplete(bool const completed);
 
     // for unit testing
@@ -164,6 +353,34 @@ private:
     std::shared_ptr<MicroserviceDynamicDmo> dynamicDmo_;
 
     std::queue<CompanEdgeProtocol::ServerMessage> requestQueue_;
+
+    struct WaitingRequest {
+        uint32_t sequenceNo;
+        CompanEdgeProtocol::ServerMessage msg;
+    };
+
+    size_t requestWindow_;
+    std::unordered_map<uint32_t, RequestCompleteCb> requestCompleteMapCb_; //!< by sequenceNo, sent and waiting
+    size_t outstandingRequests_;                                           //!< sent and not yet completed
+    std::deque<WaitingRequest> waitingRequests_;                           //!< past the request window
+
+    SignalScopedConnection onRequestComplete_;
+    SignalScopedConnection onVersion_;
+
+    /// Where a reconnect resumes from
+    struct ResumePoint {
+        uint64_t epoch;        //!< the server store's, 0 if there's nothing to resume
+        uint64_t version;      //!< server store version the local values are current to, advanced as changes arrive
+        uint64_t localVersion; //!< local values changed since are pushed on resume
+    };
+
+    ResumePoint resumePoint_;
+    uint64_t connectedVersion_; //!< local store version when connected
+    bool resumePointTaken_;     //!< taken on this connection
+    bool resumePending_;        //!< resumed once connected
+
+    MicroServiceValueCache::Ptr cache_; //!< nullptr unless in cache mode
+    SignalScopedConnection onInvalidated_;
 };
 
 inline std::string MicroServiceClient::appName() const
@@ -181,6 +398,143 @@ inline VariantValueStore& MicroServiceClient::ws()
     return ws_;
 }
 
+template <typename CompletionToken>
+auto MicroServiceClient::asyncRequest(CompanEdgeProtocol::ServerMessage&& msg, CompletionToken&& token)
+{
+    return boost::asio::async_initiate<CompletionToken, RequestSignature>(
+            [this](auto handler, CompanEdgeProtocol::ServerMessage msg) {
+                // asio handlers may be move only
+                using HandlerType = typename std::decay<decltype(handler)>::type;
+                std::shared_ptr<HandlerType> handlerPtr(std::make_shared<HandlerType>(std::move(handler)));
+
+                auto executor = boost::asio::get_associated_executor(*handlerPtr, ctx_.get_executor());
+
+                auto complete = [handlerPtr, executor](
+                                        boost::system::error_code const& ec,
+                                        CompanEdgeProtocol::ClientMessage&& rspMsg) {
+                    boost::asio::post(executor, [handlerPtr, ec, rspMsg]() mutable {
+                        std::move(*handlerPtr)(ec, std::move(rspMsg));
+                    });
+                };
+
+                std::shared_ptr<CompanEdgeProtocol::ClientMessage> response(
+                        std::make_shared<CompanEdgeProtocol::ClientMessage>());
+
+                uint32_t const sequenceNo =
+                        request(std::move(msg), [complete, response](CompanEdgeProtocol::ClientMessage const& rspMsg) {
+                            // lost with the connection
+                            if (!rspMsg.has_vsresult() && !rspMsg.has_vsmultigetresult()
+                                && !rspMsg.has_vsmultisetresult()) {
+                                complete(boost::asio::error::connection_aborted, CompanEdgeProtocol::ClientMessage());
+                                return;
+                            }
+
+                            response->MergeFrom(rspMsg);
+
+                            // streamed, wait for the final chunk
+                            if (rspMsg.has_vsresult() && rspMsg.vsresult().more()) return;
+
+                            // default values aren't merged
+                            if (response->has_vsresult()) response->mutable_vsresult()->set_more(false);
+
+                            complete(boost::system::error_code(), std::move(*response));
+                        });
+
+                if (sequenceNo == 0) complete(boost::asio::error::invalid_argument, CompanEdgeProtocol::ClientMessage());
+            },
+            token,
+            std::move(msg));
+}
+
+template <typename CompletionToken>
+auto MicroServiceClient::asyncGetValue(std::string const& valueId, CompletionToken&& token)
+{
+    CompanEdgeProtocol::ServerMessage msg;
+    msg.mutable_vsgetvalue()->set_id(valueId);
+
+    return asyncRequest(std::move(msg), std::forward<CompletionToken>(token));
+}
+
+template <typename CompletionToken>
+auto MicroServiceClient::asyncSetValue(std::string const& valueId, std::string const& value, CompletionToken&& token)
+{
+    CompanEdgeProtocol::ServerMessage msg;
+    msg.mutable_vssetvalue()->set_id(valueId);
+    msg.mutable_vssetvalue()->set_value(value);
+
+    return asyncRequest(std::move(msg), std::forward<CompletionToken>(token));
+}
+
+template <typename CompletionToken>
+auto MicroServiceClient::asyncMultiGet(std::vector<std::string> const& valueIds, CompletionToken&& token)
+{
+    CompanEdgeProtocol::ServerMessage msg;
+    CompanEdgeProtocol::VsMultiGet* vsMultiGet = msg.mutable_vsmultiget();
+
+    for (auto& valueId : valueIds) vsMultiGet->add_ids(valueId);
+
+    return asyncRequest(std::move(msg), std::forward<CompletionToken>(token));
+}
+
+template <typename CompletionToken>
+auto MicroServiceClient::asyncMultiSet(
+        std::vector<std::pair<std::string, std::string>> const& values,
+        CompletionToken&& token)
+{
+    CompanEdgeProtocol::ServerMessage msg;
+    CompanEdgeProtocol::VsMultiSet* vsMultiSet = msg.mutable_vsmultiset();
+
+    for (auto& value : values) {
+        CompanEdgeProtocol::VsMultiSet::Value* setValue = vsMultiSet->add_values();
+        setValue->set_id(value.first);
+        setValue->set_value(value.second);
+    }
+
+    return asyncRequest(std::move(msg), std::forward<CompletionToken>(token));
+}
+
+template <typename CompletionToken>
+auto MicroServiceClient::asyncSubscribe(std::vector<std::string> const& valueIds, CompletionToken&& token)
+{
+    CompanEdgeProtocol::ServerMessage msg;
+    CompanEdgeProtocol::VsSubscribe* vsSubscribe = msg.mutable_vssubscribe();
+
+    for (auto& valueId : valueIds) vsSubscribe->add_ids(valueId);
+
+    return asyncRequest(std::move(msg), std::forward<CompletionToken>(token));
+}
+
+inline void MicroServiceClient::requestWindow(size_t const window)
+{
+    requestWindow_ = window ? window : 1;
+    sendWaitingRequests();
+}
+
+inline size_t MicroServiceClient::requestWindow() const
+{
+    return requestWindow_;
+}
+
+inline size_t MicroServiceClient::outstandingRequests() const
+{
+    return outstandingRequests_;
+}
+
+inline size_t MicroServiceClient::waitingRequests() const
+{
+    return waitingRequests_.size();
+}
+
+inline void MicroServiceClient::coalesceWrites(std::chrono::milliseconds const window, size_t const maxEntries)
+{
+    messageHandler_->coalesceWrites(window, maxEntries);
+}
+
+inline void MicroServiceClient::flush()
+{
+    messageHandler_->flush();
+}
+
 inline MicroServiceMessageHandler::Ptr MicroServiceClient::messageHandler()
 {
     return messageHandler_;
@@ -21,6 +21,7 @@ CompanLogger MicroServiceMessageHandlerLog("MsClient.MessageHandler", LogLevel::
 using namespace Compan::Edge;
 
 MicroServiceMessageHandler::MicroServiceMessageHandler(
+        boost::asio::io_context& ctx,
         VariantValueStore& ws,
         std::string const& appName,
         uint32_t& seqNo)
@@ -35,9 +36,13 @@ MicroServiceMessageHandler::MicroServiceMessageHandler(
     , removedListener_(ws_.connectValueRemovedListener(
               std::bind(&MicroServiceMessageHandler::handleValueRemoved, this, std::placeholders::_1)))
     , addToContainerListener_(ws_.connectValueAddToContainerListener(
-              std::bind(&MicroServiceMessageHandler::handleValueChanged, this, std::placeholders::_1)))
+              std::bind(&MicroServiceMessageHandler::handleContainerChanged, this, std::placeholders::_1)))
     , removeFromContainerListener_(ws_.connectValueRemoveFromContainerListener(
-              std::bind(&MicroServiceMessageHandler::handleValueChanged, this, std::placeholders::_1)))
+              std::bind(&MicroServiceMessageHandler::handleContainerChanged, this, std::placeholders::_1)))
+    , coalesceTimer_(ctx)
+    , coalesceWindow_(0)
+    , coalesceEntries_(1)
+    , coalesceTimerActive_(false)
 {
     FunctionLog(MicroServiceMessageHandlerLog);
 }
@@ -50,6 +55,9 @@ MicroServiceMessageHandler::~MicroServiceMessageHandler()
 void MicroServiceMessageHandler::disconnect()
 {
     subscribeSignal_.disconnectAll();
+    responseSignal_.disconnectAll();
+    invalidatedSignal_.disconnectAll();
+    versionSignal_.disconnectAll();
 
     addedListener_.disconnect();
     changedListener_.disconnect();
@@ -57,6 +65,13 @@ void MicroServiceMessageHandler::disconnect()
 
     addToContainerListener_.disconnect();
     removeFromContainerListener_.disconnect();
+
+    // the local state is pushed again on reconnect
+    coalesceTimer_.cancel();
+    coalesceTimerActive_ = false;
+
+    dirtyIndex_.clear();
+    dirtyValues_.clear();
 }
 
 void MicroServiceMessageHandler::doMessage(CompanEdgeProtocol::ClientMessage const& responseMessage)
@@ -67,6 +82,12 @@ void MicroServiceMessageHandler::doMessage(CompanEdgeProtocol::ClientMessage con
     if (responseMessage.has_valueremoved()) onMessage(responseMessage.valueremoved());
     if (responseMessage.has_vssynccompleted()) onMessage(responseMessage.vssynccompleted());
     if (responseMessage.has_vsresult()) onMessage(responseMessage.vsresult());
+    if (responseMessage.has_valueinvalidated()) invalidatedSignal_(responseMessage.valueinvalidated());
+
+    // completes pipelined requests
+    if (responseMessage.has_vsresult() || responseMessage.has_vsmultigetresult()
+        || responseMessage.has_vsmultisetresult())
+        responseSignal_(responseMessage);
 }
 
 void MicroServiceMessageHandler::onMessage(CompanEdgeProtocol::ValueChanged const& valueChanged)
@@ -74,6 +95,8 @@ void MicroServiceMessageHandler::onMessage(CompanEdgeProtocol::ValueChanged cons
     for (auto& value : valueChanged.value()) {
         if (valueUpdate(value)) continue;
     }
+
+    if (valueChanged.version()) versionSignal_(valueChanged.version());
 }
 
 bool MicroServiceMessageHandler::valueUpdate(CompanEdgeProtocol::Value const& value)
@@ -176,6 +199,44 @@ void MicroServiceMessageHandler::handleValueChanged(VariantValue::Ptr const valu
     // We don't need to bounce back a value changed if it came from the remote side
     if (valuePtr->setUpdateType() == VariantValue::Remote) return;
 
+    if (coalesceWindow_.count() == 0) {
+        writeValueChanged(valuePtr);
+        return;
+    }
+
+    // latest value wins
+    auto it = dirtyIndex_.find(valuePtr->hashToken());
+    if (it != dirtyIndex_.end()) {
+        dirtyValues_[it->second] = valuePtr->get();
+        return;
+    }
+
+    dirtyIndex_.emplace(valuePtr->hashToken(), dirtyValues_.size());
+    dirtyValues_.push_back(valuePtr->get());
+
+    if (dirtyValues_.size() >= coalesceEntries_) {
+        flush();
+        return;
+    }
+
+    setCoalesceTimer();
+}
+
+void MicroServiceMessageHandler::handleContainerChanged(VariantValue::Ptr const valuePtr)
+{
+    FunctionArgLog(MicroServiceMessageHandlerLog) << " valueId: " << valuePtr->id() << std::endl;
+
+    if (valuePtr->type() == CompanEdgeProtocol::Unknown) return;
+
+    // We don't need to bounce back a value changed if it came from the remote side
+    if (valuePtr->setUpdateType() == VariantValue::Remote) return;
+
+    flush();
+    writeValueChanged(valuePtr);
+}
+
+void MicroServiceMessageHandler::writeValueChanged(VariantValue::Ptr const valuePtr)
+{
     ServerMessagePtr requestMessage(std::make_shared<CompanEdgeProtocol::ServerMessage>());
     CompanEdgeProtocol::ValueChanged* valueChanged = requestMessage->mutable_valuechanged();
     *valueChanged->add_value() = valuePtr->get();
@@ -187,6 +248,12 @@ void MicroServiceMessageHandler::handleValueRemoved(VariantValue::Ptr const valu
 {
     FunctionArgLog(MicroServiceMessageHandlerLog) << " valueId: " << valuePtr->id() << std::endl;
 
+    // dropped locally only, e.g. evicted from the cache
+    if (valuePtr->setUpdateType() == VariantValue::Remote) return;
+
+    // a coalesced change of the value mustn't follow it's removal
+    flush();
+
     ServerMessagePtr requestMessage(std::make_shared<CompanEdgeProtocol::ServerMessage>());
     CompanEdgeProtocol::ValueRemoved* valueRemoved = requestMessage->mutable_valueremoved();
     valueRemoved->add_id(valuePtr->id());
@@ -203,6 +270,65 @@ void MicroServiceMessageHandler::write(CompanEdgeProtocol::ServerMessage const&
     onSendCallback_(std::move(requestMessage));
 }
 
+void MicroServiceMessageHandler::coalesceWrites(std::chrono::milliseconds const window, size_t const maxEntries)
+{
+    FunctionArgLog(MicroServiceMessageHandlerLog) << window.count() << "ms, " << maxEntries << std::endl;
+
+    coalesceWindow_ = window;
+    coalesceEntries_ = maxEntries ? maxEntries : 1;
+
+    // no longer coalescing, or the limit was lowered
+    if (coalesceWindow_.count() == 0 || dirtyValues_.size() >= coalesceEntries_) flush();
+}
+
+void MicroServiceMessageHandler::flush()
+{
+    if (coalesceTimerActive_) {
+        coalesceTimer_.cancel();
+        coalesceTimerActive_ = false;
+    }
+
+    if (dirtyValues_.empty()) return;
+
+    ServerMessagePtr requestMessage(std::make_shared<CompanEdgeProtocol::ServerMessage>());
+    CompanEdgeProtocol::ValueChanged* valueChanged = requestMessage->mutable_valuechanged();
+
+    valueChanged->mutable_value()->Reserve(dirtyValues_.size());
+    for (auto& value : dirtyValues_) *valueChanged->add_value() = std::move(value);
+
+    dirtyIndex_.clear();
+    dirtyValues_.clear();
+
+    DebugLog(MicroServiceMessageHandlerLog) << __FUNCTION__ << ": " << valueChanged->value_size() << std::endl;
+
+    onSendCallback_(std::move(requestMessage));
+}
+
+void MicroServiceMessageHandler::setCoalesceTimer()
+{
+    if (coalesceTimerActive_) return;
+
+    coalesceTimer_.expires_after(coalesceWindow_);
+    coalesceTimer_.async_wait(
+            std::bind(&MicroServiceMessageHandler::onCoalesceTimer, this, std::placeholders::_1));
+    coalesceTimerActive_ = true;
+}
+
+void MicroServiceMessageHandler::onCoalesceTimer(boost::system::error_code const& error)
+{
+    // flushed, or going away
+    if (error == boost::asio::error::operation_aborted) return;
+
+    coalesceTimerActive_ = false;
+
+    if (error) {
+        ErrorLog(MicroServiceMessageHandlerLog) << __FUNCTION__ << ": " << error.message() << std::endl;
+        return;
+    }
+
+    flush();
+}
+
 void MicroServiceMessageHandler::insertAppNameFilter(ValueId const& valueId)
 {
     VariantValue::Ptr valuePtr = ws_.get(valueId);
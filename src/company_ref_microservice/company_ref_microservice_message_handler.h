@@ -13,8 +13,14 @@
 #include <company_ref_variant_valuestore/company_ref_variant_valuestore.h>
 #include <company_ref_variant_valuestore/company_ref_variant_valuestore_hashtoken_set.h>
 
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <chrono>
 #include <map>
 #include <queue>
+#include <unordered_map>
+#include <vector>
 
 namespace Compan{
 namespace Edge {
@@ -33,7 +39,8 @@ class VariantValueStore;
  * server.
  *
  * Changes to values in the local VariantValueStore will be transmitted to the VariantValueStore
- * server.
+ * server. When coalescing, the changes are kept latest value wins and written as one
+ * ValueChanged per window.
  */
 class MicroServiceMessageHandler : public ClientProtocolHandler {
 public:
@@ -41,12 +48,19 @@ public:
 
     using ValueRemovedNotification = std::function<void(std::string const&)>;
     using SubscribeSignal = Signal<void(CompanEdgeProtocol::VsResult const&)>;
+    using ResponseSignal = Signal<void(CompanEdgeProtocol::ClientMessage const&)>;
+    using InvalidatedSignal = Signal<void(CompanEdgeProtocol::ValueInvalidated const&)>;
+    using VersionSignal = Signal<void(uint64_t const)>;
 
     MicroServiceMessageHandler(MicroServiceMessageHandler const&) = delete;
     MicroServiceMessageHandler& operator=(MicroServiceMessageHandler const&) = delete;
 
 public:
-    MicroServiceMessageHandler(VariantValueStore& ws, std::string const& appName, uint32_t& seqNo);
+    MicroServiceMessageHandler(
+            boost::asio::io_context& ctx,
+            VariantValueStore& ws,
+            std::string const& appName,
+            uint32_t& seqNo);
     virtual ~MicroServiceMessageHandler();
 
     virtual void disconnect();
@@ -56,8 +70,31 @@ public:
 
     SignalConnection connectSubscribeListener(SubscribeSignal::SlotType const& cb);
 
+    /// Notified of every VsResult, VsMultiGetResult and VsMultiSetResult
+    SignalConnection connectResponseListener(ResponseSignal::SlotType const& cb);
+
+    /// Notified of the server's ValueInvalidated, for values subscribed with invalidate
+    SignalConnection connectInvalidatedListener(InvalidatedSignal::SlotType const& cb);
+
+    /// Notified of the server's store version, once a ValueChanged stamped with it is applied
+    SignalConnection connectVersionListener(VersionSignal::SlotType const& cb);
+
     void write(CompanEdgeProtocol::ServerMessage const&);
 
+    /*!
+     * Coalesces local value changes into a single ValueChanged
+     *
+     * Changes are kept by hash token, latest value wins, and written once the window
+     * expires or maxEntries values are dirty.
+     *
+     * @param window        0 writes each change as it happens
+     * @param maxEntries    dirty values that force a write
+     */
+    void coalesceWrites(std::chrono::milliseconds const window, size_t const maxEntries);
+
+    /// Writes the coalesced value changes now
+    void flush();
+
     /// Filters to keep from cross pollution of values
     void insertAppNameFilter(ValueId const&);
 
@@ -91,6 +128,15 @@ protected:
      */
     void handleValueChanged(VariantValue::Ptr const);
 
+    /*!
+     * Container add to/remove from callback handler from the Value Store
+     *
+     * Never coalesced, the coalesced changes are written first to keep the order
+     *
+     * @param VariantValue::Ptr with the container operation
+     */
+    void handleContainerChanged(VariantValue::Ptr const);
+
     /*!
      * Value removed callback handler from the Value Store
      *
@@ -100,6 +146,12 @@ protected:
      */
     void handleValueRemoved(VariantValue::Ptr const);
 
+    /// Writes a single ValueChanged of the value
+    void writeValueChanged(VariantValue::Ptr const);
+
+    void setCoalesceTimer();
+    void onCoalesceTimer(boost::system::error_code const& error);
+
     /*!
      * Updates the variant value in the value store
      * @param value Value object
@@ -118,6 +170,9 @@ private:
     HashTokenSet parentFilter_;
 
     SubscribeSignal subscribeSignal_;
+    ResponseSignal responseSignal_;
+    InvalidatedSignal invalidatedSignal_;
+    VersionSignal versionSignal_;
 
     // listen for Variant ValueStore global connections
     SignalScopedConnection addedListener_;
@@ -126,6 +181,14 @@ private:
 
     SignalScopedConnection addToContainerListener_;
     SignalScopedConnection removeFromContainerListener_;
+
+    boost::asio::steady_timer coalesceTimer_;
+    std::chrono::milliseconds coalesceWindow_; //!< 0 when not coalescing
+    size_t coalesceEntries_;
+    bool coalesceTimerActive_;
+
+    std::unordered_map<uint64_t, size_t> dirtyIndex_;  //!< by hash token, into dirtyValues_
+    std::vector<CompanEdgeProtocol::Value> dirtyValues_; //!< in order of their first change
 };
 
 inline SignalConnection MicroServiceMessageHandler::connectSubscribeListener(SubscribeSignal::SlotType const& cb)
@@ -133,6 +196,21 @@ inline SignalConnection MicroServiceMessageHandler::connectSubscribeListener(Sub
     return subscribeSignal_.connect(cb);
 }
 
+inline SignalConnection MicroServiceMessageHandler::connectResponseListener(ResponseSignal::SlotType const& cb)
+{
+    return responseSignal_.connect(cb);
+}
+
+inline SignalConnection MicroServiceMessageHandler::connectInvalidatedListener(InvalidatedSignal::SlotType const& cb)
+{
+    return invalidatedSignal_.connect(cb);
+}
+
+inline SignalConnection MicroServiceMessageHandler::connectVersionListener(VersionSignal::SlotType const& cb)
+{
+    return versionSignal_.connect(cb);
+}
+
 } // namespace Edge
 } // namespace Compan
 
@@ -0,0 +1,323 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_microservice_value_cache.cpp
+ @brief MicroService read through value cache
+ */
+#include "company_ref_microservice_value_cache.h"
+
+#include <company_ref_utils/company_ref_weak_bind.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_valueid.h>
+
+#include <Compan_logger/Compan_logger.h>
+
+#include <boost/asio/post.hpp>
+
+#include <algorithm>
+
+namespace Compan{
+namespace Edge {
+CompanLogger MicroServiceValueCacheLog("MsClient.ValueCache", LogLevel::Information);
+} // namespace Edge
+} // namespace Compan
+
+using namespace Compan::Edge;
+
+size_t const MicroServiceValueCache::MaxBatch;
+size_t const MicroServiceValueCache::EntryOverhead(96);
+
+MicroServiceValueCache::MicroServiceValueCache(
+        boost::asio::io_context& ctx,
+        VariantValueStore& ws,
+        RequestFunction const& request,
+        size_t const memoryBudget)
+    : ctx_(ctx)
+    , ws_(ws)
+    , request_(request)
+    , memoryBudget_(memoryBudget)
+    , bytes_(0)
+    , fetchPosted_(false)
+    , stats_({0, 0, 0, 0, 0, 0, 0})
+{
+    FunctionArgLog(MicroServiceValueCacheLog) << memoryBudget_ << std::endl;
+}
+
+MicroServiceValueCache::~MicroServiceValueCache()
+{
+    FunctionLog(MicroServiceValueCacheLog);
+}
+
+void MicroServiceValueCache::get(std::vector<std::string> const& valueIds, GetCompleteCb const& cb)
+{
+    std::shared_ptr<PendingGet> pending(std::make_shared<PendingGet>(PendingGet{valueIds, cb, 0}));
+
+    for (auto& valueId : valueIds) {
+        if (touch(valueId)) {
+            ++stats_.hits;
+            continue;
+        }
+
+        ++stats_.misses;
+        ++pending->missing;
+
+        // already waiting on a fetch, it's completed by it
+        std::vector<std::shared_ptr<PendingGet>>& waiting = fetching_[valueId];
+        if (waiting.empty()) misses_.push_back(valueId);
+
+        waiting.push_back(pending);
+    }
+
+    if (pending->missing == 0) {
+        if (cb) cb(values(valueIds));
+        return;
+    }
+
+    // the misses of this handler invocation are fetched together
+    if (!misses_.empty() && !fetchPosted_) {
+        fetchPosted_ = true;
+        boost::asio::post(ctx_, WeakBind(&MicroServiceValueCache::fetch, shared_from_this()));
+    }
+}
+
+VariantValue::Ptr MicroServiceValueCache::cached(std::string const& valueId)
+{
+    VariantValue::Ptr valuePtr = touch(valueId);
+    if (valuePtr) ++stats_.hits;
+
+    return valuePtr;
+}
+
+void MicroServiceValueCache::invalidate(std::string const& valueId)
+{
+    FunctionArgLog(MicroServiceValueCacheLog) << valueId << std::endl;
+
+    // a cached parent holds the value too
+    for (ValueId id(valueId); !id.empty(); id = id.parent()) {
+        // the result may have been read before the change
+        if (fetching_.find(id.name()) != fetching_.end()) staleFetches_.insert(id.name());
+
+        if (entries_.find(id.name()) == entries_.end()) continue;
+
+        drop(id.name());
+        ++stats_.invalidations;
+    }
+}
+
+void MicroServiceValueCache::clear()
+{
+    FunctionArgLog(MicroServiceValueCacheLog) << entries_.size() << std::endl;
+
+    while (!lru_.empty()) drop(lru_.back());
+
+    misses_.clear();
+    staleFetches_.clear();
+
+    // the fetches are lost, their responses aren't waited on
+    std::unordered_map<std::string, std::vector<std::shared_ptr<PendingGet>>> fetching;
+    fetching.swap(fetching_);
+
+    for (auto& waiting : fetching) {
+        for (auto& pending : waiting.second) {
+            if (--pending->missing) continue;
+            if (pending->cb) pending->cb(std::vector<VariantValue::Ptr>(pending->valueIds.size()));
+        }
+    }
+}
+
+void MicroServiceValueCache::memoryBudget(size_t const memoryBudget)
+{
+    memoryBudget_ = memoryBudget;
+    evict();
+}
+
+MicroServiceValueCache::Stats MicroServiceValueCache::stats() const
+{
+    Stats stats(stats_);
+    stats.entries = entries_.size();
+    stats.bytes = bytes_;
+
+    return stats;
+}
+
+void MicroServiceValueCache::fetch()
+{
+    fetchPosted_ = false;
+
+    std::vector<std::string> misses;
+    misses.swap(misses_);
+
+    for (size_t begin = 0; begin < misses.size(); begin += MaxBatch) {
+        size_t const end(std::min(begin + MaxBatch, misses.size()));
+
+        std::vector<std::string> valueIds(misses.begin() + begin, misses.begin() + end);
+
+        CompanEdgeProtocol::ServerMessage subscribeMsg;
+        CompanEdgeProtocol::VsSubscribe* vsSubscribe = subscribeMsg.mutable_vssubscribe();
+        vsSubscribe->set_invalidate(true);
+
+        CompanEdgeProtocol::ServerMessage getMsg;
+        CompanEdgeProtocol::VsMultiGet* vsMultiGet = getMsg.mutable_vsmultiget();
+
+        for (auto& valueId : valueIds) {
+            vsSubscribe->add_ids(valueId);
+            vsMultiGet->add_ids(valueId);
+        }
+
+        DebugLog(MicroServiceValueCacheLog) << __FUNCTION__ << ": " << valueIds.size() << std::endl;
+
+        // subscribed first, a change after the values are read is always invalidated
+        request_(std::move(subscribeMsg), nullptr);
+        request_(
+                std::move(getMsg),
+                WeakBind(&MicroServiceValueCache::onFetched, shared_from_this(), valueIds, std::placeholders::_1));
+
+        ++stats_.fetches;
+    }
+}
+
+void MicroServiceValueCache::onFetched(
+        std::vector<std::string> const& valueIds,
+        CompanEdgeProtocol::ClientMessage const& rspMsg)
+{
+    std::unordered_set<std::string> refetch;
+
+    // lost with the connection, the gets complete with nullptr
+    if (rspMsg.has_vsmultigetresult()) {
+        auto& results = rspMsg.vsmultigetresult().results();
+
+        // the results are in the order of the ids
+        for (int i = 0; i < results.size() && i < static_cast<int>(valueIds.size()); ++i) {
+            if (results.Get(i).error() != CompanEdgeProtocol::VsMultiGetResult::Success) continue;
+
+            // cleared while fetching
+            if (fetching_.find(valueIds[i]) == fetching_.end()) continue;
+
+            std::string const& valueId(valueIds[i]);
+
+            // invalidated while fetching, the gets wait for the next fetch
+            if (staleFetches_.erase(valueId)) {
+                refetch.insert(valueId);
+                misses_.push_back(valueId);
+                continue;
+            }
+            size_t const bytes(update(results.Get(i)));
+
+            auto entryIter = entries_.find(valueId);
+            if (entryIter == entries_.end()) {
+                lru_.push_front(valueId);
+                entries_.emplace(valueId, Entry{lru_.begin(), bytes});
+            } else {
+                bytes_ -= entryIter->second.bytes;
+                entryIter->second.bytes = bytes;
+                lru_.splice(lru_.begin(), lru_, entryIter->second.lru);
+            }
+
+            bytes_ += bytes;
+        }
+    }
+
+    for (auto& valueId : valueIds) {
+        if (refetch.count(valueId)) continue;
+
+        staleFetches_.erase(valueId);
+        complete(valueId);
+    }
+
+    if (!refetch.empty() && !fetchPosted_) {
+        fetchPosted_ = true;
+        boost::asio::post(ctx_, WeakBind(&MicroServiceValueCache::fetch, shared_from_this()));
+    }
+
+    // once the gets have their values
+    evict();
+}
+
+size_t MicroServiceValueCache::update(CompanEdgeProtocol::VsMultiGetResult::Result const& result)
+{
+    size_t bytes(EntryOverhead);
+
+    for (auto& value : result.values()) {
+        bytes += value.ByteSizeLong();
+
+        VariantValue::Ptr valuePtr = ws_.get(value.id());
+        if (valuePtr == nullptr) {
+            ws_.set(value, VariantValue::Remote);
+            continue;
+        }
+
+        // container and struct values are updated through their elements
+        if (valuePtr->type() == CompanEdgeProtocol::Container || valuePtr->type() == CompanEdgeProtocol::Struct)
+            continue;
+
+        valuePtr->set(value, VariantValue::Remote);
+    }
+
+    return bytes;
+}
+
+void MicroServiceValueCache::complete(std::string const& valueId)
+{
+    auto fetchingIter = fetching_.find(valueId);
+    if (fetchingIter == fetching_.end()) return;
+
+    std::vector<std::shared_ptr<PendingGet>> waiting(std::move(fetchingIter->second));
+    fetching_.erase(fetchingIter);
+
+    for (auto& pending : waiting) {
+        if (--pending->missing) continue;
+        if (pending->cb) pending->cb(values(pending->valueIds));
+    }
+}
+
+std::vector<VariantValue::Ptr> MicroServiceValueCache::values(std::vector<std::string> const& valueIds)
+{
+    std::vector<VariantValue::Ptr> valuePtrs;
+    valuePtrs.reserve(valueIds.size());
+
+    for (auto& valueId : valueIds)
+        valuePtrs.push_back(entries_.find(valueId) != entries_.end() ? ws_.get(valueId) : nullptr);
+
+    return valuePtrs;
+}
+
+VariantValue::Ptr MicroServiceValueCache::touch(std::string const& valueId)
+{
+    auto entryIter = entries_.find(valueId);
+    if (entryIter == entries_.end()) return nullptr;
+
+    // removed along with a parent
+    VariantValue::Ptr valuePtr = ws_.get(valueId);
+    if (valuePtr == nullptr) {
+        bytes_ -= entryIter->second.bytes;
+        lru_.erase(entryIter->second.lru);
+        entries_.erase(entryIter);
+        return nullptr;
+    }
+
+    lru_.splice(lru_.begin(), lru_, entryIter->second.lru);
+
+    return valuePtr;
+}
+
+void MicroServiceValueCache::drop(std::string const& valueId)
+{
+    auto entryIter = entries_.find(valueId);
+    if (entryIter == entries_.end()) return;
+
+    bytes_ -= entryIter->second.bytes;
+    lru_.erase(entryIter->second.lru);
+    entries_.erase(entryIter);
+
+    // never written back to the server
+    ws_.del(valueId, VariantValue::Remote);
+}
+
+void MicroServiceValueCache::evict()
+{
+    while (bytes_ > memoryBudget_ && !lru_.empty()) {
+        DebugLog(MicroServiceValueCacheLog) << __FUNCTION__ << ": " << lru_.back() << std::endl;
+
+        drop(lru_.back());
+        ++stats_.evictions;
+    }
+}
@@ -0,0 +1,168 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_microservice_value_cache.h
+ @brief MicroService read through value cache
+ */
+#ifndef __company_ref_MICROSERVICE_VALUE_CACHE_H__
+#define __company_ref_MICROSERVICE_VALUE_CACHE_H__
+
+#include <company_ref_protocol/company_ref_protocol.pb.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_variant.h>
+
+#include <boost/asio/io_context.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Compan{
+namespace Edge {
+
+class VariantValueStore;
+
+/*!
+ * @brief Read through cache of server values, kept in a local VariantValueStore
+ *
+ * Values are materialized on first access; the misses of a handler invocation
+ * are fetched together, with a VsMultiGet per MaxBatch ids. Each fetch is
+ * preceded by a VsSubscribe flagged invalidate, so the server notifies a
+ * change with a ValueInvalidated rather than pushing the value. An invalidated
+ * value is dropped, and fetched again on it's next access. A value invalidated
+ * while it's being fetched isn't cached, it's fetched again for the gets
+ * waiting on it.
+ *
+ * Values are evicted least recently used first once their estimated size
+ * exceeds the memory budget. Evicted and invalidated values are removed from
+ * the store as Remote, they're never written back to the server.
+ *
+ * @note Must be held by a shared_ptr; fetches are bound weakly, the cache
+ *       may be dropped while they're outstanding.
+ */
+class MicroServiceValueCache : public std::enable_shared_from_this<MicroServiceValueCache> {
+public:
+    using Ptr = std::shared_ptr<MicroServiceValueCache>;
+
+    using RequestCompleteCb = std::function<void(CompanEdgeProtocol::ClientMessage const&)>;
+    using RequestFunction = std::function<uint32_t(CompanEdgeProtocol::ServerMessage&&, RequestCompleteCb const&)>;
+
+    /// Called with a value per requested id, nullptr if it's not found or the connection was lost
+    using GetCompleteCb = std::function<void(std::vector<VariantValue::Ptr> const&)>;
+
+    static size_t const MaxBatch = 256;
+    static size_t const EntryOverhead; //!< bytes added to each value's encoded size
+
+    struct Stats {
+        size_t entries;
+        size_t bytes;
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t fetches;       //!< VsMultiGet requests sent
+        uint64_t evictions;
+        uint64_t invalidations; //!< cached values dropped on the server's ValueInvalidated
+    };
+
+    MicroServiceValueCache(MicroServiceValueCache const&) = delete;
+    MicroServiceValueCache& operator=(MicroServiceValueCache const&) = delete;
+
+    /*!
+     * @param ctx           the client's io_context, misses are fetched from it
+     * @param ws            local VariantValueStore holding the cached values
+     * @param request       sends a pipelined request
+     * @param memoryBudget  estimated bytes of cached values
+     */
+    MicroServiceValueCache(
+            boost::asio::io_context& ctx,
+            VariantValueStore& ws,
+            RequestFunction const& request,
+            size_t const memoryBudget);
+    virtual ~MicroServiceValueCache();
+
+    /*!
+     * Gets values, fetching the ones not cached
+     *
+     * @param valueIds  ids of the values
+     * @param cb        called at once if all are cached, else once fetched
+     */
+    void get(std::vector<std::string> const& valueIds, GetCompleteCb const& cb);
+
+    /// Returns the cached value, without fetching it
+    VariantValue::Ptr cached(std::string const& valueId);
+
+    /// Drops the value, and any cached parent of it; their fetches are sent again
+    void invalidate(std::string const& valueId);
+
+    /// Drops all the values, waiting gets complete with nullptr
+    void clear();
+
+    /// Evicts down to the new budget
+    void memoryBudget(size_t const memoryBudget);
+    size_t memoryBudget() const;
+
+    Stats stats() const;
+
+protected:
+    /// Fetches the misses waiting, posted once per handler invocation
+    void fetch();
+    void onFetched(std::vector<std::string> const& valueIds, CompanEdgeProtocol::ClientMessage const& rspMsg);
+
+    /// Updates the store with the fetched values, returns their estimated size
+    size_t update(CompanEdgeProtocol::VsMultiGetResult::Result const& result);
+
+    /// Completes the gets waiting on the id
+    void complete(std::string const& valueId);
+
+    /// The cached values of the ids, nullptr for those not cached
+    std::vector<VariantValue::Ptr> values(std::vector<std::string> const& valueIds);
+
+    /// Moves the entry to the front of the LRU list, nullptr if it's not cached
+    VariantValue::Ptr touch(std::string const& valueId);
+
+    /// Removes the entry and it's value
+    void drop(std::string const& valueId);
+
+    void evict();
+
+private:
+    struct Entry {
+        std::list<std::string>::iterator lru;
+        size_t bytes;
+    };
+
+    struct PendingGet {
+        std::vector<std::string> valueIds;
+        GetCompleteCb cb;
+        size_t missing; //!< ids still being fetched
+    };
+
+    boost::asio::io_context& ctx_;
+    VariantValueStore& ws_;
+    RequestFunction const request_;
+    size_t memoryBudget_;
+
+    std::list<std::string> lru_; //!< most recently used first
+    std::unordered_map<std::string, Entry> entries_;
+    size_t bytes_;
+
+    std::vector<std::string> misses_; //!< waiting for the next fetch
+    bool fetchPosted_;
+
+    std::unordered_map<std::string, std::vector<std::shared_ptr<PendingGet>>> fetching_; //!< by id, queued or sent
+    std::unordered_set<std::string> staleFetches_; //!< invalidated while fetching, their results are discarded
+
+    Stats stats_;
+};
+
+inline size_t MicroServiceValueCache::memoryBudget() const
+{
+    return memoryBudget_;
+}
+
+} // namespace Edge
+} // namespace Compan
+
+#endif // __company_ref_MICROSERVICE_VALUE_CACHE_H__
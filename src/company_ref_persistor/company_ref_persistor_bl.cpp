@@ -21,11 +21,20 @@ extern CompanLogger PersistorMainLog;
 
 using namespace Compan::Edge;
 
+std::string const PersistorBl::StatsSectionName("stats");
+std::string const PersistorBl::StatsIntervalName("interval");
+std::string const PersistorBl::StatsWriteRateName("write_rate");
+std::string const PersistorBl::StatsDirtyName("dirty");
+std::string const PersistorBl::StatsFlushLatencyName("flush_latency");
+
 PersistorBl::PersistorBl(boost::asio::io_context& ioContext, std::string const& udsPath, std::string const& cfgPath)
     : ioContext_(ioContext)
     , udsPath_(udsPath)
     , cfgPath_(cfgPath)
     , client_(ioContext_, "Persistor", udsPath)
+    , statsTimer_(ioContext_)
+    , statsIntervalSeconds_(5)
+    , lastBytesWritten_(0)
     , clientConnectedListener(
               client_.clientConnection()->connectOnConnection(std::bind(&PersistorBl::onConnected, this)))
     , clientDisconnectedListener(
@@ -36,6 +45,7 @@ PersistorBl::PersistorBl(boost::asio::io_context& ioContext, std::string const&
 
 PersistorBl::~PersistorBl()
 {
+    statsTimer_.cancel();
     persistorClient_.reset();
 }
 
@@ -48,11 +58,94 @@ void PersistorBl::onConnected()
 
     persistorClient_->start(cfgPath_);
 
+    startStats();
+
     client_.setStartupCompleted();
 }
 
 void PersistorBl::onDisconnected()
 {
     FunctionLog(PersistorMainLog);
+    statsTimer_.cancel();
     persistorClient_.reset();
 }
+
+void PersistorBl::startStats()
+{
+    FunctionLog(PersistorMainLog);
+
+    if (!readStatsConfig()) return;
+
+    lastBytesWritten_ = persistorClient_->writerStats().bytesWritten;
+    lastStatsTime_ = std::chrono::steady_clock::now();
+
+    statsTimer_.expires_from_now(boost::posix_time::seconds(statsIntervalSeconds_));
+    statsTimer_.async_wait(std::bind(&PersistorBl::statsTimerHandler, this, std::placeholders::_1));
+}
+
+bool PersistorBl::readStatsConfig()
+{
+    IniConfigFile cfgFile;
+    if (!cfgFile.read(cfgPath_)) return false;
+
+    writeRateId_ = cfgFile.getValue(StatsSectionName, StatsWriteRateName);
+    dirtyId_ = cfgFile.getValue(StatsSectionName, StatsDirtyName);
+    flushLatencyId_ = cfgFile.getValue(StatsSectionName, StatsFlushLatencyName);
+
+    if (writeRateId_.empty() && dirtyId_.empty() && flushLatencyId_.empty()) return false;
+
+    {
+        uint32_t argValue(0);
+        std::istringstream(cfgFile.getValue(StatsSectionName, StatsIntervalName)) >> argValue;
+
+        if (argValue) statsIntervalSeconds_ = argValue;
+    }
+
+    return true;
+}
+
+std::vector<std::pair<std::string, std::string>>
+PersistorBl::statsValues(PersistorWriter::Stats const& stats, size_t const backlog, double const seconds)
+{
+    uint64_t const writeRate(
+            seconds > 0 ? static_cast<uint64_t>((stats.bytesWritten - lastBytesWritten_) / seconds) : 0);
+
+    lastBytesWritten_ = stats.bytesWritten;
+
+    std::vector<std::pair<std::string, std::string>> values;
+    if (!writeRateId_.empty()) values.emplace_back(writeRateId_, std::to_string(writeRate));
+    if (!dirtyId_.empty()) values.emplace_back(dirtyId_, std::to_string(backlog));
+    if (!flushLatencyId_.empty()) values.emplace_back(flushLatencyId_, std::to_string(stats.lastFlushMicroseconds));
+
+    return values;
+}
+
+void PersistorBl::statsTimerHandler(boost::system::error_code const& error)
+{
+    if (error == boost::asio::error::operation_aborted) return;
+
+    if (error) {
+        ErrorLog(PersistorMainLog) << __FUNCTION__ << ": " << error.message() << std::endl;
+        return;
+    }
+
+    if (!persistorClient_) return;
+
+    auto const now = std::chrono::steady_clock::now();
+    double const seconds(std::chrono::duration<double>(now - lastStatsTime_).count());
+
+    lastStatsTime_ = now;
+
+    auto values = statsValues(persistorClient_->writerStats(), persistorClient_->backlog(), seconds);
+
+    client_.multiSet(values, [](CompanEdgeProtocol::ClientMessage const& rspMsg) {
+        for (auto& result : rspMsg.vsmultisetresult().results()) {
+            if (result.error() == CompanEdgeProtocol::VsMultiSetResult::Success) continue;
+
+            WarnLog(PersistorMainLog) << "Failed to set " << result.id() << ": " << result.description() << std::endl;
+        }
+    });
+
+    statsTimer_.expires_from_now(boost::posix_time::seconds(statsIntervalSeconds_));
+    statsTimer_.async_wait(std::bind(&PersistorBl::statsTimerHandler, this, std::placeholders::_1));
+}
@@ -12,6 +12,9 @@
 
 #include "company_ref_persistor_client.h"
 
+#include <boost/asio/deadline_timer.hpp>
+
+#include <chrono>
 #include <string>
 #include <vector>
 
@@ -30,12 +33,25 @@ class VariantValueStore;
  *
  * Config file should be as follows:
  * [persist]
- * file=path
- * flush_timeout=seconds
+ * file=path, values are sharded by top level subtree in path.<n>, listed by path.manifest
+ * flush_timeout=seconds, the longest a change waits for a flush
+ * flush_max_values=changed values and removals that start a flush before the timeout
+ * flush_max_bytes=size of the changes that starts a flush before the timeout
+ * durability=none|flush|group, logs are left to the kernel, synced per flush or per commit window
+ * commit_window_ms=milliseconds a group commit's sync is delayed by, to be shared by later flushes
+ * compact_ratio=ratio of a shard's log size to it's file's, that merges it into the file
  *
  * [values]
  * valueid
  *
+ * [stats]
+ * interval=seconds between updates of the stats values
+ * write_rate=valueid, set to the bytes persisted per second
+ * dirty=valueid, set to the values and removals not yet persisted
+ * flush_latency=valueid, set to the microseconds the last flush took
+ *
+ * The stats values are defined by the datamodel, and are best kept out of
+ * the persisted values.
  */
 class PersistorBl {
 public:
@@ -59,6 +75,25 @@ protected:
     /// Notification the client has disconnected, kill client pipeline
     void onDisconnected();
 
+    /// Reads the stats value ids, and starts updating them
+    void startStats();
+
+    /// Reads the stats value ids and interval, false if there are none
+    bool readStatsConfig();
+
+    /*!
+     * The configured stats values
+     *
+     * @param stats     the writer's stats
+     * @param backlog   values and removals not yet persisted
+     * @param seconds   since the previous stats, the write rate is over
+     */
+    std::vector<std::pair<std::string, std::string>>
+    statsValues(PersistorWriter::Stats const& stats, size_t const backlog, double const seconds);
+
+    /// Sets the stats values
+    void statsTimerHandler(boost::system::error_code const& error);
+
 private:
     boost::asio::io_context& ioContext_; //!< Main execution context
     std::string udsPath_;                //!< uds socket path
@@ -68,8 +103,23 @@ private:
 
     PersistorClient::Ptr persistorClient_;
 
+    boost::asio::deadline_timer statsTimer_; //!< Timer to update the stats values
+    uint32_t statsIntervalSeconds_;
+    std::string writeRateId_;    //!< Bytes persisted per second
+    std::string dirtyId_;        //!< Values and removals not yet persisted
+    std::string flushLatencyId_; //!< Microseconds of the last flush
+
+    uint64_t lastBytesWritten_;
+    std::chrono::steady_clock::time_point lastStatsTime_;
+
     SignalScopedConnection clientConnectedListener;
     SignalScopedConnection clientDisconnectedListener;
+
+    static std::string const StatsSectionName;
+    static std::string const StatsIntervalName;
+    static std::string const StatsWriteRateName;
+    static std::string const StatsDirtyName;
+    static std::string const StatsFlushLatencyName;
 };
 
 } // namespace Edge
@@ -10,8 +10,6 @@
 
 #include <company_ref_protocol_utils/company_ref_stream.h>
 
-#include <fstream>
-
 namespace Compan{
 namespace Edge {
 CompanLogger PersistorClientLog("persistor.client", LogLevel::Information);
@@ -23,6 +21,11 @@ using namespace Compan::Edge;
 std::string const PersistorClient::PersistSectionName("persist");
 std::string const PersistorClient::PersistFileName("file");
 std::string const PersistorClient::PersistFlushTimeoutName("flush_timeout");
+std::string const PersistorClient::PersistCompactRatioName("compact_ratio");
+std::string const PersistorClient::PersistFlushMaxValuesName("flush_max_values");
+std::string const PersistorClient::PersistFlushMaxBytesName("flush_max_bytes");
+std::string const PersistorClient::PersistDurabilityName("durability");
+std::string const PersistorClient::PersistCommitWindowName("commit_window_ms");
 std::string const PersistorClient::ValueSectionName("values");
 
 PersistorClient::PersistorClient(boost::asio::io_context& ioContext, std::string const& udsPath)
@@ -33,7 +36,12 @@ PersistorClient::PersistorClient(boost::asio::io_context& ioContext, std::string
     , flushTimerActive_(false)
     , clientMessageConnection_(udsClient_->connectClientMessageListener(
               std::bind(&PersistorClient::onMessageReceived, this, std::placeholders::_1)))
-
+    , dirtyBytes_(0)
+    , flushMaxValues_(10000)
+    , flushMaxBytes_(1024 * 1024)
+    , compactRatio_(2)
+    , durability_(PersistorWriter::SyncOnFlush)
+    , commitWindow_(100)
 {
     FunctionLog(PersistorClientLog);
 
@@ -49,6 +57,13 @@ PersistorClient::~PersistorClient()
     // cancel the timer
     flushTimer_.cancel();
     flushTimerActive_ = false;
+
+    // nothing pending is left behind
+    if (writer_) {
+        writer_->wait();
+        saveToFile();
+        writer_->stop();
+    }
 }
 
 void PersistorClient::start(std::string const& cfgPath)
@@ -71,6 +86,49 @@ void PersistorClient::start(std::string const& cfgPath)
         if (argValue) flushTimeoutSeconds_ = argValue;
     }
 
+    {
+        uint32_t argValue(0);
+        std::istringstream(cfgFile.getValue(PersistSectionName, PersistCompactRatioName)) >> argValue;
+
+        if (argValue) compactRatio_ = argValue;
+    }
+
+    {
+        size_t argValue(0);
+        std::istringstream(cfgFile.getValue(PersistSectionName, PersistFlushMaxValuesName)) >> argValue;
+
+        if (argValue) flushMaxValues_ = argValue;
+    }
+
+    {
+        size_t argValue(0);
+        std::istringstream(cfgFile.getValue(PersistSectionName, PersistFlushMaxBytesName)) >> argValue;
+
+        if (argValue) flushMaxBytes_ = argValue;
+    }
+
+    {
+        std::string const argValue(cfgFile.getValue(PersistSectionName, PersistDurabilityName));
+
+        if (argValue == "none")
+            durability_ = PersistorWriter::NoSync;
+        else if (argValue == "group")
+            durability_ = PersistorWriter::GroupCommit;
+        else if (!argValue.empty() && argValue != "flush")
+            WarnLog(PersistorClientLog) << "Unknown durability " << argValue << ", syncing on flush" << std::endl;
+    }
+
+    {
+        uint32_t argValue(0);
+        std::istringstream(cfgFile.getValue(PersistSectionName, PersistCommitWindowName)) >> argValue;
+
+        if (argValue) commitWindow_ = std::chrono::milliseconds(argValue);
+    }
+
+    writer_ = std::make_unique<PersistorWriter>(persistPath_, compactRatio_, durability_, commitWindow_);
+    if (!writer_->start())
+        ErrorLog(PersistorClientLog) << "Failed to start the writer of " << persistPath_ << std::endl;
+
     CompanEdgeProtocol::ServerMessage requestMessage;
     CompanEdgeProtocol::VsSubscribe* vsSubscribe = requestMessage.mutable_vssubscribe();
 
@@ -86,6 +144,12 @@ void PersistorClient::onMessageReceived(CompanEdgeProtocol::ClientMessage const&
     if (rspMsg.has_valueremoved()) onMessage(rspMsg.valueremoved());
     if (rspMsg.has_vsresult()) onMessage(rspMsg.vsresult());
 
+    // a burst is handed over without waiting for the timeout
+    if (flushDue()) {
+        saveToFile();
+        return;
+    }
+
     setFlushTimer();
 }
 
@@ -98,7 +162,15 @@ void PersistorClient::onMessage(CompanEdgeProtocol::ValueChanged const& valueCha
 void PersistorClient::onMessage(CompanEdgeProtocol::ValueRemoved const& valueRemoved)
 {
     FunctionLog(PersistorClientLog);
-    for (auto& valueId : valueRemoved.id()) removeIds_.insert(valueId);
+    for (auto& valueId : valueRemoved.id()) {
+        auto iter = changeValues_.find(valueId);
+        if (iter != changeValues_.end()) {
+            dirtyBytes_ -= iter->second.ByteSizeLong();
+            changeValues_.erase(iter);
+        }
+
+        if (removeIds_.insert(valueId).second) dirtyBytes_ += valueId.size();
+    }
 }
 
 void PersistorClient::onMessage(CompanEdgeProtocol::VsResult const& vsResult)
@@ -118,7 +190,19 @@ void PersistorClient::insertValueChange(CompanEdgeProtocol::Value const& value)
         return;
     }
 
-    changeValues_.emplace(value);
+    // latest value wins
+    if (removeIds_.erase(value.id())) dirtyBytes_ -= value.id().size();
+
+    CompanEdgeProtocol::Value& changeValue(changeValues_[value.id()]);
+    dirtyBytes_ -= changeValue.ByteSizeLong();
+
+    changeValue = value;
+    dirtyBytes_ += changeValue.ByteSizeLong();
+}
+
+bool PersistorClient::flushDue() const
+{
+    return changeValues_.size() + removeIds_.size() >= flushMaxValues_ || dirtyBytes_ >= flushMaxBytes_;
 }
 
 void PersistorClient::setFlushTimer()
@@ -136,63 +220,43 @@ void PersistorClient::flushTimerHandler(boost::system::error_code const& error)
 {
     FunctionLog(PersistorClientLog);
 
-    if (error && error != boost::asio::error::operation_aborted) {
+    // cancelled on destruction, which saves what's pending
+    if (error == boost::asio::error::operation_aborted) return;
+
+    if (error) {
         ErrorLog(PersistorClientLog) << __FUNCTION__ << ": " << error.message() << std::endl;
         return;
     }
 
-    saveToFile();
     flushTimerActive_ = false;
+    saveToFile();
 }
 
 void PersistorClient::saveToFile()
 {
     FunctionLog(PersistorClientLog);
 
-    CompanEdgeDataModel::DataModelMessage dmo;
-
-    std::ifstream iFile(persistPath_.c_str(), std::ios::binary);
-    if (iFile.is_open()) { dmo.ParseFromIstream(&iFile); }
-
-    CompanEdgeProtocol::ValueChanged* entities = dmo.mutable_dataentities();
-
-    // we do an inplace remove or replace to the existing entities
-    for (auto iter = entities->mutable_value()->begin(); iter != entities->mutable_value()->end(); ++iter) {
-        CompanEdgeProtocol::Value value = *iter;
-
-        // remove takes priortity over any change
-        if (removeIds_.count(value.id())) {
-            auto nextIter = entities->mutable_value()->erase(iter);
-            removeIds_.erase(value.id());
+    if (!writer_) return;
 
-            if (nextIter == entities->mutable_value()->end()) break;
-
-            // step back one because of for() loop's incrementor
-            iter = nextIter - 1;
-            continue;
-        }
-
-        auto valueSetIter = changeValues_.find(value);
-        if (valueSetIter != changeValues_.end()) {
-            *iter = *valueSetIter;
-            changeValues_.erase(valueSetIter);
-        }
+    if (writer_->flush(changeValues_, removeIds_)) {
+        dirtyBytes_ = 0;
+        return;
     }
 
-    // anything left in the incoming value changes gets added
-    while (changeValues_.begin() != changeValues_.end()) {
-        *entities->add_value() = *changeValues_.begin();
-        changeValues_.erase(changeValues_.begin());
-    }
+    // still writing the previous flush, they're handed over next time
+    DebugLog(PersistorClientLog) << __FUNCTION__ << ": writer busy, backlog " << backlog() << std::endl;
+
+    setFlushTimer();
+}
 
-    removeIds_.clear();
-    changeValues_.clear();
+size_t PersistorClient::backlog() const
+{
+    size_t const writing(writer_ ? writer_->stats().writing : 0);
 
-    std::ofstream oFile(persistPath_.c_str(), std::ios::binary);
-    if (!oFile.is_open()) {
-        ErrorLog(PersistorClientLog) << "Failed to open file for writing: " << persistPath_ << std::endl;
-        return;
-    }
+    return changeValues_.size() + removeIds_.size() + writing;
+}
 
-    dmo.SerializeToOstream(&oFile);
+PersistorWriter::Stats PersistorClient::writerStats() const
+{
+    return writer_ ? writer_->stats() : PersistorWriter::Stats({0, 0, 0, 0, 0, 0, 0});
 }
@@ -10,25 +10,29 @@
 #include <company_ref_protocol/company_ref_datamodel.pb.h>
 #include <boost/asio/deadline_timer.hpp>
 
+#include "company_ref_persistor_writer.h"
+
+#include <chrono>
+#include <map>
 #include <memory>
 #include <set>
 
 namespace Compan{
 namespace Edge {
 
-struct ValueIdCompare {
-    bool operator()(CompanEdgeProtocol::Value const& lhs, CompanEdgeProtocol::Value const& rhs) const
-    {
-        return lhs.id() < rhs.id();
-    }
-};
-
 /*!
  * PersistorClient subscribes to value id's that are required
  * for persistance
  *
  * This bypasses the microservice client's ValueStore, keeping
  * values in memory only for the purpose of persistence
+ *
+ * Changes are appended to the persisted file's write ahead log by the
+ * PersistorWriter's thread; changes keep being collected while a flush is
+ * written. A flush is started by whichever comes first of
+ *  - the flush timeout since the first change
+ *  - the number of changed values and removals reaching flushMaxValues
+ *  - the encoded size of the changes reaching flushMaxBytes
  */
 class PersistorClient {
 public:
@@ -39,6 +43,11 @@ public:
 
     void start(std::string const& cfgPath);
 
+    /// Values and removals not yet persisted, collected and being written
+    size_t backlog() const;
+
+    PersistorWriter::Stats writerStats() const;
+
 protected:
     /// Main message handler from the client
     void onMessageReceived(CompanEdgeProtocol::ClientMessage const& rspMsg);
@@ -59,16 +68,18 @@ protected:
     void flushTimerHandler(boost::system::error_code const& error);
 
     /*!
-     * Loads the persisted DMO file
-     *  - replaces values from the value update set
-     *  - removes values from the remove id set
-     *  - saves and clears update sets
+     * Hands the update sets to the writer
+     *  - clears the update sets
+     *  - retried on the next timeout if the previous ones are still being written
      */
     void saveToFile();
 
     /// inserts value changes into the
     void insertValueChange(CompanEdgeProtocol::Value const& value);
 
+    /// Whether the changes outgrew the count or size limit
+    bool flushDue() const;
+
 private:
     CompanEdgeBoostUdsClient::Ptr udsClient_;  //!< UDS client to VariantValueStore server
     boost::asio::deadline_timer flushTimer_; //!< Timer to flush persistant values
@@ -78,12 +89,26 @@ private:
 
     SignalScopedConnection clientMessageConnection_;
 
-    std::set<CompanEdgeProtocol::Value, ValueIdCompare> changeValues_; //!< Incoming values that have been updated
-    std::set<std::string> removeIds_;                                //!< Keeps a copy the remove id's
+    std::map<std::string, CompanEdgeProtocol::Value> changeValues_; //!< Incoming values that have been updated
+    std::set<std::string> removeIds_;                               //!< Keeps a copy the remove id's
+    size_t dirtyBytes_;                                             //!< Encoded size of the update sets
+
+    size_t flushMaxValues_; //!< Changes that start a flush before the timeout
+    size_t flushMaxBytes_;  //!< Size of the changes that starts a flush before the timeout
+
+    uint32_t compactRatio_;                   //!< Log to persist file size that triggers a compaction
+    PersistorWriter::Durability durability_;  //!< When the logs are synced
+    std::chrono::milliseconds commitWindow_;  //!< Delay of group commits' syncs
+    std::unique_ptr<PersistorWriter> writer_; //!< Writes the update sets to the persist file's log
 
     static std::string const PersistSectionName;
     static std::string const PersistFileName;
     static std::string const PersistFlushTimeoutName;
+    static std::string const PersistCompactRatioName;
+    static std::string const PersistFlushMaxValuesName;
+    static std::string const PersistFlushMaxBytesName;
+    static std::string const PersistDurabilityName;
+    static std::string const PersistCommitWindowName;
     static std::string const ValueSectionName;
 };
 
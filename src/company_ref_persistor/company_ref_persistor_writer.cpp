@@ -0,0 +1,375 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_persistor_writer.cpp
+ @brief Persistor's writer thread
+ */
+#include "company_ref_persistor_writer.h"
+
+#include <company_ref_protocol/company_ref_datamodel.pb.h>
+#include <Compan_logger/Compan_logger.h>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <set>
+
+namespace Compan{
+namespace Edge {
+CompanLogger PersistorWriterLog("persistor.writer", LogLevel::Information);
+} // namespace Edge
+} // namespace Compan
+
+using namespace Compan::Edge;
+
+uint64_t const PersistorWriter::MinCompactSize(64 * 1024);
+
+PersistorWriter::PersistorWriter(
+        std::string const& persistPath,
+        uint32_t const compactRatio,
+        Durability const durability,
+        std::chrono::milliseconds const commitWindow)
+    : persistPath_(persistPath)
+    , compactRatio_(compactRatio)
+    , manifest_(persistPath)
+    , durability_(durability)
+    , commitWindow_(commitWindow)
+    , writing_(false)
+    , stopping_(false)
+    , flushes_(0)
+    , lastFlushMicroseconds_(0)
+    , lastFlushBytes_(0)
+    , bytesWritten_(0)
+    , frozenSize_(0)
+    , lastFlushShards_(0)
+    , commits_(0)
+{
+    FunctionArgLog(PersistorWriterLog) << persistPath_ << std::endl;
+}
+
+PersistorWriter::~PersistorWriter()
+{
+    FunctionLog(PersistorWriterLog);
+
+    stop();
+}
+
+bool PersistorWriter::start()
+{
+    FunctionLog(PersistorWriterLog);
+
+    if (thread_.joinable()) return true;
+
+    if (!manifest_.read()) {
+        ErrorLog(PersistorWriterLog) << "Failed to read the manifest of " << persistPath_ << std::endl;
+        return false;
+    }
+
+    if (!DmoShards::exists(persistPath_) && !migrate()) {
+        ErrorLog(PersistorWriterLog) << "Failed to shard " << persistPath_ << std::endl;
+        return false;
+    }
+
+    // compactions were interrupted
+    std::vector<std::string> interrupted;
+    for (auto& shardPath : manifest_.shardPaths()) {
+        boost::system::error_code ec;
+        if (boost::filesystem::exists(DmoWal::rotatedPath(shardPath), ec)) interrupted.push_back(shardPath);
+    }
+
+    if (!interrupted.empty()) startCompaction(interrupted);
+
+    thread_ = std::thread(&PersistorWriter::run, this);
+
+    return true;
+}
+
+void PersistorWriter::stop()
+{
+    if (!thread_.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cond_.notify_all();
+
+    thread_.join();
+
+    if (compaction_.valid()) compaction_.wait();
+
+    logs_.clear();
+}
+
+bool PersistorWriter::flush(ValueMap& changeValues, IdSet& removeIds)
+{
+    if (changeValues.empty() && removeIds.empty()) return true;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (writing_) return false;
+
+        frozenValues_.swap(changeValues);
+        frozenRemoveIds_.swap(removeIds);
+        frozenSize_ = frozenValues_.size() + frozenRemoveIds_.size();
+
+        writing_ = true;
+    }
+    cond_.notify_all();
+
+    return true;
+}
+
+void PersistorWriter::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this]() { return !writing_; });
+}
+
+bool PersistorWriter::busy() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return writing_;
+}
+
+PersistorWriter::Stats PersistorWriter::stats() const
+{
+    return Stats(
+            {flushes_, lastFlushMicroseconds_, lastFlushBytes_, bytesWritten_, frozenSize_, lastFlushShards_, commits_});
+}
+
+void PersistorWriter::run()
+{
+    FunctionLog(PersistorWriterLog);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    auto const handedOver = [this]() { return writing_ || stopping_; };
+
+    while (true) {
+        // what's handed over is written before stopping
+        if (uncommitted_.empty())
+            cond_.wait(lock, handedOver);
+        else
+            cond_.wait_until(lock, commitDeadline_, handedOver);
+
+        if (!writing_) {
+            // the commit window has passed, or stopping
+            lock.unlock();
+            commit();
+            lock.lock();
+
+            if (stopping_) break;
+            continue;
+        }
+
+        lock.unlock();
+
+        // a flood of flushes doesn't hold back the sync past the commit window
+        if (!uncommitted_.empty() && std::chrono::steady_clock::now() >= commitDeadline_) commit();
+
+        write();
+        lock.lock();
+
+        frozenValues_.clear();
+        frozenRemoveIds_.clear();
+        frozenSize_ = 0;
+
+        writing_ = false;
+        cond_.notify_all();
+    }
+}
+
+void PersistorWriter::write()
+{
+    auto const start = std::chrono::steady_clock::now();
+
+    // the shards holding the frozen sets, and their log sizes before appending
+    std::map<DmoWal*, uint64_t> dirty;
+
+    auto dirtyLog = [this, &dirty](std::string const& valueId) -> DmoWal* {
+        DmoWal* log = shardLog(DmoShards::subtree(valueId));
+        if (log) dirty.emplace(log, log->logSize());
+
+        return log;
+    };
+
+    // each id's latest change is kept, their order doesn't matter
+    for (auto& valueId : frozenRemoveIds_) {
+        DmoWal* log = dirtyLog(valueId);
+        if (log) log->appendRemove(valueId);
+    }
+
+    for (auto& value : frozenValues_) {
+        DmoWal* log = dirtyLog(value.first);
+        if (log) log->append(value.second);
+    }
+
+    // new shards are listed before anything is synced to them
+    if (!manifest_.write()) {
+        ErrorLog(PersistorWriterLog) << "Failed to write the manifest of " << persistPath_ << std::endl;
+        return;
+    }
+
+    uint64_t bytes(0);
+    std::vector<DmoWal*> writtenLogs;
+
+    for (auto& shard : dirty) {
+        bool const written(durability_ == SyncOnFlush ? shard.first->sync() : shard.first->write());
+        if (!written) {
+            ErrorLog(PersistorWriterLog) << "Failed to write the log of " << shard.first->snapshotPath()
+                                         << std::endl;
+            continue;
+        }
+
+        bytes += shard.first->logSize() - shard.second;
+        writtenLogs.push_back(shard.first);
+    }
+
+    if (durability_ == SyncOnFlush && !writtenLogs.empty()) ++commits_;
+
+    if (durability_ == GroupCommit && !writtenLogs.empty()) {
+        if (uncommitted_.empty()) commitDeadline_ = start + commitWindow_;
+        uncommitted_.insert(writtenLogs.begin(), writtenLogs.end());
+    }
+
+    uint64_t const microseconds(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+
+    ++flushes_;
+    lastFlushMicroseconds_ = microseconds;
+    lastFlushBytes_ = bytes;
+    lastFlushShards_ = dirty.size();
+    bytesWritten_ += bytes;
+
+    DebugLog(PersistorWriterLog) << __FUNCTION__ << ": " << frozenSize_ << " records, " << dirty.size()
+                                 << " shards, " << bytes << " bytes, " << microseconds << "us" << std::endl;
+
+    compactIfNeeded(writtenLogs);
+}
+
+void PersistorWriter::commit()
+{
+    if (uncommitted_.empty()) return;
+
+    auto const start = std::chrono::steady_clock::now();
+
+    for (auto& log : uncommitted_)
+        if (!log->sync())
+            ErrorLog(PersistorWriterLog) << "Failed to sync the log of " << log->snapshotPath() << std::endl;
+
+    DebugLog(PersistorWriterLog) << __FUNCTION__ << ": " << uncommitted_.size() << " shards, "
+                                 << std::chrono::duration_cast<std::chrono::microseconds>(
+                                            std::chrono::steady_clock::now() - start)
+                                            .count()
+                                 << "us" << std::endl;
+
+    uncommitted_.clear();
+    ++commits_;
+}
+
+DmoWal* PersistorWriter::shardLog(std::string const& subtree)
+{
+    auto iter = logs_.find(subtree);
+    if (iter != logs_.end()) return iter->second.get();
+
+    std::unique_ptr<DmoWal> log(new DmoWal(manifest_.shardPath(subtree)));
+    if (!log->open()) {
+        ErrorLog(PersistorWriterLog) << "Failed to open the log of " << log->snapshotPath() << std::endl;
+        return nullptr;
+    }
+
+    return logs_.emplace(subtree, std::move(log)).first->second.get();
+}
+
+bool PersistorWriter::migrate()
+{
+    FunctionArgLog(PersistorWriterLog) << persistPath_ << std::endl;
+
+    std::vector<std::string> const legacyPaths(
+            {persistPath_, DmoWal::rotatedPath(persistPath_), DmoWal::logPath(persistPath_)});
+
+    boost::system::error_code ec;
+    if (std::none_of(legacyPaths.begin(), legacyPaths.end(), [&ec](std::string const& path) {
+            return boost::filesystem::exists(path, ec);
+        }))
+        return true;
+
+    CompanEdgeDataModel::DataModelMessage dmoData;
+    if (!DmoWal::restore(persistPath_, dmoData)) return false;
+
+    std::set<DmoWal*> dirty;
+
+    for (auto& value : dmoData.dataentities().value()) {
+        DmoWal* log = shardLog(DmoShards::subtree(value.id()));
+        if (!log) return false;
+
+        log->append(value);
+        dirty.insert(log);
+    }
+
+    for (auto& log : dirty)
+        if (!log->sync()) return false;
+
+    // records are absolute, shards left by an interrupted migration are appended to again
+    if (!manifest_.write()) return false;
+
+    // the manifest takes precedence, the old files are only left behind on a crash
+    for (auto& path : legacyPaths) boost::filesystem::remove(path, ec);
+
+    InfoLog(PersistorWriterLog) << __FUNCTION__ << ": " << dmoData.dataentities().value_size() << " values in "
+                                << manifest_.shards().size() << " shards" << std::endl;
+
+    return true;
+}
+
+void PersistorWriter::compactIfNeeded(std::vector<DmoWal*> const& shards)
+{
+    if (compaction_.valid()) {
+        if (compaction_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+
+        if (!compaction_.get()) ErrorLog(PersistorWriterLog) << "Failed to compact " << persistPath_ << std::endl;
+
+        // rotated logs are kept when they fail, and retried
+        std::vector<std::string> failed;
+        for (auto& shardPath : compacting_) {
+            boost::system::error_code ec;
+            if (boost::filesystem::exists(DmoWal::rotatedPath(shardPath), ec)) failed.push_back(shardPath);
+        }
+
+        compacting_.clear();
+
+        if (!failed.empty()) {
+            startCompaction(failed);
+            return;
+        }
+    }
+
+    std::vector<std::string> rotated;
+
+    for (auto& log : shards) {
+        boost::system::error_code ec;
+        uint64_t shardSize = boost::filesystem::file_size(log->snapshotPath(), ec);
+        if (ec) shardSize = 0;
+
+        if (log->logSize() < compactRatio_ * std::max(shardSize, MinCompactSize)) continue;
+
+        if (log->rotate()) rotated.push_back(log->snapshotPath());
+    }
+
+    if (!rotated.empty()) startCompaction(rotated);
+}
+
+void PersistorWriter::startCompaction(std::vector<std::string> const& shardPaths)
+{
+    FunctionArgLog(PersistorWriterLog) << shardPaths.size() << " shards" << std::endl;
+
+    compacting_ = shardPaths;
+
+    compaction_ = std::async(std::launch::async, [shardPaths]() {
+        bool compacted(true);
+        for (auto& shardPath : shardPaths) compacted = DmoWal::compact(shardPath) && compacted;
+
+        return compacted;
+    });
+}
@@ -0,0 +1,154 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_persistor_writer.h
+ @brief Persistor's writer thread
+ */
+#ifndef __company_ref_PERSISTOR_WRITER_H__
+#define __company_ref_PERSISTOR_WRITER_H__
+
+#include <company_ref_dmo/company_ref_dmo_shards.h>
+#include <company_ref_dmo/company_ref_dmo_wal.h>
+#include <company_ref_protocol/company_ref_protocol.pb.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Compan{
+namespace Edge {
+
+/*!
+ * @brief Persists the dirty sets on a dedicated thread
+ *
+ * The io thread hands over it's dirty sets by swapping them with the
+ * writer's frozen ones, which are empty while the writer is idle, and
+ * keeps on collecting changes while the frozen sets are written.
+ *
+ * The persisted file is split in shards by top level subtree (DmoShards),
+ * each with it's own write ahead log. The writer appends the frozen sets to
+ * the logs of the shards holding them, syncs only those, and rotates a
+ * shard's log for compaction once it's compactRatio times the size of the
+ * shard's file. An unsharded persisted file is migrated when started.
+ *
+ * How a flush reaches the disk depends on the durability:
+ *  - NoSync, the logs are written and left to the kernel
+ *  - SyncOnFlush, the logs are synced by each flush
+ *  - GroupCommit, the logs are written by each flush, and synced once by
+ *    the first idle moment or flush past the commit window; bursts of
+ *    flushes share a sync
+ */
+class PersistorWriter {
+public:
+    using ValueMap = std::map<std::string, CompanEdgeProtocol::Value>;
+    using IdSet = std::set<std::string>;
+
+    enum Durability { NoSync, SyncOnFlush, GroupCommit };
+
+    static uint64_t const MinCompactSize;
+
+    struct Stats {
+        uint64_t flushes;
+        uint64_t lastFlushMicroseconds; //!< append and sync of the last flush
+        uint64_t lastFlushBytes;
+        uint64_t bytesWritten;
+        size_t writing; //!< values and removals of the flush being written
+        size_t lastFlushShards; //!< shards written by the last flush
+        uint64_t commits; //!< syncs of the written logs, by flushes or group commits
+    };
+
+    PersistorWriter(
+            std::string const& persistPath,
+            uint32_t const compactRatio,
+            Durability const durability = SyncOnFlush,
+            std::chrono::milliseconds const commitWindow = std::chrono::milliseconds(100));
+    virtual ~PersistorWriter();
+
+    PersistorWriter(PersistorWriter const&) = delete;
+    PersistorWriter& operator=(PersistorWriter const&) = delete;
+
+    /// Reads the manifest and starts the thread
+    bool start();
+
+    /// Writes what's handed over, and stops the thread
+    void stop();
+
+    /*!
+     * Hands the dirty sets to the writer, they're left empty
+     *
+     * @returns false if the writer is still writing the previous ones,
+     *          the dirty sets are untouched
+     */
+    bool flush(ValueMap& changeValues, IdSet& removeIds);
+
+    /// Waits until the writer is idle
+    void wait();
+
+    bool busy() const;
+
+    Stats stats() const;
+
+protected:
+    void run();
+
+    /// Appends the frozen sets, synced as the durability requires
+    void write();
+
+    /// Syncs the logs written since the last commit
+    void commit();
+
+    /// Log of the subtree's shard, opened on first use
+    DmoWal* shardLog(std::string const& subtree);
+
+    /// Splits an unsharded persisted file and it's logs into shards
+    bool migrate();
+
+    /// Rotates the shards' logs and compacts them in the background, once they've outgrown their files
+    void compactIfNeeded(std::vector<DmoWal*> const& shards);
+    void startCompaction(std::vector<std::string> const& shardPaths);
+
+private:
+    std::string const persistPath_;
+    uint32_t const compactRatio_;
+
+    DmoShards manifest_;                                   //!< writer thread only, once started
+    std::map<std::string, std::unique_ptr<DmoWal>> logs_; //!< shard logs by subtree, writer thread only
+    std::future<bool> compaction_;                         //!< running compaction, if valid
+    std::vector<std::string> compacting_;                  //!< shards of the running compaction
+
+    Durability const durability_;
+    std::chrono::milliseconds const commitWindow_;
+    std::set<DmoWal*> uncommitted_;                        //!< logs written since the last commit, writer thread only
+    std::chrono::steady_clock::time_point commitDeadline_; //!< of the oldest uncommitted write
+
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    bool writing_;  //!< the frozen sets are being written, guarded by mutex_
+    bool stopping_; //!< guarded by mutex_
+
+    ValueMap frozenValues_; //!< owned by the writer while writing_
+    IdSet frozenRemoveIds_;
+
+    std::thread thread_;
+
+    std::atomic<uint64_t> flushes_;
+    std::atomic<uint64_t> lastFlushMicroseconds_;
+    std::atomic<uint64_t> lastFlushBytes_;
+    std::atomic<uint64_t> bytesWritten_;
+    std::atomic<size_t> frozenSize_;
+    std::atomic<size_t> lastFlushShards_;
+    std::atomic<uint64_t> commits_;
+};
+
+} // namespace Edge
+} // namespace Compan
+
+#endif // __company_ref_PERSISTOR_WRITER_H__
@@ -8,7 +8,10 @@
 
 #include "company_ref_variant_container_util.h"
 #include "company_ref_variant_factory.h"
+#include "company_ref_variant_valuestore_client_frame_compressor.h"
 #include "company_ref_variant_valuestore_dispatcher.h"
+#include "company_ref_variant_valuestore_hash_methods.h"
+#include "company_ref_variant_valuestore_subscription_index.h"
 #include "company_ref_variant_valuestore_valueid.h"
 #include "company_ref_variant_valuestore_visitor.h"
 
@@ -22,6 +25,9 @@
 
 #include <Compan_logger/Compan_logger.h>
 
+#include <chrono>
+#include <random>
+
 namespace Compan{
 namespace Edge {
 
@@ -30,6 +36,19 @@ CompanLogger VariantValueStoreLog("variantvalue.store", LogLevel::Information);
 } // namespace Edge
 } // namespace Compan
 
+namespace {
+/// A non zero epoch, a restarted store doesn't reuse it's predecessor's
+uint64_t makeEpoch()
+{
+    std::random_device device;
+
+    uint64_t epoch = (static_cast<uint64_t>(device()) << 32) ^ device()
+                     ^ static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+
+    return epoch ? epoch : 1;
+}
+} // namespace
+
 using namespace Compan::Edge;
 
 VariantValueStore::VariantValueStore(boost::asio::io_context& ctx)
@@ -43,6 +62,11 @@ VariantValueStore::VariantValueStore(boost::asio::io_context& ctx)
     , onValueAddToContainerSignal_(ctx_)
     , onValueRemoveFromContainerSignal_(ctx_)
     , dataDispatcher_(std::make_shared<VariantValueDispatcher>())
+    , subscriptions_(std::make_unique<VariantValueSubscriptionIndex>(*this))
+    , compressorMutex_()
+    , compressor_(std::make_shared<ClientFrameCompressor>(std::string()))
+    , epoch_(makeEpoch())
+    , version_(0)
 {
     Protobuf::instance();
     dataDispatcher_->start();
@@ -154,6 +178,32 @@ VariantValue::Ptr VariantValueStore::add(VariantValue::Ptr wsValue)
     if (get(wsValue->id()) != nullptr) return nullptr;
     if (wsValue->id().empty()) return nullptr;
 
+    attach(wsValue);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // we will always make sure that the hash token is correct
+        HashToken hashToken = bucketizer_.make(wsValue->id());
+
+        wsValue->hashToken(hashToken.transportToken());
+
+        // Set the shared name from the bucketizer
+        wsValue->valueId_ = bucketizer_.get(hashToken);
+
+        auto insert_iter = wsMap_.emplace(wsValue->id(), wsValue);
+
+        // maybe this is a glitch?
+        if (!insert_iter.second) return nullptr;
+    }
+
+    doAddedSignal(wsValue);
+
+    return wsValue;
+}
+
+void VariantValueStore::attach(VariantValue::Ptr const& wsValue)
+{
     wsValue->setDataDispatcher(dataDispatcher_);
     wsValue->setWsChangedSignal(std::bind(&VariantValueStore::doChangedSignal, this, std::placeholders::_1));
 
@@ -169,8 +219,6 @@ VariantValue::Ptr VariantValueStore::add(VariantValue::Ptr wsValue)
             WarnLog(VariantValueStoreLog) << "Adding : " << wsValue->id() << " is not a VariantMapValue" << std::endl;
     }
 
-    ValueId valueId(wsValue->id());
-
     VariantValue::Ptr parentValue = getParent(wsValue);
     if (parentValue) {
 
@@ -178,27 +226,84 @@ VariantValue::Ptr VariantValueStore::add(VariantValue::Ptr wsValue)
         wsValue->connectChangedListener(WeakBind(&VariantValue::parentSignal, parentValue, std::placeholders::_1));
         wsValue->parent(parentValue);
     }
+}
+
+size_t VariantValueStore::setSorted(SortedValueFunction const& next, VariantValue::SetUpdateType const updateType)
+{
+    CompanEdgeProtocol::Value wsValue;
+    HashToken::HashIdType hashId(HashToken::InvalidHashId);
+
+    size_t count(0);
 
+    Iterator pos;          //!< first value not less than the last one loaded
+    size_t mapSize(0);     //!< values, as of the last one loaded
+    bool fnvHashed(false); //!< the supplied hash ids are the store's
     {
         std::lock_guard<std::mutex> lock(mutex_);
+        pos = wsMap_.begin();
+        mapSize = wsMap_.size();
 
-        // we will always make sure that the hash token is correct
-        HashToken hashToken = bucketizer_.make(wsValue->id());
+        HashBucket::HashFunction const hashFunction(bucketizer_.hashBucket().getHashFunction());
+        auto const target = hashFunction.target<uint32_t (*)(std::string const&)>();
+        fnvHashed = target && *target == &FnvHash::as32;
+    }
 
-        wsValue->hashToken(hashToken.transportToken());
+    while (next(wsValue, hashId)) {
+        if (wsValue.id().empty() || !ValueTypeTraits::isValid(wsValue)) {
+            ErrorLog(VariantValueStoreLog) << "Set value failed: " << wsValue.id() << " - Invalid data" << std::endl;
+            continue;
+        }
 
-        // Set the shared name from the bucketizer
-        wsValue->valueId_ = bucketizer_.get(hashToken);
+        VariantValue::Ptr valuePtr;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
 
-        auto insert_iter = wsMap_.emplace(wsValue->id(), wsValue);
+            // values were added by someone else, or this one is out of order
+            if (wsMap_.size() != mapSize || (pos != wsMap_.begin() && std::prev(pos)->first >= wsValue.id()))
+                pos = wsMap_.lower_bound(wsValue.id());
 
-        // maybe this is a glitch?
-        if (!insert_iter.second) return nullptr;
-    }
+            while (pos != wsMap_.end() && pos->first < wsValue.id()) ++pos;
 
-    doAddedSignal(wsValue);
+            if (pos != wsMap_.end() && pos->first == wsValue.id()) valuePtr = pos->second;
+        }
 
-    return wsValue;
+        if (valuePtr) {
+            ValueDataSet::Results const result = valuePtr->set(wsValue, updateType);
+
+            if (result == ValueDataSet::Success || result == ValueDataSet::SameValue)
+                ++count;
+            else
+                ErrorLog(VariantValueStoreLog)
+                        << "Set value failed: " << valuePtr->id() << " - " << ValueDataSet::resultStr(result) << std::endl;
+
+            continue;
+        }
+
+        valuePtr = VariantFactory::make(ctx_, wsValue, updateType);
+        if (!valuePtr) continue;
+
+        // parents missing from the load are added, ahead of the merge position
+        attach(valuePtr);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            // precomputed hash ids are FnvHash's, a store hashing otherwise computes it's own
+            HashToken const hashToken =
+                    bucketizer_.make(valuePtr->id(), fnvHashed ? hashId : HashToken::InvalidHashId);
+
+            valuePtr->hashToken(hashToken.transportToken());
+            valuePtr->valueId_ = bucketizer_.get(hashToken);
+
+            pos = wsMap_.emplace_hint(pos, wsValue.id(), valuePtr);
+            mapSize = wsMap_.size();
+        }
+
+        doAddedSignal(valuePtr);
+        ++count;
+    }
+
+    return count;
 }
 
 bool VariantValueStore::has(ValueId const& valueId)
@@ -220,6 +325,22 @@ void VariantValueStore::visitValues(VisitFunction const& visitFunction)
     }
 }
 
+std::shared_ptr<ClientFrameCompressor> VariantValueStore::frameCompressor()
+{
+    std::lock_guard<std::mutex> lock(compressorMutex_);
+
+    return compressor_;
+}
+
+void VariantValueStore::trainFrameCompressor()
+{
+    // visits the store outside the lock, connections negotiate with the previous compressor meanwhile
+    std::shared_ptr<ClientFrameCompressor> compressor = ClientFrameCompressor::train(*this);
+
+    std::lock_guard<std::mutex> lock(compressorMutex_);
+    compressor_ = compressor;
+}
+
 size_t VariantValueStore::size()
 {
     std::lock_guard<std::mutex> lock(mutex_);
@@ -384,16 +505,22 @@ VariantValue::Ptr VariantValueStore::getParent(VariantValue::Ptr const valuePtr)
 
 void VariantValueStore::doAddedSignal(VariantValue::Ptr const variantPtr)
 {
+    variantPtr->version(++version_);
+
     onValueAddedSignal_(variantPtr);
 }
 
 void VariantValueStore::doChangedSignal(VariantValue::Ptr const variantPtr)
 {
+    variantPtr->version(++version_);
+
     onValueChangedSignal_(variantPtr);
 }
 
 void VariantValueStore::doRemovedSignal(VariantValue::Ptr const variantPtr)
 {
+    ++version_;
+
     onValueRemovedSignal_(variantPtr);
 }
 
@@ -407,6 +534,11 @@ void VariantValueStore::doRemoveFromContainerSignal(VariantValue::Ptr const vari
     onValueRemoveFromContainerSignal_(variantPtr);
 }
 
+bool VariantValueStore::canResume(uint64_t const epoch, uint64_t const version) const
+{
+    return epoch == epoch_ && version <= version_;
+}
+
 void VariantValueStore::print(std::ostream& os)
 {
     visitValues([&os](VariantValue::Ptr const& valuePtr) { os << valuePtr->get() << std::endl; });
@@ -9,10 +9,13 @@
 
 #include <company_ref_utils/company_ref_signals.h>
 
+#include <atomic>
 #include <functional>
+#include <iterator>
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <mutex>
 
@@ -35,6 +38,9 @@ class VariantValueDispatcher;
 
 using VariantValueDispatcherPtr = std::shared_ptr<VariantValueDispatcher>;
 
+class VariantValueSubscriptionIndex;
+class ClientFrameCompressor;
+
 /*!
  * * @brief VariantValue::Ptr Container
  *
@@ -51,6 +57,9 @@ private:
 public:
     using VisitFunction = std::function<void(VariantValue::Ptr const&)>;
 
+    /// Supplies the next value of a sorted load and it's precomputed hash id, false once done
+    using SortedValueFunction = std::function<bool(CompanEdgeProtocol::Value&, HashToken::HashIdType&)>;
+
 public:
     VariantValueStore(boost::asio::io_context&);
     virtual ~VariantValueStore();
@@ -73,6 +82,25 @@ public:
             CompanEdgeProtocol::Value const& vsValue,
             VariantValue::SetUpdateType const updateType = VariantValue::Local);
 
+    /*!
+     * Adds or updates values supplied in ascending id order, in one pass
+     *
+     * The store is merged with the values rather than searched for each one;
+     * new values are inserted at the merge position, with the supplied hash
+     * id (HashToken::InvalidHashId has it computed). Supplied hash ids are
+     * FnvHash::as32's, they're only used while the store hashes with it.
+     *
+     * The supplier may add values, ie. container instances, but none may be
+     * removed while loading.
+     *
+     * @param next          supplies the values
+     * @param updateType    Identifies who is making the update
+     * @return number of values added or updated
+     */
+    size_t setSorted(
+            SortedValueFunction const& next,
+            VariantValue::SetUpdateType const updateType = VariantValue::Local);
+
     /*!
      * Returns a valid VariantValue::Ptr for a value in the variant value store.
      * @param valueId Value Id
@@ -91,6 +119,26 @@ public:
         return std::dynamic_pointer_cast<Derived>(get(valueId));
     }
 
+    /*!
+     * Returns the VariantValue::Ptr of a range of values in one pass over the store,
+     * nullptr for the values not found.
+     * @param first     first element of the range
+     * @param last      end of the range
+     * @param idOf      returns the Value Id of an element
+     * @return VariantValue::Ptr's in range order
+     */
+    template <typename InputIt, typename IdOf>
+    std::vector<VariantValue::Ptr> get(InputIt first, InputIt last, IdOf idOf)
+    {
+        std::vector<VariantValue::Ptr> valuePtrs;
+        valuePtrs.reserve(std::distance(first, last));
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (; first != last; ++first) valuePtrs.push_back(getSafe(idOf(*first)));
+
+        return valuePtrs;
+    }
+
     /*!
      * Removes a value from the variant value store
      *
@@ -162,6 +210,38 @@ public:
 
     boost::asio::io_context::strand& getStrand();
 
+    /// Returns the subtree subscription index shared by all subscribers
+    VariantValueSubscriptionIndex& subscriptions();
+
+    /*!
+     * Returns the compressor of frames sent to clients
+     *
+     * Until the store is trained, frames are compressed without a dictionary.
+     */
+    std::shared_ptr<ClientFrameCompressor> frameCompressor();
+
+    /*!
+     * (Re)trains the frame compressor's dictionary from the store's values
+     *
+     * Called once loads complete, connections that already negotiated keep
+     * their compressor, later ones negotiate the new dictionary.
+     */
+    void trainFrameCompressor();
+
+    /// Returns the store's epoch, unique to this instance
+    uint64_t epoch() const;
+
+    /// Returns the version, bumped by every add, change and removal
+    uint64_t version() const;
+
+    /*!
+     * Returns true if a client current to the epoch and version can be brought
+     * up to date with the values changed since, ie. VariantValue::version() > version
+     *
+     * A store with another epoch, or a version not handed out yet, requires a full resync
+     */
+    bool canResume(uint64_t const epoch, uint64_t const version) const;
+
 public:
     /// Connects a listener to value added notifications
     SignalConnection connectValueAddedListener(VariantValue::ValueSignal::SlotType const&);
@@ -187,6 +267,9 @@ protected:
     /// Used to create parent Value's when no parent is found
     VariantValue::Ptr getParent(VariantValue::Ptr const valuePtr);
 
+    /// Hooks a value being added to the store's signals, and to it's parent
+    void attach(VariantValue::Ptr const& wsValue);
+
     /// Removes parent and children values
     void delChildren(VariantValue::Ptr, VariantValue::SetUpdateType const updateType);
 
@@ -213,6 +296,15 @@ private:
     std::mutex mutex_;
 
     VariantValueDispatcherPtr dataDispatcher_;
+
+    // connects to onValueChangedSignal_, must be declared after it
+    std::unique_ptr<VariantValueSubscriptionIndex> subscriptions_;
+
+    std::mutex compressorMutex_;
+    std::shared_ptr<ClientFrameCompressor> compressor_; //!< shared by every connection, frames are compressed once
+
+    uint64_t const epoch_;
+    std::atomic<uint64_t> version_; //!< values are stamped as they're added or changed
 };
 
 inline boost::asio::io_context::strand& VariantValueStore::getStrand()
@@ -220,6 +312,21 @@ inline boost::asio::io_context::strand& VariantValueStore::getStrand()
     return ctx_;
 }
 
+inline VariantValueSubscriptionIndex& VariantValueStore::subscriptions()
+{
+    return *subscriptions_;
+}
+
+inline uint64_t VariantValueStore::epoch() const
+{
+    return epoch_;
+}
+
+inline uint64_t VariantValueStore::version() const
+{
+    return version_;
+}
+
 inline SignalConnection VariantValueStore::connectValueAddedListener(VariantValue::ValueSignal::SlotType const& cb)
 {
     return onValueAddedSignal_.connect(cb);
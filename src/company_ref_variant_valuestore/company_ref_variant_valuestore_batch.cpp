@@ -0,0 +1,179 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_variant_valuestore_batch.cpp
+ @brief Batched VariantValue data access
+ */
+#include "company_ref_variant_valuestore_batch.h"
+
+#include "company_ref_variant_valuestore.h"
+#include "company_ref_variant_valuestore_dispatcher.h"
+#include "company_ref_variant_valuestore_visitor.h"
+
+#include <company_ref_protocol/company_ref_protocol.pb.h>
+
+#include <Compan_logger/Compan_logger.h>
+
+#include <exception>
+#include <future>
+#include <memory>
+#include <sstream>
+
+using namespace Compan::Edge;
+
+CompanLogger VariantValueBatchLog("variantvalue.batch", LogLevel::Information);
+
+size_t const VariantValueBatch::MaxChunk(512);
+
+void VariantValueBatch::dispatch(std::vector<VariantValue::Ptr> const& valuePtrs, DataFunction const& dataFunction)
+{
+    std::vector<std::future<void>> chunks;
+    chunks.reserve(valuePtrs.size() / MaxChunk + 1);
+
+    size_t first = 0;
+    while (first < valuePtrs.size()) {
+        VariantValueDispatcherPtr const& dispatcher = valuePtrs[first]->dataDispatcher_;
+
+        size_t last = first + 1;
+        while (last < valuePtrs.size() && last - first < MaxChunk && valuePtrs[last]->dataDispatcher_ == dispatcher)
+            ++last;
+
+        VariantValueDispatcher::ProtocolValueBatchPtr chunkTask(
+                std::make_shared<VariantValueDispatcher::ProtocolValueBatch>([&dataFunction, first, last]() {
+                    for (size_t i = first; i < last; ++i) dataFunction(i);
+                }));
+
+        chunks.push_back(chunkTask->get_future());
+
+        if (dispatcher)
+            dispatcher->batchCompanEdgeProtocolValues(chunkTask);
+        else
+            (*chunkTask)();
+
+        first = last;
+    }
+
+    // the chunks reference the caller's data - all must be done before an exception leaves
+    for (auto& chunk : chunks) chunk.wait();
+    for (auto& chunk : chunks) chunk.get();
+}
+
+void VariantValueBatch::get(
+        std::vector<VariantValue::Ptr> const& valuePtrs,
+        std::vector<CompanEdgeProtocol::Value*> const& values)
+{
+    dispatch(valuePtrs, [&valuePtrs, &values](size_t const i) { valuePtrs[i]->getData(*values[i]); });
+}
+
+std::vector<ValueDataSet::Results> VariantValueBatch::set(
+        std::vector<VariantValue::Ptr> const& valuePtrs,
+        std::vector<std::string const*> const& args,
+        VariantValue::SetUpdateType const updateType)
+{
+    std::vector<ValueDataSet::Results> results(valuePtrs.size(), ValueDataSet::InvalidType);
+
+    dispatch(valuePtrs, [&valuePtrs, &args, &results, updateType](size_t const i) {
+        // a bad value fails on it's own, not the whole batch
+        try {
+            results[i] = valuePtrs[i]->setData(*args[i], updateType);
+        } catch (std::exception const& e) {
+            ErrorLog(VariantValueBatchLog) << "Failed to set " << valuePtrs[i]->id() << ": " << e.what() << std::endl;
+        }
+    });
+
+    for (size_t i = 0; i < valuePtrs.size(); ++i)
+        if (results[i] == ValueDataSet::Success) valuePtrs[i]->signal();
+
+    return results;
+}
+
+void VariantValueBatch::multiGet(
+        VariantValueStore& ws,
+        CompanEdgeProtocol::VsMultiGet const& msg,
+        CompanEdgeProtocol::VsMultiGetResult& multiGetResult)
+{
+    multiGetResult.set_sequenceno(msg.sequenceno());
+
+    std::vector<VariantValue::Ptr> const found(
+            ws.get(msg.ids().begin(), msg.ids().end(), [](std::string const& id) -> std::string const& {
+                return id;
+            }));
+
+    // the reads, containers flattened with their children,
+    // and where each goes in the result
+    std::vector<VariantValue::Ptr> valuePtrs;
+    std::vector<CompanEdgeProtocol::Value*> values;
+    valuePtrs.reserve(found.size());
+    values.reserve(found.size());
+
+    for (auto const& valuePtr : found) {
+        CompanEdgeProtocol::VsMultiGetResult_Result* result = multiGetResult.add_results();
+
+        if (valuePtr == nullptr) {
+            result->set_error(CompanEdgeProtocol::VsMultiGetResult::ValueNotFound);
+            result->set_description("Value not found");
+            continue;
+        }
+
+        result->set_error(CompanEdgeProtocol::VsMultiGetResult::Success);
+        valuePtrs.push_back(valuePtr);
+        values.push_back(result->add_values());
+
+        if (valuePtr->type() == CompanEdgeProtocol::Container) {
+            VariantValueVisitor::visitChildren(valuePtr, [&](VariantValue::Ptr const& visitPtr) {
+                valuePtrs.push_back(visitPtr);
+                values.push_back(result->add_values());
+            });
+        }
+    }
+
+    get(valuePtrs, values);
+}
+
+void VariantValueBatch::multiSet(
+        VariantValueStore& ws,
+        CompanEdgeProtocol::VsMultiSet const& msg,
+        CompanEdgeProtocol::VsMultiSetResult& multiSetResult)
+{
+    multiSetResult.set_sequenceno(msg.sequenceno());
+
+    std::vector<VariantValue::Ptr> const found(ws.get(
+            msg.values().begin(),
+            msg.values().end(),
+            [](CompanEdgeProtocol::VsMultiSet::Value const& setValue) -> std::string const& { return setValue.id(); }));
+
+    std::vector<VariantValue::Ptr> valuePtrs;
+    std::vector<std::string const*> args;
+    std::vector<CompanEdgeProtocol::VsMultiSetResult_Result*> setResults;
+    valuePtrs.reserve(found.size());
+    args.reserve(found.size());
+    setResults.reserve(found.size());
+
+    for (int i = 0; i < msg.values_size(); ++i) {
+        CompanEdgeProtocol::VsMultiSetResult_Result* result = multiSetResult.add_results();
+        result->set_id(msg.values(i).id());
+
+        if (found[i] == nullptr) {
+            result->set_error(CompanEdgeProtocol::VsMultiSetResult::ValueNotFound);
+            result->set_description("Value not found");
+            continue;
+        }
+
+        valuePtrs.push_back(found[i]);
+        args.push_back(&msg.values(i).value());
+        setResults.push_back(result);
+    }
+
+    std::vector<ValueDataSet::Results> const results(set(valuePtrs, args));
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (results[i] == ValueDataSet::Success || results[i] == ValueDataSet::SameValue) {
+            setResults[i]->set_error(CompanEdgeProtocol::VsMultiSetResult::Success);
+            continue;
+        }
+
+        setResults[i]->set_error(CompanEdgeProtocol::VsMultiSetResult::UnknownError);
+        std::stringstream ss;
+        ss << "Failed to set value: " << ValueDataSet::resultStr(results[i]);
+        setResults[i]->set_description(ss.str());
+    }
+}
@@ -0,0 +1,86 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_variant_valuestore_batch.h
+ @brief Batched VariantValue data access
+ */
+#ifndef __company_ref_VARIANT_VALUESTORE_BATCH_H__
+#define __company_ref_VARIANT_VALUESTORE_BATCH_H__
+
+#include "company_ref_variant_valuestore_variant.h"
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace CompanEdgeProtocol {
+class VsMultiGet;
+class VsMultiGetResult;
+class VsMultiSet;
+class VsMultiSetResult;
+} // namespace CompanEdgeProtocol
+
+namespace Compan{
+namespace Edge {
+
+class VariantValueStore;
+
+/*!
+ * @brief Reads and writes many values with few data dispatcher round trips
+ *
+ * A VariantValue get or set is a blocking round trip to the data
+ * dispatcher's thread. A multi request of n values paid n of them, each
+ * waiting on the one before.
+ *
+ * Here the ids are resolved under a single store lock, then runs of
+ * values sharing a dispatcher are handed over in chunks of MaxChunk.
+ * Every chunk is posted before the first is waited on, so the dispatcher
+ * works through them back to back. Results are assembled in request
+ * order and change signals sent from the calling thread, as a single
+ * set would.
+ */
+class VariantValueBatch {
+public:
+    static size_t const MaxChunk; //!< values per dispatcher round trip
+
+    /// Function run for the value at an index
+    using DataFunction = std::function<void(size_t const)>;
+
+    /*!
+     * Runs dataFunction for each value, on the value's data dispatcher
+     * or inline when it has none; returns when all have run
+     */
+    static void dispatch(std::vector<VariantValue::Ptr> const& valuePtrs, DataFunction const& dataFunction);
+
+    /// Reads the values into values, in order
+    static void get(std::vector<VariantValue::Ptr> const& valuePtrs, std::vector<CompanEdgeProtocol::Value*> const& values);
+
+    /*!
+     * Sets the values from their string data, signaling the changed ones
+     *
+     * @param valuePtrs     values to set
+     * @param args          string data, one per value
+     * @param updateType    Sets who the updater was
+     * @return SetResults value, one per value
+     */
+    static std::vector<ValueDataSet::Results> set(
+            std::vector<VariantValue::Ptr> const& valuePtrs,
+            std::vector<std::string const*> const& args,
+            VariantValue::SetUpdateType const updateType = VariantValue::Local);
+
+    /// Answers a VsMultiGet request
+    static void multiGet(
+            VariantValueStore& ws,
+            CompanEdgeProtocol::VsMultiGet const& msg,
+            CompanEdgeProtocol::VsMultiGetResult& multiGetResult);
+
+    /// Answers a VsMultiSet request
+    static void multiSet(
+            VariantValueStore& ws,
+            CompanEdgeProtocol::VsMultiSet const& msg,
+            CompanEdgeProtocol::VsMultiSetResult& multiSetResult);
+};
+
+} // namespace Edge
+} // namespace Compan
+
+#endif // __company_ref_VARIANT_VALUESTORE_BATCH_H__
@@ -0,0 +1,74 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_variant_valuestore_chunker.cpp
+ @brief Splits a snapshot of VariantValues into bounded chunks
+ */
+#include "company_ref_variant_valuestore_chunker.h"
+
+#include "company_ref_variant_valuestore.h"
+#include "company_ref_variant_valuestore_visitor.h"
+
+#include <company_ref_protocol/company_ref_protocol.pb.h>
+
+using namespace Compan::Edge;
+
+size_t const VariantValueChunker::DefaultMaxValues(1000);
+size_t const VariantValueChunker::DefaultMaxBytes(256 * 1024);
+
+VariantValueChunker::VariantValueChunker(VariantValueStore& ws, size_t const maxValues, size_t const maxBytes)
+    : ws_(ws)
+    , maxValues_(maxValues ? maxValues : DefaultMaxValues)
+    , maxBytes_(maxBytes ? maxBytes : DefaultMaxBytes)
+    , offset_(0)
+{
+}
+
+void VariantValueChunker::insertStore()
+{
+    values_.reserve(values_.size() + ws_.size());
+    ws_.visitValues([this](VariantValue::Ptr const& valuePtr) { insert(valuePtr); });
+}
+
+void VariantValueChunker::insertChildren(VariantValue::Ptr valuePtr)
+{
+    if (valuePtr == nullptr) return;
+
+    insert(valuePtr);
+    VariantValueVisitor::visitChildren(valuePtr, [this](VariantValue::Ptr const& visitPtr) { insert(visitPtr); });
+}
+
+void VariantValueChunker::insert(VariantValue::Ptr valuePtr)
+{
+    if (valuePtr == nullptr) return;
+
+    values_.push_back(std::move(valuePtr));
+}
+
+bool VariantValueChunker::fill(google::protobuf::RepeatedPtrField<CompanEdgeProtocol::Value>* repeatedValues)
+{
+    if (repeatedValues == nullptr) return !empty();
+
+    size_t count(0);
+    size_t bytes(0);
+
+    while (!empty() && count < maxValues_ && (count == 0 || bytes < maxBytes_)) {
+        VariantValue::Ptr valuePtr = std::move(values_[offset_++]);
+
+        // removed, or replaced, while waiting for it's chunk
+        if (ws_.get(valuePtr->id()) != valuePtr) continue;
+
+        CompanEdgeProtocol::Value* value = repeatedValues->Add();
+        *value = valuePtr->get();
+
+        bytes += value->ByteSizeLong();
+        ++count;
+    }
+
+    if (empty()) {
+        values_.clear();
+        values_.shrink_to_fit();
+        offset_ = 0;
+    }
+
+    return !empty();
+}
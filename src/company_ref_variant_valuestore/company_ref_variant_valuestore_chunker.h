@@ -0,0 +1,116 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_variant_valuestore_chunker.h
+ @brief Splits a snapshot of VariantValues into bounded chunks
+ */
+#ifndef __company_ref_VARIANT_VALUESTORE_CHUNKER_H__
+#define __company_ref_VARIANT_VALUESTORE_CHUNKER_H__
+
+#include "company_ref_variant_valuestore_variant.h"
+
+#include <google/protobuf/repeated_field.h>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace CompanEdgeProtocol {
+class Value;
+} // namespace CompanEdgeProtocol
+
+namespace Compan{
+namespace Edge {
+
+class VariantValueStore;
+
+/*!
+ * @brief Produces a large set of values in bounded chunks
+ *
+ * Only the VariantValue pointers are captured when the chunker is
+ * populated; the protobuf Value is built when a chunk is filled.
+ * This keeps a full store transfer from materializing every value
+ * in a single message.
+ *
+ * A chunk is closed when either the value count or the encoded
+ * byte size limit has been reached, which ever comes first.
+ * A chunk always holds at least one value.
+ */
+class VariantValueChunker {
+public:
+    using Ptr = std::shared_ptr<VariantValueChunker>;
+
+    static size_t const DefaultMaxValues; //!< Values per chunk
+    static size_t const DefaultMaxBytes;  //!< Encoded bytes per chunk
+
+    VariantValueChunker(
+            VariantValueStore& ws,
+            size_t const maxValues = DefaultMaxValues,
+            size_t const maxBytes = DefaultMaxBytes);
+    virtual ~VariantValueChunker() = default;
+
+    /// Captures every value in the store
+    void insertStore();
+
+    /// Captures a value and all of it's children
+    void insertChildren(VariantValue::Ptr valuePtr);
+
+    /// Captures a single value
+    void insert(VariantValue::Ptr valuePtr);
+
+    /*!
+     * Moves the next chunk of values into the repeated field
+     *
+     * Values that were removed from the store since they were
+     * captured are skipped
+     *
+     * @param repeatedValues    RepeatedPtrField to add values to
+     * @returns True if values remain for another chunk
+     */
+    bool fill(google::protobuf::RepeatedPtrField<CompanEdgeProtocol::Value>* repeatedValues);
+
+    /// Returns true if all values have been filled
+    bool empty() const;
+
+    /// Returns the number of values left to fill
+    size_t remaining() const;
+
+    size_t maxValues() const;
+    size_t maxBytes() const;
+
+protected:
+    VariantValueChunker(VariantValueChunker const&) = delete;
+    VariantValueChunker& operator=(VariantValueChunker const&) = delete;
+
+private:
+    VariantValueStore& ws_;
+    size_t const maxValues_;
+    size_t const maxBytes_;
+
+    std::vector<VariantValue::Ptr> values_;
+    size_t offset_;
+};
+
+inline bool VariantValueChunker::empty() const
+{
+    return offset_ >= values_.size();
+}
+
+inline size_t VariantValueChunker::remaining() const
+{
+    return values_.size() - offset_;
+}
+
+inline size_t VariantValueChunker::maxValues() const
+{
+    return maxValues_;
+}
+
+inline size_t VariantValueChunker::maxBytes() const
+{
+    return maxBytes_;
+}
+
+} // namespace Edge
+} // namespace Compan
+
+#endif // __company_ref_VARIANT_VALUESTORE_CHUNKER_H__
@@ -0,0 +1,122 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_variant_valuestore_client_frame.cpp
+ @brief ClientMessage encoded once and shared between connections
+ */
+#include "company_ref_variant_valuestore_client_frame.h"
+
+#include <company_ref_protocol/company_ref_protocol.pb.h>
+#include <company_ref_protocol_utils/company_ref_framing.h>
+#include <company_ref_protocol_utils/company_ref_stream.h>
+
+#include <Compan_logger/Compan_logger.h>
+
+#include <algorithm>
+
+namespace Compan{
+namespace Edge {
+CompanLogger ClientMessageFrameLog("variantvalue.frame", LogLevel::Information);
+} // namespace Edge
+} // namespace Compan
+
+using namespace Compan::Edge;
+
+ClientMessageFrame::ClientMessageFrame(ClientMessagePtr msgPtr)
+    : valuePtr_()
+    , version_(0)
+    , msgPtr_(std::move(msgPtr))
+    , encodeCount_(0)
+{
+}
+
+ClientMessageFrame::ClientMessageFrame(VariantValue::Ptr valuePtr)
+    : ClientMessageFrame(valuePtr, valuePtr ? valuePtr->version() : 0)
+{
+}
+
+ClientMessageFrame::ClientMessageFrame(VariantValue::Ptr valuePtr, uint64_t const version)
+    : valuePtr_(std::move(valuePtr))
+    , version_(version)
+    , encodeCount_(0)
+{
+}
+
+ClientMessageFrame::ClientMessagePtr ClientMessageFrame::message()
+{
+    // constructed from a message
+    if (!valuePtr_) return msgPtr_;
+
+    std::call_once(messageOnce_, [this]() {
+        msgPtr_ = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+
+        // the value is at least as current as the version
+        msgPtr_->mutable_valuechanged()->set_version(version_);
+        *msgPtr_->mutable_valuechanged()->add_value() = valuePtr_->get();
+    });
+
+    return msgPtr_;
+}
+
+ClientMessageFrame::BufferPtr ClientMessageFrame::encoded(bool const newFraming, ClientFrameCompressor const* compressor)
+{
+    ClientMessagePtr msgPtr = message();
+    if (!msgPtr) return nullptr;
+
+    size_t const idx = newFraming ? 1 : 0;
+
+    if (!compressor) {
+        std::call_once(encodeOnce_[idx], [this, &msgPtr, newFraming, idx]() {
+            encoded_[idx] = encode(*msgPtr, newFraming, nullptr);
+        });
+
+        return encoded_[idx];
+    }
+
+    // a retrain leaves connections on different dictionaries, each gets the encoding of it's own
+    std::lock_guard<std::mutex> lock(compressedMutex_);
+
+    std::vector<std::pair<uint64_t, BufferPtr>>& compressed(compressed_[idx]);
+    auto it = std::find_if(compressed.begin(), compressed.end(), [compressor](auto const& entry) {
+        return entry.first == compressor->id();
+    });
+    if (it != compressed.end()) return it->second;
+
+    compressed.emplace_back(compressor->id(), encode(*msgPtr, newFraming, compressor));
+    return compressed.back().second;
+}
+
+ClientMessageFrame::BufferPtr ClientMessageFrame::encode(
+        CompanEdgeProtocol::ClientMessage const& msg,
+        bool const newFraming,
+        ClientFrameCompressor const* compressor)
+{
+    ++encodeCount_;
+
+    std::shared_ptr<std::string> buffer = std::make_shared<std::string>();
+    if (!msg.SerializeToString(buffer.get())) {
+        ErrorLog(ClientMessageFrameLog) << "failed to serialize : " << msg << std::endl;
+        return nullptr;
+    }
+
+    // the result carries the dictionary, the client can't decompress it
+    if (compressor && buffer->size() >= compressor->minSize() && !msg.has_vscompressionresult()) {
+        CompanEdgeProtocol::ClientMessage wrapper;
+        CompanEdgeProtocol::CompressedMessage* compressedMessage = wrapper.mutable_compressedmessage();
+
+        if (compressor->compress(*buffer, *compressedMessage->mutable_data())
+            && compressedMessage->data().size() < buffer->size()) {
+            compressedMessage->set_codec(CompanEdgeProtocol::CompressedMessage::Deflate);
+            compressedMessage->set_size(buffer->size());
+
+            buffer->clear();
+            wrapper.SerializeToString(buffer.get());
+        }
+    }
+
+    if (newFraming)
+        buffer->insert(0, AECv10::makeHeader<std::string>(buffer->cbegin(), buffer->cend()));
+    else
+        buffer->insert(0, AECv09::makeHeader<std::string>(buffer->cbegin(), buffer->cend()));
+
+    return buffer;
+}
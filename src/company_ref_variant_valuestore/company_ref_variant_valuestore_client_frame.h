@@ -0,0 +1,125 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_variant_valuestore_client_frame.h
+ @brief ClientMessage encoded once and shared between connections
+ */
+#ifndef __company_ref_VARIANT_VALUESTORE_CLIENT_FRAME_H__
+#define __company_ref_VARIANT_VALUESTORE_CLIENT_FRAME_H__
+
+#include "company_ref_variant_valuestore_client_frame_compressor.h"
+#include "company_ref_variant_valuestore_variant.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace CompanEdgeProtocol {
+class ClientMessage;
+} // namespace CompanEdgeProtocol
+
+namespace Compan{
+namespace Edge {
+
+/*!
+ * @brief Immutable ClientMessage and it's AEC framed encoding
+ *
+ * A value change fanned out to many connections is built and serialized
+ * once; every connection enqueues the same refcounted buffer.
+ *
+ * Both the message and the framed buffers are produced on first use,
+ * one buffer per framing version and compressor since those are
+ * negotiated per connection; connections negotiated before a retrain
+ * keep the previous dictionary.
+ *
+ * A value change is stamped with the store version of the change when
+ * constructed, the value itself is read when the message is built.
+ *
+ * @note The message is shared, it must not be modified once the frame
+ *       has been handed out.
+ */
+class ClientMessageFrame {
+public:
+    using Ptr = std::shared_ptr<ClientMessageFrame>;
+    using ClientMessagePtr = std::shared_ptr<CompanEdgeProtocol::ClientMessage>;
+    using BufferPtr = std::shared_ptr<std::string const>;
+
+    /// Frames an already built message
+    explicit ClientMessageFrame(ClientMessagePtr msgPtr);
+
+    /// Frames a ValueChanged of a single value, stamped with it's current version
+    explicit ClientMessageFrame(VariantValue::Ptr valuePtr);
+
+    /// Frames a ValueChanged of a single value, stamped with an earlier version
+    ClientMessageFrame(VariantValue::Ptr valuePtr, uint64_t const version);
+
+    virtual ~ClientMessageFrame() = default;
+
+    /// Returns the changed value, nullptr if constructed from a message
+    VariantValue::Ptr const& value() const;
+
+    /// Returns the version the change is stamped with, 0 if constructed from a message
+    uint64_t version() const;
+
+    /// Returns the shared message, built on first call
+    ClientMessagePtr message();
+
+    /*!
+     * Returns the AEC framed encoding of the message
+     *
+     * @param newFraming    AECv10 when true, otherwise AECv09
+     * @param compressor    The connection's negotiated compressor, nullptr if none
+     * @returns nullptr if the message failed to serialize
+     */
+    BufferPtr encoded(bool const newFraming, ClientFrameCompressor const* compressor = nullptr);
+
+    /// Number of times the message was serialized, at most once per framing and compressor
+    size_t encodeCount() const;
+
+protected:
+    ClientMessageFrame(ClientMessageFrame const&) = delete;
+    ClientMessageFrame& operator=(ClientMessageFrame const&) = delete;
+
+    /// Serializes and frames the message, compressed when worth it
+    BufferPtr encode(
+            CompanEdgeProtocol::ClientMessage const& msg,
+            bool const newFraming,
+            ClientFrameCompressor const* compressor);
+
+private:
+    VariantValue::Ptr const valuePtr_;
+    uint64_t const version_;
+
+    std::once_flag messageOnce_;
+    ClientMessagePtr msgPtr_;
+
+    std::once_flag encodeOnce_[2];
+    BufferPtr encoded_[2]; //!< uncompressed, indexed by newFraming
+
+    std::mutex compressedMutex_;
+    std::vector<std::pair<uint64_t, BufferPtr>> compressed_[2]; //!< indexed by newFraming, per compressor id
+
+    std::atomic<size_t> encodeCount_;
+};
+
+inline VariantValue::Ptr const& ClientMessageFrame::value() const
+{
+    return valuePtr_;
+}
+
+inline uint64_t ClientMessageFrame::version() const
+{
+    return version_;
+}
+
+inline size_t ClientMessageFrame::encodeCount() const
+{
+    return encodeCount_;
+}
+
+} // namespace Edge
+} // namespace Compan
+
+#endif // __company_ref_VARIANT_VALUESTORE_CLIENT_FRAME_H__
@@ -0,0 +1,236 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_variant_valuestore_client_frame_compressor.cpp
+ @brief Compression of large ClientMessage frames
+ */
+#include "company_ref_variant_valuestore_client_frame_compressor.h"
+
+#include "company_ref_variant_valuestore.h"
+
+#include <company_ref_protocol/company_ref_protocol.pb.h>
+
+#include <Compan_logger/Compan_logger.h>
+
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <zlib.h>
+
+namespace Compan{
+namespace Edge {
+CompanLogger ClientFrameCompressorLog("variantvalue.compressor", LogLevel::Information);
+} // namespace Edge
+} // namespace Compan
+
+using namespace Compan::Edge;
+
+namespace {
+/// Raw deflate, the frame carries it's own size
+int const WindowBits(-15);
+
+/// Candidates looked at when filling the dictionary
+size_t const MaxCandidates(4096);
+
+std::atomic<uint64_t> NextId(1);
+
+/// Deflate can't expand data more than this
+size_t const MaxRatio(1032);
+} // namespace
+
+size_t const ClientFrameCompressor::DefaultMinSize(4096);
+size_t const ClientFrameCompressor::MaxDictionarySize(32768);
+size_t const ClientFrameCompressor::MaxTrainingValues(100000);
+
+ClientFrameCompressor::ClientFrameCompressor(std::string dictionary, size_t const minSize)
+    : id_(NextId++)
+    , dictionary_(dictionary.size() > MaxDictionarySize ? dictionary.substr(dictionary.size() - MaxDictionarySize)
+                                                        : std::move(dictionary))
+    , minSize_(minSize)
+{
+}
+
+ClientFrameCompressor::Ptr ClientFrameCompressor::train(VariantValueStore& ws, size_t const minSize)
+{
+    std::unordered_map<std::string, size_t> counts;
+    size_t visited(0);
+
+    ws.visitValues([&counts, &visited](VariantValue::Ptr const& valuePtr) {
+        if (++visited > MaxTrainingValues) return;
+
+        std::string const id(valuePtr->id().name());
+
+        // every parent of the id, "a." "a.b." ...
+        for (size_t pos = id.find('.'); pos != std::string::npos; pos = id.find('.', pos + 1))
+            ++counts[id.substr(0, pos + 1)];
+
+        // the enumerators repeat for every value of the same enum
+        if (valuePtr->type() == CompanEdgeProtocol::Enum) {
+            CompanValueTypes::EnumValue enumValue(valuePtr->get().enumvalue());
+            enumValue.clear_value();
+
+            std::string encoded;
+            if (enumValue.SerializeToString(&encoded) && !encoded.empty()) ++counts[encoded];
+        }
+    });
+
+    // what a string saves is roughly how often it occurs times it's length
+    std::vector<std::pair<size_t, std::string>> candidates;
+    candidates.reserve(counts.size());
+
+    for (auto& count : counts) {
+        if (count.second < 2) continue;
+        candidates.emplace_back(count.second * count.first.size(), count.first);
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](auto const& lhs, auto const& rhs) {
+        return lhs.first > rhs.first;
+    });
+
+    if (candidates.size() > MaxCandidates) candidates.resize(MaxCandidates);
+
+    std::vector<std::string const*> selected;
+    size_t size(0);
+
+    for (auto const& candidate : candidates) {
+        std::string const& text(candidate.second);
+        if (size + text.size() > MaxDictionarySize) continue;
+
+        // "a.b." adds nothing once "a.b.c." is in
+        bool const covered = std::any_of(selected.begin(), selected.end(), [&text](std::string const* other) {
+            return other->find(text) != std::string::npos;
+        });
+        if (covered) continue;
+
+        selected.push_back(&text);
+        size += text.size();
+    }
+
+    // deflate references the end of the dictionary cheapest, the best strings go last
+    std::string dictionary;
+    dictionary.reserve(size);
+    for (auto it = selected.rbegin(); it != selected.rend(); ++it) dictionary += **it;
+
+    DebugLog(ClientFrameCompressorLog) << "trained " << dictionary.size() << " byte dictionary from "
+                                       << std::min(visited, MaxTrainingValues) << " values" << std::endl;
+
+    return std::make_shared<ClientFrameCompressor>(std::move(dictionary), minSize);
+}
+
+void ClientFrameCompressor::makeRequest(CompanEdgeProtocol::ServerMessage& msg)
+{
+    msg.mutable_vscompression()->add_codecs(CompanEdgeProtocol::CompressedMessage::Deflate);
+}
+
+ClientFrameCompressor::Ptr ClientFrameCompressor::negotiate(
+        Ptr compressor,
+        CompanEdgeProtocol::VsCompression const& request,
+        CompanEdgeProtocol::ClientMessage& msg)
+{
+    CompanEdgeProtocol::VsCompressionResult* result = msg.mutable_vscompressionresult();
+    result->set_sequenceno(request.sequenceno());
+    result->set_codec(CompanEdgeProtocol::CompressedMessage::Uncompressed);
+
+    if (!compressor) return nullptr;
+
+    bool const deflate =
+            std::any_of(request.codecs().begin(), request.codecs().end(), [](int const codec) {
+                return codec == CompanEdgeProtocol::CompressedMessage::Deflate;
+            });
+    if (!deflate) return nullptr;
+
+    result->set_codec(CompanEdgeProtocol::CompressedMessage::Deflate);
+    result->set_dictionary(compressor->dictionary());
+    result->set_minsize(compressor->minSize());
+
+    return compressor;
+}
+
+ClientFrameCompressor::Ptr ClientFrameCompressor::accept(CompanEdgeProtocol::VsCompressionResult const& result)
+{
+    if (result.codec() != CompanEdgeProtocol::CompressedMessage::Deflate) return nullptr;
+
+    return std::make_shared<ClientFrameCompressor>(result.dictionary(), result.minsize());
+}
+
+bool ClientFrameCompressor::compress(std::string const& payload, std::string& compressed) const
+{
+    z_stream stream{};
+    if (deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, WindowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) return false;
+
+    int result = Z_OK;
+    if (!dictionary_.empty())
+        result = deflateSetDictionary(
+                &stream, reinterpret_cast<Bytef const*>(dictionary_.data()), static_cast<uInt>(dictionary_.size()));
+
+    if (result == Z_OK) {
+        compressed.resize(deflateBound(&stream, payload.size()));
+
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(payload.data()));
+        stream.avail_in = static_cast<uInt>(payload.size());
+        stream.next_out = reinterpret_cast<Bytef*>(&compressed[0]);
+        stream.avail_out = static_cast<uInt>(compressed.size());
+
+        result = deflate(&stream, Z_FINISH);
+        compressed.resize(stream.total_out);
+    }
+
+    deflateEnd(&stream);
+
+    if (result != Z_STREAM_END) {
+        ErrorLog(ClientFrameCompressorLog) << "deflate failed: " << result << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool ClientFrameCompressor::decompress(std::string const& compressed, size_t const size, std::string& payload) const
+{
+    // a corrupt size mustn't allocate the world
+    if (size > compressed.size() * MaxRatio) return false;
+
+    z_stream stream{};
+    if (inflateInit2(&stream, WindowBits) != Z_OK) return false;
+
+    int result = Z_OK;
+    if (!dictionary_.empty())
+        result = inflateSetDictionary(
+                &stream, reinterpret_cast<Bytef const*>(dictionary_.data()), static_cast<uInt>(dictionary_.size()));
+
+    if (result == Z_OK) {
+        payload.resize(size);
+
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+        stream.avail_in = static_cast<uInt>(compressed.size());
+        stream.next_out = reinterpret_cast<Bytef*>(&payload[0]);
+        stream.avail_out = static_cast<uInt>(payload.size());
+
+        result = inflate(&stream, Z_FINISH);
+    }
+
+    bool const complete = result == Z_STREAM_END && stream.total_out == size;
+    inflateEnd(&stream);
+
+    if (!complete) {
+        ErrorLog(ClientFrameCompressorLog) << "inflate failed: " << result << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool ClientFrameCompressor::expand(CompanEdgeProtocol::ClientMessage& msg) const
+{
+    if (!msg.has_compressedmessage()) return true;
+
+    CompanEdgeProtocol::CompressedMessage const& compressedMessage(msg.compressedmessage());
+    if (compressedMessage.codec() != CompanEdgeProtocol::CompressedMessage::Deflate) return false;
+
+    std::string payload;
+    if (!decompress(compressedMessage.data(), compressedMessage.size(), payload)) return false;
+
+    return msg.ParseFromString(payload);
+}
@@ -0,0 +1,125 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_variant_valuestore_client_frame_compressor.h
+ @brief Compression of large ClientMessage frames
+ */
+#ifndef __company_ref_VARIANT_VALUESTORE_CLIENT_FRAME_COMPRESSOR_H__
+#define __company_ref_VARIANT_VALUESTORE_CLIENT_FRAME_COMPRESSOR_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace CompanEdgeProtocol {
+class ClientMessage;
+class ServerMessage;
+class VsCompression;
+class VsCompressionResult;
+} // namespace CompanEdgeProtocol
+
+namespace Compan{
+namespace Edge {
+
+class VariantValueStore;
+
+/*!
+ * @brief Deflate with a preset dictionary, negotiated per connection
+ *
+ * Full store responses repeat the same id prefixes and enum metadata over
+ * and over; the dictionary is trained from the store so even the first
+ * values of a frame compress. It is sent to the client once, in the
+ * VsCompressionResult.
+ *
+ * Negotiation:
+ * - The client sends a VsCompression listing it's codecs.
+ * - The server answers with a VsCompressionResult. Once that has been
+ *   written, frames of at least minSize bytes are sent as a
+ *   CompressedMessage.
+ * - A server that doesn't know VsCompression ignores it and the client
+ *   keeps receiving uncompressed frames.
+ */
+class ClientFrameCompressor {
+public:
+    using Ptr = std::shared_ptr<ClientFrameCompressor>;
+
+    static size_t const DefaultMinSize;     //!< Smaller frames aren't worth compressing
+    static size_t const MaxDictionarySize;  //!< The deflate window
+    static size_t const MaxTrainingValues;  //!< Values sampled when training
+
+    explicit ClientFrameCompressor(std::string dictionary, size_t const minSize = DefaultMinSize);
+    virtual ~ClientFrameCompressor() = default;
+
+    /// Trains a dictionary from the most repeated id prefixes and enum metadata of the store
+    static Ptr train(VariantValueStore& ws, size_t const minSize = DefaultMinSize);
+
+    /// Fills in a client's VsCompression request
+    static void makeRequest(CompanEdgeProtocol::ServerMessage& msg);
+
+    /*!
+     * Answers a client's VsCompression
+     *
+     * @param compressor    The server's compressor, nullptr if it has none
+     * @param request       The client's request
+     * @param msg           Filled in with the VsCompressionResult
+     * @returns The compressor to use once the result is written, nullptr if
+     *          the client's codecs aren't supported
+     */
+    static Ptr negotiate(
+            Ptr compressor,
+            CompanEdgeProtocol::VsCompression const& request,
+            CompanEdgeProtocol::ClientMessage& msg);
+
+    /// Decompressor of the negotiated codec, nullptr if the server declined
+    static Ptr accept(CompanEdgeProtocol::VsCompressionResult const& result);
+
+    /// Unique to this compressor, a retrained dictionary gets a new one
+    uint64_t id() const;
+
+    std::string const& dictionary() const;
+    size_t minSize() const;
+
+    /// Compresses a serialized ClientMessage, false on failure
+    bool compress(std::string const& payload, std::string& compressed) const;
+
+    /// Decompresses a CompressedMessage's data, false if it is corrupt
+    bool decompress(std::string const& compressed, size_t const size, std::string& payload) const;
+
+    /*!
+     * Replaces a CompressedMessage with the ClientMessage it carries
+     *
+     * A message that isn't compressed is left as is
+     *
+     * @returns false if the message can't be decompressed
+     */
+    bool expand(CompanEdgeProtocol::ClientMessage& msg) const;
+
+protected:
+    ClientFrameCompressor(ClientFrameCompressor const&) = delete;
+    ClientFrameCompressor& operator=(ClientFrameCompressor const&) = delete;
+
+private:
+    uint64_t const id_;
+    std::string const dictionary_;
+    size_t const minSize_;
+};
+
+inline uint64_t ClientFrameCompressor::id() const
+{
+    return id_;
+}
+
+inline std::string const& ClientFrameCompressor::dictionary() const
+{
+    return dictionary_;
+}
+
+inline size_t ClientFrameCompressor::minSize() const
+{
+    return minSize_;
+}
+
+} // namespace Edge
+} // namespace Compan
+
+#endif // __company_ref_VARIANT_VALUESTORE_CLIENT_FRAME_COMPRESSOR_H__
@@ -0,0 +1,91 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_variant_valuestore_client_frame_queue.cpp
+ @brief Bounded outbound queue of a connection
+ */
+#include "company_ref_variant_valuestore_client_frame_queue.h"
+
+#include <algorithm>
+
+using namespace Compan::Edge;
+
+ClientFrameQueue::Limits const ClientFrameQueue::DefaultLimits = {1024, 16384};
+
+ClientFrameQueue::ClientFrameQueue(Limits const& limits)
+    : limits_(limits)
+    , headSeq_(0)
+    , stats_({0, 0, 0, 0, 0, 0})
+{
+}
+
+ClientFrameQueue::PushResult ClientFrameQueue::push(ClientMessageFrame::Ptr framePtr)
+{
+    VariantValue::Ptr const valuePtr = framePtr ? framePtr->value() : nullptr;
+
+    if (valuePtr == nullptr) {
+        // changes queued before this can't be conflated with the ones after it
+        pendingChanges_.clear();
+    } else if (entries_.size() >= limits_.conflateAt) {
+        auto pendingIter = pendingChanges_.find(valuePtr->hashToken());
+        if (pendingIter != pendingChanges_.end()) {
+            ClientMessageFrame::Ptr& pendingPtr(entries_[pendingIter->second - headSeq_].framePtr);
+
+            // keeps the replaced change's version, the frame may be shared so this connection gets it's own
+            if (pendingPtr->version() == framePtr->version())
+                pendingPtr = std::move(framePtr);
+            else
+                pendingPtr = std::make_shared<ClientMessageFrame>(valuePtr, pendingPtr->version());
+
+            ++stats_.conflated;
+            return Conflated;
+        }
+    }
+
+    if (!hasRoom()) {
+        ++stats_.overflows;
+        return Overflow;
+    }
+
+    if (valuePtr) pendingChanges_[valuePtr->hashToken()] = headSeq_ + entries_.size();
+
+    entries_.push_back({std::move(framePtr), valuePtr ? valuePtr->hashToken() : 0, valuePtr != nullptr});
+
+    ++stats_.queued;
+    stats_.highWater = std::max(stats_.highWater, entries_.size());
+
+    return Queued;
+}
+
+ClientMessageFrame::Ptr ClientFrameQueue::pop()
+{
+    if (entries_.empty()) return nullptr;
+
+    Entry entry(std::move(entries_.front()));
+    entries_.pop_front();
+
+    if (entry.conflatable) {
+        auto pendingIter = pendingChanges_.find(entry.hashToken);
+        if (pendingIter != pendingChanges_.end() && pendingIter->second == headSeq_) pendingChanges_.erase(pendingIter);
+    }
+
+    ++headSeq_;
+    ++stats_.written;
+
+    return entry.framePtr;
+}
+
+void ClientFrameQueue::clear()
+{
+    headSeq_ += entries_.size();
+
+    entries_.clear();
+    pendingChanges_.clear();
+}
+
+ClientFrameQueue::Stats ClientFrameQueue::stats() const
+{
+    Stats stats(stats_);
+    stats.pending = entries_.size();
+
+    return stats;
+}
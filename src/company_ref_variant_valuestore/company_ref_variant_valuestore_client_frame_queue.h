@@ -0,0 +1,130 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_variant_valuestore_client_frame_queue.h
+ @brief Bounded outbound queue of a connection
+ */
+#ifndef __company_ref_VARIANT_VALUESTORE_CLIENT_FRAME_QUEUE_H__
+#define __company_ref_VARIANT_VALUESTORE_CLIENT_FRAME_QUEUE_H__
+
+#include "company_ref_variant_valuestore_client_frame.h"
+
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+
+namespace Compan{
+namespace Edge {
+
+/*!
+ * @brief Bounded queue of frames waiting to be written to a client
+ *
+ * Protects the server from a slow, or stalled, consumer:
+ *
+ * - Once conflateAt frames are pending, a value change replaces the
+ *   pending change of the same hash token, latest value wins. It keeps
+ *   the replaced change's version, the changes queued behind it are
+ *   newer and a client resuming from it mustn't skip them.
+ * - Anything else (results, removals, streamed chunks) is never dropped
+ *   or conflated, it also acts as an ordering barrier; changes are
+ *   not conflated across it.
+ * - Once disconnectAt frames are pending a frame that can't be conflated
+ *   is refused, the caller is expected to disconnect the client.
+ *
+ * @note Not thread safe, the owning connection guards it.
+ */
+class ClientFrameQueue {
+public:
+    /// Outbound limits, in pending frames
+    struct Limits {
+        size_t conflateAt;   //!< value changes are conflated from here on
+        size_t disconnectAt; //!< the consumer is given up on from here on
+    };
+
+    /// Per connection counters
+    struct Stats {
+        uint64_t queued;    //!< frames accepted
+        uint64_t written;   //!< frames popped for writing
+        uint64_t conflated; //!< value changes that replaced a pending one
+        uint64_t overflows; //!< frames refused
+        size_t pending;     //!< frames waiting
+        size_t highWater;   //!< most frames waiting at once
+    };
+
+    enum PushResult {
+        Queued,    //!< appended to the queue
+        Conflated, //!< replaced a pending change of the same value
+        Overflow   //!< refused, disconnectAt reached
+    };
+
+    static Limits const DefaultLimits;
+
+    explicit ClientFrameQueue(Limits const& limits = DefaultLimits);
+    virtual ~ClientFrameQueue() = default;
+
+    /// Queues or conflates a frame
+    PushResult push(ClientMessageFrame::Ptr framePtr);
+
+    /// Returns the oldest pending frame, nullptr if empty
+    ClientMessageFrame::Ptr pop();
+
+    /// Drops all pending frames, counters are kept
+    void clear();
+
+    bool empty() const;
+    size_t size() const;
+
+    Limits const& limits() const;
+    void limits(Limits const& limits);
+
+    Stats stats() const;
+
+private:
+    struct Entry {
+        ClientMessageFrame::Ptr framePtr;
+        uint64_t hashToken;
+        bool conflatable;
+    };
+
+    /// Room for one more frame
+    bool hasRoom() const;
+
+private:
+    Limits limits_;
+
+    std::deque<Entry> entries_;
+    uint64_t headSeq_; //!< sequence number of entries_.front()
+
+    std::unordered_map<uint64_t, uint64_t> pendingChanges_; //!< hash token to sequence number of it's latest change
+
+    Stats stats_;
+};
+
+inline bool ClientFrameQueue::empty() const
+{
+    return entries_.empty();
+}
+
+inline size_t ClientFrameQueue::size() const
+{
+    return entries_.size();
+}
+
+inline ClientFrameQueue::Limits const& ClientFrameQueue::limits() const
+{
+    return limits_;
+}
+
+inline void ClientFrameQueue::limits(Limits const& limits)
+{
+    limits_ = limits;
+}
+
+inline bool ClientFrameQueue::hasRoom() const
+{
+    return entries_.size() < limits_.disconnectAt;
+}
+
+} // namespace Edge
+} // namespace Compan
+
+#endif // __company_ref_VARIANT_VALUESTORE_CLIENT_FRAME_QUEUE_H__
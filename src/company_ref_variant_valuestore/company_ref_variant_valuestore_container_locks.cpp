@@ -0,0 +1,74 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_variant_valuestore_container_locks.cpp
+ @brief Per container locks for structural changes
+ */
+#include "company_ref_variant_valuestore_container_locks.h"
+
+#include <algorithm>
+#include <functional>
+
+using namespace Compan::Edge;
+
+VariantContainerLocks::Guard::Guard(VariantContainerLocks& locks, Stripes&& stripes)
+    : locks_(&locks)
+    , stripes_(std::move(stripes))
+{
+    for (auto const& stripe : stripes_) {
+        if (stripe.second)
+            locks_->stripes_[stripe.first].lock();
+        else
+            locks_->stripes_[stripe.first].lock_shared();
+    }
+}
+
+VariantContainerLocks::Guard::Guard(Guard&& src)
+    : locks_(src.locks_)
+    , stripes_(std::move(src.stripes_))
+{
+    src.locks_ = nullptr;
+    src.stripes_.clear();
+}
+
+VariantContainerLocks::Guard::~Guard()
+{
+    if (locks_ == nullptr) return;
+
+    for (auto stripe = stripes_.rbegin(); stripe != stripes_.rend(); ++stripe) {
+        if (stripe->second)
+            locks_->stripes_[stripe->first].unlock();
+        else
+            locks_->stripes_[stripe->first].unlock_shared();
+    }
+}
+
+VariantContainerLocks::VariantContainerLocks(size_t const stripes)
+    : stripes_(std::max<size_t>(1, stripes))
+{
+}
+
+VariantContainerLocks::Guard VariantContainerLocks::lock(ValueId const& containerId)
+{
+    Guard::Stripes stripes({{stripe(containerId), true}});
+
+    for (ValueId parentId(containerId.parent()); !parentId.empty(); parentId = parentId.parent())
+        stripes.emplace_back(stripe(parentId), false);
+
+    // ascending order, exclusive first when a stripe is shared with a parent
+    std::sort(stripes.begin(), stripes.end(), [](auto const& lhs, auto const& rhs) {
+        return lhs.first < rhs.first || (lhs.first == rhs.first && lhs.second > rhs.second);
+    });
+    stripes.erase(
+            std::unique(
+                    stripes.begin(),
+                    stripes.end(),
+                    [](auto const& lhs, auto const& rhs) { return lhs.first == rhs.first; }),
+            stripes.end());
+
+    return Guard(*this, std::move(stripes));
+}
+
+size_t VariantContainerLocks::stripe(ValueId const& valueId) const
+{
+    return std::hash<std::string>()(valueId.name()) % stripes_.size();
+}
@@ -0,0 +1,85 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_variant_valuestore_container_locks.h
+ @brief Per container locks for structural changes
+ */
+#ifndef __company_ref_VARIANT_VALUESTORE_CONTAINER_LOCKS_H__
+#define __company_ref_VARIANT_VALUESTORE_CONTAINER_LOCKS_H__
+
+#include "company_ref_variant_valuestore_valueid.h"
+
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+namespace Compan{
+namespace Edge {
+
+/*!
+ * @brief Serializes add/remove of a container's elements
+ *
+ * Replaces a single mutex shared by every connection; changes to
+ * unrelated containers proceed in parallel.
+ *
+ * A structural change locks it's container exclusively and each of the
+ * container's parents shared. A removal from a parent container is
+ * serialized with any change nested below it, while siblings under the
+ * same parent don't block each other.
+ *
+ * The locks are striped by a hash of the ValueId, two containers may
+ * share a stripe; stripes are always taken in ascending order so that
+ * can't deadlock.
+ */
+class VariantContainerLocks {
+public:
+    static size_t const DefaultStripes = 256;
+
+    /// Holds the stripes of a structural change, released on destruction
+    class Guard {
+    public:
+        Guard(Guard&& src);
+        ~Guard();
+
+    protected:
+        friend class VariantContainerLocks;
+
+        /// stripe index, exclusive
+        using Stripes = std::vector<std::pair<size_t, bool>>;
+
+        Guard(VariantContainerLocks& locks, Stripes&& stripes);
+
+        Guard(Guard const&) = delete;
+        Guard& operator=(Guard const&) = delete;
+
+    private:
+        VariantContainerLocks* locks_;
+        Stripes stripes_;
+    };
+
+    explicit VariantContainerLocks(size_t const stripes = DefaultStripes);
+    virtual ~VariantContainerLocks() = default;
+
+    /// Locks containerId for adding/removing elements
+    Guard lock(ValueId const& containerId);
+
+    size_t stripes() const;
+
+protected:
+    VariantContainerLocks(VariantContainerLocks const&) = delete;
+    VariantContainerLocks& operator=(VariantContainerLocks const&) = delete;
+
+    size_t stripe(ValueId const& valueId) const;
+
+private:
+    std::vector<std::shared_timed_mutex> stripes_;
+};
+
+inline size_t VariantContainerLocks::stripes() const
+{
+    return stripes_.size();
+}
+
+} // namespace Edge
+} // namespace Compan
+
+#endif // __company_ref_VARIANT_VALUESTORE_CONTAINER_LOCKS_H__
@@ -40,3 +40,8 @@ void VariantValueDispatcher::hasDataCompanEdgeProtocolValue(ProtocolValueHasData
 {
     boost::asio::post(ctx_, std::bind(&ProtocolValueHasData::operator(), taskPtr));
 }
+
+void VariantValueDispatcher::batchCompanEdgeProtocolValues(ProtocolValueBatchPtr taskPtr)
+{
+    boost::asio::post(ctx_, std::bind(&ProtocolValueBatch::operator(), taskPtr));
+}
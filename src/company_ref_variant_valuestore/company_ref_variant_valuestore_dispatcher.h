@@ -29,6 +29,8 @@ public:
     using ProtocolValueSetPtr = std::shared_ptr<ProtocolValueSet>;
     using ProtocolValueHasData = std::packaged_task<bool()>;
     using ProtocolValueHasDataPtr = std::shared_ptr<ProtocolValueHasData>;
+    using ProtocolValueBatch = std::packaged_task<void()>;
+    using ProtocolValueBatchPtr = std::shared_ptr<ProtocolValueBatch>;
 
 public:
     VariantValueDispatcher();
@@ -51,6 +53,9 @@ public:
     /// Performs a has data operation on a CompanEdgeProtocolValueData compliant object
     void hasDataCompanEdgeProtocolValue(ProtocolValueHasDataPtr);
 
+    /// Performs a run of operations on CompanEdgeProtocolValueData compliant objects, in one round trip
+    void batchCompanEdgeProtocolValues(ProtocolValueBatchPtr);
+
 private:
     // single context, single thread - keeps the requests in order
     boost::asio::io_context ctx_;
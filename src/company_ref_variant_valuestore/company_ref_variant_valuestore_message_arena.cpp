@@ -0,0 +1,74 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_variant_valuestore_message_arena.cpp
+ @brief Pool of protobuf Arenas for short lived messages
+ */
+#include "company_ref_variant_valuestore_message_arena.h"
+
+using namespace Compan::Edge;
+
+size_t const MessageArenaPool::DefaultMaxIdle(4);
+size_t const MessageArenaPool::DefaultBlockSize(512);
+
+MessageArenaPool::Ptr MessageArenaPool::create(size_t const maxIdle, size_t const blockSize)
+{
+    return Ptr(new MessageArenaPool(maxIdle, blockSize));
+}
+
+MessageArenaPool::MessageArenaPool(size_t const maxIdle, size_t const blockSize)
+    : maxIdle_(maxIdle)
+    , blockSize_(blockSize)
+    , stats_({0, 0, 0})
+{
+    idle_.reserve(maxIdle_);
+}
+
+MessageArenaPool::Stats MessageArenaPool::stats()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Stats stats(stats_);
+    stats.idle = idle_.size();
+    return stats;
+}
+
+std::unique_ptr<MessageArenaPool::Slot> MessageArenaPool::acquire()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (!idle_.empty()) {
+            std::unique_ptr<Slot> slot(std::move(idle_.back()));
+            idle_.pop_back();
+
+            ++stats_.reused;
+            return slot;
+        }
+
+        ++stats_.created;
+    }
+
+    std::unique_ptr<Slot> slot(new Slot);
+    slot->block.reset(new char[blockSize_]);
+
+    google::protobuf::ArenaOptions options;
+    options.initial_block = slot->block.get();
+    options.initial_block_size = blockSize_;
+    // larger messages grow the arena from the block size, those blocks are freed on reset
+    options.start_block_size = blockSize_;
+
+    slot->arena.reset(new google::protobuf::Arena(options));
+    return slot;
+}
+
+void MessageArenaPool::release(std::weak_ptr<MessageArenaPool> const& weakPool, std::unique_ptr<Slot> slot)
+{
+    // runs the message destructors, frees all but the first block
+    slot->arena->Reset();
+
+    MessageArenaPool::Ptr pool = weakPool.lock();
+    if (!pool) return;
+
+    std::lock_guard<std::mutex> lock(pool->mutex_);
+    if (pool->idle_.size() < pool->maxIdle_) pool->idle_.push_back(std::move(slot));
+}
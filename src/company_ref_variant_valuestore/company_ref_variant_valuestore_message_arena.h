@@ -0,0 +1,106 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_variant_valuestore_message_arena.h
+ @brief Pool of protobuf Arenas for short lived messages
+ */
+#ifndef __company_ref_VARIANT_VALUESTORE_MESSAGE_ARENA_H__
+#define __company_ref_VARIANT_VALUESTORE_MESSAGE_ARENA_H__
+
+#include <google/protobuf/arena.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Compan{
+namespace Edge {
+
+/*!
+ * @brief Hands out messages allocated on a recycled protobuf Arena
+ *
+ * A decoded request or a response is a tree of small allocations, each
+ * freed as soon as the message has been handled or written. Made from
+ * the pool, the whole tree lives in one Arena; releasing the last
+ * reference resets the Arena and returns it, with it's first block, to
+ * the pool for the next message.
+ *
+ * One Arena per message, so a message held for longer, a queued
+ * response, doesn't pin the memory of the others. The first block is
+ * kept small, sized for the common single value request; a larger
+ * message grows it's Arena and gives the extra blocks back on release.
+ *
+ * @note The pool is thread safe; messages may outlive it.
+ */
+class MessageArenaPool : public std::enable_shared_from_this<MessageArenaPool> {
+public:
+    using Ptr = std::shared_ptr<MessageArenaPool>;
+
+    /// Pool counters
+    struct Stats {
+        uint64_t created; //!< Arenas allocated
+        uint64_t reused;  //!< messages made on a recycled Arena
+        size_t idle;      //!< Arenas waiting in the pool
+    };
+
+    static size_t const DefaultMaxIdle;   //!< Arenas kept for reuse
+    static size_t const DefaultBlockSize; //!< First block of an Arena, kept across resets
+
+    /// Creates a pool, it must be held by a shared_ptr
+    static Ptr create(size_t const maxIdle = DefaultMaxIdle, size_t const blockSize = DefaultBlockSize);
+
+    virtual ~MessageArenaPool() = default;
+
+    /// Returns an empty message on an Arena of the pool
+    template <typename Message>
+    std::shared_ptr<Message> make();
+
+    Stats stats();
+
+protected:
+    MessageArenaPool(size_t const maxIdle, size_t const blockSize);
+
+    MessageArenaPool(MessageArenaPool const&) = delete;
+    MessageArenaPool& operator=(MessageArenaPool const&) = delete;
+
+private:
+    /// An Arena and the block it starts with
+    struct Slot {
+        std::unique_ptr<char[]> block;
+        std::unique_ptr<google::protobuf::Arena> arena;
+    };
+
+    std::unique_ptr<Slot> acquire();
+
+    /// Resets the Arena and returns it to the pool, if the pool is still around
+    static void release(std::weak_ptr<MessageArenaPool> const& weakPool, std::unique_ptr<Slot> slot);
+
+private:
+    size_t const maxIdle_;
+    size_t const blockSize_;
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Slot>> idle_;
+    Stats stats_;
+};
+
+template <typename Message>
+std::shared_ptr<Message> MessageArenaPool::make()
+{
+    std::unique_ptr<Slot> slot(acquire());
+    Message* msg = google::protobuf::Arena::CreateMessage<Message>(slot->arena.get());
+
+    // the Arena owns the message, the deleter only hands the Arena back
+    std::weak_ptr<MessageArenaPool> weakPool(shared_from_this());
+    Slot* rawSlot = slot.release();
+
+    return std::shared_ptr<Message>(msg, [weakPool, rawSlot](Message*) {
+        release(weakPool, std::unique_ptr<Slot>(rawSlot));
+    });
+}
+
+} // namespace Edge
+} // namespace Compan
+
+#endif // __company_ref_VARIANT_VALUESTORE_MESSAGE_ARENA_H__
@@ -0,0 +1,67 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_variant_valuestore_resume.cpp
+ @brief Resumes a client's subscription from the version it's current to
+ */
+#include "company_ref_variant_valuestore_resume.h"
+
+#include "company_ref_variant_valuestore.h"
+#include "company_ref_variant_valuestore_visitor.h"
+
+#include <company_ref_protocol/company_ref_protocol.pb.h>
+
+#include <unordered_set>
+
+using namespace Compan::Edge;
+
+bool VariantValueResume::resume(
+        VariantValueStore& ws,
+        CompanEdgeProtocol::VsSubscribe const& request,
+        CompanEdgeProtocol::VsResult& success,
+        CompanEdgeProtocol::VsResult& notFound,
+        SubscribeCb const& subscribe)
+{
+    // the version is taken first, the values are at least as current
+    success.set_epoch(ws.epoch());
+    success.set_version(ws.version());
+
+    if (!ws.canResume(request.epoch(), request.version())) {
+        success.set_status(CompanEdgeProtocol::VsResult::resync_required);
+        return false;
+    }
+
+    success.set_delta(true);
+
+    notFound = success;
+    notFound.set_status(CompanEdgeProtocol::VsResult::error_not_found);
+
+    uint64_t const since(request.version());
+
+    // clients list parents before their children, a subtree is walked once
+    std::unordered_set<VariantValue const*> visited;
+
+    auto copyChanged = [&visited, since, &success](VariantValue::Ptr const& valuePtr) {
+        if (!visited.insert(valuePtr.get()).second) return false;
+
+        if (valuePtr->version() > since) *success.add_values() = valuePtr->get();
+        return true;
+    };
+
+    for (auto& valueId : request.ids()) {
+
+        VariantValue::Ptr valuePtr = ws.get(valueId);
+        if (valuePtr == nullptr) {
+            notFound.add_values()->set_id(valueId);
+            continue;
+        }
+
+        if (subscribe) subscribe(valuePtr);
+
+        if (!copyChanged(valuePtr)) continue;
+
+        VariantValueVisitor::visitChildren(
+                valuePtr, [&copyChanged](VariantValue::Ptr const& visitPtr) { copyChanged(visitPtr); });
+    }
+
+    return true;
+}
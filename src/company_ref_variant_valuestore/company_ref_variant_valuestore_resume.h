@@ -0,0 +1,60 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_variant_valuestore_resume.h
+ @brief Resumes a client's subscription from the version it's current to
+ */
+#ifndef __company_ref_VARIANT_VALUESTORE_RESUME_H__
+#define __company_ref_VARIANT_VALUESTORE_RESUME_H__
+
+#include "company_ref_variant_valuestore_variant.h"
+
+#include <functional>
+
+namespace CompanEdgeProtocol {
+class VsResult;
+class VsSubscribe;
+} // namespace CompanEdgeProtocol
+
+namespace Compan{
+namespace Edge {
+
+class VariantValueStore;
+
+/*!
+ * @brief Builds the results of a VsSubscribe resuming a subscription
+ *
+ * A reconnecting client sends the epoch and version of the store it's
+ * values are current to; only the values of the subscribed subtrees
+ * changed since are answered. Shared by the servers' message handlers,
+ * which send the results and subscribe the values found.
+ */
+class VariantValueResume {
+public:
+    using SubscribeCb = std::function<void(VariantValue::Ptr const&)>;
+
+    /*!
+     * Fills the results of a resuming VsSubscribe
+     *
+     * Both results are stamped with the store's epoch and version, taken
+     * first so the values are at least as current. If the store can't
+     * resume the epoch, success is flagged resync_required.
+     *
+     * @param ws        store the client resumes from
+     * @param request   VsSubscribe, with the epoch and version the client is current to
+     * @param success   sequenceNo set; the changed values, flagged delta
+     * @param notFound  the ids no longer found, flagged error_not_found
+     * @param subscribe called with the value of every id found
+     * @return false if the client must resync
+     */
+    static bool resume(
+            VariantValueStore& ws,
+            CompanEdgeProtocol::VsSubscribe const& request,
+            CompanEdgeProtocol::VsResult& success,
+            CompanEdgeProtocol::VsResult& notFound,
+            SubscribeCb const& subscribe);
+};
+
+} // namespace Edge
+} // namespace Compan
+
+#endif // __company_ref_VARIANT_VALUESTORE_RESUME_H__
@@ -0,0 +1,253 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_variant_valuestore_subscription_index.cpp
+ @brief Store level registry of subtree subscriptions
+ */
+#include "company_ref_variant_valuestore_subscription_index.h"
+
+#include "company_ref_variant_valuestore.h"
+
+#include <vector>
+
+using namespace Compan::Edge;
+
+VariantValueSubscriptionIndex::VariantValueSubscriptionIndex(VariantValueStore& ws)
+    : nodeCount_(0)
+    , nextSubscriberId_(InvalidSubscriber)
+    , changedListener_(ws.connectValueChangedListener(
+              std::bind(&VariantValueSubscriptionIndex::onValueChanged, this, std::placeholders::_1)))
+{
+}
+
+VariantValueSubscriptionIndex::~VariantValueSubscriptionIndex()
+{
+    changedListener_.disconnect();
+}
+
+VariantValueSubscriptionIndex::SubscriberId VariantValueSubscriptionIndex::connect(NotifyFunction const& onChanged)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // never hand out the invalid id, even on wrap around
+    if (++nextSubscriberId_ == InvalidSubscriber) ++nextSubscriberId_;
+
+    Subscriber& subscriber = subscribers_[nextSubscriberId_];
+    subscriber.onChanged = std::make_shared<NotifyFunction>(onChanged);
+
+    return nextSubscriberId_;
+}
+
+void VariantValueSubscriptionIndex::disconnect(SubscriberId const subscriberId)
+{
+    unsubscribeAll(subscriberId);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    storeSubscribers_.erase(subscriberId);
+    subscribers_.erase(subscriberId);
+}
+
+void VariantValueSubscriptionIndex::subscribe(SubscriberId const subscriberId, VariantValue::Ptr const valuePtr)
+{
+    if (valuePtr == nullptr || valuePtr->id().empty()) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto subscriberIter = subscribers_.find(subscriberId);
+    if (subscriberIter == subscribers_.end()) return;
+
+    if (!subscriberIter->second.roots.emplace(valuePtr->id().name(), valuePtr->hashToken()).second) return;
+
+    Node* node = &root_;
+    for (auto iter = valuePtr->id().begin(); iter != valuePtr->id().end(); ++iter) {
+        std::unique_ptr<Node>& child = node->children[(*iter).name()];
+        if (!child) {
+            child = std::make_unique<Node>();
+            ++nodeCount_;
+        }
+        node = child.get();
+    }
+
+    node->subscribers.insert(subscriberId);
+    tokenIndex_[valuePtr->hashToken()].insert(subscriberId);
+}
+
+void VariantValueSubscriptionIndex::unsubscribe(SubscriberId const subscriberId, VariantValue::Ptr const valuePtr)
+{
+    if (valuePtr == nullptr) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto subscriberIter = subscribers_.find(subscriberId);
+    if (subscriberIter == subscribers_.end()) return;
+
+    auto rootIter = subscriberIter->second.roots.find(valuePtr->id().name());
+    if (rootIter == subscriberIter->second.roots.end()) return;
+
+    uint64_t const hashToken = rootIter->second;
+    subscriberIter->second.roots.erase(rootIter);
+
+    eraseRoot(subscriberId, valuePtr->id().name(), hashToken);
+}
+
+void VariantValueSubscriptionIndex::unsubscribeAll(SubscriberId const subscriberId)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto subscriberIter = subscribers_.find(subscriberId);
+    if (subscriberIter == subscribers_.end()) return;
+
+    std::map<std::string, uint64_t> roots;
+    roots.swap(subscriberIter->second.roots);
+
+    for (auto& root : roots) eraseRoot(subscriberId, root.first, root.second);
+}
+
+void VariantValueSubscriptionIndex::subscribeStore(SubscriberId const subscriberId)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (subscribers_.count(subscriberId)) storeSubscribers_.insert(subscriberId);
+}
+
+void VariantValueSubscriptionIndex::unsubscribeStore(SubscriberId const subscriberId)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    storeSubscribers_.erase(subscriberId);
+}
+
+bool VariantValueSubscriptionIndex::hasSubscriptions(SubscriberId const subscriberId) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto subscriberIter = subscribers_.find(subscriberId);
+    return subscriberIter != subscribers_.end() && !subscriberIter->second.roots.empty();
+}
+
+bool VariantValueSubscriptionIndex::isSubscribed(SubscriberId const subscriberId, VariantValue::Ptr const valuePtr) const
+{
+    if (valuePtr == nullptr) return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // exact match on a subscribed root
+    auto tokenIter = tokenIndex_.find(valuePtr->hashToken());
+    if (tokenIter != tokenIndex_.end() && tokenIter->second.count(subscriberId)) return true;
+
+    Node const* node = &root_;
+    for (auto iter = valuePtr->id().begin(); iter != valuePtr->id().end(); ++iter) {
+        auto childIter = node->children.find((*iter).name());
+        if (childIter == node->children.end()) return false;
+
+        node = childIter->second.get();
+        if (node->subscribers.count(subscriberId)) return true;
+    }
+
+    return false;
+}
+
+VariantValueSubscriptionIndex::SubscriberSet VariantValueSubscriptionIndex::subscribers(ValueId const& valueId) const
+{
+    SubscriberSet subscriberSet;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    resolve(valueId, subscriberSet);
+
+    return subscriberSet;
+}
+
+size_t VariantValueSubscriptionIndex::subscriberCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return subscribers_.size();
+}
+
+size_t VariantValueSubscriptionIndex::nodeCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return nodeCount_;
+}
+
+void VariantValueSubscriptionIndex::onValueChanged(VariantValue::Ptr const valuePtr)
+{
+    if (valuePtr == nullptr) return;
+
+    std::vector<std::shared_ptr<NotifyFunction>> notifiers;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (tokenIndex_.empty() && storeSubscribers_.empty()) return;
+
+        SubscriberSet subscriberSet;
+        resolve(valuePtr->id(), subscriberSet);
+
+        notifiers.reserve(subscriberSet.size());
+        for (auto& subscriberId : subscriberSet) {
+            auto subscriberIter = subscribers_.find(subscriberId);
+            if (subscriberIter != subscribers_.end()) notifiers.push_back(subscriberIter->second.onChanged);
+        }
+    }
+
+    if (notifiers.empty()) return;
+
+    // one frame for every subscriber, the message and it's encoding are built on first use
+    ClientMessageFrame::Ptr framePtr = std::make_shared<ClientMessageFrame>(valuePtr);
+
+    // call outside of the lock, subscribers are free to (un)subscribe
+    for (auto& notifier : notifiers)
+        if (notifier && *notifier) (*notifier)(framePtr);
+}
+
+void VariantValueSubscriptionIndex::resolve(ValueId const& valueId, SubscriberSet& subscriberSet) const
+{
+    subscriberSet.insert(storeSubscribers_.begin(), storeSubscribers_.end());
+
+    Node const* node = &root_;
+    for (auto iter = valueId.begin(); iter != valueId.end(); ++iter) {
+        auto childIter = node->children.find((*iter).name());
+        if (childIter == node->children.end()) return;
+
+        node = childIter->second.get();
+        subscriberSet.insert(node->subscribers.begin(), node->subscribers.end());
+    }
+}
+
+void VariantValueSubscriptionIndex::eraseRoot(
+        SubscriberId const subscriberId,
+        std::string const& valueId,
+        uint64_t const hashToken)
+{
+    auto tokenIter = tokenIndex_.find(hashToken);
+    if (tokenIter != tokenIndex_.end()) {
+        tokenIter->second.erase(subscriberId);
+        if (tokenIter->second.empty()) tokenIndex_.erase(tokenIter);
+    }
+
+    ValueId const id(valueId);
+
+    Node* node = &root_;
+    for (auto iter = id.begin(); iter != id.end(); ++iter) {
+        auto childIter = node->children.find((*iter).name());
+        if (childIter == node->children.end()) return;
+
+        node = childIter->second.get();
+    }
+
+    node->subscribers.erase(subscriberId);
+
+    prune(root_, id.begin(), id.end());
+}
+
+bool VariantValueSubscriptionIndex::prune(Node& node, ValueIdIterator iter, ValueIdIterator const& end)
+{
+    if (iter != end) {
+        auto childIter = node.children.find((*iter).name());
+
+        if (childIter != node.children.end() && prune(*childIter->second, iter + 1, end)) {
+            node.children.erase(childIter);
+            --nodeCount_;
+        }
+    }
+
+    return node.children.empty() && node.subscribers.empty();
+}
@@ -0,0 +1,139 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_variant_valuestore_subscription_index.h
+ @brief Store level registry of subtree subscriptions
+ */
+#ifndef __company_ref_VARIANT_VALUESTORE_SUBSCRIPTION_INDEX_H__
+#define __company_ref_VARIANT_VALUESTORE_SUBSCRIPTION_INDEX_H__
+
+#include "company_ref_variant_valuestore_client_frame.h"
+#include "company_ref_variant_valuestore_valueid.h"
+#include "company_ref_variant_valuestore_variant.h"
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+namespace Compan{
+namespace Edge {
+
+class VariantValueStore;
+
+/*!
+ * @brief Registry of subscribed subtrees, shared by all subscribers of a VariantValueStore
+ *
+ * Subscriptions are kept in a prefix trie of ValueId elements; a node holds
+ * the subscribers of the subtree rooted at it. A reverse index from a
+ * subscribed root's hash token to it's subscribers gives an O(1) exact match.
+ *
+ * The index holds a single connection to the store's changed signal, and
+ * resolves the subscribers of a changed value by walking the trie along
+ * the value's id, O(depth), instead of every subscriber holding a signal
+ * connection on every subscribed value.
+ *
+ * Every subscriber of a change is handed the same ClientMessageFrame, so
+ * the change is built and encoded once regardless of the subscriber count.
+ */
+class VariantValueSubscriptionIndex {
+public:
+    using SubscriberId = uint32_t;
+    using SubscriberSet = std::set<SubscriberId>;
+    using NotifyFunction = std::function<void(ClientMessageFrame::Ptr const)>;
+
+    static SubscriberId const InvalidSubscriber = 0;
+
+    explicit VariantValueSubscriptionIndex(VariantValueStore& ws);
+    virtual ~VariantValueSubscriptionIndex();
+
+    /*!
+     * Registers a subscriber
+     *
+     * @param onChanged called for changes to any value within the subscriber's subtrees
+     * @returns unique SubscriberId
+     */
+    SubscriberId connect(NotifyFunction const& onChanged);
+
+    /// Removes a subscriber and all of it's subscriptions
+    void disconnect(SubscriberId const subscriberId);
+
+    /// Subscribes to a value and all of it's children
+    void subscribe(SubscriberId const subscriberId, VariantValue::Ptr const valuePtr);
+
+    /// Removes the subscription rooted at this value, if there is one
+    void unsubscribe(SubscriberId const subscriberId, VariantValue::Ptr const valuePtr);
+
+    /// Removes all of the subscriptions, the subscriber stays registered
+    void unsubscribeAll(SubscriberId const subscriberId);
+
+    /// Subscribes to every value in the store
+    void subscribeStore(SubscriberId const subscriberId);
+
+    /// Removes the whole store subscription, subtree subscriptions are kept
+    void unsubscribeStore(SubscriberId const subscriberId);
+
+    /// Returns true if the subscriber has at least one subtree subscription
+    bool hasSubscriptions(SubscriberId const subscriberId) const;
+
+    /// Returns true if the value or one of it's parents is subscribed to
+    bool isSubscribed(SubscriberId const subscriberId, VariantValue::Ptr const valuePtr) const;
+
+    /// Returns the subscribers of the value and it's parents, including whole store subscribers
+    SubscriberSet subscribers(ValueId const& valueId) const;
+
+    /// Number of registered subscribers
+    size_t subscriberCount() const;
+
+    /// Number of trie nodes, used for measuring the memory footprint
+    size_t nodeCount() const;
+
+protected:
+    VariantValueSubscriptionIndex(VariantValueSubscriptionIndex const&) = delete;
+    VariantValueSubscriptionIndex& operator=(VariantValueSubscriptionIndex const&) = delete;
+
+    /// Store changed notification, dispatched to the resolved subscribers
+    void onValueChanged(VariantValue::Ptr const valuePtr);
+
+private:
+    struct Node {
+        std::map<std::string, std::unique_ptr<Node>> children;
+        SubscriberSet subscribers;
+    };
+
+    struct Subscriber {
+        std::shared_ptr<NotifyFunction> onChanged;
+        std::map<std::string, uint64_t> roots; //!< subscribed value id and it's hash token
+    };
+
+    /// non-locking resolve of the value's subscribers
+    void resolve(ValueId const& valueId, SubscriberSet& subscriberSet) const;
+
+    /// non-locking removal of a subscription root, prunes empty nodes
+    void eraseRoot(SubscriberId const subscriberId, std::string const& valueId, uint64_t const hashToken);
+
+    /// Removes empty nodes along the path
+    bool prune(Node& node, ValueIdIterator iter, ValueIdIterator const& end);
+
+private:
+    mutable std::mutex mutex_;
+
+    Node root_;
+    size_t nodeCount_;
+
+    std::unordered_map<uint64_t, SubscriberSet> tokenIndex_; //!< subscribed root's hash token to subscribers
+    SubscriberSet storeSubscribers_;                          //!< subscribed to every value
+    std::unordered_map<SubscriberId, Subscriber> subscribers_;
+
+    SubscriberId nextSubscriberId_;
+
+    SignalScopedConnection changedListener_;
+};
+
+} // namespace Edge
+} // namespace Compan
+
+#endif // __company_ref_VARIANT_VALUESTORE_SUBSCRIPTION_INDEX_H__
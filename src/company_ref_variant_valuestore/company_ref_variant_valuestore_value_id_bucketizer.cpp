@@ -19,7 +19,12 @@ HashBucket& ValueIdBucketizer::hashBucket()
 
 HashToken ValueIdBucketizer::make(ValueId const& valueId)
 {
-    HashToken::HashIdType hashId = hashBucket_.getHashFunction()(valueId);
+    return make(valueId, HashToken::InvalidHashId);
+}
+
+HashToken ValueIdBucketizer::make(ValueId const& valueId, HashToken::HashIdType hashId)
+{
+    if (hashId == HashToken::InvalidHashId) hashId = hashBucket_.getHashFunction()(valueId);
 
     if (hashBucket_.hasBucket(hashId)) {
         HashToken::BucketType bucket = findById(hashId, valueId);
@@ -58,6 +58,15 @@ public:
     ///
     HashToken make(ValueId const&);
 
+    /*!
+     * Returns a HashToken for a Value Id name, with it's precomputed hash id
+     *
+     * @param Value Id String
+     * @param hashId    the Value Id's hash, HashToken::InvalidHashId to have it computed
+     * @return  Valid HashToken
+     */
+    HashToken make(ValueId const&, HashToken::HashIdType const hashId);
+
     /*!
      * Returns a Value Id that is associated with a HashToken
      * @param HashToken to search for
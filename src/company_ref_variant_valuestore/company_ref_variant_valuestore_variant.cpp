@@ -78,6 +78,7 @@ VariantValue::VariantValue(
     , value_(type, access)
     , valueId_(std::make_shared<ValueId>(valueId))
     , setUpdateType_(Local)
+    , version_(0)
 {
 }
 
@@ -90,6 +91,7 @@ VariantValue::VariantValue(
     , value_(arg)
     , valueId_(std::make_shared<ValueId>(arg.id()))
     , setUpdateType_(updateType)
+    , version_(0)
 {
 }
 
@@ -103,6 +105,7 @@ VariantValue::VariantValue(
     , value_(CompanEdgeProtocol::Enum, access)
     , valueId_(std::make_shared<ValueId>(valueId))
     , setUpdateType_(Local)
+    , version_(0)
 {
     if (enumerator.empty()) return;
 
@@ -113,6 +116,27 @@ VariantValue::VariantValue(
 }
 
 ValueDataSet::Results VariantValue::set(std::string const& arg, SetUpdateType const updateType)
+{
+    ValueDataSet::Results retValue;
+    if (dataDispatcher_) {
+        // read, convert and write in a single round trip
+        VariantValueDispatcher::ProtocolValueBatchPtr setTask(std::make_shared<VariantValueDispatcher::ProtocolValueBatch>(
+                [this, &arg, updateType, &retValue]() { retValue = setData(arg, updateType); }));
+
+        std::future<void> result = setTask->get_future();
+
+        dataDispatcher_->batchCompanEdgeProtocolValues(setTask);
+
+        result.get();
+    } else
+        retValue = setData(arg, updateType);
+
+    if (retValue == ValueDataSet::Success) signal();
+
+    return retValue;
+}
+
+ValueDataSet::Results VariantValue::setData(std::string const& arg, SetUpdateType const updateType)
 {
     if (value_.access() == CompanEdgeProtocol::Value_Access_ReadOnly && updateType == Local)
         return ValueDataSet::AccessError;
@@ -120,8 +144,21 @@ ValueDataSet::Results VariantValue::set(std::string const& arg, SetUpdateType co
     if (value_.type() == CompanEdgeProtocol::Unset || value_.type() == CompanEdgeProtocol::Unknown)
         return ValueDataSet::InvalidType;
 
-    CompanEdgeProtocol::Value updateValue(get());
+    CompanEdgeProtocol::Value updateValue;
+    getData(updateValue);
+
+    // no point in continuing, right? the caller signals
+    if (updateValue.type() == CompanEdgeProtocol::Container || updateValue.type() == CompanEdgeProtocol::Struct)
+        return ValueDataSet::Success;
 
+    ValueDataSet::Results const parsed = parse(arg, updateValue);
+    if (parsed != ValueDataSet::Success) return parsed;
+
+    return setData(updateValue, updateType);
+}
+
+ValueDataSet::Results VariantValue::parse(std::string const& arg, CompanEdgeProtocol::Value& updateValue) const
+{
     switch (updateValue.type()) {
     case CompanEdgeProtocol::Bool: {
         if (arg.empty()) return ValueDataSet::InvalidType;
@@ -209,11 +246,7 @@ ValueDataSet::Results VariantValue::set(std::string const& arg, SetUpdateType co
     } break;
 
     case CompanEdgeProtocol::Container:
-    case CompanEdgeProtocol::Struct:
-        // no point in continuing, right?
-        signal();
-        return ValueDataSet::Success;
-        break;
+    case CompanEdgeProtocol::Struct: return ValueDataSet::Success;
 
     case CompanEdgeProtocol::Unset:
     case CompanEdgeProtocol::Unknown:
@@ -226,25 +259,20 @@ ValueDataSet::Results VariantValue::set(std::string const& arg, SetUpdateType co
     case CompanEdgeProtocol::Value_Type_INT_MAX_SENTINEL_DO_NOT_USE_: return ValueDataSet::InvalidType;
     }
 
-    return set(updateValue, updateType);
+    return ValueDataSet::Success;
 }
 
 ValueDataSet::Results VariantValue::set(CompanEdgeProtocol::Value const& arg, SetUpdateType const updateType)
 {
-    if (value_.access() == CompanEdgeProtocol::Value_Access_ReadOnly && updateType == Local)
-        return ValueDataSet::AccessError;
-
-    // the stored value is not set
-    if (value_.type() == CompanEdgeProtocol::Unset || value_.type() == CompanEdgeProtocol::Unknown) value_.type(arg.type());
-
-    if (value_.type() != arg.type()) return ValueDataSet::InvalidType;
-
-    setUpdateType_ = updateType;
-
     ValueDataSet::Results retValue;
     if (dataDispatcher_) {
         VariantValueDispatcher::ProtocolValueSetPtr setTask(std::make_shared<VariantValueDispatcher::ProtocolValueSet>(
-                std::bind(&CompanEdgeProtocolValueData::set, &value_, std::placeholders::_1)));
+                std::bind(
+                        static_cast<ValueDataSet::Results (VariantValue::*)(
+                                CompanEdgeProtocol::Value const&, SetUpdateType const)>(&VariantValue::setData),
+                        this,
+                        std::placeholders::_1,
+                        updateType)));
 
         std::future<ValueDataSet::Results> result = setTask->get_future();
 
@@ -252,14 +280,31 @@ ValueDataSet::Results VariantValue::set(CompanEdgeProtocol::Value const& arg, Se
 
         retValue = result.get();
     } else
-        retValue = value_.set(arg);
+        retValue = setData(arg, updateType);
+
+    if (retValue == ValueDataSet::Success) signal();
+
+    return retValue;
+}
+
+ValueDataSet::Results VariantValue::setData(CompanEdgeProtocol::Value const& arg, SetUpdateType const updateType)
+{
+    if (value_.access() == CompanEdgeProtocol::Value_Access_ReadOnly && updateType == Local)
+        return ValueDataSet::AccessError;
+
+    // the stored value is not set
+    if (value_.type() == CompanEdgeProtocol::Unset || value_.type() == CompanEdgeProtocol::Unknown) value_.type(arg.type());
+
+    if (value_.type() != arg.type()) return ValueDataSet::InvalidType;
+
+    setUpdateType_ = updateType;
+
+    ValueDataSet::Results const retValue = value_.set(arg);
 
     if ((retValue == ValueDataSet::Success)
         && (value_.access() == Value_Access_WriteOnce || arg.access() == CompanEdgeProtocol::Value_Access_ReadOnly))
         value_.access(CompanEdgeProtocol::Value_Access_ReadOnly);
 
-    if (retValue == ValueDataSet::Success) signal();
-
     return retValue;
 }
 
@@ -318,6 +363,16 @@ CompanEdgeProtocol::Value VariantValue::get() const
     return value;
 }
 
+void VariantValue::getData(CompanEdgeProtocol::Value& value) const
+{
+    value = value_.get();
+
+    if (valueId_)
+        value.set_id(*valueId_);
+    else
+        ErrorLog(VariantValueLog) << "Value Id is invalid:" << value_.hashToken() << std::endl;
+}
+
 void VariantValue::addChild(VariantValue::Ptr valuePtr)
 {
     children_.emplace(valuePtr->id().leaf(), valuePtr);
@@ -10,6 +10,7 @@
 #include <company_ref_utils/company_ref_signals.h>
 #include <company_ref_variant_valuestore/company_ref_variant_valuestore_valuedata.h>
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <set>
@@ -27,6 +28,7 @@ namespace Edge {
 
 // fwd decl for friendship
 class ValueId;
+class VariantValueBatch;
 class VariantValueDispatcher;
 class VariantValueStore;
 
@@ -137,6 +139,9 @@ public:
     /// Returns the last set update type
     SetUpdateType setUpdateType() const;
 
+    /// Returns the VariantValueStore version of the last add or change
+    uint64_t version() const;
+
     /// Returns a copy of the CompanEdgeProtocol::Value object
     CompanEdgeProtocol::Value get() const;
 
@@ -197,6 +202,9 @@ protected:
 
     void setUpdateType(SetUpdateType const);
 
+    /// Stamps the VariantValueStore version of an add or change
+    void version(uint64_t const);
+
     // Set Parent/Child relationships is the responsibility of the VariantValueStore
 
     /// Sets the parent VariantValue
@@ -233,9 +241,25 @@ protected:
     void setWsChangedSignal(ValueSignal::SlotType const&);
 
     friend class VariantValueStore;
+    friend class VariantValueBatch;
 
     ChildMapType children_;
 
+private:
+    // Data access - runs on the data dispatcher's thread, doesn't signal
+
+    /// Copies the data and id into value
+    void getData(CompanEdgeProtocol::Value& value) const;
+
+    /// Transforms and sets the string data
+    ValueDataSet::Results setData(std::string const& arg, SetUpdateType const updateType);
+
+    /// Sets the data from another CompanEdgeProtocol::Value object
+    ValueDataSet::Results setData(CompanEdgeProtocol::Value const& arg, SetUpdateType const updateType);
+
+    /// Transforms the string data into updateValue, of the stored type
+    ValueDataSet::Results parse(std::string const& arg, CompanEdgeProtocol::Value& updateValue) const;
+
 private:
     boost::asio::io_context::strand& ctx_;
     ValueSignal signal_;
@@ -246,6 +270,7 @@ private:
     ValueSignal::SlotType wsChangeNotification_;
 
     SetUpdateType setUpdateType_;
+    std::atomic<uint64_t> version_; //!< stamped by the VariantValueStore
 
     VariantValue::Ptr parent_;
 
@@ -297,6 +322,16 @@ inline void VariantValue::setUpdateType(SetUpdateType const arg)
     setUpdateType_ = arg;
 }
 
+inline uint64_t VariantValue::version() const
+{
+    return version_;
+}
+
+inline void VariantValue::version(uint64_t const arg)
+{
+    version_ = arg;
+}
+
 inline void VariantValue::parent(VariantValue::Ptr parent)
 {
     parent_ = parent;
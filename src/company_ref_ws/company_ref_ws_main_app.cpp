@@ -35,18 +35,28 @@ using namespace Compan::Edge;
 
 CompanLogger AeWsMainLog("appmain", LogLevel::Information);
 
+namespace {
+std::chrono::seconds const ReactorStatsInterval(60);
+} // namespace
+
 MainApp::MainApp()
     : mainIo_(AeWsMainLog)
     , ws_(mainIo_.getIoContext())
     , dmo_()
     , handlerFactory_(mainIo_.getIoContext(), ws_, dmo_)
+    , reactorStatsTimer_(mainIo_.getIoContext())
     , udsPath_("/tmp/company_ref_ws.socket")
     , loadPath_("")
     , restorePath_("")
     , dmoPath_("")
     , persistedPath_("")
+    , shmPath_("")
     , enableTcp_(false)
     , threads_(std::thread::hardware_concurrency())
+    , reactors_(0)
+    , pinReactors_(false)
+    , useUring_(false)
+    , reactorPolicy_(AsioReactorPool::RoundRobin)
 {
 }
 
@@ -74,18 +84,24 @@ int MainApp::run(int argc, char* argv[])
 
     try {
 
+        startReactors();
+
         startUdsServer();
         startTcpServer();
+        startShmServer();
 
         InfoLog(AeWsMainLog) << "VariantValueStore Server launching: " << threads_ << std::endl;
 
         mainIo_.run(threads_);
 
+        if (reactorPool_) reactorPool_->stop();
+
     } catch (std::exception& e) {
         std::cerr << "Error: exception occured: " << e.what() << "\n";
     }
 
     if (!udsPath_.empty()) { unlink(udsPath_.c_str()); };
+    if (!shmPath_.empty()) { unlink(shmPath_.c_str()); };
     return 0;
 }
 
@@ -96,8 +112,13 @@ bool MainApp::parseCmdLine(int argc, char* argv[])
             {'l', "load", true, false},
             {'r', "restore", true, false},
             {'c', "threads", true, false},
+            {'R', "reactors", true, false},
+            {'b', "balance", true, false},
+            {'P', "pin", false, false},
+            {'U', "io-uring", false, false},
             {'d', "dmo", true, false},
             {'p', "persisted", true, false},
+            {'s', "shm", true, false},
             {'t', "tcp", false, false},
             {'h', "help", false, false},
     });
@@ -113,12 +134,28 @@ bool MainApp::parseCmdLine(int argc, char* argv[])
         } catch (...) {
         }
     }
+    if (appOptionsParser.has('R')) {
+        try {
+            reactors_ = std::max(0, std::stoi(appOptionsParser.single('R')));
+        } catch (...) {
+        }
+    }
+    if (appOptionsParser.has('b')) {
+        std::string const policy(appOptionsParser.single('b'));
+        if (policy == "least-loaded")
+            reactorPolicy_ = AsioReactorPool::LeastLoaded;
+        else if (policy != "round-robin")
+            return false;
+    }
+    if (appOptionsParser.has('P')) pinReactors_ = true;
+    if (appOptionsParser.has('U')) useUring_ = true;
     if (appOptionsParser.has('l')) loadPath_ = appOptionsParser.single('l');
     if (appOptionsParser.has('r')) restorePath_ = appOptionsParser.single('r');
 
     if (appOptionsParser.has('d')) dmoPath_ = appOptionsParser.single('d');
     if (appOptionsParser.has('p')) persistedPath_ = appOptionsParser.single('p');
 
+    if (appOptionsParser.has('s')) shmPath_ = appOptionsParser.single('s');
     if (appOptionsParser.has('t')) enableTcp_ = true;
 
     return true;
@@ -134,6 +171,12 @@ int MainApp::usage(int const ret)
     std::cout << "  -r, --restore <path>    Path to restore a persisted state " << std::endl;
     std::cout << "  -d, --dmo <path>        Path to data model files" << std::endl;
     std::cout << "  -p, --persisted <path>  Path to persisted files" << std::endl;
+    std::cout << "  -s, --shm <path>        Path to the shared memory bootstrap socket" << std::endl;
+    std::cout << "  -c, --threads <n>       Threads running the value store" << std::endl;
+    std::cout << "  -R, --reactors <n>      Service connections on n single threaded reactors" << std::endl;
+    std::cout << "  -b, --balance <policy>  Reactor placement: round-robin (default), least-loaded" << std::endl;
+    std::cout << "  -P, --pin               Pin each reactor to a core" << std::endl;
+    std::cout << "  -U, --io-uring          Service connections with io_uring, when the kernel supports it" << std::endl;
 
     // Hide the tcp option; use primarily by devs
     // std::cout << "  -t, --tcp             Turns on the default tcp server" << std::endl;
@@ -188,7 +231,13 @@ void MainApp::startUdsServer()
 {
     if (udsPath_.empty()) return;
 
-    udsServer_ = std::make_unique<AsioUdsServer>(mainIo_.getIoContext(), handlerFactory_, udsPath_);
+    udsServer_ = std::make_unique<AsioUdsServer>(
+            mainIo_.getIoContext(), handlerFactory_, udsPath_, reactorPool_.get());
+
+    if (useUring_ && !udsServer_->enableUring()) {
+        WarnLog(AeWsMainLog) << "io_uring unavailable, Uds connections use the reactor backend" << std::endl;
+    }
+
     DebugLog(AeWsMainLog) << "Server is running, Uds: " << udsPath_ << std::endl;
 }
 
@@ -209,6 +258,59 @@ void MainApp::startTcpServer()
         return;
     }
 
-    tcpServer_ = std::make_unique<AsioTcpServer>(mainIo_.getIoContext(), handlerFactory_, host, port);
+    tcpServer_ = std::make_unique<AsioTcpServer>(
+            mainIo_.getIoContext(), handlerFactory_, host, port, reactorPool_.get());
+
+    if (useUring_ && !tcpServer_->enableUring()) {
+        WarnLog(AeWsMainLog) << "io_uring unavailable, Tcp connections use the reactor backend" << std::endl;
+    }
+
     DebugLog(AeWsMainLog) << "Server is running, Ip: " << host << ":" << port << std::endl;
 }
+
+void MainApp::startShmServer()
+{
+    if (shmPath_.empty()) return;
+
+    shmServer_ = std::make_unique<AsioShmServer>(
+            mainIo_.getIoContext(), handlerFactory_, shmPath_, AsioShmSegment::DefaultCapacity, reactorPool_.get());
+    DebugLog(AeWsMainLog) << "Server is running, Shm: " << shmPath_ << std::endl;
+}
+
+void MainApp::startReactors()
+{
+    if (reactors_ == 0) return;
+
+    reactorPool_ = std::make_unique<AsioReactorPool>(reactors_, reactorPolicy_, pinReactors_);
+    reactorPool_->run();
+
+    InfoLog(AeWsMainLog) << "Connection reactors: " << reactors_ << (pinReactors_ ? ", pinned" : "") << std::endl;
+
+    reactorStatsTimer_.expires_after(ReactorStatsInterval);
+    reactorStatsTimer_.async_wait([this](boost::system::error_code const& ec) {
+        if (!ec) publishReactorStats();
+    });
+}
+
+void MainApp::publishReactorStats()
+{
+    std::vector<AsioReactorPool::Stats> const stats(reactorPool_->stats());
+
+    size_t least(stats.front().connections);
+    size_t most(stats.front().connections);
+
+    for (size_t i = 0; i < stats.size(); ++i) {
+        least = std::min(least, stats[i].connections);
+        most = std::max(most, stats[i].connections);
+
+        InfoLog(AeWsMainLog) << "reactor[" << i << "] connections: " << stats[i].connections
+                             << " accepted: " << stats[i].accepted << std::endl;
+    }
+
+    InfoLog(AeWsMainLog) << "reactor imbalance: " << (most - least) << std::endl;
+
+    reactorStatsTimer_.expires_after(ReactorStatsInterval);
+    reactorStatsTimer_.async_wait([this](boost::system::error_code const& ec) {
+        if (!ec) publishReactorStats();
+    });
+}
@@ -6,6 +6,8 @@
 #ifndef __company_ref_WS_MAIN_APP_H__
 #define __company_ref_WS_MAIN_APP_H__
 
+#include <company_ref_asio/company_ref_asio_reactor_pool.h>
+#include <company_ref_asio/company_ref_asio_shm_server.h>
 #include <company_ref_asio/company_ref_asio_tcp_server.h>
 #include <company_ref_asio/company_ref_asio_uds_server.h>
 #include <company_ref_asio_protocol_server/company_ref_asio_server_msg_handler_factory.h>
@@ -14,6 +16,8 @@
 #include <company_ref_main_apps/company_ref_main_io_context.h>
 #include <company_ref_variant_valuestore/company_ref_variant_valuestore.h>
 
+#include <boost/asio/steady_timer.hpp>
+
 namespace Compan{
 namespace Edge {
 
@@ -35,6 +39,13 @@ protected:
 
     void startUdsServer();
     void startTcpServer();
+    void startShmServer();
+
+    /// Creates the connection reactors, when asked for
+    void startReactors();
+
+    /// Logs the connection load of each reactor
+    void publishReactorStats();
 
 private:
     MainIoContext mainIo_;
@@ -42,8 +53,13 @@ private:
     DmoContainer dmo_;
 
     ServerMsgHandlerFactory handlerFactory_;
+
+    std::unique_ptr<AsioReactorPool> reactorPool_; // outlives the servers' connections
+    boost::asio::steady_timer reactorStatsTimer_;
+
     std::unique_ptr<AsioUdsServer> udsServer_;
     std::unique_ptr<AsioTcpServer> tcpServer_;
+    std::unique_ptr<AsioShmServer> shmServer_;
 
     std::unique_ptr<DynamicDmoController> controller_;
 
@@ -53,8 +69,13 @@ private:
     std::string restorePath_;   // -r
     std::string dmoPath_;       // -d
     std::string persistedPath_; // -p
+    std::string shmPath_;       // -s
     bool enableTcp_;            // -t
     int threads_;               // -c
+    int reactors_;              // -R
+    bool pinReactors_;          // -P
+    bool useUring_;             // -U
+    AsioReactorPool::Policy reactorPolicy_; // -b
 };
 
 } // namespace Edge
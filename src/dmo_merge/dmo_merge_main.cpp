@@ -5,6 +5,8 @@
 */
 
 #include <company_ref_dmo/company_ref_dmo_file.h>
+#include <company_ref_dmo/company_ref_dmo_snapshot.h>
+#include <company_ref_protocol/company_ref_datamodel.pb.h>
 #include <company_ref_utils/company_ref_path_parser.h>
 #include <Compan_logger/Compan_logger_sink_cout.h>
 
@@ -19,6 +21,7 @@ struct option long_options[] = {
         {"show", no_argument, 0, 's'},
         {"files", required_argument, 0, 'f'},
         {"dmo", required_argument, 0, 'd'},
+        {"binary", no_argument, 0, 'b'},
         {0, 0, 0, 0}};
 
 int usage(char const* appname, int ret)
@@ -30,6 +33,7 @@ int usage(char const* appname, int ret)
     std::cout << "  -f, --files               Path to files for merge" << std::endl;
     std::cout << "                            Comma seperated" << std::endl;
     std::cout << "  -d, --dmo                 Path to dmo output" << std::endl;
+    std::cout << "  -b, --binary              Write the dmo output as a binary snapshot" << std::endl;
 
     std::cout << std::endl;
     return ret;
@@ -53,13 +57,15 @@ int main(int argc, char* argv[])
     std::string filesPath;
     std::string dmoPath;
     bool showTree(false);
+    bool binary(false);
 
     int c = 0, option_index = 0;
-    std::string const argOptions("hsf:d:");
+    std::string const argOptions("hsbf:d:");
     while ((c = getopt_long(argc, argv, argOptions.c_str(), long_options, &option_index)) != -1) {
         switch (c) {
         case 'h': return usage(appName, 0);
         case 's': showTree = true; break;
+        case 'b': binary = true; break;
 
         case 'f': {
             filesPath = optarg;
@@ -87,7 +93,12 @@ int main(int argc, char* argv[])
     PathParser::pathSplitString(
             filesPath, [&dmoContainer](std::string const& mergeFile) { DmoFile::read(mergeFile, dmoContainer); });
 
-    if (!DmoFile::write(dmoPath, dmoContainer)) std::cout << "Error Writing: " << dmoPath << std::endl;
+    if (binary) {
+        CompanEdgeDataModel::DataModelMessage dmoData;
+        if (!DmoFile::write(dmoContainer, dmoData) || !DmoSnapshot::write(dmoPath, dmoData))
+            std::cout << "Error Writing: " << dmoPath << std::endl;
+    } else if (!DmoFile::write(dmoPath, dmoContainer))
+        std::cout << "Error Writing: " << dmoPath << std::endl;
 
     if (showTree) dmoContainer.print(std::cout);
 
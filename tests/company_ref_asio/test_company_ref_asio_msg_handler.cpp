@@ -43,17 +43,16 @@ public:
     {
     }
 
-    void sendData(AsioMsgHandler::BufferType&& sendBuffer)
+    void sendData(boost::asio::const_buffer const& sendBuffer)
     {
-        EXPECT_EQ(sendBuffer_, sendBuffer);
+        uint8_t const* data = static_cast<uint8_t const*>(sendBuffer.data());
+        EXPECT_EQ(sendBuffer_, AsioMsgHandler::BufferType(data, data + sendBuffer.size()));
     }
 
     AsioMsgHandler::BufferType sendBuffer_;
 };
 
-using BufferType = std::vector<uint8_t>;
-using SendFunction = std::function<void(BufferType&&)>;
-using SendConnection = std::shared_ptr<SendFunction>;
+using SendConnection = AsioMsgHandler::SendConnection;
 
 TEST(AsioMsgHandlerTest, CheckConnection)
 {
@@ -86,6 +85,51 @@ TEST(AsioMsgHandlerTest, CheckSend)
     handler.recvData(std::move(buffer));
 }
 
+TEST(AsioMsgHandlerTest, CheckSendWritten)
+{
+    AsioMsgHandler::BufferType rspBuffer({'r', 's', 'p'});
+    boost::asio::const_buffer const buffer(rspBuffer.data(), rspBuffer.size());
+
+    MockAsioMsgHandler handler(rspBuffer);
+    MockConnection connection(rspBuffer);
+
+    bool written(false);
+    auto onWritten = [&written]() { written = true; };
+
+    // written before sendData returns
+    SendConnection sendConnection =
+            handler.connectSendData(std::bind(&MockConnection::sendData, connection, std::placeholders::_1));
+
+    EXPECT_TRUE(handler.sendData(buffer, onWritten));
+    EXPECT_TRUE(written);
+
+    // a connection queueing it's sends reports the write later
+    AsioMsgHandler::WrittenFunction queued;
+    AsioMsgHandler::QueuedSendConnection queuedConnection = handler.connectSendDataQueued(
+            [&queued](boost::asio::const_buffer const&, AsioMsgHandler::WrittenFunction const& onWritten) {
+                queued = onWritten;
+            });
+
+    written = false;
+    EXPECT_TRUE(handler.sendData(buffer, onWritten));
+    EXPECT_FALSE(written);
+
+    ASSERT_TRUE(queued);
+    queued();
+    EXPECT_TRUE(written);
+
+    // falls back to the remaining connection
+    queuedConnection.reset();
+    EXPECT_TRUE(handler.isConnected());
+
+    sendConnection.reset();
+    EXPECT_FALSE(handler.isConnected());
+
+    written = false;
+    EXPECT_FALSE(handler.sendData(buffer, onWritten));
+    EXPECT_FALSE(written);
+}
+
 TEST(AsioMsgHandlerTest, CheckSendDisconnect)
 {
     AsioMsgHandler::BufferType rspBuffer({'r', 's', 'p'});
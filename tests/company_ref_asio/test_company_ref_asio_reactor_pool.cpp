@@ -0,0 +1,77 @@
+/**
+  Copyright © 2024 COMPAN REF
+  @file test_company_ref_asio_reactor_pool.cpp
+  @brief Reactor pool tests
+*/
+
+#include <gmock/gmock.h>
+
+#include <company_ref_asio/company_ref_asio_reactor_pool.h>
+
+#include <boost/asio/post.hpp>
+
+#include <future>
+#include <set>
+
+using namespace Compan::Edge;
+
+TEST(AsioReactorPoolTest, RoundRobin)
+{
+    AsioReactorPool pool(3);
+
+    EXPECT_EQ(pool.size(), 3u);
+    EXPECT_EQ(pool.policy(), AsioReactorPool::RoundRobin);
+
+    EXPECT_EQ(pool.select(), 0u);
+    EXPECT_EQ(pool.select(), 1u);
+    EXPECT_EQ(pool.select(), 2u);
+    EXPECT_EQ(pool.select(), 0u);
+}
+
+TEST(AsioReactorPoolTest, LeastLoaded)
+{
+    AsioReactorPool pool(3, AsioReactorPool::LeastLoaded);
+
+    pool.connectionOpened(0);
+    pool.connectionOpened(0);
+    pool.connectionOpened(1);
+
+    EXPECT_EQ(pool.select(), 2u);
+    pool.connectionOpened(2);
+
+    EXPECT_EQ(pool.select(), 1u);
+    pool.connectionOpened(1);
+
+    pool.connectionClosed(0);
+    pool.connectionClosed(0);
+    EXPECT_EQ(pool.select(), 0u);
+
+    std::vector<AsioReactorPool::Stats> const stats(pool.stats());
+    ASSERT_EQ(stats.size(), 3u);
+
+    EXPECT_EQ(stats[0].connections, 0u);
+    EXPECT_EQ(stats[0].accepted, 2u);
+    EXPECT_EQ(stats[1].connections, 2u);
+    EXPECT_EQ(stats[2].connections, 1u);
+}
+
+TEST(AsioReactorPoolTest, ReactorThreads)
+{
+    AsioReactorPool pool(2);
+    pool.run();
+
+    std::set<std::thread::id> threads;
+
+    for (size_t i = 0; i < pool.size(); ++i) {
+        std::promise<std::thread::id> ran;
+        boost::asio::post(pool.ioContext(i), [&ran] { ran.set_value(std::this_thread::get_id()); });
+
+        threads.insert(ran.get_future().get());
+    }
+
+    // each reactor is serviced by it's own thread
+    EXPECT_EQ(threads.size(), 2u);
+    EXPECT_EQ(threads.count(std::this_thread::get_id()), 0u);
+
+    pool.stop();
+}
@@ -0,0 +1,212 @@
+/**
+  Copyright © 2024 COMPAN REF
+  @file test_company_ref_asio_shm_ring.cpp
+  @brief Shared memory ring tests
+*/
+
+#include <gmock/gmock.h>
+
+#include <company_ref_asio/company_ref_asio_shm_ring.h>
+#include <Compan_logger/Compan_logger_sink_buffered.h>
+
+#include <numeric>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace Compan::Edge;
+
+namespace {
+/// A ring in private memory, with views for both sides and the shared counters
+struct LocalRing {
+    static uint64_t const Capacity = 4096;
+
+    LocalRing()
+        : writer(memory, Capacity, true)
+        , reader(memory, Capacity, false)
+    {
+    }
+
+    AsioShmRing::Header& header() { return *reinterpret_cast<AsioShmRing::Header*>(memory); }
+
+    alignas(64) uint8_t memory[sizeof(AsioShmRing::Header) + Capacity];
+    AsioShmRing writer;
+    AsioShmRing reader;
+};
+} // namespace
+
+TEST(AsioShmRingTest, WrapAround)
+{
+    AsioShmSegment segment;
+    ASSERT_TRUE(segment.create(4096));
+
+    AsioShmRing& ring = segment.ring(AsioShmSegment::ServerToClient);
+    EXPECT_EQ(ring.capacity(), 4096u);
+    EXPECT_EQ(ring.writable(), 4096u);
+
+    std::vector<uint8_t> data(3000);
+    std::iota(data.begin(), data.end(), 0);
+
+    std::vector<uint8_t> out(data.size());
+
+    // the second pass straddles the end of the ring
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(ring.write(data.data(), data.size()), data.size());
+        EXPECT_EQ(ring.readable(), data.size());
+
+        EXPECT_EQ(ring.read(out.data(), out.size()), out.size());
+        EXPECT_EQ(out, data);
+        EXPECT_EQ(ring.readable(), 0u);
+    }
+}
+
+TEST(AsioShmRingTest, Full)
+{
+    AsioShmSegment segment;
+    ASSERT_TRUE(segment.create(4096));
+
+    AsioShmRing& ring = segment.ring(AsioShmSegment::ClientToServer);
+
+    std::vector<uint8_t> data(5000, 0x5a);
+
+    EXPECT_EQ(ring.write(data.data(), data.size()), 4096u);
+    EXPECT_EQ(ring.writable(), 0u);
+    EXPECT_EQ(ring.write(data.data(), data.size()), 0u);
+
+    std::vector<uint8_t> out(100);
+    EXPECT_EQ(ring.read(out.data(), out.size()), out.size());
+    EXPECT_EQ(ring.writable(), out.size());
+
+    // the other direction is untouched
+    EXPECT_EQ(segment.ring(AsioShmSegment::ServerToClient).readable(), 0u);
+}
+
+TEST(AsioShmRingTest, Attach)
+{
+    AsioShmSegment server;
+    ASSERT_TRUE(server.create(8192));
+
+    AsioShmSegment client;
+    ASSERT_TRUE(client.attach(::dup(server.fd())));
+
+    std::string const msg("hello");
+
+    AsioShmRing& tx = server.ring(AsioShmSegment::ServerToClient);
+    AsioShmRing& rx = client.ring(AsioShmSegment::ServerToClient);
+
+    EXPECT_EQ(rx.capacity(), 8192u);
+
+    EXPECT_EQ(tx.write(reinterpret_cast<uint8_t const*>(msg.data()), msg.size()), msg.size());
+    ASSERT_EQ(rx.readable(), msg.size());
+
+    std::string out(msg.size(), '\0');
+    EXPECT_EQ(rx.read(reinterpret_cast<uint8_t*>(&out[0]), out.size()), out.size());
+    EXPECT_EQ(out, msg);
+
+    EXPECT_EQ(tx.writable(), tx.capacity());
+}
+
+TEST(AsioShmRingTest, AttachInvalid)
+{
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    ::close(fds[1]);
+
+    AsioShmSegment client;
+    EXPECT_FALSE(client.attach(fds[0]));
+    EXPECT_EQ(client.fd(), -1);
+}
+
+TEST(AsioShmRingTest, AttachUnsealed)
+{
+    CompanLoggerSinkBuffered coutWrapper;
+
+    AsioShmSegment server;
+    ASSERT_TRUE(server.create(4096));
+
+    // the server's segment can't be resized
+    struct stat st;
+    ASSERT_EQ(::fstat(server.fd(), &st), 0);
+    EXPECT_NE(::ftruncate(server.fd(), 0), 0);
+    EXPECT_NE(::ftruncate(server.fd(), st.st_size * 2), 0);
+
+    // a copy of it without the seals is refused
+    int const fd = ::memfd_create("test_shm", MFD_CLOEXEC);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(::ftruncate(fd, st.st_size), 0);
+
+    std::vector<uint8_t> segment(st.st_size);
+    ASSERT_EQ(::pread(server.fd(), segment.data(), segment.size(), 0), st.st_size);
+    ASSERT_EQ(::pwrite(fd, segment.data(), segment.size(), 0), st.st_size);
+
+    AsioShmSegment client;
+    EXPECT_FALSE(client.attach(fd));
+    EXPECT_EQ(client.fd(), -1);
+
+    EXPECT_EQ(coutWrapper.pop(), "asio.shm: Error: attach: segment not sealed\n");
+}
+
+TEST(AsioShmRingTest, CorruptedHead)
+{
+    CompanLoggerSinkBuffered coutWrapper;
+
+    LocalRing ring;
+
+    std::vector<uint8_t> data(100, 0x5a);
+    EXPECT_EQ(ring.writer.write(data.data(), data.size()), data.size());
+    EXPECT_EQ(ring.reader.readable(), data.size());
+
+    // more in flight than the ring holds
+    ring.header().head.store(LocalRing::Capacity + 1);
+
+    std::vector<uint8_t> out(LocalRing::Capacity * 2);
+    EXPECT_EQ(ring.reader.readable(), 0u);
+    EXPECT_EQ(ring.reader.read(out.data(), out.size()), 0u);
+    EXPECT_TRUE(ring.reader.isCorrupted());
+
+    EXPECT_EQ(coutWrapper.pop(), "asio.shm: Error: read: head 4097 out of bounds, tail 0\n");
+
+    // stays corrupted, even once the head looks sane again
+    ring.header().head.store(data.size());
+    EXPECT_EQ(ring.reader.readable(), 0u);
+    EXPECT_TRUE(coutWrapper.empty());
+}
+
+TEST(AsioShmRingTest, HeadBackwards)
+{
+    CompanLoggerSinkBuffered coutWrapper;
+
+    LocalRing ring;
+
+    std::vector<uint8_t> data(100, 0x5a);
+    EXPECT_EQ(ring.writer.write(data.data(), data.size()), data.size());
+    EXPECT_EQ(ring.reader.readable(), data.size());
+
+    ring.header().head.store(50);
+
+    EXPECT_EQ(ring.reader.readable(), 0u);
+    EXPECT_TRUE(ring.reader.isCorrupted());
+
+    EXPECT_EQ(coutWrapper.pop(), "asio.shm: Error: read: head 50 out of bounds, tail 0\n");
+}
+
+TEST(AsioShmRingTest, CorruptedTail)
+{
+    CompanLoggerSinkBuffered coutWrapper;
+
+    LocalRing ring;
+
+    std::vector<uint8_t> data(100, 0x5a);
+    EXPECT_EQ(ring.writer.write(data.data(), data.size()), data.size());
+
+    // the reader claims more than was written
+    ring.header().tail.store(data.size() + 1);
+
+    EXPECT_EQ(ring.writer.writable(), 0u);
+    EXPECT_EQ(ring.writer.write(data.data(), data.size()), 0u);
+    EXPECT_TRUE(ring.writer.isCorrupted());
+
+    EXPECT_EQ(coutWrapper.pop(), "asio.shm: Error: write: tail 101 out of bounds, head 100\n");
+}
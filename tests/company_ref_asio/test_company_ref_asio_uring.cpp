@@ -0,0 +1,340 @@
+/**
+  Copyright © 2024 COMPAN REF
+  @file test_company_ref_asio_uring.cpp
+  @brief io_uring connection tests
+*/
+
+#include <gmock/gmock.h>
+
+#include <company_ref_asio/company_ref_asio_msg_handler.h>
+#include <company_ref_asio/company_ref_asio_msg_handler_factory.h>
+#include <company_ref_asio/company_ref_asio_uds_connection.h>
+#include <company_ref_asio/company_ref_asio_uds_server.h>
+#include <company_ref_asio/company_ref_asio_uring.h>
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace Compan::Edge;
+
+namespace {
+
+class EchoMsgHandler : public AsioMsgHandler {
+public:
+    EchoMsgHandler(std::atomic<uint64_t>& reads, std::atomic<uint64_t>& written)
+        : reads_(reads)
+        , written_(written)
+    {
+    }
+
+    virtual void start()
+    {
+    }
+    virtual void stop()
+    {
+    }
+
+    virtual void recvData(BufferType&& buffer)
+    {
+        ++reads_;
+
+        std::atomic<uint64_t>& written(written_);
+        sendData(boost::asio::buffer(buffer.data(), buffer.size()), [&written]() { ++written; });
+    }
+
+    std::atomic<uint64_t>& reads_;
+    std::atomic<uint64_t>& written_;
+};
+
+class EchoFactory : public AsioMsgHandlerFactory {
+public:
+    EchoFactory()
+        : reads_(0)
+        , written_(0)
+    {
+    }
+
+    AsioMsgHandler::Ptr make(uint32_t const)
+    {
+        return std::make_shared<EchoMsgHandler>(reads_, written_);
+    }
+
+    std::atomic<uint64_t> reads_;   //!< recvData calls
+    std::atomic<uint64_t> written_; //!< echoes reported written
+};
+
+class ClientMsgHandler : public AsioMsgHandler {
+public:
+    using Ptr = std::shared_ptr<ClientMsgHandler>;
+
+    virtual void start()
+    {
+    }
+    virtual void stop()
+    {
+    }
+
+    virtual void recvData(BufferType&& buffer)
+    {
+        received_.insert(received_.end(), buffer.begin(), buffer.end());
+    }
+
+    void sendMessage(BufferType buffer)
+    {
+        sendData(std::move(buffer));
+    }
+
+    BufferType received_;
+};
+
+/// Blocking client, keeps the load generation out of the io_contexts measured
+int connectUds(std::string const& path)
+{
+    int const fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    if (::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+} // namespace
+
+class AsioUringTest : public testing::Test {
+public:
+    AsioUringTest()
+        : ctx_()
+        , udsPath_("./uring")
+    {
+    }
+
+    virtual ~AsioUringTest()
+    {
+        ::unlink(udsPath_.c_str());
+    }
+
+    /// Runs the io_context until pred holds
+    bool runUntil(std::function<bool()> const& pred)
+    {
+        auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+        while (!pred()) {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+
+            ctx_.run_for(std::chrono::milliseconds(1));
+            ctx_.restart();
+        }
+
+        return true;
+    }
+
+    boost::asio::io_context ctx_;
+    std::string const udsPath_;
+
+    EchoFactory factory_;
+};
+
+TEST_F(AsioUringTest, PingPong)
+{
+    if (!AsioUring::isSupported()) {
+        std::cout << "io_uring not supported, skipped" << std::endl;
+        return;
+    }
+
+    AsioUdsServer server(ctx_, factory_, udsPath_);
+    ASSERT_TRUE(server.enableUring());
+
+    ClientMsgHandler::Ptr clientHandler(std::make_shared<ClientMsgHandler>());
+    AsioUdsConnection::Ptr client = std::make_shared<AsioUdsConnection>(ctx_, 0, clientHandler, udsPath_);
+    client->connect();
+
+    ASSERT_TRUE(runUntil([&server] { return !server.empty(); }));
+
+    AsioMsgHandler::BufferType const hello({'h', 'e', 'l', 'l', 'o'});
+    clientHandler->sendMessage(hello);
+
+    ASSERT_TRUE(runUntil([&clientHandler, &hello] { return clientHandler->received_.size() >= hello.size(); }));
+    EXPECT_EQ(clientHandler->received_, hello);
+
+    // the echo is reported written once it's send completes
+    EXPECT_TRUE(runUntil([this] { return factory_.written_ == factory_.reads_; }));
+
+    client->close();
+
+    EXPECT_TRUE(runUntil([&server] { return server.empty(); }));
+}
+
+TEST_F(AsioUringTest, LargeEcho)
+{
+    if (!AsioUring::isSupported()) {
+        std::cout << "io_uring not supported, skipped" << std::endl;
+        return;
+    }
+
+    AsioUdsServer server(ctx_, factory_, udsPath_);
+    ASSERT_TRUE(server.enableUring());
+
+    ClientMsgHandler::Ptr clientHandler(std::make_shared<ClientMsgHandler>());
+    AsioUdsConnection::Ptr client = std::make_shared<AsioUdsConnection>(ctx_, 0, clientHandler, udsPath_);
+    client->connect();
+
+    ASSERT_TRUE(runUntil([&server] { return !server.empty(); }));
+
+    // spans many provided buffers and partial sends
+    AsioMsgHandler::BufferType large(4 * 1024 * 1024);
+    for (size_t i = 0; i < large.size(); ++i) large[i] = static_cast<uint8_t>(i * 7);
+
+    std::thread sender([&clientHandler, &large] { clientHandler->sendMessage(large); });
+
+    bool const echoed =
+            runUntil([&clientHandler, &large] { return clientHandler->received_.size() >= large.size(); });
+    sender.join();
+
+    ASSERT_TRUE(echoed);
+    EXPECT_EQ(clientHandler->received_, large);
+
+    // echoes appended to a send in flight are reported with it
+    EXPECT_TRUE(runUntil([this] { return factory_.written_ == factory_.reads_; }));
+
+    client->close();
+    EXPECT_TRUE(runUntil([&server] { return server.empty(); }));
+}
+
+TEST_F(AsioUringTest, ServerDisconnect)
+{
+    if (!AsioUring::isSupported()) {
+        std::cout << "io_uring not supported, skipped" << std::endl;
+        return;
+    }
+
+    AsioUdsServer server(ctx_, factory_, udsPath_);
+    ASSERT_TRUE(server.enableUring());
+
+    ClientMsgHandler::Ptr clientHandler(std::make_shared<ClientMsgHandler>());
+    AsioUdsConnection::Ptr client = std::make_shared<AsioUdsConnection>(ctx_, 0, clientHandler, udsPath_);
+    client->connect();
+
+    ASSERT_TRUE(runUntil([&server] { return !server.empty(); }));
+
+    server.close();
+
+    EXPECT_TRUE(runUntil([&client] { return !client->isConnected(); }));
+    EXPECT_TRUE(server.empty());
+}
+
+/*!
+ * Same echo load on both backends; clients are blocking sockets on their
+ * own threads, the server runs on one thread.
+ *
+ * System calls are counted from what each backend can observe; with
+ * AsioConnection every recvData is (at least) a read and the echo a write,
+ * AsioUring's are io_uring_enter and the eventfd reads. strace -c -f gives
+ * the complete picture, epoll_wait included.
+ *
+ * A benchmark, run with --gtest_also_run_disabled_tests
+ * --gtest_filter=AsioUringTest.DISABLED_BackendComparison
+ */
+TEST_F(AsioUringTest, DISABLED_BackendComparison)
+{
+    if (!AsioUring::isSupported()) {
+        std::cout << "io_uring not supported, skipped" << std::endl;
+        return;
+    }
+
+    size_t const clientCount(64);
+    size_t const messageCount(2000);
+    size_t const messageSize(64);
+    size_t const window(16); //!< messages in flight per client
+
+    std::cout << std::setw(10) << "backend" << std::setw(14) << "msgs/s" << std::setw(16) << "syscalls/msg"
+              << std::endl;
+
+    for (bool const useUring : {false, true}) {
+        boost::asio::io_context serverCtx;
+        EchoFactory factory;
+
+        std::unique_ptr<AsioUdsServer> server(std::make_unique<AsioUdsServer>(serverCtx, factory, udsPath_));
+
+        if (useUring) { ASSERT_TRUE(server->enableUring()); }
+
+        auto work = boost::asio::make_work_guard(serverCtx);
+        std::thread serverThread([&serverCtx] { serverCtx.run(); });
+
+        auto const start = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> clients;
+        std::atomic<size_t> failures(0);
+
+        for (size_t c = 0; c < clientCount; ++c) {
+            clients.emplace_back([this, &failures, messageCount, messageSize, window] {
+                int const fd = connectUds(udsPath_);
+                if (fd < 0) {
+                    ++failures;
+                    return;
+                }
+
+                std::vector<uint8_t> const message(messageSize * window, 0x5a);
+                std::vector<uint8_t> echo(message.size());
+
+                for (size_t sent = 0; sent < messageCount; sent += window) {
+                    if (::write(fd, message.data(), message.size()) != ssize_t(message.size())) {
+                        ++failures;
+                        break;
+                    }
+
+                    size_t received(0);
+                    while (received < echo.size()) {
+                        ssize_t const n = ::read(fd, echo.data() + received, echo.size() - received);
+                        if (n <= 0) break;
+                        received += n;
+                    }
+
+                    if (received != echo.size()) {
+                        ++failures;
+                        break;
+                    }
+                }
+
+                ::close(fd);
+            });
+        }
+
+        for (auto& client : clients) client.join();
+
+        double const seconds =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        EXPECT_EQ(failures, 0u);
+
+        uint64_t syscalls(2 * factory.reads_);
+        if (useUring) {
+            AsioUring::Stats const stats(server->uringStats());
+            syscalls = stats.enters + stats.wakeups;
+        }
+
+        work.reset();
+        serverCtx.stop();
+        serverThread.join();
+        server.reset();
+
+        double const messages = double(clientCount * messageCount);
+
+        std::cout << std::setw(10) << (useUring ? "io_uring" : "reactor") << std::setw(14)
+                  << uint64_t(messages / seconds) << std::setw(16) << std::fixed << std::setprecision(3)
+                  << (syscalls / messages) << std::endl;
+    }
+}
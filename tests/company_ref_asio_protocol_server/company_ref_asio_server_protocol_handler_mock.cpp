@@ -13,7 +13,7 @@ ServerProtocolHandlerTest::ServerProtocolHandlerTest()
     , strand_(ctx_)
     , ws_(ctx_)
     , msgQueue_()
-    , handler_(std::make_shared<ServerProtocolHandler>(ws_, dmo_, wsContainerMutex_, 0))
+    , handler_(std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, 0))
     , boolId_("test.bool")
     , enumId_("test.enum")
     , rangedId_("test.ranged")
@@ -96,6 +96,8 @@ void ServerProtocolHandlerTest::messageCompleted(std::shared_ptr<CompanEdgeProto
 {
     if (!msgPtr) return;
 
+    lastMsgPtr_ = msgPtr;
+
     if (msgPtr->has_valuechanged() || msgPtr->has_valueremoved() || msgPtr->has_vsresult()
         || msgPtr->has_vsmultigetresult() || msgPtr->has_vsmultisetresult() || msgPtr->has_vssynccompleted())
         msgQueue_.push(*msgPtr);
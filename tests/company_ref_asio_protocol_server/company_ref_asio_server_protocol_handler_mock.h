@@ -127,9 +127,10 @@ public:
 
     VariantValueStore ws_;
     DmoContainer dmo_;
-    std::mutex wsContainerMutex_;
+    VariantContainerLocks containerLocks_;
 
     std::queue<CompanEdgeProtocol::ClientMessage> msgQueue_;
+    std::shared_ptr<CompanEdgeProtocol::ClientMessage> lastMsgPtr_; //!< used to signal a drained chunk
 
     ServerProtocolHandler::Ptr handler_;
 
@@ -0,0 +1,121 @@
+/**
+  Copyright © 2024 COMPAN REF
+  @file test_company_ref_protocol_message_arena_allocations.cpp
+  @brief Counting the heap allocations of arena backed messages
+
+  Replaces the global operator new, so it's built as it's own test binary
+  rather than into the protocol server's.
+*/
+
+#include <company_ref_protocol/company_ref_protocol.pb.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_message_arena.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+using namespace Compan::Edge;
+
+namespace {
+/// Heap allocations made by the test binary
+std::atomic<size_t> allocations(0);
+} // namespace
+
+void* operator new(size_t size)
+{
+    ++allocations;
+
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace {
+/// A VsMultiSet of count values, serialized as received from a client
+std::string makeMultiSet(size_t const count)
+{
+    CompanEdgeProtocol::ServerMessage msg;
+    CompanEdgeProtocol::VsMultiSet* multiSet = msg.mutable_vsmultiset();
+    multiSet->set_sequenceno(1);
+
+    for (size_t i = 0; i < count; ++i) {
+        CompanEdgeProtocol::VsMultiSet::Value* value = multiSet->add_values();
+        value->set_id("test.arena.value" + std::to_string(i));
+        value->set_value("text");
+    }
+
+    return msg.SerializeAsString();
+}
+
+/// Decodes a request and builds it's response, as the serializer and handler do
+template <typename MakeServer, typename MakeClient>
+void handleRequest(std::string const& data, MakeServer makeServer, MakeClient makeClient)
+{
+    std::shared_ptr<CompanEdgeProtocol::ServerMessage> reqPtr = makeServer();
+    ASSERT_TRUE(reqPtr->ParseFromArray(data.data(), data.size()));
+
+    std::shared_ptr<CompanEdgeProtocol::ClientMessage> rspPtr = makeClient();
+    CompanEdgeProtocol::VsMultiSetResult* result = rspPtr->mutable_vsmultisetresult();
+    result->set_sequenceno(reqPtr->vsmultiset().sequenceno());
+
+    for (auto const& value : reqPtr->vsmultiset().values()) {
+        CompanEdgeProtocol::VsMultiSetResult::Result* valueResult = result->add_results();
+        valueResult->set_id(value.id());
+        valueResult->set_error(CompanEdgeProtocol::VsMultiSetResult::Success);
+    }
+}
+} // namespace
+
+/*!
+ * Heap allocations of decoding a VsMultiSet and building it's result,
+ * with make_shared messages and with messages from the arena pool
+ *
+ * A benchmark, run with --gtest_also_run_disabled_tests
+ * --gtest_filter=MessageArenaAllocationsTest.DISABLED_RequestResponse
+ */
+TEST(MessageArenaAllocationsTest, DISABLED_RequestResponse)
+{
+    size_t const requests(1000);
+
+    std::cout << std::setw(8) << "values" << std::setw(14) << "make_shared" << std::setw(14) << "arena pool"
+              << std::endl;
+
+    for (size_t const count : {1, 16, 128}) {
+        std::string const data(makeMultiSet(count));
+        MessageArenaPool::Ptr pool = MessageArenaPool::create();
+
+        size_t start = allocations;
+        for (size_t i = 0; i < requests; ++i)
+            handleRequest(
+                    data,
+                    [] { return std::make_shared<CompanEdgeProtocol::ServerMessage>(); },
+                    [] { return std::make_shared<CompanEdgeProtocol::ClientMessage>(); });
+        size_t const heap = (allocations - start) / requests;
+
+        start = allocations;
+        for (size_t i = 0; i < requests; ++i)
+            handleRequest(
+                    data,
+                    [&pool] { return pool->make<CompanEdgeProtocol::ServerMessage>(); },
+                    [&pool] { return pool->make<CompanEdgeProtocol::ClientMessage>(); });
+        size_t const arena = (allocations - start) / requests;
+
+        EXPECT_LT(arena, heap);
+
+        // allocations per request
+        std::cout << std::setw(8) << count << std::setw(14) << heap << std::setw(14) << arena << std::endl;
+    }
+}
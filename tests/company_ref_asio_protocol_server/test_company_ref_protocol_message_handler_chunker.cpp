@@ -0,0 +1,211 @@
+/**
+  Copyright © 2024 COMPAN REF
+  @file test_company_ref_protocol_message_handler_chunker.cpp
+  @brief Testing the chunking of a full store transfer
+*/
+
+#include "company_ref_asio_server_protocol_handler_mock.h"
+
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_chunker.h>
+
+#include <iomanip>
+#include <iostream>
+
+#include <sys/resource.h>
+
+namespace {
+
+/// Adds count text values, each holding size bytes
+void addTextValues(VariantValueStore& ws, size_t const count, size_t const size)
+{
+    for (size_t idx = 0; idx < count; ++idx) {
+        CompanEdgeProtocol::Value value;
+        value.set_id("chunk.text" + std::to_string(idx));
+        value.set_type(CompanEdgeProtocol::Text);
+        value.set_access(CompanEdgeProtocol::Value_Access_ReadWrite);
+        value.mutable_textvalue()->set_value(std::string(size, 'a'));
+        ws.set(value);
+    }
+}
+
+/// Peak resident set size of the process, in KB
+long peakRss()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+} // namespace
+
+TEST_F(ServerProtocolHandlerTest, Chunker_MaxValues)
+{
+    addTextValues(ws_, 10, 8);
+    run();
+
+    VariantValueChunker chunker(ws_, 4);
+    chunker.insertStore();
+    EXPECT_EQ(chunker.remaining(), ws_.size());
+
+    CompanEdgeProtocol::VsResult result;
+
+    EXPECT_TRUE(chunker.fill(result.mutable_values()));
+    EXPECT_EQ(result.values_size(), 4);
+    EXPECT_EQ(chunker.remaining(), ws_.size() - 4);
+
+    result.Clear();
+    EXPECT_TRUE(chunker.fill(result.mutable_values()));
+    EXPECT_EQ(result.values_size(), 4);
+
+    // the last chunk holds what's left
+    result.Clear();
+    EXPECT_FALSE(chunker.fill(result.mutable_values()));
+    EXPECT_EQ(result.values_size(), static_cast<int>(ws_.size() - 8));
+    EXPECT_TRUE(chunker.empty());
+    EXPECT_EQ(chunker.remaining(), 0u);
+}
+
+TEST_F(ServerProtocolHandlerTest, Chunker_MaxBytes)
+{
+    addTextValues(ws_, 4, 100);
+    run();
+
+    // the limit is reached by the second value
+    VariantValueChunker chunker(ws_, 100, 150);
+    chunker.insertStore();
+
+    CompanEdgeProtocol::VsResult result;
+
+    EXPECT_TRUE(chunker.fill(result.mutable_values()));
+    EXPECT_EQ(result.values_size(), 2);
+
+    result.Clear();
+    EXPECT_FALSE(chunker.fill(result.mutable_values()));
+    EXPECT_EQ(result.values_size(), 2);
+}
+
+TEST_F(ServerProtocolHandlerTest, Chunker_MaxBytesSingleValue)
+{
+    addTextValues(ws_, 2, 100);
+    run();
+
+    // a value larger than the limit still gets it's own chunk
+    VariantValueChunker chunker(ws_, 100, 10);
+    chunker.insertStore();
+
+    CompanEdgeProtocol::VsResult result;
+
+    EXPECT_TRUE(chunker.fill(result.mutable_values()));
+    EXPECT_EQ(result.values_size(), 1);
+
+    result.Clear();
+    EXPECT_FALSE(chunker.fill(result.mutable_values()));
+    EXPECT_EQ(result.values_size(), 1);
+}
+
+TEST_F(ServerProtocolHandlerTest, Chunker_Empty)
+{
+    VariantValueChunker chunker(ws_);
+    EXPECT_TRUE(chunker.empty());
+
+    // nothing inserted, nothing filled
+    chunker.insert(nullptr);
+    chunker.insertChildren(nullptr);
+    EXPECT_TRUE(chunker.empty());
+
+    CompanEdgeProtocol::VsResult result;
+    EXPECT_FALSE(chunker.fill(result.mutable_values()));
+    EXPECT_EQ(result.values_size(), 0);
+}
+
+TEST_F(ServerProtocolHandlerTest, Chunker_SkipRemoved)
+{
+    addTextValues(ws_, 4, 8);
+    run();
+
+    VariantValueChunker chunker(ws_, 2);
+    chunker.insert(ws_.get("chunk.text0"));
+    chunker.insert(ws_.get("chunk.text1"));
+    chunker.insert(ws_.get("chunk.text2"));
+    chunker.insert(ws_.get("chunk.text3"));
+
+    // removed while waiting for it's chunk
+    EXPECT_TRUE(ws_.del("chunk.text1"));
+    run();
+
+    CompanEdgeProtocol::VsResult result;
+
+    EXPECT_TRUE(chunker.fill(result.mutable_values()));
+    ASSERT_EQ(result.values_size(), 2);
+    EXPECT_EQ(result.values(0).id(), "chunk.text0");
+    EXPECT_EQ(result.values(1).id(), "chunk.text2");
+
+    result.Clear();
+    EXPECT_FALSE(chunker.fill(result.mutable_values()));
+    ASSERT_EQ(result.values_size(), 1);
+    EXPECT_EQ(result.values(0).id(), "chunk.text3");
+}
+
+/*!
+ * Peak resident memory of a full store response encoded as a single
+ * message, against the same store encoded in default sized chunks;
+ * the chunked transfer runs first, as the peak only ever grows
+ *
+ * A benchmark, run with --gtest_also_run_disabled_tests
+ * --gtest_filter=ServerProtocolHandlerTest.DISABLED_Chunker_PeakRss
+ */
+TEST_F(ServerProtocolHandlerTest, DISABLED_Chunker_PeakRss)
+{
+    size_t const Values(200000);
+    size_t const Size(256);
+
+    addTextValues(ws_, Values, Size);
+    run();
+
+    long const startRss(peakRss());
+
+    size_t chunks(0);
+    size_t chunkedBytes(0);
+    {
+        VariantValueChunker chunker(ws_);
+        chunker.insertStore();
+
+        CompanEdgeProtocol::ClientMessage msg;
+        std::string payload;
+
+        bool more(true);
+        while (more) {
+            msg.Clear();
+            more = chunker.fill(msg.mutable_vsresult()->mutable_values());
+            ASSERT_TRUE(msg.SerializeToString(&payload));
+
+            chunkedBytes += payload.size();
+            ++chunks;
+        }
+    }
+
+    long const chunkedRss(peakRss());
+
+    size_t singleBytes(0);
+    {
+        CompanEdgeProtocol::ClientMessage msg;
+        ws_.visitValues([&msg](VariantValue::Ptr const& valuePtr) {
+            *msg.mutable_vsresult()->add_values() = valuePtr->get();
+        });
+
+        std::string payload;
+        ASSERT_TRUE(msg.SerializeToString(&payload));
+        singleBytes = payload.size();
+    }
+
+    long const singleRss(peakRss());
+
+    EXPECT_GT(chunks, 1u);
+
+    std::cout << std::setw(10) << "transfer" << std::setw(10) << "messages" << std::setw(14) << "bytes"
+              << std::setw(14) << "peak KB" << std::endl;
+    std::cout << std::setw(10) << "chunked" << std::setw(10) << chunks << std::setw(14) << chunkedBytes
+              << std::setw(14) << chunkedRss - startRss << std::endl;
+    std::cout << std::setw(10) << "single" << std::setw(10) << 1 << std::setw(14) << singleBytes << std::setw(14)
+              << singleRss - startRss << std::endl;
+}
@@ -0,0 +1,249 @@
+/**
+  Copyright © 2024 COMPAN REF
+  @file test_company_ref_protocol_message_handler_compression.cpp
+  @brief Testing the compression of large frames
+*/
+
+#include "company_ref_asio_server_protocol_handler_mock.h"
+
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_client_frame.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_client_frame_compressor.h>
+
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+namespace {
+/// A VsResult of every value in the store, repeated to get a large frame
+ClientMessageFrame::ClientMessagePtr makeLargeResult(VariantValueStore& ws, size_t const repeat)
+{
+    ClientMessageFrame::ClientMessagePtr msgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+    CompanEdgeProtocol::VsResult* result = msgPtr->mutable_vsresult();
+
+    for (size_t i = 0; i < repeat; ++i)
+        ws.visitValues([result](VariantValue::Ptr const& valuePtr) { *result->add_values() = valuePtr->get(); });
+
+    return msgPtr;
+}
+} // namespace
+
+TEST_F(ServerProtocolHandlerTest, Compression_Train)
+{
+    populateValueStore();
+
+    ClientFrameCompressor::Ptr compressor = ClientFrameCompressor::train(ws_);
+    ASSERT_TRUE(compressor);
+
+    EXPECT_FALSE(compressor->dictionary().empty());
+    EXPECT_LE(compressor->dictionary().size(), ClientFrameCompressor::MaxDictionarySize);
+    EXPECT_EQ(compressor->minSize(), ClientFrameCompressor::DefaultMinSize);
+
+    // the shared prefix of the test ids
+    std::string const prefix(textId_.substr(0, textId_.find('.') + 1));
+    EXPECT_NE(compressor->dictionary().find(prefix), std::string::npos);
+
+    // shared by every connection
+    EXPECT_EQ(ws_.frameCompressor(), ws_.frameCompressor());
+}
+
+TEST_F(ServerProtocolHandlerTest, Compression_Retrain)
+{
+    // untrained until the store is loaded
+    ClientFrameCompressor::Ptr untrained = ws_.frameCompressor();
+    ASSERT_TRUE(untrained);
+    EXPECT_TRUE(untrained->dictionary().empty());
+
+    populateValueStore();
+    EXPECT_EQ(ws_.frameCompressor(), untrained);
+
+    ws_.trainFrameCompressor();
+
+    ClientFrameCompressor::Ptr trained = ws_.frameCompressor();
+    ASSERT_TRUE(trained);
+    EXPECT_NE(trained, untrained);
+    EXPECT_FALSE(trained->dictionary().empty());
+
+    // a negotiated compressor is kept as the store retrains
+    EXPECT_TRUE(untrained->dictionary().empty());
+
+    ws_.trainFrameCompressor();
+    EXPECT_NE(ws_.frameCompressor(), trained);
+    EXPECT_EQ(ws_.frameCompressor()->dictionary(), trained->dictionary());
+}
+
+TEST_F(ServerProtocolHandlerTest, Compression_RoundTrip)
+{
+    populateValueStore();
+
+    ClientFrameCompressor::Ptr compressor = ClientFrameCompressor::train(ws_);
+
+    std::string payload;
+    ASSERT_TRUE(makeLargeResult(ws_, 16)->SerializeToString(&payload));
+
+    std::string compressed;
+    ASSERT_TRUE(compressor->compress(payload, compressed));
+    EXPECT_LT(compressed.size(), payload.size());
+
+    std::string decompressed;
+    ASSERT_TRUE(compressor->decompress(compressed, payload.size(), decompressed));
+    EXPECT_EQ(decompressed, payload);
+
+    // the wrong size fails
+    EXPECT_FALSE(compressor->decompress(compressed, payload.size() + 1, decompressed));
+
+    // a corrupt size doesn't allocate
+    EXPECT_FALSE(compressor->decompress(compressed, std::numeric_limits<uint32_t>::max(), decompressed));
+}
+
+TEST_F(ServerProtocolHandlerTest, Compression_Expand)
+{
+    populateValueStore();
+
+    ClientFrameCompressor::Ptr compressor = ClientFrameCompressor::train(ws_);
+    ClientFrameCompressor::Ptr decompressor = std::make_shared<ClientFrameCompressor>(compressor->dictionary());
+
+    ClientMessageFrame::ClientMessagePtr msgPtr = makeLargeResult(ws_, 16);
+
+    std::string payload;
+    ASSERT_TRUE(msgPtr->SerializeToString(&payload));
+
+    CompanEdgeProtocol::ClientMessage msg;
+    CompanEdgeProtocol::CompressedMessage* compressedMessage = msg.mutable_compressedmessage();
+    compressedMessage->set_codec(CompanEdgeProtocol::CompressedMessage::Deflate);
+    compressedMessage->set_size(payload.size());
+    ASSERT_TRUE(compressor->compress(payload, *compressedMessage->mutable_data()));
+
+    ASSERT_TRUE(decompressor->expand(msg));
+    EXPECT_FALSE(msg.has_compressedmessage());
+    ASSERT_TRUE(msg.has_vsresult());
+    EXPECT_EQ(msg.vsresult().values_size(), msgPtr->vsresult().values_size());
+
+    // an uncompressed message is left alone
+    EXPECT_TRUE(decompressor->expand(msg));
+    EXPECT_EQ(msg.vsresult().values_size(), msgPtr->vsresult().values_size());
+
+    // unknown codec
+    msg.Clear();
+    msg.mutable_compressedmessage()->set_codec(CompanEdgeProtocol::CompressedMessage::Uncompressed);
+    EXPECT_FALSE(decompressor->expand(msg));
+}
+
+TEST_F(ServerProtocolHandlerTest, Compression_Negotiate)
+{
+    populateValueStore();
+
+    ClientFrameCompressor::Ptr compressor = ClientFrameCompressor::train(ws_);
+
+    CompanEdgeProtocol::ServerMessage request;
+    ClientFrameCompressor::makeRequest(request);
+    request.mutable_vscompression()->set_sequenceno(7);
+    ASSERT_TRUE(request.has_vscompression());
+
+    CompanEdgeProtocol::ClientMessage msg;
+    EXPECT_EQ(ClientFrameCompressor::negotiate(compressor, request.vscompression(), msg), compressor);
+
+    ASSERT_TRUE(msg.has_vscompressionresult());
+    CompanEdgeProtocol::VsCompressionResult const& result(msg.vscompressionresult());
+    EXPECT_EQ(result.sequenceno(), 7u);
+    EXPECT_EQ(result.codec(), CompanEdgeProtocol::CompressedMessage::Deflate);
+    EXPECT_EQ(result.dictionary(), compressor->dictionary());
+    EXPECT_EQ(result.minsize(), compressor->minSize());
+
+    ClientFrameCompressor::Ptr decompressor = ClientFrameCompressor::accept(result);
+    ASSERT_TRUE(decompressor);
+    EXPECT_EQ(decompressor->dictionary(), compressor->dictionary());
+
+    // the server has no compressor
+    msg.Clear();
+    EXPECT_FALSE(ClientFrameCompressor::negotiate(nullptr, request.vscompression(), msg));
+    EXPECT_EQ(msg.vscompressionresult().codec(), CompanEdgeProtocol::CompressedMessage::Uncompressed);
+    EXPECT_FALSE(ClientFrameCompressor::accept(msg.vscompressionresult()));
+
+    // the client offers nothing the server knows
+    msg.Clear();
+    request.mutable_vscompression()->clear_codecs();
+    EXPECT_FALSE(ClientFrameCompressor::negotiate(compressor, request.vscompression(), msg));
+    EXPECT_EQ(msg.vscompressionresult().codec(), CompanEdgeProtocol::CompressedMessage::Uncompressed);
+}
+
+TEST_F(ServerProtocolHandlerTest, Compression_Frame)
+{
+    populateValueStore();
+
+    ClientFrameCompressor::Ptr compressor = ClientFrameCompressor::train(ws_);
+
+    // large frames shrink, encoded once per framing and compression
+    ClientMessageFrame large(makeLargeResult(ws_, 64));
+
+    ClientMessageFrame::BufferPtr plain = large.encoded(true);
+    ClientMessageFrame::BufferPtr compressed = large.encoded(true, compressor.get());
+    ASSERT_TRUE(plain);
+    ASSERT_TRUE(compressed);
+    EXPECT_LT(compressed->size(), plain->size());
+
+    EXPECT_EQ(large.encoded(true, compressor.get()), compressed);
+    EXPECT_EQ(large.encodeCount(), 2u);
+
+    // a retrained dictionary is encoded for itself, the previous encoding is kept for it's connections
+    ClientFrameCompressor retrained(std::string(), compressor->minSize());
+    ClientMessageFrame::BufferPtr recompressed = large.encoded(true, &retrained);
+    ASSERT_TRUE(recompressed);
+    EXPECT_NE(*recompressed, *compressed);
+    EXPECT_NE(retrained.id(), compressor->id());
+
+    ClientMessageFrame fresh(large.message());
+    EXPECT_EQ(*fresh.encoded(true, &retrained), *recompressed);
+
+    EXPECT_EQ(large.encoded(true, compressor.get()), compressed);
+    EXPECT_EQ(large.encoded(true, &retrained), recompressed);
+    EXPECT_EQ(large.encodeCount(), 3u);
+
+    // small frames aren't worth it
+    ClientMessageFrame small(ws_.get(boolId_));
+    EXPECT_EQ(*small.encoded(true, compressor.get()), *small.encoded(true));
+
+    // the result carries the dictionary and is never compressed
+    ClientMessageFrame::ClientMessagePtr resultPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+    CompanEdgeProtocol::ServerMessage request;
+    ClientFrameCompressor::makeRequest(request);
+    ClientFrameCompressor::negotiate(compressor, request.vscompression(), *resultPtr);
+
+    ClientFrameCompressor tiny(compressor->dictionary(), 1);
+    ClientMessageFrame result(resultPtr);
+    EXPECT_EQ(*result.encoded(true, &tiny), *result.encoded(true));
+}
+
+/*!
+ * Compression ratio of a full store response with and without the
+ * trained dictionary; the dictionary pays off on the smaller frames,
+ * where there is little earlier data to match against
+ *
+ * A benchmark, run with --gtest_also_run_disabled_tests
+ * --gtest_filter=ServerProtocolHandlerTest.DISABLED_Compression_Ratio
+ */
+TEST_F(ServerProtocolHandlerTest, DISABLED_Compression_Ratio)
+{
+    populateValueStore();
+
+    ClientFrameCompressor::Ptr trained = ClientFrameCompressor::train(ws_);
+    ClientFrameCompressor plain("");
+
+    std::cout << std::setw(10) << "values" << std::setw(12) << "size" << std::setw(12) << "plain" << std::setw(12)
+              << "trained" << std::endl;
+
+    for (size_t const repeat : {1, 4, 16}) {
+        std::string payload;
+        ASSERT_TRUE(makeLargeResult(ws_, repeat)->SerializeToString(&payload));
+
+        std::string plainCompressed;
+        std::string trainedCompressed;
+        ASSERT_TRUE(plain.compress(payload, plainCompressed));
+        ASSERT_TRUE(trained->compress(payload, trainedCompressed));
+
+        EXPECT_LT(trainedCompressed.size(), payload.size());
+
+        std::cout << std::setw(10) << makeLargeResult(ws_, repeat)->vsresult().values_size() << std::setw(12)
+                  << payload.size() << std::setw(12) << plainCompressed.size() << std::setw(12)
+                  << trainedCompressed.size() << std::endl;
+    }
+}
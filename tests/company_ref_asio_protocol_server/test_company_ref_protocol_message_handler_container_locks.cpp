@@ -0,0 +1,152 @@
+/**
+  Copyright © 2024 COMPAN REF
+  @file test_company_ref_protocol_message_handler_container_locks.cpp
+  @brief Testing per container locking of AddToContainer
+*/
+
+#include "company_ref_asio_server_protocol_handler_mock.h"
+
+#include <company_ref_variant_valuestore/company_ref_variant_factory.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iomanip>
+#include <thread>
+
+TEST_F(ServerProtocolHandlerTest, ContainerLocks_Siblings)
+{
+    std::chrono::milliseconds const Blocked(50);
+
+    VariantContainerLocks locks;
+
+    VariantContainerLocks::Guard container1(locks.lock(containerId1_));
+
+    // a sibling container doesn't wait
+    auto sibling = std::async(std::launch::async, [&locks, this] { locks.lock(containerId2_); });
+    EXPECT_EQ(sibling.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+
+    // neither does the same container in another parent
+    auto other = std::async(std::launch::async, [&locks] { locks.lock(ValueId("x.y.container1")); });
+    EXPECT_EQ(other.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+
+    // the same container, or it's parent, waits for the change to complete
+    auto same = std::async(std::launch::async, [&locks, this] { locks.lock(containerId1_); });
+    auto parent = std::async(std::launch::async, [&locks, this] { locks.lock(structId_); });
+
+    EXPECT_EQ(same.wait_for(Blocked), std::future_status::timeout);
+    EXPECT_EQ(parent.wait_for(Blocked), std::future_status::timeout);
+
+    {
+        VariantContainerLocks::Guard released(std::move(container1));
+    }
+
+    EXPECT_EQ(same.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(parent.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+}
+
+TEST_F(ServerProtocolHandlerTest, ContainerLocks_SingleStripe)
+{
+    VariantContainerLocks locks(1);
+    EXPECT_EQ(locks.stripes(), 1u);
+
+    // a container and it's parents sharing the stripe is locked once
+    VariantContainerLocks::Guard guard(locks.lock(containerId1_));
+
+    auto sibling = std::async(std::launch::async, [&locks, this] { locks.lock(containerId2_); });
+    EXPECT_EQ(sibling.wait_for(std::chrono::milliseconds(50)), std::future_status::timeout);
+
+    {
+        VariantContainerLocks::Guard released(std::move(guard));
+    }
+
+    EXPECT_EQ(sibling.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+}
+
+/*!
+ * Provisioning benchmark
+ *
+ * Every client adds elements to it's own container from it's own thread.
+ * A single stripe behaves like the former global mutex.
+ *
+ * A benchmark, run with --gtest_also_run_disabled_tests
+ * --gtest_filter=ServerProtocolHandlerTest.DISABLED_ContainerLocks_ProvisioningScaling
+ */
+TEST_F(ServerProtocolHandlerTest, DISABLED_ContainerLocks_ProvisioningScaling)
+{
+    size_t const Adds(64);
+
+    for (size_t stripes : {size_t(1), VariantContainerLocks::DefaultStripes}) {
+        for (size_t clients : {1, 4, 16}) {
+            VariantContainerLocks locks(stripes);
+
+            std::string const prefix("bench.s" + std::to_string(stripes) + "c" + std::to_string(clients));
+
+            std::vector<CompanEdgeProtocol::Value> containers;
+            std::vector<ServerProtocolHandler::Ptr> handlers;
+            std::atomic<size_t> responses(0);
+
+            for (size_t client = 0; client < clients; ++client) {
+                CompanEdgeProtocol::Value container;
+                container.set_id(prefix + ".container" + std::to_string(client));
+                container.set_type(CompanEdgeProtocol::Container);
+                container.set_access(CompanEdgeProtocol::Value_Access_ReadWrite);
+
+                CompanEdgeProtocol::Value meta;
+                meta.set_id(container.id() + ".+.text");
+                meta.set_type(CompanEdgeProtocol::Text);
+                meta.set_access(CompanEdgeProtocol::Value_Access_ReadWrite);
+                meta.mutable_textvalue()->set_value("provisioned");
+
+                ws_.add(VariantFactory::make(strand_, container));
+                ASSERT_TRUE(dmo_.insertValue(container));
+                ASSERT_TRUE(dmo_.insertMetaData(ValueId(meta.id()), meta));
+
+                containers.push_back(container);
+
+                ServerProtocolHandler::Ptr handler =
+                        std::make_shared<ServerProtocolHandler>(ws_, dmo_, locks, client + 1);
+                handler->connectSendCallback([&responses](ClientMessagePtr) { ++responses; });
+                handlers.push_back(handler);
+            }
+            run();
+
+            auto start = std::chrono::steady_clock::now();
+
+            std::vector<std::thread> threads;
+            for (size_t client = 0; client < clients; ++client) {
+                threads.emplace_back([&containers, &handlers, client] {
+                    for (size_t key = 0; key < Adds; ++key) {
+                        CompanEdgeProtocol::Value addToValue(containers[client]);
+                        addToValue.mutable_addtocontainer()->set_key(std::to_string(key));
+
+                        CompanEdgeProtocol::ServerMessage reqMsg;
+                        *reqMsg.mutable_valuechanged()->add_value() = addToValue;
+
+                        handlers[client]->doMessage(reqMsg);
+                    }
+                });
+            }
+            for (auto& thread : threads) thread.join();
+
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            run();
+
+            for (auto const& container : containers) {
+                EXPECT_TRUE(ws_.get(ValueId(container.id(), std::to_string(Adds - 1))));
+                EXPECT_TRUE(ws_.get(ValueId(ValueId(container.id(), "0"), "text")));
+            }
+            EXPECT_GE(responses, clients * Adds);
+
+            std::cout << "stripes:" << std::setw(4) << stripes << " clients:" << std::setw(3) << clients
+                      << " adds/s:" << std::setw(9)
+                      << (clients * Adds * 1000000)
+                                 / std::max<int64_t>(
+                                         1, std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count())
+                      << std::endl;
+
+            for (auto& handler : handlers) handler->disconnect();
+            run();
+        }
+    }
+}
@@ -0,0 +1,99 @@
+/**
+  Copyright © 2024 COMPAN REF
+  @file test_company_ref_protocol_message_handler_message_arena.cpp
+  @brief Testing the arena backed request and response messages
+*/
+
+#include "company_ref_asio_server_protocol_handler_mock.h"
+
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_message_arena.h>
+
+TEST_F(ServerProtocolHandlerTest, MessageArena_Reuse)
+{
+    MessageArenaPool::Ptr pool = MessageArenaPool::create();
+
+    {
+        std::shared_ptr<CompanEdgeProtocol::ServerMessage> msgPtr = pool->make<CompanEdgeProtocol::ServerMessage>();
+        EXPECT_NE(msgPtr->GetArena(), nullptr);
+
+        msgPtr->mutable_vsgetvalue()->set_id(textId_);
+    }
+
+    MessageArenaPool::Stats stats = pool->stats();
+    EXPECT_EQ(stats.created, 1u);
+    EXPECT_EQ(stats.reused, 0u);
+    EXPECT_EQ(stats.idle, 1u);
+
+    // the arena comes back empty
+    std::shared_ptr<CompanEdgeProtocol::ClientMessage> msgPtr = pool->make<CompanEdgeProtocol::ClientMessage>();
+    EXPECT_FALSE(msgPtr->has_vsresult());
+
+    stats = pool->stats();
+    EXPECT_EQ(stats.created, 1u);
+    EXPECT_EQ(stats.reused, 1u);
+    EXPECT_EQ(stats.idle, 0u);
+}
+
+TEST_F(ServerProtocolHandlerTest, MessageArena_MaxIdle)
+{
+    MessageArenaPool::Ptr pool = MessageArenaPool::create(2);
+
+    {
+        std::vector<std::shared_ptr<CompanEdgeProtocol::ClientMessage>> held;
+        for (int i = 0; i < 4; ++i) held.push_back(pool->make<CompanEdgeProtocol::ClientMessage>());
+
+        EXPECT_EQ(pool->stats().created, 4u);
+    }
+
+    EXPECT_EQ(pool->stats().idle, 2u);
+}
+
+TEST_F(ServerProtocolHandlerTest, MessageArena_BlockSize)
+{
+    MessageArenaPool::Ptr pool = MessageArenaPool::create();
+
+    {
+        std::shared_ptr<CompanEdgeProtocol::ClientMessage> msgPtr = pool->make<CompanEdgeProtocol::ClientMessage>();
+        msgPtr->mutable_vsresult()->set_sequenceno(1);
+
+        // a small message fits the first block
+        EXPECT_EQ(msgPtr->GetArena()->SpaceAllocated(), MessageArenaPool::DefaultBlockSize);
+
+        // a large one grows the arena
+        for (int i = 0; i < 256; ++i) msgPtr->mutable_vsresult()->add_values()->set_id(textId_);
+        EXPECT_GT(msgPtr->GetArena()->SpaceAllocated(), MessageArenaPool::DefaultBlockSize);
+    }
+
+    // only the first block is kept in the pool
+    std::shared_ptr<CompanEdgeProtocol::ClientMessage> msgPtr = pool->make<CompanEdgeProtocol::ClientMessage>();
+    EXPECT_EQ(pool->stats().reused, 1u);
+    EXPECT_EQ(msgPtr->GetArena()->SpaceAllocated(), MessageArenaPool::DefaultBlockSize);
+}
+
+TEST_F(ServerProtocolHandlerTest, MessageArena_OutlivesPool)
+{
+    MessageArenaPool::Ptr pool = MessageArenaPool::create();
+
+    std::shared_ptr<CompanEdgeProtocol::ClientMessage> msgPtr = pool->make<CompanEdgeProtocol::ClientMessage>();
+    msgPtr->mutable_vsresult()->set_sequenceno(1);
+
+    pool.reset();
+
+    // a queued response keeps it's arena
+    EXPECT_EQ(msgPtr->vsresult().sequenceno(), 1u);
+}
+
+TEST_F(ServerProtocolHandlerTest, MessageArena_HandlerResponse)
+{
+    populateValueStore();
+
+    CompanEdgeProtocol::ServerMessage reqMsg;
+    reqMsg.mutable_vsgetvalue()->set_id(textId_);
+
+    handler_->doMessage(reqMsg);
+    queueGet();
+
+    ASSERT_TRUE(lastMsgPtr_);
+    EXPECT_NE(lastMsgPtr_->GetArena(), nullptr);
+    EXPECT_GE(handler_->arenas()->stats().created, 1u);
+}
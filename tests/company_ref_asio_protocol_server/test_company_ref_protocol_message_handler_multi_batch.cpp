@@ -0,0 +1,181 @@
+/**
+  Copyright © 2024 COMPAN REF
+  @file test_company_ref_protocol_message_handler_multi_batch.cpp
+  @brief Testing the batched VsMultiGet and VsMultiSet
+*/
+
+#include "company_ref_asio_server_protocol_handler_mock.h"
+
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_batch.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+/// Id of the i'th batch test value
+std::string batchId(size_t const i)
+{
+    return "test.batch.value" + std::to_string(i);
+}
+
+/// Adds count Text values to the store
+void addBatchValues(boost::asio::io_context::strand& strand, VariantValueStore& ws, size_t const count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        VariantValue::Ptr valuePtr = std::make_shared<VariantValue>(strand, batchId(i), CompanEdgeProtocol::Text);
+        ws.add(valuePtr);
+        valuePtr->set(std::to_string(i));
+    }
+}
+
+/// Microseconds taken by fn, best of a few runs
+template <typename Function>
+double bestOf(size_t const runs, Function fn)
+{
+    double best = 0;
+    for (size_t i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        double const elapsed =
+                std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        if (i == 0 || elapsed < best) best = elapsed;
+    }
+
+    return best;
+}
+} // namespace
+
+TEST_F(ServerProtocolHandlerTest, MultiBatch_GetOrder)
+{
+    // spans several chunks
+    size_t const count(VariantValueBatch::MaxChunk * 2 + 3);
+    addBatchValues(strand_, ws_, count);
+
+    CompanEdgeProtocol::VsMultiGet msg;
+    msg.set_sequenceno(3);
+    for (size_t i = 0; i < count; ++i) {
+        msg.add_ids(batchId(i));
+        if (i == VariantValueBatch::MaxChunk) msg.add_ids("test.batch.missing");
+    }
+
+    CompanEdgeProtocol::VsMultiGetResult result;
+    VariantValueBatch::multiGet(ws_, msg, result);
+
+    EXPECT_EQ(result.sequenceno(), 3u);
+    ASSERT_EQ(result.results_size(), static_cast<int>(count + 1));
+
+    for (int i = 0, value = 0; i < result.results_size(); ++i) {
+        if (i == static_cast<int>(VariantValueBatch::MaxChunk) + 1) {
+            EXPECT_EQ(result.results(i).error(), CompanEdgeProtocol::VsMultiGetResult::ValueNotFound);
+            continue;
+        }
+
+        ASSERT_EQ(result.results(i).error(), CompanEdgeProtocol::VsMultiGetResult::Success);
+        ASSERT_EQ(result.results(i).values_size(), 1);
+        EXPECT_EQ(result.results(i).values(0).id(), batchId(value));
+        EXPECT_EQ(result.results(i).values(0).stringvalue(), std::to_string(value));
+        ++value;
+    }
+}
+
+TEST_F(ServerProtocolHandlerTest, MultiBatch_SetOrder)
+{
+    size_t const count(VariantValueBatch::MaxChunk + 1);
+    addBatchValues(strand_, ws_, count);
+    populateValueStore();
+
+    ValueIdListener listener(batchId(count - 1));
+    ws_.get(batchId(count - 1))
+            ->connectChangedListener(std::bind(&ValueIdListener::doNotification, &listener, std::placeholders::_1));
+
+    CompanEdgeProtocol::VsMultiSet msg;
+    msg.set_sequenceno(5);
+    for (size_t i = 0; i < count; ++i) {
+        CompanEdgeProtocol::VsMultiSet::Value* value = msg.add_values();
+        value->set_id(batchId(i));
+        value->set_value("set" + std::to_string(i));
+    }
+
+    // a value that fails to convert fails on it's own
+    CompanEdgeProtocol::VsMultiSet::Value* value = msg.add_values();
+    value->set_id(rangedId_);
+    value->set_value("-");
+
+    // the later set of the same value wins
+    value = msg.add_values();
+    value->set_id(batchId(0));
+    value->set_value("again");
+
+    CompanEdgeProtocol::VsMultiSetResult result;
+    VariantValueBatch::multiSet(ws_, msg, result);
+
+    EXPECT_EQ(result.sequenceno(), 5u);
+    ASSERT_EQ(result.results_size(), static_cast<int>(count + 2));
+
+    for (size_t i = 0; i < count; ++i) {
+        EXPECT_EQ(result.results(i).id(), batchId(i));
+        EXPECT_EQ(result.results(i).error(), CompanEdgeProtocol::VsMultiSetResult::Success);
+    }
+
+    EXPECT_EQ(result.results(count).error(), CompanEdgeProtocol::VsMultiSetResult::UnknownError);
+    EXPECT_EQ(result.results(count + 1).error(), CompanEdgeProtocol::VsMultiSetResult::Success);
+
+    EXPECT_EQ(ws_.get(batchId(0))->get().stringvalue(), "again");
+    EXPECT_EQ(ws_.get(batchId(count - 1))->get().stringvalue(), "set" + std::to_string(count - 1));
+
+    // the listener expects a single change
+    run();
+}
+
+/*!
+ * Latency of a VsMultiGet and a VsMultiSet answered a value at a
+ * time, as before, and batched
+ *
+ * A benchmark, run with --gtest_also_run_disabled_tests
+ * --gtest_filter=ServerProtocolHandlerTest.DISABLED_MultiBatch_Latency
+ */
+TEST_F(ServerProtocolHandlerTest, DISABLED_MultiBatch_Latency)
+{
+    size_t const maxCount(10000);
+    addBatchValues(strand_, ws_, maxCount);
+
+    std::cout << std::setw(8) << "values" << std::setw(14) << "get (us)" << std::setw(14) << "batched"
+              << std::setw(14) << "set (us)" << std::setw(14) << "batched" << std::endl;
+
+    for (size_t const count : {10, 1000, 10000}) {
+        CompanEdgeProtocol::VsMultiGet getMsg;
+        CompanEdgeProtocol::VsMultiSet setMsg;
+        for (size_t i = 0; i < count; ++i) {
+            getMsg.add_ids(batchId(i));
+
+            CompanEdgeProtocol::VsMultiSet::Value* value = setMsg.add_values();
+            value->set_id(batchId(i));
+            value->set_value("latency");
+        }
+
+        double const getEach = bestOf(3, [&] {
+            CompanEdgeProtocol::VsMultiGetResult result;
+            for (auto const& id : getMsg.ids()) *result.add_results()->add_values() = ws_.get(id)->get();
+        });
+
+        double const getBatched = bestOf(3, [&] {
+            CompanEdgeProtocol::VsMultiGetResult result;
+            VariantValueBatch::multiGet(ws_, getMsg, result);
+        });
+
+        double const setEach = bestOf(3, [&] {
+            for (auto const& value : setMsg.values()) ws_.get(value.id())->set(value.value());
+        });
+
+        double const setBatched = bestOf(3, [&] {
+            CompanEdgeProtocol::VsMultiSetResult result;
+            VariantValueBatch::multiSet(ws_, setMsg, result);
+        });
+
+        std::cout << std::setw(8) << count << std::fixed << std::setprecision(0) << std::setw(14) << getEach
+                  << std::setw(14) << getBatched << std::setw(14) << setEach << std::setw(14) << setBatched
+                  << std::endl;
+    }
+}
@@ -0,0 +1,215 @@
+/**
+  Copyright © 2024 COMPAN REF
+  @file test_company_ref_protocol_message_handler_outbound_queue.cpp
+  @brief Testing the bounded outbound queue of a connection
+*/
+
+#include "company_ref_asio_server_protocol_handler_mock.h"
+
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_client_frame_queue.h>
+
+#include <algorithm>
+
+namespace {
+ClientMessageFrame::Ptr makeResult()
+{
+    ClientMessagePtr msgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+    msgPtr->mutable_vsresult()->set_status(CompanEdgeProtocol::VsResult_Status_success);
+
+    return std::make_shared<ClientMessageFrame>(msgPtr);
+}
+} // namespace
+
+TEST_F(ServerProtocolHandlerTest, OutboundQueue_BelowLimit)
+{
+    populateValueStore();
+
+    ClientFrameQueue queue({4, 8});
+
+    ClientMessageFrame::Ptr first = std::make_shared<ClientMessageFrame>(ws_.get(textId_));
+    ClientMessageFrame::Ptr second = std::make_shared<ClientMessageFrame>(ws_.get(textId_));
+
+    // not conflated until the limit is reached
+    EXPECT_EQ(queue.push(first), ClientFrameQueue::Queued);
+    EXPECT_EQ(queue.push(second), ClientFrameQueue::Queued);
+    EXPECT_EQ(queue.size(), 2u);
+
+    EXPECT_EQ(queue.pop(), first);
+    EXPECT_EQ(queue.pop(), second);
+    EXPECT_EQ(queue.pop(), nullptr);
+
+    ClientFrameQueue::Stats stats = queue.stats();
+    EXPECT_EQ(stats.queued, 2u);
+    EXPECT_EQ(stats.written, 2u);
+    EXPECT_EQ(stats.conflated, 0u);
+    EXPECT_EQ(stats.highWater, 2u);
+    EXPECT_EQ(stats.pending, 0u);
+}
+
+TEST_F(ServerProtocolHandlerTest, OutboundQueue_LatestValueWins)
+{
+    populateValueStore();
+
+    ClientFrameQueue queue({2, 8});
+
+    ClientMessageFrame::Ptr text = std::make_shared<ClientMessageFrame>(ws_.get(textId_));
+    ClientMessageFrame::Ptr boolean = std::make_shared<ClientMessageFrame>(ws_.get(boolId_));
+    ClientMessageFrame::Ptr latest = std::make_shared<ClientMessageFrame>(ws_.get(textId_));
+
+    EXPECT_EQ(queue.push(text), ClientFrameQueue::Queued);
+    EXPECT_EQ(queue.push(boolean), ClientFrameQueue::Queued);
+
+    // replaces the pending change, keeping it's place in the queue
+    EXPECT_EQ(queue.push(latest), ClientFrameQueue::Conflated);
+    EXPECT_EQ(queue.size(), 2u);
+    EXPECT_EQ(queue.stats().conflated, 1u);
+
+    EXPECT_EQ(queue.pop(), latest);
+
+    // the written change can't be conflated any more
+    ClientMessageFrame::Ptr next = std::make_shared<ClientMessageFrame>(ws_.get(textId_));
+    EXPECT_EQ(queue.push(next), ClientFrameQueue::Queued);
+    EXPECT_EQ(queue.push(std::make_shared<ClientMessageFrame>(ws_.get(textId_))), ClientFrameQueue::Conflated);
+
+    EXPECT_EQ(queue.pop(), boolean);
+    EXPECT_EQ(queue.pop()->value(), ws_.get(textId_));
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(ServerProtocolHandlerTest, OutboundQueue_ResultsNeverConflated)
+{
+    populateValueStore();
+
+    ClientFrameQueue queue({1, 4});
+
+    ClientMessageFrame::Ptr text = std::make_shared<ClientMessageFrame>(ws_.get(textId_));
+    ClientMessageFrame::Ptr result = makeResult();
+    ClientMessageFrame::Ptr latest = std::make_shared<ClientMessageFrame>(ws_.get(textId_));
+
+    EXPECT_EQ(queue.push(text), ClientFrameQueue::Queued);
+    EXPECT_EQ(queue.push(result), ClientFrameQueue::Queued);
+    EXPECT_EQ(queue.push(makeResult()), ClientFrameQueue::Queued);
+
+    // not moved ahead of the results
+    EXPECT_EQ(queue.push(latest), ClientFrameQueue::Queued);
+
+    // full, results are refused rather than dropped
+    EXPECT_EQ(queue.push(makeResult()), ClientFrameQueue::Overflow);
+
+    // changes still conflate when full
+    EXPECT_EQ(queue.push(std::make_shared<ClientMessageFrame>(ws_.get(textId_))), ClientFrameQueue::Conflated);
+    EXPECT_EQ(queue.push(std::make_shared<ClientMessageFrame>(ws_.get(boolId_))), ClientFrameQueue::Overflow);
+
+    ClientFrameQueue::Stats stats = queue.stats();
+    EXPECT_EQ(stats.queued, 4u);
+    EXPECT_EQ(stats.conflated, 1u);
+    EXPECT_EQ(stats.overflows, 2u);
+    EXPECT_EQ(stats.pending, 4u);
+
+    EXPECT_EQ(queue.pop(), text);
+    EXPECT_EQ(queue.pop(), result);
+}
+
+TEST_F(ServerProtocolHandlerTest, OutboundQueue_ResumeConflated)
+{
+    populateValueStore();
+
+    CompanEdgeProtocol::ServerMessage reqMsg;
+    CompanEdgeProtocol::VsSubscribe* vsSubscribe = reqMsg.mutable_vssubscribe();
+    vsSubscribe->add_ids(textId_);
+    vsSubscribe->add_ids(boolId_);
+    handler_->doMessage(reqMsg);
+
+    CompanEdgeProtocol::ClientMessage rspMsg = queueGet();
+    ASSERT_TRUE(rspMsg.has_vsresult());
+
+    // the consumer is slow, the changes conflate right away
+    ClientFrameQueue queue({1, 16});
+    SignalScopedConnection frameConnection(handler_->connectSendFrameCallback(
+            [&queue](ClientMessageFrame::Ptr framePtr) { queue.push(framePtr); }));
+
+    CompanEdgeProtocol::Value boolValue(ws_.get(boolId_)->get());
+    boolValue.mutable_boolvalue()->set_value(!boolValue.boolvalue().value());
+
+    ws_.get(textId_)->set("first");
+    run();
+    uint64_t const firstVersion(ws_.get(textId_)->version());
+
+    ws_.get(boolId_)->set(boolValue);
+    run();
+    uint64_t const boolVersion(ws_.get(boolId_)->version());
+
+    ws_.get(textId_)->set("latest");
+    run();
+
+    EXPECT_EQ(queue.stats().conflated, 1u);
+
+    // the latest text takes the first one's place, and it's version
+    ClientMessageFrame::Ptr framePtr = queue.pop();
+    ASSERT_TRUE(framePtr);
+
+    CompanEdgeProtocol::ValueChanged const& valueChanged = framePtr->message()->valuechanged();
+    ASSERT_EQ(valueChanged.value_size(), 1);
+    EXPECT_EQ(valueChanged.value(0).id(), textId_);
+    EXPECT_EQ(valueChanged.value(0).textvalue().value(), "latest");
+    EXPECT_EQ(valueChanged.version(), firstVersion);
+    EXPECT_LT(valueChanged.version(), boolVersion);
+
+    // disconnected with the bool's change still pending
+    queue.clear();
+
+    reqMsg.Clear();
+    reqMsg.mutable_vsunsubscribe();
+    handler_->doMessage(reqMsg);
+    rspMsg = queueGet();
+
+    // resumed from the version received, the pending change isn't lost
+    reqMsg.Clear();
+    vsSubscribe = reqMsg.mutable_vssubscribe();
+    vsSubscribe->set_sequenceno(2);
+    vsSubscribe->add_ids(textId_);
+    vsSubscribe->add_ids(boolId_);
+    vsSubscribe->set_epoch(ws_.epoch());
+    vsSubscribe->set_version(valueChanged.version());
+    handler_->doMessage(reqMsg);
+
+    rspMsg = queueGet();
+    ASSERT_TRUE(rspMsg.has_vsresult());
+    EXPECT_TRUE(rspMsg.vsresult().delta());
+    auto const& values = rspMsg.vsresult().values();
+    EXPECT_TRUE(std::any_of(values.begin(), values.end(), [this](auto const& value) { return value.id() == boolId_; }));
+}
+
+TEST_F(ServerProtocolHandlerTest, OutboundQueue_SlowConsumer)
+{
+    populateValueStore();
+
+    ClientFrameQueue queue({4, 16});
+    size_t overflows(0);
+
+    CompanEdgeProtocol::ServerMessage reqMsg;
+    *reqMsg.mutable_vssubscribe()->add_ids() = "test";
+    handler_->doMessage(reqMsg);
+    run();
+
+    // the consumer never drains
+    handler_->connectSendFrameCallback([&queue, &overflows](ClientMessageFrame::Ptr framePtr) {
+        if (queue.push(framePtr) == ClientFrameQueue::Overflow) ++overflows;
+    });
+
+    CompanEdgeProtocol::Value boolValue(boolValue_);
+
+    for (size_t change = 0; change < 1000; ++change) {
+        boolValue.mutable_boolvalue()->set_value(change % 2 == 0);
+
+        ws_.get(textId_)->set(std::to_string(change));
+        ws_.get(boolId_)->set(boolValue);
+        run();
+    }
+
+    // bounded by the changed values, test.string, test.bool and test
+    ClientFrameQueue::Stats stats = queue.stats();
+    EXPECT_EQ(overflows, 0u);
+    EXPECT_LE(stats.highWater, 4u + 3u);
+    EXPECT_GT(stats.conflated, 0u);
+}
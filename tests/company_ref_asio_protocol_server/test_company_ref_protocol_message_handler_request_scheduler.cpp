@@ -0,0 +1,271 @@
+/**
+  Copyright © 2024 COMPAN REF
+  @file test_company_ref_protocol_message_handler_request_scheduler.cpp
+  @brief Testing the fair scheduling of requests across connections
+*/
+
+#include "company_ref_asio_server_protocol_handler_mock.h"
+
+#include <company_ref_asio_protocol_server/company_ref_asio_server_request_scheduler.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+namespace {
+/// Records the order requests are run in
+struct RunOrder {
+    ServerRequestScheduler::Task task(uint32_t const connectionId, int const request)
+    {
+        return [this, connectionId, request] { order.emplace_back(connectionId, request); };
+    }
+
+    std::vector<std::pair<uint32_t, int>> order;
+};
+} // namespace
+
+TEST_F(ServerProtocolHandlerTest, RequestScheduler_Lanes)
+{
+    CompanEdgeProtocol::ServerMessage msg;
+
+    msg.mutable_vsgetvalue()->set_id("a");
+    EXPECT_EQ(ServerRequestScheduler::lane(msg), ServerRequestScheduler::Priority);
+
+    msg.Clear();
+    msg.mutable_vssync();
+    EXPECT_EQ(ServerRequestScheduler::lane(msg), ServerRequestScheduler::Priority);
+
+    msg.Clear();
+    msg.mutable_vssetvalue();
+    EXPECT_EQ(ServerRequestScheduler::lane(msg), ServerRequestScheduler::Normal);
+
+    msg.Clear();
+    msg.mutable_vsmultiset();
+    EXPECT_EQ(ServerRequestScheduler::lane(msg), ServerRequestScheduler::Normal);
+
+    msg.Clear();
+    CompanEdgeProtocol::VsMultiGet* multiGet = msg.mutable_vsmultiget();
+    for (int i = 0; i < ServerRequestScheduler::SmallReadIds; ++i) multiGet->add_ids("a");
+    EXPECT_EQ(ServerRequestScheduler::lane(msg), ServerRequestScheduler::Priority);
+
+    multiGet->add_ids("a");
+    EXPECT_EQ(ServerRequestScheduler::lane(msg), ServerRequestScheduler::Normal);
+}
+
+TEST_F(ServerProtocolHandlerTest, RequestScheduler_DeficitRoundRobin)
+{
+    ServerRequestScheduler scheduler(ctx_, 1000);
+    RunOrder run;
+
+    // one connection floods large requests, the other sends small ones
+    for (int i = 0; i < 4; ++i) scheduler.schedule(1, ServerRequestScheduler::Normal, 1000, run.task(1, i));
+    for (int i = 0; i < 4; ++i) scheduler.schedule(2, ServerRequestScheduler::Normal, 250, run.task(2, i));
+
+    EXPECT_EQ(scheduler.pending(), 8u);
+
+    ctx_.run();
+
+    // the same share of bytes per round
+    std::vector<std::pair<uint32_t, int>> const expected(
+            {{1, 0}, {2, 0}, {2, 1}, {2, 2}, {2, 3}, {1, 1}, {1, 2}, {1, 3}});
+    EXPECT_EQ(run.order, expected);
+    EXPECT_EQ(scheduler.pending(), 0u);
+}
+
+TEST_F(ServerProtocolHandlerTest, RequestScheduler_CreditCarriesOver)
+{
+    ServerRequestScheduler scheduler(ctx_, 1000);
+    RunOrder run;
+
+    // larger than a quantum, runs once enough credit is banked
+    scheduler.schedule(1, ServerRequestScheduler::Normal, 1500, run.task(1, 0));
+    for (int i = 0; i < 3; ++i) scheduler.schedule(2, ServerRequestScheduler::Normal, 1000, run.task(2, i));
+
+    ctx_.run();
+
+    std::vector<std::pair<uint32_t, int>> const expected({{2, 0}, {1, 0}, {2, 1}, {2, 2}});
+    EXPECT_EQ(run.order, expected);
+}
+
+TEST_F(ServerProtocolHandlerTest, RequestScheduler_PriorityLane)
+{
+    ServerRequestScheduler scheduler(ctx_);
+    RunOrder run;
+
+    for (int i = 0; i < 2; ++i) scheduler.schedule(1, ServerRequestScheduler::Normal, 100, run.task(1, i));
+    scheduler.schedule(2, ServerRequestScheduler::Priority, 10, run.task(2, 0));
+    scheduler.schedule(3, ServerRequestScheduler::Priority, 10, run.task(3, 0));
+    scheduler.schedule(2, ServerRequestScheduler::Priority, 10, run.task(2, 1));
+
+    ctx_.run();
+
+    // round robin across connections ahead of the normal lane
+    std::vector<std::pair<uint32_t, int>> const expected({{2, 0}, {3, 0}, {2, 1}, {1, 0}, {1, 1}});
+    EXPECT_EQ(run.order, expected);
+
+    EXPECT_EQ(scheduler.stats(2).prioritized, 2u);
+    EXPECT_EQ(scheduler.stats(1).prioritized, 0u);
+}
+
+TEST_F(ServerProtocolHandlerTest, RequestScheduler_PriorityBurst)
+{
+    ServerRequestScheduler scheduler(ctx_);
+    RunOrder run;
+
+    scheduler.schedule(1, ServerRequestScheduler::Normal, 100, run.task(1, 0));
+    for (size_t i = 0; i < 2 * ServerRequestScheduler::PriorityBurst; ++i)
+        scheduler.schedule(2, ServerRequestScheduler::Priority, 10, run.task(2, i));
+
+    ctx_.run();
+
+    // the waiting normal request isn't starved
+    ASSERT_EQ(run.order.size(), 2 * ServerRequestScheduler::PriorityBurst + 1);
+    EXPECT_EQ(run.order[ServerRequestScheduler::PriorityBurst], std::make_pair(uint32_t(1), 0));
+}
+
+TEST_F(ServerProtocolHandlerTest, RequestScheduler_ConnectionOrder)
+{
+    ServerRequestScheduler scheduler(ctx_);
+    RunOrder run;
+
+    // a read queued behind a write of the same connection stays behind it
+    scheduler.schedule(1, ServerRequestScheduler::Normal, 100, run.task(1, 0));
+    scheduler.schedule(1, ServerRequestScheduler::Priority, 10, run.task(1, 1));
+    scheduler.schedule(2, ServerRequestScheduler::Priority, 10, run.task(2, 0));
+
+    ctx_.run();
+
+    std::vector<std::pair<uint32_t, int>> const expected({{2, 0}, {1, 0}, {1, 1}});
+    EXPECT_EQ(run.order, expected);
+}
+
+TEST_F(ServerProtocolHandlerTest, RequestScheduler_WriteBehindRead)
+{
+    ServerRequestScheduler scheduler(ctx_);
+    RunOrder run;
+
+    // more connections with a read waiting than a burst serves
+    for (uint32_t i = 0; i <= ServerRequestScheduler::PriorityBurst; ++i)
+        scheduler.schedule(10 + i, ServerRequestScheduler::Priority, 10, run.task(10 + i, 0));
+
+    // a write queued behind a read of the same connection stays behind it, when the normal lane gets its turn
+    scheduler.schedule(1, ServerRequestScheduler::Priority, 10, run.task(1, 0));
+    scheduler.schedule(1, ServerRequestScheduler::Normal, 100, run.task(1, 1));
+
+    ctx_.run();
+
+    auto position = [&run](uint32_t const connectionId, int const request) {
+        return std::find(run.order.begin(), run.order.end(), std::make_pair(connectionId, request))
+               - run.order.begin();
+    };
+
+    ASSERT_EQ(run.order.size(), ServerRequestScheduler::PriorityBurst + 3);
+    EXPECT_LT(position(1, 0), position(1, 1));
+    EXPECT_EQ(scheduler.stats(1).prioritized, 1u);
+}
+
+TEST_F(ServerProtocolHandlerTest, RequestScheduler_Remove)
+{
+    ServerRequestScheduler scheduler(ctx_);
+    RunOrder run;
+
+    for (int i = 0; i < 3; ++i) scheduler.schedule(1, ServerRequestScheduler::Normal, 100, run.task(1, i));
+    scheduler.schedule(2, ServerRequestScheduler::Priority, 10, run.task(2, 0));
+
+    scheduler.remove(1);
+    EXPECT_EQ(scheduler.pending(), 1u);
+
+    ctx_.run();
+
+    std::vector<std::pair<uint32_t, int>> const expected({{2, 0}});
+    EXPECT_EQ(run.order, expected);
+    EXPECT_EQ(scheduler.stats(1).queued, 0u);
+}
+
+TEST_F(ServerProtocolHandlerTest, RequestScheduler_Stats)
+{
+    ServerRequestScheduler scheduler(ctx_);
+    RunOrder run;
+
+    for (int i = 0; i < 3; ++i) scheduler.schedule(1, ServerRequestScheduler::Normal, 100, run.task(1, i));
+
+    ServerRequestScheduler::Stats stats = scheduler.stats(1);
+    EXPECT_EQ(stats.queued, 3u);
+    EXPECT_EQ(stats.pending, 3u);
+    EXPECT_EQ(stats.highWater, 3u);
+    EXPECT_EQ(stats.dispatched, 0u);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    ctx_.run();
+
+    stats = scheduler.stats(1);
+    EXPECT_EQ(stats.dispatched, 3u);
+    EXPECT_EQ(stats.pending, 0u);
+    EXPECT_EQ(stats.highWater, 3u);
+    EXPECT_GE(stats.maxWait, std::chrono::microseconds(2000));
+    EXPECT_GE(stats.waited, 3 * std::chrono::microseconds(2000));
+}
+
+/*!
+ * One connection floods VsMultiSet sized requests ahead of another's
+ * VsGetValue; the position of the reads shows the latency they see with
+ * a plain post to the io_context and with the scheduler.
+ *
+ * A benchmark, run with --gtest_also_run_disabled_tests
+ * --gtest_filter=ServerProtocolHandlerTest.DISABLED_RequestScheduler_Latency
+ */
+TEST_F(ServerProtocolHandlerTest, DISABLED_RequestScheduler_Latency)
+{
+    size_t const floodCount(1000);
+    size_t const floodSize(8192);
+    size_t const readCount(100);
+
+    std::cout << std::setw(12) << "dispatch" << std::setw(16) << "avg read wait" << std::setw(16)
+              << "max read wait" << std::endl;
+
+    for (bool const scheduled : {false, true}) {
+        boost::asio::io_context ctx;
+        ServerRequestScheduler scheduler(ctx);
+
+        size_t ran(0);
+        size_t readWait(0);
+        size_t readMaxWait(0);
+
+        auto flood = [&ran] {
+            ++ran;
+
+            // stands in for applying a large VsMultiSet
+            std::this_thread::sleep_for(std::chrono::microseconds(1));
+        };
+        auto read = [&ran, &readWait, &readMaxWait] {
+            readWait += ran;
+            readMaxWait = std::max(readMaxWait, ran);
+            ++ran;
+        };
+
+        for (size_t i = 0; i < floodCount; ++i) {
+            if (scheduled)
+                scheduler.schedule(1, ServerRequestScheduler::Normal, floodSize, flood);
+            else
+                boost::asio::post(ctx, flood);
+        }
+
+        for (size_t i = 0; i < readCount; ++i) {
+            if (scheduled)
+                scheduler.schedule(2, ServerRequestScheduler::Priority, 32, read);
+            else
+                boost::asio::post(ctx, read);
+        }
+
+        ctx.run();
+
+        EXPECT_EQ(ran, floodCount + readCount);
+        if (scheduled) { EXPECT_LT(readMaxWait, floodCount / 2); }
+
+        // requests run ahead of the read
+        std::cout << std::setw(12) << (scheduled ? "scheduler" : "post") << std::setw(16) << (readWait / readCount)
+                  << std::setw(16) << readMaxWait << std::endl;
+    }
+}
@@ -152,3 +152,187 @@ TEST_F(ServerProtocolHandlerTest, VsSubscribe_DiscreteChildren)
     Validate_VsResultOffset(rspMsg, containerId1_, 1);
     Validate_VsResultOffset(rspMsg, containerId2_, 2);
 }
+
+TEST_F(ServerProtocolHandlerTest, VsSubscribe_GlobalChunked)
+{
+    CompanEdgeProtocol::ServerMessage reqMsg;
+    CompanEdgeProtocol::ClientMessage rspMsg;
+
+    populateValueStore();
+
+    handler_->setChunkLimits(4, 0);
+
+    reqMsg.mutable_vssubscribe()->set_sequenceno(42);
+    handler_->doMessage(reqMsg);
+
+    int received(0);
+    while (true) {
+        rspMsg = queueGet();
+
+        ASSERT_TRUE(rspMsg.has_vsresult());
+        EXPECT_EQ(rspMsg.vsresult().sequenceno(), 42u);
+        EXPECT_EQ(rspMsg.vsresult().status(), CompanEdgeProtocol::VsResult_Status_success);
+        EXPECT_LE(rspMsg.vsresult().values_size(), 4);
+        received += rspMsg.vsresult().values_size();
+
+        if (!rspMsg.vsresult().more()) break;
+
+        EXPECT_TRUE(msgQueue_.empty());
+        handler_->onMessageDrained(lastMsgPtr_);
+    }
+
+    EXPECT_EQ(received, static_cast<int>(ws_.size()));
+
+    // subscription is active once streamed
+    {
+        VariantValue::Ptr valuePtr = ws_.get(textId_);
+        valuePtr->set("something");
+    }
+    rspMsg = queueGet();
+    Validate_ValueChangedSingle(rspMsg, textId_);
+
+    rspMsg = queueGet();
+    Validate_ValueChangedSingle(rspMsg, "test");
+}
+
+TEST_F(ServerProtocolHandlerTest, VsSubscribe_Resume)
+{
+    CompanEdgeProtocol::ClientMessage rspMsg;
+    CompanEdgeProtocol::ServerMessage reqMsg;
+
+    populateValueStore();
+
+    CompanEdgeProtocol::VsSubscribe* vsSubscribe = reqMsg.mutable_vssubscribe();
+    vsSubscribe->add_ids(textId_);
+    vsSubscribe->add_ids(enumId_);
+    vsSubscribe->add_ids(rangedId_);
+    handler_->doMessage(reqMsg);
+
+    rspMsg = queueGet();
+    ASSERT_TRUE(rspMsg.has_vsresult());
+    EXPECT_EQ(rspMsg.vsresult().values_size(), 3);
+    EXPECT_EQ(rspMsg.vsresult().epoch(), ws_.epoch());
+    EXPECT_FALSE(rspMsg.vsresult().delta());
+
+    // the client is current to this version
+    uint64_t const version(rspMsg.vsresult().version());
+
+    // the connection is lost, values change meanwhile
+    reqMsg.Clear();
+    reqMsg.mutable_vsunsubscribe();
+    handler_->doMessage(reqMsg);
+    rspMsg = queueGet();
+
+    ws_.get(enumId_)->set("Maybe");
+    EXPECT_TRUE(ws_.del(rangedId_));
+
+    run();
+    EXPECT_TRUE(msgQueue_.empty());
+
+    // resumed, only the changed value is sent
+    reqMsg.Clear();
+    vsSubscribe = reqMsg.mutable_vssubscribe();
+    vsSubscribe->set_sequenceno(2);
+    vsSubscribe->add_ids(textId_);
+    vsSubscribe->add_ids(enumId_);
+    vsSubscribe->add_ids(rangedId_);
+    vsSubscribe->set_epoch(ws_.epoch());
+    vsSubscribe->set_version(version);
+    handler_->doMessage(reqMsg);
+
+    rspMsg = queueGet();
+    ASSERT_TRUE(rspMsg.has_vsresult());
+    EXPECT_EQ(rspMsg.vsresult().sequenceno(), 2u);
+    EXPECT_EQ(rspMsg.vsresult().status(), CompanEdgeProtocol::VsResult_Status_success);
+    EXPECT_TRUE(rspMsg.vsresult().delta());
+    EXPECT_GT(rspMsg.vsresult().version(), version);
+    ASSERT_EQ(rspMsg.vsresult().values_size(), 1);
+    EXPECT_EQ(rspMsg.vsresult().values(0).id(), enumId_);
+
+    // the removed value isn't found
+    rspMsg = queueGet();
+    ASSERT_TRUE(rspMsg.has_vsresult());
+    EXPECT_EQ(rspMsg.vsresult().status(), CompanEdgeProtocol::VsResult_Status_error_not_found);
+    ASSERT_EQ(rspMsg.vsresult().values_size(), 1);
+    EXPECT_EQ(rspMsg.vsresult().values(0).id(), rangedId_);
+
+    // and the subscription is active again
+    ws_.get(textId_)->set("something");
+
+    rspMsg = queueGet();
+    Validate_ValueChangedSingle(rspMsg, textId_);
+}
+
+TEST_F(ServerProtocolHandlerTest, VsSubscribe_ResumeResync)
+{
+    CompanEdgeProtocol::ClientMessage rspMsg;
+    CompanEdgeProtocol::ServerMessage reqMsg;
+
+    populateValueStore();
+
+    // the epoch of a previous server
+    CompanEdgeProtocol::VsSubscribe* vsSubscribe = reqMsg.mutable_vssubscribe();
+    vsSubscribe->add_ids(textId_);
+    vsSubscribe->set_epoch(ws_.epoch() + 1);
+    vsSubscribe->set_version(1);
+    handler_->doMessage(reqMsg);
+
+    rspMsg = queueGet();
+    ASSERT_TRUE(rspMsg.has_vsresult());
+    EXPECT_EQ(rspMsg.vsresult().status(), CompanEdgeProtocol::VsResult_Status_resync_required);
+    EXPECT_EQ(rspMsg.vsresult().values_size(), 0);
+    EXPECT_EQ(rspMsg.vsresult().epoch(), ws_.epoch());
+
+    // nothing is subscribed
+    ws_.get(textId_)->set("something");
+
+    run();
+    EXPECT_TRUE(msgQueue_.empty());
+}
+
+TEST_F(ServerProtocolHandlerTest, VsSubscribe_Invalidate)
+{
+    CompanEdgeProtocol::ClientMessage rspMsg;
+    CompanEdgeProtocol::ServerMessage reqMsg;
+
+    populateValueStore();
+
+    CompanEdgeProtocol::VsSubscribe* vsSubscribe = reqMsg.mutable_vssubscribe();
+    vsSubscribe->set_invalidate(true);
+    vsSubscribe->add_ids(textId_);
+    handler_->doMessage(reqMsg);
+
+    // the values aren't sent
+    rspMsg = queueGet();
+    ASSERT_TRUE(rspMsg.has_vsresult());
+    EXPECT_EQ(rspMsg.vsresult().status(), CompanEdgeProtocol::VsResult_Status_success);
+    EXPECT_EQ(rspMsg.vsresult().values_size(), 0);
+
+    // a change is notified by id
+    ws_.get(textId_)->set("something");
+
+    rspMsg = queueGet();
+    ASSERT_TRUE(rspMsg.has_valueinvalidated());
+    ASSERT_EQ(rspMsg.valueinvalidated().id_size(), 1);
+    EXPECT_EQ(rspMsg.valueinvalidated().id(0), textId_);
+
+    // once, until it's subscribed again
+    ws_.get(textId_)->set("nothing");
+
+    run();
+    EXPECT_TRUE(msgQueue_.empty());
+
+    handler_->doMessage(reqMsg);
+    rspMsg = queueGet();
+    ASSERT_TRUE(rspMsg.has_vsresult());
+
+    // a removal is too
+    EXPECT_TRUE(ws_.del(textId_));
+
+    rspMsg = queueGet();
+    ASSERT_TRUE(rspMsg.has_valueinvalidated());
+    EXPECT_EQ(rspMsg.valueinvalidated().id(0), textId_);
+
+    run();
+    EXPECT_TRUE(msgQueue_.empty());
+}
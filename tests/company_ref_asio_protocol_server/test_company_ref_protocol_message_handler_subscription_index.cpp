@@ -0,0 +1,355 @@
+/**
+  Copyright © 2024 COMPAN REF
+  @file test_company_ref_protocol_message_handler_subscription_index.cpp
+  @brief Testing the VariantValueStore subscription index
+*/
+
+#include "company_ref_asio_server_protocol_handler_mock.h"
+
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_subscription_index.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <set>
+
+TEST_F(ServerProtocolHandlerTest, SubscriptionIndex_Subtree)
+{
+    populateValueStore();
+
+    VariantValueSubscriptionIndex& index = ws_.subscriptions();
+
+    int notified(0);
+    VariantValueSubscriptionIndex::SubscriberId subscriberId =
+            index.connect([&notified](ClientMessageFrame::Ptr const) { ++notified; });
+
+    EXPECT_NE(subscriberId, VariantValueSubscriptionIndex::InvalidSubscriber);
+    EXPECT_FALSE(index.hasSubscriptions(subscriberId));
+
+    index.subscribe(subscriberId, ws_.get("test"));
+
+    EXPECT_TRUE(index.hasSubscriptions(subscriberId));
+    EXPECT_TRUE(index.isSubscribed(subscriberId, ws_.get("test")));
+    EXPECT_TRUE(index.isSubscribed(subscriberId, ws_.get(textId_)));
+    EXPECT_FALSE(index.isSubscribed(subscriberId, ws_.get(structId_)));
+
+    EXPECT_EQ(index.subscribers(ValueId(textId_)).count(subscriberId), 1u);
+    EXPECT_EQ(index.subscribers(ValueId(structId_)).count(subscriberId), 0u);
+
+    // a child and it's parent are notified
+    ws_.get(textId_)->set("something");
+    run();
+    EXPECT_EQ(notified, 2);
+
+    // outside of the subtree
+    CompanEdgeProtocol::Value otherValue(textValue_);
+    otherValue.set_id("other.string");
+    ASSERT_TRUE(ws_.set(otherValue));
+    run();
+
+    notified = 0;
+    ws_.get("other.string")->set("something");
+    run();
+    EXPECT_EQ(notified, 0);
+
+    index.unsubscribe(subscriberId, ws_.get("test"));
+    EXPECT_FALSE(index.hasSubscriptions(subscriberId));
+    EXPECT_EQ(index.nodeCount(), 0u);
+
+    index.disconnect(subscriberId);
+    EXPECT_EQ(index.subscriberCount(), 0u);
+}
+
+TEST_F(ServerProtocolHandlerTest, SubscriptionIndex_SharedNodes)
+{
+    populateValueStore();
+
+    VariantValueSubscriptionIndex& index = ws_.subscriptions();
+
+    VariantValueSubscriptionIndex::SubscriberId first = index.connect([](ClientMessageFrame::Ptr const) {});
+    VariantValueSubscriptionIndex::SubscriberId second = index.connect([](ClientMessageFrame::Ptr const) {});
+
+    EXPECT_NE(first, second);
+
+    index.subscribe(first, ws_.get(containerId1_));
+    index.subscribe(second, ws_.get(containerId2_));
+    index.subscribe(second, ws_.get(containerId2_));
+
+    // a, a.b, a.b.container1 and a.b.container2
+    EXPECT_EQ(index.nodeCount(), 4u);
+
+    EXPECT_EQ(index.subscribers(ValueId(containerId1_)).size(), 1u);
+    EXPECT_EQ(index.subscribers(ValueId(structId_)).size(), 0u);
+
+    // the parent is not part of either subscription
+    EXPECT_FALSE(index.isSubscribed(first, ws_.get(structId_)));
+    EXPECT_FALSE(index.isSubscribed(first, ws_.get(containerId2_)));
+
+    index.unsubscribeAll(second);
+    EXPECT_EQ(index.nodeCount(), 3u);
+    EXPECT_TRUE(index.hasSubscriptions(first));
+
+    index.disconnect(first);
+    index.disconnect(second);
+    EXPECT_EQ(index.nodeCount(), 0u);
+    EXPECT_EQ(index.subscriberCount(), 0u);
+}
+
+TEST_F(ServerProtocolHandlerTest, SubscriptionIndex_HandlerDisconnect)
+{
+    CompanEdgeProtocol::ServerMessage reqMsg;
+    CompanEdgeProtocol::ClientMessage rspMsg;
+
+    populateValueStore();
+
+    *reqMsg.mutable_vssubscribe()->add_ids() = structId_;
+    handler_->doMessage(reqMsg);
+
+    rspMsg = queueGet();
+    Validate_VsResultOffset(rspMsg, structId_, 0);
+
+    // only the subscribed root is held, not it's children
+    EXPECT_EQ(ws_.subscriptions().subscriberCount(), 1u);
+    EXPECT_EQ(ws_.subscriptions().nodeCount(), 2u);
+
+    reqMsg.Clear();
+    reqMsg.mutable_vsunsubscribe();
+    handler_->doMessage(reqMsg);
+
+    rspMsg = queueGet();
+    EXPECT_EQ(rspMsg.vsresult().status(), CompanEdgeProtocol::VsResult_Status_success);
+    EXPECT_EQ(ws_.subscriptions().nodeCount(), 0u);
+
+    handler_->disconnect();
+    EXPECT_EQ(ws_.subscriptions().subscriberCount(), 0u);
+}
+
+/*!
+ * Measures the cost of a single value change as the number of
+ * subscribed connections grows.
+ *
+ * Each connection subscribes to one subtree; the trie is shared,
+ * so the node count grows with the number of subtrees, not with
+ * connections or subscribed children.
+ *
+ * A benchmark, run with --gtest_also_run_disabled_tests
+ * --gtest_filter=ServerProtocolHandlerTest.DISABLED_SubscriptionIndex_DispatchScaling
+ */
+TEST_F(ServerProtocolHandlerTest, DISABLED_SubscriptionIndex_DispatchScaling)
+{
+    size_t const Subtrees(16);
+    size_t const Leaves(64);
+    size_t const Changes(256);
+
+    for (size_t tree = 0; tree < Subtrees; ++tree) {
+        for (size_t leaf = 0; leaf < Leaves; ++leaf) {
+            CompanEdgeProtocol::Value value;
+            value.set_id("bench." + std::to_string(tree) + ".leaf" + std::to_string(leaf));
+            value.set_type(CompanEdgeProtocol::Text);
+            value.set_access(CompanEdgeProtocol::Value_Access_ReadWrite);
+            value.mutable_textvalue()->set_value("init");
+            ASSERT_TRUE(ws_.set(value));
+        }
+    }
+    run();
+
+    for (size_t connections : {1, 16, 256, 1024}) {
+        size_t delivered(0);
+
+        std::vector<ServerProtocolHandler::Ptr> handlers;
+        handlers.reserve(connections);
+
+        for (size_t count = 0; count < connections; ++count) {
+            ServerProtocolHandler::Ptr handler =
+                    std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, count + 1);
+
+            CompanEdgeProtocol::ServerMessage reqMsg;
+            *reqMsg.mutable_vssubscribe()->add_ids() = "bench." + std::to_string(count % Subtrees);
+            handler->doMessage(reqMsg);
+
+            handler->connectSendCallback([&delivered](ClientMessagePtr) { ++delivered; });
+            handlers.push_back(handler);
+        }
+        run();
+
+        EXPECT_LE(ws_.subscriptions().nodeCount(), Subtrees + 1);
+
+        VariantValue::Ptr valuePtr = ws_.get("bench.0.leaf0");
+        ASSERT_TRUE(valuePtr);
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t change = 0; change < Changes; ++change) {
+            valuePtr->set(std::to_string(change));
+            run();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        // the leaf and it's subscribed parent, to each connection on that subtree
+        size_t const subscribed = (connections + Subtrees - 1) / Subtrees;
+        EXPECT_EQ(delivered, Changes * 2 * subscribed);
+
+        std::cout << "connections:" << std::setw(5) << connections
+                  << " nodes:" << std::setw(3) << ws_.subscriptions().nodeCount() << " per change:" << std::setw(8)
+                  << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / Changes << "ns"
+                  << std::endl;
+
+        for (auto& handler : handlers) handler->disconnect();
+        run();
+
+        EXPECT_EQ(ws_.subscriptions().nodeCount(), 0u);
+    }
+}
+
+TEST_F(ServerProtocolHandlerTest, SubscriptionIndex_SharedMessage)
+{
+    populateValueStore();
+
+    std::vector<ServerProtocolHandler::Ptr> handlers;
+    std::set<ClientMessagePtr> messages;
+    size_t delivered(0);
+
+    for (size_t count = 0; count < 4; ++count) {
+        ServerProtocolHandler::Ptr handler =
+                std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, count + 1);
+
+        CompanEdgeProtocol::ServerMessage reqMsg;
+        *reqMsg.mutable_vssubscribe()->add_ids() = textId_;
+        handler->doMessage(reqMsg);
+
+        handler->connectSendCallback([&messages, &delivered](ClientMessagePtr msgPtr) {
+            messages.insert(msgPtr);
+            ++delivered;
+        });
+        handlers.push_back(handler);
+    }
+    run();
+
+    ws_.get(textId_)->set("something");
+    run();
+
+    // every connection was handed the same message
+    EXPECT_EQ(delivered, handlers.size());
+    ASSERT_EQ(messages.size(), 1u);
+    ASSERT_TRUE(*messages.begin());
+    EXPECT_EQ((*messages.begin())->valuechanged().value(0).id(), textId_);
+
+    for (auto& handler : handlers) handler->disconnect();
+}
+
+TEST_F(ServerProtocolHandlerTest, SubscriptionIndex_SharedFrame)
+{
+    populateValueStore();
+
+    std::vector<ServerProtocolHandler::Ptr> handlers;
+    std::set<ClientMessageFrame::Ptr> frames;
+
+    for (size_t count = 0; count < 4; ++count) {
+        ServerProtocolHandler::Ptr handler =
+                std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, count + 1);
+
+        CompanEdgeProtocol::ServerMessage reqMsg;
+        *reqMsg.mutable_vssubscribe()->add_ids() = textId_;
+        handler->doMessage(reqMsg);
+
+        handler->connectSendFrameCallback([&frames](ClientMessageFrame::Ptr framePtr) {
+            // every connection writes it's own framing
+            framePtr->encoded(true);
+            frames.insert(framePtr);
+        });
+        handlers.push_back(handler);
+    }
+    run();
+
+    ws_.get(textId_)->set("something");
+    run();
+
+    ASSERT_EQ(frames.size(), 1u);
+
+    ClientMessageFrame::Ptr framePtr = *frames.begin();
+    EXPECT_EQ(framePtr->value(), ws_.get(textId_));
+    EXPECT_EQ(framePtr->encodeCount(), 1u);
+
+    // the same buffer is handed out, per framing version
+    ClientMessageFrame::BufferPtr buffer = framePtr->encoded(true);
+    ASSERT_TRUE(buffer);
+    EXPECT_EQ(buffer, framePtr->encoded(true));
+    EXPECT_EQ(framePtr->encodeCount(), 1u);
+
+    ClientMessageFrame::BufferPtr oldBuffer = framePtr->encoded(false);
+    ASSERT_TRUE(oldBuffer);
+    EXPECT_NE(buffer, oldBuffer);
+    EXPECT_EQ(framePtr->encodeCount(), 2u);
+
+    // both carry the same payload
+    std::string const serialized = framePtr->message()->SerializeAsString();
+    EXPECT_EQ(buffer->substr(buffer->size() - serialized.size()), serialized);
+    EXPECT_EQ(oldBuffer->substr(oldBuffer->size() - serialized.size()), serialized);
+
+    for (auto& handler : handlers) handler->disconnect();
+}
+
+/*!
+ * Measures the cost of fanning out a single value change as the
+ * number of subscribed connections grows.
+ *
+ * The change is serialized and framed once, regardless of how
+ * many connections write it.
+ *
+ * A benchmark, run with --gtest_also_run_disabled_tests
+ * --gtest_filter=ServerProtocolHandlerTest.DISABLED_SubscriptionIndex_FanOutScaling
+ */
+TEST_F(ServerProtocolHandlerTest, DISABLED_SubscriptionIndex_FanOutScaling)
+{
+    size_t const Changes(256);
+
+    populateValueStore();
+
+    for (size_t connections : {1, 16, 256, 1024}) {
+        std::vector<ServerProtocolHandler::Ptr> handlers;
+        handlers.reserve(connections);
+
+        size_t delivered(0);
+        std::set<ClientMessageFrame::Ptr> frames;
+
+        for (size_t count = 0; count < connections; ++count) {
+            ServerProtocolHandler::Ptr handler =
+                    std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, count + 1);
+
+            CompanEdgeProtocol::ServerMessage reqMsg;
+            *reqMsg.mutable_vssubscribe()->add_ids() = textId_;
+            handler->doMessage(reqMsg);
+
+            handler->connectSendFrameCallback([&delivered, &frames](ClientMessageFrame::Ptr framePtr) {
+                if (framePtr->encoded(true)) ++delivered;
+                frames.insert(framePtr);
+            });
+            handlers.push_back(handler);
+        }
+        run();
+
+        VariantValue::Ptr valuePtr = ws_.get(textId_);
+        ASSERT_TRUE(valuePtr);
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t change = 0; change < Changes; ++change) {
+            valuePtr->set(std::to_string(change));
+            run();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        size_t encodes(0);
+        for (auto& framePtr : frames) encodes += framePtr->encodeCount();
+
+        EXPECT_EQ(delivered, Changes * connections);
+        EXPECT_EQ(frames.size(), Changes);
+        EXPECT_EQ(encodes, Changes);
+
+        std::cout << "connections:" << std::setw(5) << connections << " encodes per change:" << std::setw(3)
+                  << encodes / Changes << " per change:" << std::setw(8)
+                  << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / Changes << "ns"
+                  << std::endl;
+
+        for (auto& handler : handlers) handler->disconnect();
+        run();
+    }
+}
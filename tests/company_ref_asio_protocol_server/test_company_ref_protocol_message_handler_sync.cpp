@@ -128,3 +128,34 @@ TEST_F(ServerProtocolHandlerTest, VsSync_DiscreteChildren)
     Validate_ValueChangedOffset(rspMsg, containerId1_, 1);
     Validate_ValueChangedOffset(rspMsg, containerId2_, 2);
 }
+
+TEST_F(ServerProtocolHandlerTest, VsSync_Chunked)
+{
+    CompanEdgeProtocol::ClientMessage rspMsg;
+    CompanEdgeProtocol::ServerMessage reqMsg;
+
+    populateValueStore();
+
+    handler_->setChunkLimits(2, 0);
+
+    reqMsg.mutable_vssync();
+    handler_->doMessage(reqMsg);
+
+    int received(0);
+    while (true) {
+        rspMsg = queueGet();
+
+        ASSERT_TRUE(rspMsg.has_valuechanged());
+        EXPECT_LE(rspMsg.valuechanged().value_size(), 2);
+        received += rspMsg.valuechanged().value_size();
+
+        if (rspMsg.has_vssynccompleted()) break;
+
+        // next chunk isn't produced until the previous one drained
+        EXPECT_TRUE(msgQueue_.empty());
+        handler_->onMessageDrained(lastMsgPtr_);
+    }
+
+    EXPECT_EQ(received, static_cast<int>(ws_.size()));
+    EXPECT_TRUE(msgQueue_.empty());
+}
@@ -0,0 +1,321 @@
+/**
+  Copyright © 2024 COMPAN REF
+  @file test_company_ref_boost_client_queue.cpp
+  @brief Testing the boost client message queues and requests
+*/
+
+#include <gmock/gmock.h>
+
+#include <company_ref_boost_client/company_ref_boost_client.h>
+#include <company_ref_boost_client/company_ref_boost_spsc_queue.h>
+#include <company_ref_protocol/company_ref_protocol.pb.h>
+
+#include <boost/asio/executor_work_guard.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace Compan::Edge;
+
+namespace {
+
+/// Exposes the receive path, without a socket
+class TestBoostClient : public CompanEdgeBoostClientBase {
+public:
+    TestBoostClient(boost::asio::io_context& ctx)
+        : CompanEdgeBoostClientBase(ctx)
+    {
+    }
+
+    virtual bool isConnected() { return true; }
+
+    using CompanEdgeBoostClientBase::write;
+
+    /// Keeps the messages rather than writing them
+    virtual void write(CompanEdgeProtocol::ServerMessage const& msg) { written_.push_back(msg); }
+
+    void receive(std::string const& payload) { parseResponseMessage(payload.data(), payload.size()); }
+
+    void receive(CompanEdgeProtocol::ClientMessage const& msg) { receive(msg.SerializeAsString()); }
+
+    /// The connection is lost, as on doClose
+    void abort() { failRequests(boost::asio::error::connection_aborted); }
+
+    std::vector<CompanEdgeProtocol::ServerMessage> written_;
+
+protected:
+    virtual void doConnect() {}
+    virtual void doCancel() {}
+    virtual void doClose() {}
+    virtual void doRead() {}
+    virtual void doWrite() {}
+};
+
+} // namespace
+
+TEST(SpscQueueTest, Order)
+{
+    SpscQueue<std::unique_ptr<int>> queue(4);
+    EXPECT_EQ(queue.capacity(), 4u);
+    EXPECT_TRUE(queue.empty());
+
+    // past the ring, values spill and keep their order
+    for (int i = 0; i < 10; ++i) queue.push(std::unique_ptr<int>(new int(i)));
+
+    EXPECT_TRUE(queue.pending());
+    EXPECT_EQ(queue.spilled(), 6u);
+
+    std::vector<int> values;
+    auto collect = [&values](std::unique_ptr<int>& value) {
+        values.push_back(*value);
+        return true;
+    };
+
+    EXPECT_EQ(queue.consume(collect, 3), 3u);
+
+    // pushed while spilled values wait, they come after them
+    queue.push(std::unique_ptr<int>(new int(10)));
+
+    EXPECT_EQ(queue.consume(collect, 100), 8u);
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.pending());
+
+    ASSERT_EQ(values.size(), 11u);
+    for (int i = 0; i < 11; ++i) EXPECT_EQ(values[i], i);
+
+    // the function stops a batch
+    for (int i = 0; i < 3; ++i) queue.push(std::unique_ptr<int>(new int(i)));
+
+    EXPECT_EQ(queue.consume([](std::unique_ptr<int>&) { return false; }, 100), 1u);
+    EXPECT_EQ(queue.clear(), 2u);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(SpscQueueTest, Concurrent)
+{
+    size_t const count(200000);
+
+    SpscQueue<size_t> queue(64);
+
+    std::thread producer([&queue, count] {
+        for (size_t i = 0; i < count; ++i) queue.push(size_t(i));
+    });
+
+    size_t expected(0);
+    bool ordered(true);
+
+    while (expected < count) {
+        queue.consume(
+                [&expected, &ordered](size_t& value) {
+                    ordered = ordered && value == expected;
+                    ++expected;
+                    return true;
+                },
+                32);
+    }
+
+    producer.join();
+
+    EXPECT_TRUE(ordered);
+    EXPECT_TRUE(queue.empty());
+}
+
+/*!
+ * Received ValueChanged messages, from the parse to the listeners
+ *
+ * A benchmark, run with --gtest_also_run_disabled_tests
+ * --gtest_filter=CompanEdgeBoostClientTest.DISABLED_ReceiveThroughput
+ */
+TEST(CompanEdgeBoostClientTest, DISABLED_ReceiveThroughput)
+{
+    size_t const messageCount(100000);
+
+    CompanEdgeProtocol::ClientMessage msg;
+    CompanEdgeProtocol::Value* value = msg.mutable_valuechanged()->add_value();
+    value->set_id("test.text");
+    value->set_type(CompanEdgeProtocol::Text);
+    value->mutable_textvalue()->set_value("something");
+
+    std::string payload;
+    msg.SerializeToString(&payload);
+
+    boost::asio::io_context ctx;
+    auto work = boost::asio::make_work_guard(ctx);
+
+    std::shared_ptr<TestBoostClient> client = std::make_shared<TestBoostClient>(ctx);
+    client->setWantRead([]() { return true; });
+
+    size_t received(0);
+    SignalScopedConnection connection(client->connectClientMessageListener(
+            [&received, &work, messageCount](CompanEdgeProtocol::ClientMessage const& rsp) {
+                if (rsp.has_valuechanged()) ++received;
+                if (received == messageCount) work.reset();
+            }));
+
+    auto const start = std::chrono::steady_clock::now();
+
+    // the reader's thread
+    std::thread producer([&client, &payload, messageCount] {
+        for (size_t i = 0; i < messageCount; ++i) client->receive(payload);
+    });
+
+    ctx.run();
+    producer.join();
+
+    double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(received, messageCount);
+
+    std::cout << std::setw(10) << "receive" << std::setw(14) << "msgs/s" << std::endl;
+    std::cout << std::setw(10) << "" << std::setw(14) << uint64_t(messageCount / seconds) << std::endl;
+}
+
+TEST(CompanEdgeBoostClientTest, RequestComplete)
+{
+    boost::asio::io_context ctx;
+
+    std::shared_ptr<TestBoostClient> client = std::make_shared<TestBoostClient>(ctx);
+    client->setWantRead([]() { return true; });
+
+    CompanEdgeProtocol::ServerMessage msg;
+    msg.mutable_vsgetvalue()->set_id("test.text");
+
+    size_t completed(0);
+    boost::system::error_code error(boost::asio::error::would_block);
+    CompanEdgeProtocol::ClientMessage response;
+
+    auto onComplete = [&completed, &error, &response](
+                              boost::system::error_code ec, CompanEdgeProtocol::ClientMessage rspMsg) {
+        ++completed;
+        error = ec;
+        response = std::move(rspMsg);
+    };
+
+    client->asyncRequest(msg, onComplete);
+    client->asyncRequest(msg, onComplete);
+
+    // each request gets it's own sequenceNo
+    ASSERT_EQ(client->written_.size(), 2u);
+    uint32_t const sequenceNo(client->written_[1].vsgetvalue().sequenceno());
+    EXPECT_NE(sequenceNo, 0u);
+    EXPECT_NE(sequenceNo, client->written_[0].vsgetvalue().sequenceno());
+
+    // a response to some other request doesn't complete it
+    CompanEdgeProtocol::ClientMessage rspMsg;
+    rspMsg.mutable_vsresult()->set_sequenceno(sequenceNo + 1);
+    client->receive(rspMsg);
+
+    ctx.run();
+    EXPECT_EQ(completed, 0u);
+
+    // completed out of order, by the response's sequenceNo
+    rspMsg.mutable_vsresult()->set_sequenceno(sequenceNo);
+    rspMsg.mutable_vsresult()->set_status(CompanEdgeProtocol::VsResult::success);
+    rspMsg.mutable_vsresult()->add_values()->set_id("test.text");
+    client->receive(rspMsg);
+
+    ctx.restart();
+    ctx.run();
+
+    EXPECT_EQ(completed, 1u);
+    EXPECT_FALSE(error);
+    EXPECT_EQ(response.vsresult().sequenceno(), sequenceNo);
+    ASSERT_EQ(response.vsresult().values_size(), 1);
+    EXPECT_EQ(response.vsresult().values(0).id(), "test.text");
+
+    // not a request
+    CompanEdgeProtocol::ServerMessage notRequest;
+    notRequest.mutable_valuechanged();
+
+    client->asyncRequest(notRequest, onComplete);
+
+    ctx.restart();
+    ctx.run();
+
+    EXPECT_EQ(completed, 2u);
+    EXPECT_EQ(error, boost::asio::error::invalid_argument);
+    EXPECT_EQ(client->written_.size(), 2u);
+}
+
+TEST(CompanEdgeBoostClientTest, RequestStreamed)
+{
+    boost::asio::io_context ctx;
+
+    std::shared_ptr<TestBoostClient> client = std::make_shared<TestBoostClient>(ctx);
+    client->setWantRead([]() { return true; });
+
+    CompanEdgeProtocol::ServerMessage msg;
+    msg.mutable_vssubscribe();
+
+    size_t completed(0);
+    CompanEdgeProtocol::ClientMessage response;
+
+    client->asyncRequest(
+            msg, [&completed, &response](boost::system::error_code ec, CompanEdgeProtocol::ClientMessage rspMsg) {
+                EXPECT_FALSE(ec);
+                ++completed;
+                response = std::move(rspMsg);
+            });
+
+    ASSERT_EQ(client->written_.size(), 1u);
+    uint32_t const sequenceNo(client->written_[0].vssubscribe().sequenceno());
+
+    // the chunks are merged into a single response
+    for (int i = 0; i < 3; ++i) {
+        CompanEdgeProtocol::ClientMessage rspMsg;
+        rspMsg.mutable_vsresult()->set_sequenceno(sequenceNo);
+        rspMsg.mutable_vsresult()->set_more(i < 2);
+        rspMsg.mutable_vsresult()->add_values()->set_id("test.value" + std::to_string(i));
+        client->receive(rspMsg);
+    }
+
+    ctx.run();
+
+    EXPECT_EQ(completed, 1u);
+    EXPECT_FALSE(response.vsresult().more());
+    ASSERT_EQ(response.vsresult().values_size(), 3);
+    for (int i = 0; i < 3; ++i) EXPECT_EQ(response.vsresult().values(i).id(), "test.value" + std::to_string(i));
+}
+
+TEST(CompanEdgeBoostClientTest, RequestAborted)
+{
+    boost::asio::io_context ctx;
+
+    std::shared_ptr<TestBoostClient> client = std::make_shared<TestBoostClient>(ctx);
+    client->setWantRead([]() { return true; });
+
+    CompanEdgeProtocol::ServerMessage msg;
+    msg.mutable_vsgetvalue()->set_id("test.text");
+
+    std::vector<boost::system::error_code> errors;
+    auto onComplete = [&errors](boost::system::error_code ec, CompanEdgeProtocol::ClientMessage rspMsg) {
+        errors.push_back(ec);
+        EXPECT_FALSE(rspMsg.has_vsresult());
+    };
+
+    client->asyncRequest(msg, onComplete);
+    client->asyncRequest(msg, onComplete);
+
+    // the responses are lost with the connection
+    client->abort();
+
+    ctx.run();
+
+    ASSERT_EQ(errors.size(), 2u);
+    for (auto const& ec : errors) EXPECT_EQ(ec, boost::asio::error::connection_aborted);
+
+    // a late response completes nothing
+    CompanEdgeProtocol::ClientMessage rspMsg;
+    rspMsg.mutable_vsresult()->set_sequenceno(client->written_[0].vsgetvalue().sequenceno());
+    client->receive(rspMsg);
+
+    ctx.restart();
+    ctx.run();
+
+    EXPECT_EQ(errors.size(), 2u);
+}
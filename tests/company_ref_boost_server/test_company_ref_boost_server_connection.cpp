@@ -0,0 +1,404 @@
+/**
+  Copyright © 2024 COMPAN REF
+  @file test_company_ref_boost_server_connection.cpp
+  @brief Testing the boost server connection read path
+*/
+
+#include <gmock/gmock.h>
+
+#include <company_ref_asio/company_ref_asio_uds_server.h>
+#include <company_ref_asio_protocol_server/company_ref_asio_server_msg_handler_factory.h>
+#include <company_ref_boost_server/company_ref_boost_uds_server.h>
+#include <company_ref_boost_server/company_ref_boost_ws_handler_factory.h>
+#include <company_ref_dmo/company_ref_dmo_container.h>
+#include <company_ref_protocol/company_ref_protocol.pb.h>
+#include <company_ref_protocol_utils/company_ref_framing.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore.h>
+
+#include <boost/asio/executor_work_guard.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace Compan::Edge;
+
+namespace {
+std::string const TextId("test.text");
+
+/// Blocking client, keeps the load generation out of the io_context measured
+int connectUds(std::string const& path)
+{
+    int const fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    if (::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/// A framed VsGetValue, repeated count times
+std::string makeRequests(size_t const count)
+{
+    CompanEdgeProtocol::ServerMessage msg;
+    msg.mutable_vsgetvalue()->set_id(TextId);
+
+    std::string frame(msg.SerializeAsString());
+    frame.insert(0, AECv10::makeHeader<std::string>(frame.cbegin(), frame.cend()));
+
+    std::string frames;
+    frames.reserve(frame.size() * count);
+    for (size_t i = 0; i < count; ++i) frames += frame;
+
+    return frames;
+}
+
+/// Counts the response frames read from a socket
+class ResponseReader {
+public:
+    ResponseReader(int const fd)
+        : fd_(fd)
+        , frames_(0)
+        , error_(false)
+        , callbacks_(
+                  {[this]() { error_ = true; },
+                   [this](AECFrameId const&, std::string::const_iterator, std::string::const_iterator) {
+                       ++frames_;
+                   }})
+    {
+    }
+
+    /// Reads until count responses have arrived, false on error or disconnect
+    bool waitFor(size_t const count)
+    {
+        char data[65536];
+
+        while (frames_ < count) {
+            ssize_t const n = ::read(fd_, data, sizeof(data));
+            if (n <= 0) return false;
+
+            buffer_.append(data, n);
+
+            while (!buffer_.empty() && !error_)
+                if (!AECv10::parseFrame(buffer_, callbacks_)) break;
+
+            if (error_) return false;
+        }
+
+        frames_ -= count;
+        return true;
+    }
+
+private:
+    int const fd_;
+    size_t frames_;
+    bool error_;
+
+    std::string buffer_;
+    AecCallbacks<std::string> callbacks_;
+};
+
+/// Writes all of data
+bool writeAll(int const fd, char const* data, size_t size)
+{
+    while (size) {
+        ssize_t const n = ::write(fd, data, size);
+        if (n <= 0) return false;
+
+        data += n;
+        size -= n;
+    }
+
+    return true;
+}
+} // namespace
+
+class CompanEdgeBoostServerConnectionTest : public testing::Test {
+public:
+    CompanEdgeBoostServerConnectionTest()
+        : udsPath_("./boost_connection")
+        , ws_(ctx_)
+    {
+        VariantValue::Ptr valuePtr = std::make_shared<VariantValue>(ws_.getStrand(), TextId, CompanEdgeProtocol::Text);
+        ws_.add(valuePtr);
+        valuePtr->set("hello");
+
+        ::unlink(udsPath_.c_str());
+    }
+
+    virtual ~CompanEdgeBoostServerConnectionTest()
+    {
+        stopThread();
+        ::unlink(udsPath_.c_str());
+    }
+
+    void startThread()
+    {
+        thread_ = std::thread([this] {
+            auto work = boost::asio::make_work_guard(ctx_);
+            ctx_.run();
+        });
+    }
+
+    /// Waits for pred to hold, the io_context runs on it's thread
+    bool waitUntil(std::function<bool()> const& pred)
+    {
+        auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+        while (!pred()) {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return true;
+    }
+
+    void stopThread()
+    {
+        if (!thread_.joinable()) return;
+
+        ctx_.stop();
+        thread_.join();
+        ctx_.restart();
+    }
+
+    std::string const udsPath_;
+
+    boost::asio::io_context ctx_;
+    VariantValueStore ws_;
+    DmoContainer dmo_;
+
+    std::thread thread_;
+};
+
+TEST_F(CompanEdgeBoostServerConnectionTest, SplitFrames)
+{
+    CompanEdgeBoostWsMessageHandlerFactory factory(ctx_, ws_, dmo_);
+    std::unique_ptr<CompanEdgeBoostUdsServer> server(
+            std::make_unique<CompanEdgeBoostUdsServer>(ctx_, factory, udsPath_));
+    startThread();
+
+    int const fd = connectUds(udsPath_);
+    ASSERT_GE(fd, 0);
+
+    ResponseReader reader(fd);
+
+    // a frame split across reads is carried over, not lost
+    std::string const requests(makeRequests(3));
+    size_t const split(requests.size() / 2);
+
+    ASSERT_TRUE(writeAll(fd, requests.data(), split));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_TRUE(writeAll(fd, requests.data() + split, requests.size() - split));
+
+    EXPECT_TRUE(reader.waitFor(3));
+
+    // a batch of frames in one read
+    std::string const batch(makeRequests(100));
+    ASSERT_TRUE(writeAll(fd, batch.data(), batch.size()));
+
+    EXPECT_TRUE(reader.waitFor(100));
+
+    ::close(fd);
+
+    stopThread();
+    server->stop();
+}
+
+TEST_F(CompanEdgeBoostServerConnectionTest, Registry)
+{
+    using ConnectionManager = CompanEdgeBoostUdsServer::ConnectionManagerType;
+
+    CompanEdgeBoostWsMessageHandlerFactory factory(ctx_, ws_, dmo_);
+    std::unique_ptr<CompanEdgeBoostUdsServer> server(
+            std::make_unique<CompanEdgeBoostUdsServer>(ctx_, factory, udsPath_));
+    ConnectionManager& manager(server->connectionManager());
+    startThread();
+
+    int const fd1 = connectUds(udsPath_);
+    int const fd2 = connectUds(udsPath_);
+    ASSERT_GE(fd1, 0);
+    ASSERT_GE(fd2, 0);
+
+    ASSERT_TRUE(waitUntil([&manager] { return manager.snapshot()->connections.size() == 2; }));
+
+    // a snapshot isn't changed by later connections
+    ConnectionManager::RegistryPtr snapshot(manager.snapshot());
+
+    for (auto const& entry : snapshot->connections) {
+        EXPECT_EQ(manager.get(entry.first), entry.second);
+        EXPECT_EQ(entry.second->getConnectionId(), entry.first);
+    }
+
+    int const fd3 = connectUds(udsPath_);
+    ASSERT_GE(fd3, 0);
+
+    ASSERT_TRUE(waitUntil([&manager] { return manager.snapshot()->connections.size() == 3; }));
+    EXPECT_EQ(snapshot->connections.size(), 2u);
+
+    // a disconnected client leaves the registry
+    ::close(fd3);
+    ASSERT_TRUE(waitUntil([&manager] { return manager.snapshot()->connections.size() == 2; }));
+    EXPECT_FALSE(manager.get(0xffffffff));
+
+    ::close(fd1);
+    ::close(fd2);
+
+    stopThread();
+    server->stop();
+
+    EXPECT_TRUE(manager.snapshot()->connections.empty());
+}
+
+TEST_F(CompanEdgeBoostServerConnectionTest, BroadcastGroups)
+{
+    using ConnectionManager = CompanEdgeBoostUdsServer::ConnectionManagerType;
+
+    CompanEdgeBoostWsMessageHandlerFactory factory(ctx_, ws_, dmo_);
+    std::unique_ptr<CompanEdgeBoostUdsServer> server(
+            std::make_unique<CompanEdgeBoostUdsServer>(ctx_, factory, udsPath_));
+    ConnectionManager& manager(server->connectionManager());
+    startThread();
+
+    std::vector<int> fds;
+    for (int i = 0; i < 3; ++i) {
+        fds.push_back(connectUds(udsPath_));
+        ASSERT_GE(fds.back(), 0);
+
+        // the connection ids follow the order of the clients
+        ASSERT_TRUE(waitUntil([&manager, &fds] { return manager.snapshot()->connections.size() == fds.size(); }));
+    }
+
+    std::vector<uint32_t> ids;
+    for (auto const& entry : manager.snapshot()->connections) ids.push_back(entry.first);
+    std::sort(ids.begin(), ids.end());
+
+    EXPECT_TRUE(manager.joinGroup("Logger", ids[0]));
+    EXPECT_TRUE(manager.joinGroup("Logger", ids[1]));
+    EXPECT_TRUE(manager.joinGroup("Logger", ids[1]));
+    EXPECT_FALSE(manager.joinGroup("Logger", 0xffffffff));
+    EXPECT_EQ(manager.snapshot()->groups.at("Logger").size(), 2u);
+
+    ClientMessageFrame::ClientMessagePtr msgPtr = std::make_shared<CompanEdgeProtocol::ClientMessage>();
+    *msgPtr->mutable_valuechanged()->add_value() = ws_.get(TextId)->get();
+    ClientMessageFrame::Ptr framePtr = std::make_shared<ClientMessageFrame>(msgPtr);
+
+    EXPECT_EQ(manager.broadcast("Logger", framePtr), 2u);
+    EXPECT_EQ(manager.broadcast("Nobody", framePtr), 0u);
+
+    ResponseReader reader0(fds[0]);
+    ResponseReader reader1(fds[1]);
+    EXPECT_TRUE(reader0.waitFor(1));
+    EXPECT_TRUE(reader1.waitFor(1));
+
+    // encoded once for the group
+    EXPECT_EQ(framePtr->encodeCount(), 1u);
+
+    // the third client isn't in the group
+    struct pollfd pfd = {fds[2], POLLIN, 0};
+    EXPECT_EQ(::poll(&pfd, 1, 50), 0);
+
+    manager.leaveGroup("Logger", ids[0]);
+    EXPECT_EQ(manager.broadcast("Logger", framePtr), 1u);
+    EXPECT_TRUE(reader1.waitFor(1));
+
+    // a disconnected client leaves it's groups, empty groups go
+    ::close(fds[1]);
+    ASSERT_TRUE(waitUntil([&manager] { return manager.snapshot()->groups.empty(); }));
+
+    ::close(fds[0]);
+    ::close(fds[2]);
+
+    stopThread();
+    server->stop();
+}
+
+/*!
+ * Pipelined VsGetValue round trips through the boost and the asio
+ * server stacks
+ *
+ * A benchmark, run with --gtest_also_run_disabled_tests
+ * --gtest_filter=CompanEdgeBoostServerConnectionTest.DISABLED_Throughput
+ */
+TEST_F(CompanEdgeBoostServerConnectionTest, DISABLED_Throughput)
+{
+    size_t const clientCount(8);
+    size_t const requestCount(20000);
+    size_t const window(64); //!< requests in flight per client
+
+    std::string const requests(makeRequests(window));
+
+    std::cout << std::setw(10) << "stack" << std::setw(14) << "msgs/s" << std::endl;
+
+    for (bool const useBoost : {true, false}) {
+        CompanEdgeBoostWsMessageHandlerFactory boostFactory(ctx_, ws_, dmo_);
+        ServerMsgHandlerFactory asioFactory(ctx_, ws_, dmo_);
+
+        std::unique_ptr<CompanEdgeBoostUdsServer> boostServer;
+        std::unique_ptr<AsioUdsServer> asioServer;
+
+        if (useBoost)
+            boostServer = std::make_unique<CompanEdgeBoostUdsServer>(ctx_, boostFactory, udsPath_);
+        else
+            asioServer = std::make_unique<AsioUdsServer>(ctx_, asioFactory, udsPath_);
+
+        startThread();
+
+        auto const start = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> clients;
+        std::atomic<size_t> failures(0);
+
+        for (size_t c = 0; c < clientCount; ++c) {
+            clients.emplace_back([this, &failures, &requests, requestCount, window] {
+                int const fd = connectUds(udsPath_);
+                if (fd < 0) {
+                    ++failures;
+                    return;
+                }
+
+                ResponseReader reader(fd);
+
+                for (size_t sent = 0; sent < requestCount; sent += window) {
+                    if (!writeAll(fd, requests.data(), requests.size()) || !reader.waitFor(window)) {
+                        ++failures;
+                        break;
+                    }
+                }
+
+                ::close(fd);
+            });
+        }
+
+        for (auto& client : clients) client.join();
+
+        double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        EXPECT_EQ(failures, 0u);
+
+        stopThread();
+        if (boostServer) boostServer->stop();
+        boostServer.reset();
+        asioServer.reset();
+        ::unlink(udsPath_.c_str());
+
+        std::cout << std::setw(10) << (useBoost ? "boost" : "asio") << std::setw(14)
+                  << uint64_t(clientCount * requestCount / seconds) << std::endl;
+    }
+}
@@ -4,6 +4,7 @@
   @brief Test the DMO Helper class
 */
 
+#include "test_company_ref_dmo_helper.h"
 #include "test_dmo_container_mock.h"
 
 #include "company_ref_dmo_helper.h"
@@ -17,6 +18,16 @@
 using namespace Compan::Edge;
 using namespace CompanEdgeProtocol;
 
+CompanEdgeProtocol::Value makeValue(std::string const& id, std::string const& text)
+{
+    CompanEdgeProtocol::Value value;
+    value.set_id(id);
+    value.set_type(CompanEdgeProtocol::Text);
+    value.mutable_textvalue()->set_value(text);
+
+    return value;
+}
+
 class DmoHelperTest : public DmoContainerTest {
 public:
     DmoHelperTest()
@@ -0,0 +1,16 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file test_company_ref_dmo_helper.h
+ @brief Helpers shared by the DMO tests
+ */
+#ifndef __TEST_COMPANY_REF_DMO_HELPER_H__
+#define __TEST_COMPANY_REF_DMO_HELPER_H__
+
+#include <company_ref_protocol/company_ref_protocol.pb.h>
+
+#include <string>
+
+/// A Text value, as persisted in datamodel files, snapshots and logs
+CompanEdgeProtocol::Value makeValue(std::string const& id, std::string const& text);
+
+#endif // __TEST_COMPANY_REF_DMO_HELPER_H__
@@ -0,0 +1,125 @@
+/**
+  Copyright © 2024 COMPAN REF
+  @file test_company_ref_dmo_shards.cpp
+  @brief Test datamodel persisted in shards
+*/
+
+#include "test_company_ref_dmo_helper.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <company_ref_dmo/company_ref_dmo_shards.h>
+#include <company_ref_dmo/company_ref_dmo_wal.h>
+#include <company_ref_protocol/company_ref_datamodel.pb.h>
+
+#include <Compan_logger/Compan_logger_sink_buffered.h>
+
+#include <fstream>
+#include <map>
+
+using namespace Compan::Edge;
+
+namespace {
+
+class DmoShardsTest : public testing::Test {
+public:
+    DmoShardsTest() { removeFiles(); }
+
+    virtual ~DmoShardsTest()
+    {
+        removeFiles();
+
+        EXPECT_TRUE(coutWrapper_.empty());
+        if (!coutWrapper_.empty()) std::cout << coutWrapper_.pop() << std::endl;
+    }
+
+    void removeFiles()
+    {
+        DmoShards shards(PersistPath);
+        shards.read();
+
+        for (auto& shardPath : shards.shardPaths()) {
+            unlink(shardPath.c_str());
+            unlink(DmoWal::logPath(shardPath).c_str());
+        }
+
+        unlink(DmoShards::manifestPath(PersistPath).c_str());
+    }
+
+    CompanLoggerSinkBuffered coutWrapper_;
+
+    static std::string const PersistPath;
+};
+
+std::string const DmoShardsTest::PersistPath("./test_shards.dmo");
+
+} // namespace
+
+TEST_F(DmoShardsTest, Subtree)
+{
+    EXPECT_EQ(DmoShards::subtree("a.b.c"), "a");
+    EXPECT_EQ(DmoShards::subtree("a"), "a");
+    EXPECT_EQ(DmoShards::subtree(""), "");
+}
+
+TEST_F(DmoShardsTest, Manifest)
+{
+    EXPECT_FALSE(DmoShards::exists(PersistPath));
+
+    DmoShards shards(PersistPath);
+    EXPECT_TRUE(shards.read());
+    EXPECT_FALSE(shards.dirty());
+
+    std::string const shardA(shards.shardPath("a"));
+    std::string const shardB(shards.shardPath("b"));
+    EXPECT_NE(shardA, shardB);
+    EXPECT_TRUE(shards.dirty());
+
+    // known subtrees keep their shard
+    EXPECT_EQ(shards.shardPath("a"), shardA);
+
+    EXPECT_TRUE(shards.write());
+    EXPECT_FALSE(shards.dirty());
+    EXPECT_TRUE(DmoShards::exists(PersistPath));
+
+    DmoShards readShards(PersistPath);
+    EXPECT_TRUE(readShards.read());
+    EXPECT_EQ(readShards.shards(), shards.shards());
+    EXPECT_EQ(readShards.shardPath("b"), shardB);
+    EXPECT_FALSE(readShards.dirty());
+}
+
+TEST_F(DmoShardsTest, Restore)
+{
+    std::map<std::string, std::string> expected;
+
+    {
+        DmoShards shards(PersistPath);
+        ASSERT_TRUE(shards.read());
+
+        for (std::string const subtree : {"a", "b", "c", "d", "e"}) {
+            DmoWal wal(shards.shardPath(subtree));
+            ASSERT_TRUE(wal.open());
+
+            wal.append(makeValue(subtree + ".one", subtree));
+            wal.append(makeValue(subtree + ".two", subtree));
+            wal.appendRemove(subtree + ".one");
+            EXPECT_TRUE(wal.sync());
+
+            expected[subtree + ".two"] = subtree;
+        }
+
+        ASSERT_TRUE(shards.write());
+    }
+
+    std::vector<CompanEdgeDataModel::DataModelMessage> dmoData;
+    EXPECT_TRUE(DmoShards::restore(PersistPath, dmoData));
+    EXPECT_EQ(dmoData.size(), 5u);
+
+    std::map<std::string, std::string> values;
+    for (auto& shard : dmoData)
+        for (auto& value : shard.dataentities().value()) values[value.id()] = value.textvalue().value();
+
+    EXPECT_EQ(values, expected);
+}
@@ -0,0 +1,205 @@
+/**
+  Copyright © 2024 COMPAN REF
+  @file test_company_ref_dmo_snapshot.cpp
+  @brief Test datamodel binary snapshot
+*/
+
+#include "test_company_ref_dmo_helper.h"
+#include "test_dmo_container_mock.h"
+
+#include <company_ref_dmo/company_ref_dmo_file.h>
+#include <company_ref_dmo/company_ref_dmo_snapshot.h>
+#include <company_ref_protocol/company_ref_datamodel.pb.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_hash_methods.h>
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include <unistd.h>
+
+using namespace Compan::Edge;
+
+namespace {
+
+std::string const SnapshotFile("./test.snapshot");
+
+size_t countValues(VariantValueStore& ws)
+{
+    size_t count(0);
+    ws.visitValues([&count](VariantValue::Ptr const) { ++count; });
+
+    return count;
+}
+
+} // namespace
+
+TEST(DmoSnapshotTest, Columns)
+{
+    CompanEdgeDataModel::DataModelMessage dmoData;
+    auto values = dmoData.mutable_dataentities()->mutable_value();
+
+    *values->Add() = makeValue("c.text", "c");
+    *values->Add() = makeValue("a.text", "old");
+    *values->Add() = makeValue("b.text", "b");
+    *values->Add() = makeValue("a.text", "a");
+
+    EXPECT_TRUE(DmoSnapshot::write(SnapshotFile, dmoData));
+    EXPECT_TRUE(DmoSnapshot::isSnapshot(SnapshotFile));
+
+    DmoSnapshot snapshot;
+    ASSERT_TRUE(snapshot.open(SnapshotFile));
+
+    // sorted by id, the last a.text is kept
+    ASSERT_EQ(snapshot.size(), 3u);
+
+    std::vector<std::string> const ids({"a.text", "b.text", "c.text"});
+    std::vector<std::string> const texts({"a", "b", "c"});
+
+    for (size_t i = 0; i < snapshot.size(); ++i) {
+        EXPECT_EQ(snapshot.id(i), ids[i]);
+        EXPECT_EQ(snapshot.hashId(i), FnvHash::as32(ids[i]));
+        EXPECT_EQ(snapshot.type(i), CompanEdgeProtocol::Text);
+
+        CompanEdgeProtocol::Value value;
+        EXPECT_TRUE(snapshot.value(i, value));
+        EXPECT_EQ(value.id(), ids[i]);
+        EXPECT_EQ(value.textvalue().value(), texts[i]);
+    }
+
+    snapshot.close();
+    EXPECT_FALSE(snapshot.isOpen());
+
+    unlink(SnapshotFile.c_str());
+}
+
+TEST(DmoSnapshotTest, Corrupted)
+{
+    CompanLoggerSinkBuffered coutWrapper;
+
+    CompanEdgeDataModel::DataModelMessage dmoData;
+    *dmoData.mutable_dataentities()->add_value() = makeValue("a.text", "a");
+
+    // a datamodel file isn't a snapshot
+    {
+        std::ofstream oFile(SnapshotFile.c_str(), std::ios::binary);
+        dmoData.SerializeToOstream(&oFile);
+    }
+    EXPECT_FALSE(DmoSnapshot::isSnapshot(SnapshotFile));
+
+    DmoSnapshot snapshot;
+    EXPECT_FALSE(snapshot.open(SnapshotFile));
+
+    // sections past the end of a truncated snapshot
+    EXPECT_TRUE(DmoSnapshot::write(SnapshotFile, dmoData));
+    EXPECT_EQ(truncate(SnapshotFile.c_str(), 100), 0);
+
+    EXPECT_TRUE(DmoSnapshot::isSnapshot(SnapshotFile));
+    EXPECT_FALSE(snapshot.open(SnapshotFile));
+    EXPECT_FALSE(snapshot.isOpen());
+
+    // the corrupted snapshots are logged
+    while (!coutWrapper.empty()) coutWrapper.pop();
+
+    unlink(SnapshotFile.c_str());
+}
+
+TEST_F(DmoContainerTest, ValueStoreFromSnapshot)
+{
+    DmoContainer readContainer;
+    boost::asio::io_context ctx;
+    VariantValueStore ws(ctx);
+
+    addValueDefs();
+    addMetaDefs();
+    addInstanceDefs();
+
+    CompanEdgeDataModel::DataModelMessage dmoData;
+    EXPECT_TRUE(DmoFile::write(dmo_, dmoData));
+    EXPECT_TRUE(DmoSnapshot::write(SnapshotFile, dmoData));
+
+    EXPECT_TRUE(DmoSnapshot::read(SnapshotFile, readContainer, ws));
+
+    ValueDefType metaVisited;
+    readContainer.visitMetaData([&metaVisited](CompanEdgeProtocol::Value const& value) {
+        metaVisited.push_back(std::make_pair(value.id(), value.type()));
+    });
+    EXPECT_EQ(metaVisited, resultsMetaVisited_);
+
+    ValueDefType valueVisited;
+    ws.visitValues([&valueVisited](VariantValue::Ptr const valuePtr) {
+        valueVisited.push_back(std::make_pair(valuePtr->id(), valuePtr->type()));
+    });
+    EXPECT_EQ(valueVisited, resultsInstanceVisited_);
+
+    unlink(SnapshotFile.c_str());
+}
+
+// a benchmark, run with --gtest_also_run_disabled_tests --gtest_filter=DmoSnapshotTest.DISABLED_Startup
+TEST(DmoSnapshotTest, DISABLED_Startup)
+{
+    std::string const dmoPath("./test_startup.dmo");
+
+    std::cout << std::setw(10) << "values" << std::setw(12) << "dmo ms" << std::setw(12) << "snapshot ms"
+              << std::endl;
+
+    for (size_t const valueCount : {10000, 100000, 1000000}) {
+        CompanEdgeDataModel::DataModelMessage dmoData;
+        auto values = dmoData.mutable_dataentities()->mutable_value();
+        values->Reserve(valueCount);
+
+        for (size_t i = 0; i < valueCount; ++i)
+            *values->Add() = makeValue(
+                    "startup.s" + std::to_string(i / 1000) + ".v" + std::to_string(i % 1000), std::to_string(i));
+
+        {
+            std::ofstream oFile(dmoPath.c_str(), std::ios::binary);
+            EXPECT_TRUE(dmoData.SerializeToOstream(&oFile));
+        }
+        EXPECT_TRUE(DmoSnapshot::write(SnapshotFile, dmoData));
+
+        dmoData.Clear();
+
+        auto elapsed = [](std::chrono::steady_clock::time_point const start) {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        };
+
+        boost::asio::io_context ctx;
+
+        size_t dmoValues(0);
+        double dmoMs(0);
+        {
+            DmoContainer container;
+            VariantValueStore ws(ctx);
+
+            auto const start = std::chrono::steady_clock::now();
+            EXPECT_TRUE(DmoFile::read(dmoPath, container, ws));
+            dmoMs = elapsed(start);
+
+            dmoValues = countValues(ws);
+        }
+
+        size_t snapshotValues(0);
+        double snapshotMs(0);
+        {
+            DmoContainer container;
+            VariantValueStore ws(ctx);
+
+            auto const start = std::chrono::steady_clock::now();
+            EXPECT_TRUE(DmoSnapshot::read(SnapshotFile, container, ws));
+            snapshotMs = elapsed(start);
+
+            snapshotValues = countValues(ws);
+        }
+
+        EXPECT_EQ(dmoValues, snapshotValues);
+
+        std::cout << std::setw(10) << valueCount << std::fixed << std::setprecision(0) << std::setw(12) << dmoMs
+                  << std::setw(12) << snapshotMs << std::endl;
+    }
+
+    unlink(dmoPath.c_str());
+    unlink(SnapshotFile.c_str());
+}
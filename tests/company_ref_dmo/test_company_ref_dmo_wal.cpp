@@ -0,0 +1,231 @@
+/**
+  Copyright © 2024 COMPAN REF
+  @file test_company_ref_dmo_wal.cpp
+  @brief Test datamodel write ahead log
+*/
+
+#include "test_company_ref_dmo_helper.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <company_ref_dmo/company_ref_dmo_wal.h>
+#include <company_ref_protocol/company_ref_datamodel.pb.h>
+
+#include <Compan_logger/Compan_logger_sink_buffered.h>
+
+#include <fstream>
+#include <map>
+
+using namespace Compan::Edge;
+
+namespace {
+
+class DmoWalTest : public testing::Test {
+public:
+    DmoWalTest() { removeFiles(); }
+
+    virtual ~DmoWalTest()
+    {
+        removeFiles();
+
+        EXPECT_TRUE(coutWrapper_.empty());
+        if (!coutWrapper_.empty()) std::cout << coutWrapper_.pop() << std::endl;
+    }
+
+    void removeFiles()
+    {
+        unlink(SnapshotPath.c_str());
+        unlink(DmoWal::logPath(SnapshotPath).c_str());
+        unlink(DmoWal::rotatedPath(SnapshotPath).c_str());
+    }
+
+    /// Restored values, by id
+    static std::map<std::string, std::string> restore()
+    {
+        CompanEdgeDataModel::DataModelMessage dmoData;
+        EXPECT_TRUE(DmoWal::restore(SnapshotPath, dmoData));
+
+        std::map<std::string, std::string> values;
+        for (auto& value : dmoData.dataentities().value()) values[value.id()] = value.textvalue().value();
+
+        return values;
+    }
+
+    CompanLoggerSinkBuffered coutWrapper_;
+
+    static std::string const SnapshotPath;
+};
+
+std::string const DmoWalTest::SnapshotPath("./test_wal.dmo");
+
+} // namespace
+
+TEST_F(DmoWalTest, AppendReplay)
+{
+    DmoWal wal(SnapshotPath);
+    ASSERT_TRUE(wal.open());
+
+    wal.append(makeValue("a.text", "one"));
+    wal.append(makeValue("b.text", "two"));
+    wal.appendRemove("a.text");
+    wal.append(makeValue("b.text", "three"));
+
+    // nothing is written until synced
+    EXPECT_EQ(wal.pending(), 4u);
+    EXPECT_EQ(wal.logSize(), 0u);
+    EXPECT_TRUE(restore().empty());
+
+    EXPECT_TRUE(wal.sync());
+    EXPECT_EQ(wal.pending(), 0u);
+    EXPECT_GT(wal.logSize(), 0u);
+
+    std::map<std::string, std::string> const expected({{"b.text", "three"}});
+    EXPECT_EQ(restore(), expected);
+
+    EXPECT_FALSE(wal.unsynced());
+
+    // a removed value is added back, written and left to the kernel until synced
+    wal.append(makeValue("a.text", "four"));
+    EXPECT_TRUE(wal.write());
+    EXPECT_TRUE(wal.unsynced());
+
+    std::map<std::string, std::string> const expectedReAdded({{"a.text", "four"}, {"b.text", "three"}});
+    EXPECT_EQ(restore(), expectedReAdded);
+
+    EXPECT_TRUE(wal.sync());
+    EXPECT_FALSE(wal.unsynced());
+}
+
+TEST_F(DmoWalTest, TornRecord)
+{
+    uint64_t logSize(0);
+
+    {
+        DmoWal wal(SnapshotPath);
+        ASSERT_TRUE(wal.open());
+
+        wal.append(makeValue("a.text", "one"));
+        EXPECT_TRUE(wal.sync());
+
+        logSize = wal.logSize();
+    }
+
+    // a crash part way through the next record
+    {
+        std::ofstream oFile(DmoWal::logPath(SnapshotPath).c_str(), std::ios::binary | std::ios::app);
+        oFile << std::string("\x20\x00\x00\x00\x01\x02", 6);
+    }
+
+    std::map<std::string, std::string> const expected({{"a.text", "one"}});
+    EXPECT_EQ(restore(), expected);
+
+    // reopened, it's truncated and appended records follow the last whole one
+    DmoWal wal(SnapshotPath);
+    ASSERT_TRUE(wal.open());
+    EXPECT_EQ(wal.logSize(), logSize);
+
+    wal.append(makeValue("b.text", "two"));
+    EXPECT_TRUE(wal.sync());
+
+    std::map<std::string, std::string> const expectedAppended({{"a.text", "one"}, {"b.text", "two"}});
+    EXPECT_EQ(restore(), expectedAppended);
+
+    // a corrupted record ends the replay
+    {
+        std::fstream file(DmoWal::logPath(SnapshotPath).c_str(), std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(logSize + 12);
+        file.put('X');
+    }
+
+    EXPECT_EQ(restore(), expected);
+
+    // the torn records are warned about
+    while (!coutWrapper_.empty()) coutWrapper_.pop();
+}
+
+TEST_F(DmoWalTest, TornRecordLength)
+{
+    uint64_t logSize(0);
+
+    {
+        DmoWal wal(SnapshotPath);
+        ASSERT_TRUE(wal.open());
+
+        wal.append(makeValue("a.text", "one"));
+        EXPECT_TRUE(wal.sync());
+
+        logSize = wal.logSize();
+    }
+
+    // a garbage length, far past the end of the log
+    {
+        std::ofstream oFile(DmoWal::logPath(SnapshotPath).c_str(), std::ios::binary | std::ios::app);
+        oFile << std::string("\xf0\xff\xff\xff\x00\x00\x00\x00\x01", 9);
+    }
+
+    std::map<std::string, std::string> const expected({{"a.text", "one"}});
+    EXPECT_EQ(restore(), expected);
+
+    DmoWal wal(SnapshotPath);
+    ASSERT_TRUE(wal.open());
+    EXPECT_EQ(wal.logSize(), logSize);
+
+    // the torn record is warned about
+    while (!coutWrapper_.empty()) coutWrapper_.pop();
+}
+
+TEST_F(DmoWalTest, Compact)
+{
+    // the persisted file, as written before the log
+    {
+        CompanEdgeDataModel::DataModelMessage dmoData;
+        *dmoData.mutable_dataentities()->add_value() = makeValue("a.text", "one");
+        *dmoData.mutable_dataentities()->add_value() = makeValue("b.text", "two");
+        *dmoData.mutable_dataentities()->add_value() = makeValue("c.text", "three");
+
+        std::ofstream oFile(SnapshotPath.c_str(), std::ios::binary);
+        ASSERT_TRUE(dmoData.SerializeToOstream(&oFile));
+    }
+
+    DmoWal wal(SnapshotPath);
+    ASSERT_TRUE(wal.open());
+
+    wal.appendRemove("a.text");
+    wal.append(makeValue("b.text", "four"));
+    wal.append(makeValue("d.text", "five"));
+
+    // rotated, changes keep being logged while it's compacted
+    EXPECT_TRUE(wal.rotate());
+    EXPECT_EQ(wal.logSize(), 0u);
+    EXPECT_FALSE(wal.rotate());
+
+    wal.append(makeValue("c.text", "six"));
+    EXPECT_TRUE(wal.sync());
+
+    std::map<std::string, std::string> const expected(
+            {{"b.text", "four"}, {"c.text", "six"}, {"d.text", "five"}});
+    EXPECT_EQ(restore(), expected);
+
+    EXPECT_TRUE(DmoWal::compact(SnapshotPath));
+    EXPECT_FALSE(std::ifstream(DmoWal::rotatedPath(SnapshotPath).c_str()).is_open());
+
+    EXPECT_EQ(restore(), expected);
+
+    // the snapshot alone has the rotated log's changes
+    {
+        CompanEdgeDataModel::DataModelMessage dmoData;
+        std::ifstream iFile(SnapshotPath.c_str(), std::ios::binary);
+        ASSERT_TRUE(dmoData.ParseFromIstream(&iFile));
+
+        std::map<std::string, std::string> values;
+        for (auto& value : dmoData.dataentities().value()) values[value.id()] = value.textvalue().value();
+
+        std::map<std::string, std::string> const expectedSnapshot(
+                {{"b.text", "four"}, {"c.text", "three"}, {"d.text", "five"}});
+        EXPECT_EQ(values, expectedSnapshot);
+    }
+
+    // and the next rotation is allowed
+    EXPECT_TRUE(wal.rotate());
+}
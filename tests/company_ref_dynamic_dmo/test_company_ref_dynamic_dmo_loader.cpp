@@ -11,10 +11,13 @@
 #include <company_ref_sdk_value_ids/dynamic_dmo_value_ids.h>
 
 #include <company_ref_dmo/company_ref_dmo_helper.h>
+#include <company_ref_dmo/company_ref_dmo_shards.h>
+#include <company_ref_dmo/company_ref_dmo_wal.h>
 #include <company_ref_dynamic_dmo/company_ref_dynamic_dmo_load_actions.h>
 #include <company_ref_protocol_utils/company_ref_pb_init.h>
 
 #include <company_ref_variant_valuestore/company_ref_variant_enum_value.h>
+#include <company_ref_variant_valuestore/company_ref_variant_valuestore_client_frame_compressor.h>
 #include <company_ref_variant_valuestore/company_ref_variant_map_value.h>
 #include <company_ref_variant_valuestore/company_ref_variant_text_value.h>
 #include <company_ref_variant_valuestore/company_ref_variant_uinterval_value.h>
@@ -107,12 +110,122 @@ TEST_F(DynamicDmoLoaderTest, Load)
         EXPECT_EQ(std::dynamic_pointer_cast<VariantEnumValue>(value)->get(), DynamicDmoValueIds::Dmo::Status::Complete);
     });
 
+    // untrained until a load completes
+    EXPECT_TRUE(ws_.frameCompressor()->dictionary().empty());
+
     microServiceDmo.config->action->set(DynamicDmoValueIds::Dmo ::Config ::Load);
 
     run();
 
     EXPECT_TRUE(dmoHelper_.insertChild("system.process.running.status.processes", "1"));
     EXPECT_TRUE(ws_.has("system.process.running.status.processes.1.rssSize"));
+
+    EXPECT_FALSE(ws_.frameCompressor()->dictionary().empty());
+}
+
+TEST_F(DynamicDmoLoaderTest, LoadLogOnly)
+{
+    boost::filesystem::path const persistedName("MockPersisted.dmo");
+    std::string const persistedPath((DmoDirName / persistedName).generic_string());
+
+    // a persisted state which hasn't been compacted yet, only it's log
+    {
+        CompanEdgeProtocol::Value value;
+        value.set_id("persisted.text");
+        value.set_type(CompanEdgeProtocol::Text);
+        value.mutable_textvalue()->set_value("logged");
+
+        DmoWal wal(persistedPath);
+        ASSERT_TRUE(wal.open());
+        wal.append(value);
+        ASSERT_TRUE(wal.sync());
+    }
+    ASSERT_FALSE(boost::filesystem::exists(persistedPath));
+
+    DynamicDmoValueIds dynamicDmoIds(ws_);
+
+    DynamicDmoValueIds::Dmo microServiceDmo(ws_, dynamicDmoIds.dmo->id(), MicroServiceName);
+
+    dynamicDmoIds.dmoPath->set(DmoDirName.generic_string());
+    microServiceDmo.config->path->set(persistedName.generic_string());
+
+    DynamicDmoLoader::Ptr dmoLoader(std::make_shared<DynamicDmoLoader>(
+            ctx_,
+            ws_,
+            dmo_,
+            dynamicDmoIds.dmoPath,
+            microServiceDmo.config->path,
+            microServiceDmo.config->action,
+            microServiceDmo.status->action));
+
+    dmoLoader->init();
+
+    microServiceDmo.config->action->set(DynamicDmoValueIds::Dmo ::Config ::Load);
+    run();
+
+    EXPECT_EQ(microServiceDmo.status->action->get(), DynamicDmoValueIds::Dmo::Status::Complete);
+    EXPECT_TRUE(ws_.has("persisted.text"));
+
+    // the other actions still need the file
+    microServiceDmo.config->action->set(DynamicDmoValueIds::Dmo ::Config ::Unload);
+    run();
+
+    EXPECT_EQ(microServiceDmo.status->action->get(), DynamicDmoValueIds::Dmo::Status::FileNotFound);
+    EXPECT_EQ(coutWrapper_.pop(), "dynamicdmo.loader: Warning: \"./MockPersisted.dmo\" doesn't exist\n");
+
+    boost::filesystem::remove(DmoWal::logPath(persistedPath));
+}
+
+TEST_F(DynamicDmoLoaderTest, LoadShards)
+{
+    boost::filesystem::path const persistedName("MockSharded.dmo");
+    std::string const persistedPath((DmoDirName / persistedName).generic_string());
+
+    // a sharded persisted state, the file itself is gone
+    DmoShards shards(persistedPath);
+    ASSERT_TRUE(shards.read());
+
+    for (std::string const subtree : {"first", "second"}) {
+        CompanEdgeProtocol::Value value;
+        value.set_id(subtree + ".text");
+        value.set_type(CompanEdgeProtocol::Text);
+        value.mutable_textvalue()->set_value(subtree);
+
+        DmoWal wal(shards.shardPath(subtree));
+        ASSERT_TRUE(wal.open());
+        wal.append(value);
+        ASSERT_TRUE(wal.sync());
+    }
+    ASSERT_TRUE(shards.write());
+    ASSERT_FALSE(boost::filesystem::exists(persistedPath));
+
+    DynamicDmoValueIds dynamicDmoIds(ws_);
+
+    DynamicDmoValueIds::Dmo microServiceDmo(ws_, dynamicDmoIds.dmo->id(), MicroServiceName);
+
+    dynamicDmoIds.dmoPath->set(DmoDirName.generic_string());
+    microServiceDmo.config->path->set(persistedName.generic_string());
+
+    DynamicDmoLoader::Ptr dmoLoader(std::make_shared<DynamicDmoLoader>(
+            ctx_,
+            ws_,
+            dmo_,
+            dynamicDmoIds.dmoPath,
+            microServiceDmo.config->path,
+            microServiceDmo.config->action,
+            microServiceDmo.status->action));
+
+    dmoLoader->init();
+
+    microServiceDmo.config->action->set(DynamicDmoValueIds::Dmo ::Config ::Load);
+    run();
+
+    EXPECT_EQ(microServiceDmo.status->action->get(), DynamicDmoValueIds::Dmo::Status::Complete);
+    EXPECT_TRUE(ws_.has("first.text"));
+    EXPECT_TRUE(ws_.has("second.text"));
+
+    for (auto& shardPath : shards.shardPaths()) boost::filesystem::remove(DmoWal::logPath(shardPath));
+    boost::filesystem::remove(DmoShards::manifestPath(persistedPath));
 }
 
 TEST_F(DynamicDmoLoaderTest, Unload)
@@ -17,6 +17,7 @@
 #include <company_ref_main_apps/Compan_logger_factory.h>
 #include <company_ref_microservice/company_ref_microservice_client.h>
 #include <company_ref_microservice/company_ref_microservice_dynamic_dmo.h>
+#include <company_ref_microservice/company_ref_microservice_value_cache.h>
 
 #include <company_ref_variant_valuestore/company_ref_variant_bool_value.h>
 #include <company_ref_variant_valuestore/company_ref_variant_map_value.h>
@@ -35,6 +36,17 @@
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
 
+#if defined(BOOST_ASIO_HAS_CO_AWAIT)
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <set>
+
 using namespace Compan::Edge;
 
 class MicroServiceClientMockable : public MicroServiceClient {
@@ -53,6 +65,8 @@ public:
     }
 
     virtual ~MicroServiceClientMockable() = default;
+
+    using MicroServiceClient::messageHandler;
 };
 
 class MicroServiceClientTest : public testing::Test {
@@ -135,7 +149,7 @@ public:
 
     VariantValueStore ws_;
     DmoContainer dmo_;
-    std::mutex wsContainerMutex_;
+    VariantContainerLocks containerLocks_;
     uint32_t connId_;
 
     std::unique_ptr<DynamicDmoController> controller_;
@@ -151,7 +165,7 @@ public:
 
 TEST_F(MicroServiceClientTest, SingleClientLogger)
 {
-    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, wsContainerMutex_, connId_++);
+    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, connId_++);
     MicroServiceClientMockable clientA(ctx_, "A", connA);
     run();
 
@@ -162,11 +176,11 @@ TEST_F(MicroServiceClientTest, SingleClientLogger)
 
 TEST_F(MicroServiceClientTest, MultiClientLogger)
 {
-    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, wsContainerMutex_, connId_++);
+    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, connId_++);
     MicroServiceClientMockable clientA(ctx_, "A", connA);
     run();
 
-    auto connB = std::make_shared<ServerProtocolHandler>(ws_, dmo_, wsContainerMutex_, connId_++);
+    auto connB = std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, connId_++);
     MicroServiceClientMockable clientB(ctx_, "B", connB);
     run();
 
@@ -187,11 +201,11 @@ TEST_F(MicroServiceClientTest, ClientSubscribeAll)
     createMockDmoStream(strm);
     DmoFile::read(strm, dmo_, ws_);
 
-    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, wsContainerMutex_, connId_++);
+    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, connId_++);
     MicroServiceClientMockable clientA(ctx_, "A", connA);
     run();
 
-    auto connB = std::make_shared<ServerProtocolHandler>(ws_, dmo_, wsContainerMutex_, connId_++);
+    auto connB = std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, connId_++);
     MicroServiceClientMockable clientB(ctx_, "B", connB);
     run();
 
@@ -215,7 +229,7 @@ TEST_F(MicroServiceClientTest, ClientSingleSubscriptionPass)
     createMockDmoStream(strm);
     DmoFile::read(strm, dmo_, ws_);
 
-    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, wsContainerMutex_, connId_++);
+    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, connId_++);
     MicroServiceClientMockable clientA(ctx_, "A", connA);
 
     run();
@@ -244,7 +258,7 @@ TEST_F(MicroServiceClientTest, ClientMultiSubscriptionPass)
     createMockDmoStream(strm);
     DmoFile::read(strm, dmo_, ws_);
 
-    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, wsContainerMutex_, connId_++);
+    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, connId_++);
     MicroServiceClientMockable clientA(ctx_, "A", connA);
     run();
 
@@ -267,7 +281,7 @@ TEST_F(MicroServiceClientTest, ClientAutoReconnect)
     createMockDmoStream(strm);
     DmoFile::read(strm, dmo_, ws_);
 
-    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, wsContainerMutex_, connId_++);
+    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, connId_++);
     MicroServiceClientMockable clientA(ctx_, "A", connA);
     run();
 
@@ -297,6 +311,336 @@ TEST_F(MicroServiceClientTest, ClientAutoReconnect)
     EXPECT_EQ(localPtr->get(), remotePtr->get());
 }
 
+TEST_F(MicroServiceClientTest, ClientResume)
+{
+    std::stringstream strm;
+    createMockDmoStream(strm);
+    DmoFile::read(strm, dmo_, ws_);
+
+    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, connId_++);
+    MicroServiceClientMockable clientA(ctx_, "A", connA);
+    run();
+
+    bool subscribed(false);
+    clientA.subscribeWithCompletion(system_a_id, [&subscribed](bool const complete) { subscribed = complete; });
+
+    run();
+    EXPECT_TRUE(subscribed);
+
+    // disconnect
+    clientA.clientConnection()->close();
+
+    // the server's value changes meanwhile
+    VariantUIntervalValue::Ptr remotePtr = ws_.get<VariantUIntervalValue>(ValueId(system_a_id, "i"));
+    ASSERT_NE(remotePtr, nullptr);
+    remotePtr->set(7);
+
+    VariantUIntervalValue::Ptr localPtr = clientA.ws().get<VariantUIntervalValue>(ValueId(system_a_id, "i"));
+    ASSERT_NE(localPtr, nullptr);
+
+    EXPECT_NE(localPtr->get(), remotePtr->get());
+
+    run();
+
+    // resumed, the change is received rather than overwritten by the local state
+    EXPECT_EQ(remotePtr->get(), 7u);
+    EXPECT_EQ(localPtr->get(), remotePtr->get());
+}
+
+TEST_F(MicroServiceClientTest, ClientResumeAdvances)
+{
+    std::stringstream strm;
+    createMockDmoStream(strm);
+    DmoFile::read(strm, dmo_, ws_);
+
+    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, connId_++);
+    MicroServiceClientMockable clientA(ctx_, "A", connA);
+    run();
+
+    bool subscribed(false);
+    clientA.subscribeWithCompletion(system_a_id, [&subscribed](bool const complete) { subscribed = complete; });
+
+    run();
+    EXPECT_TRUE(subscribed);
+
+    std::string const valueId(ValueId(system_a_id, "i"));
+
+    VariantUIntervalValue::Ptr remotePtr = ws_.get<VariantUIntervalValue>(valueId);
+    ASSERT_NE(remotePtr, nullptr);
+    VariantUIntervalValue::Ptr localPtr = clientA.ws().get<VariantUIntervalValue>(valueId);
+    ASSERT_NE(localPtr, nullptr);
+
+    // received while connected, the resume point moves past it
+    remotePtr->set(5);
+    run();
+    EXPECT_EQ(localPtr->get(), 5u);
+
+    CompanEdgeProtocol::VsResult resumed;
+    SignalScopedConnection responseConnection(clientA.messageHandler()->connectResponseListener(
+            [&resumed](CompanEdgeProtocol::ClientMessage const& rspMsg) {
+                if (rspMsg.vsresult().delta()) resumed = rspMsg.vsresult();
+            }));
+
+    clientA.clientConnection()->close();
+    run();
+
+    // the resume doesn't send the change again
+    EXPECT_TRUE(resumed.delta());
+    for (auto& value : resumed.values()) EXPECT_NE(value.id(), valueId);
+
+    // the next one does, as it's missed while disconnected
+    clientA.clientConnection()->close();
+    remotePtr->set(6);
+    run();
+
+    EXPECT_EQ(localPtr->get(), 6u);
+    EXPECT_TRUE(std::any_of(resumed.values().begin(), resumed.values().end(), [&valueId](auto const& value) {
+        return value.id() == valueId;
+    }));
+}
+
+TEST_F(MicroServiceClientTest, ClientCoalescedWrites)
+{
+    std::stringstream strm;
+    createMockDmoStream(strm);
+    DmoFile::read(strm, dmo_, ws_);
+
+    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, connId_++);
+    MicroServiceClientMockable clientA(ctx_, "A", connA);
+    run();
+
+    bool subscribed(false);
+    clientA.subscribeWithCompletion(system_a_id, [&subscribed](bool const complete) { subscribed = complete; });
+
+    run();
+    EXPECT_TRUE(subscribed);
+
+    ValueId const valueId(system_a_id, "i");
+
+    // count the writes reaching the server
+    size_t remoteChanges(0);
+    SignalScopedConnection changedConnection(
+            ws_.connectValueChangedListener([&remoteChanges, &valueId](VariantValue::Ptr const valuePtr) {
+                if (valuePtr->id() == valueId) ++remoteChanges;
+            }));
+
+    VariantUIntervalValue::Ptr localPtr = clientA.ws().get<VariantUIntervalValue>(valueId);
+    ASSERT_NE(localPtr, nullptr);
+    VariantUIntervalValue::Ptr remotePtr = ws_.get<VariantUIntervalValue>(valueId);
+    ASSERT_NE(remotePtr, nullptr);
+
+    // the window's changes are written once, latest value wins
+    clientA.coalesceWrites(std::chrono::milliseconds(10));
+
+    localPtr->set(1);
+    localPtr->set(2);
+    localPtr->set(3);
+
+    run();
+
+    EXPECT_EQ(remotePtr->get(), 3u);
+    EXPECT_EQ(remoteChanges, 1u);
+
+    // an explicit flush doesn't wait on the window
+    clientA.coalesceWrites(std::chrono::hours(1));
+
+    localPtr->set(4);
+
+    ctx_.restart();
+    ctx_.poll();
+    EXPECT_EQ(remotePtr->get(), 3u);
+
+    clientA.flush();
+    run();
+
+    EXPECT_EQ(remotePtr->get(), 4u);
+    EXPECT_EQ(remoteChanges, 2u);
+}
+
+TEST_F(MicroServiceClientTest, ClientCacheMode)
+{
+    std::stringstream strm;
+    createMockDmoStream(strm);
+    DmoFile::read(strm, dmo_, ws_);
+
+    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, connId_++);
+    MicroServiceClientMockable clientA(ctx_, "A", connA);
+    run();
+
+    ValueId const valueId(system_a_id, "i");
+
+    VariantUIntervalValue::Ptr remotePtr = ws_.get<VariantUIntervalValue>(valueId);
+    ASSERT_NE(remotePtr, nullptr);
+    remotePtr->set(5);
+
+    clientA.cacheMode(1024 * 1024);
+
+    std::vector<VariantValue::Ptr> values;
+    auto getComplete = [&values](std::vector<VariantValue::Ptr> const& valuePtrs) { values = valuePtrs; };
+
+    // a miss is fetched
+    clientA.cacheGet({valueId, "system.a.none"}, getComplete);
+    run();
+
+    ASSERT_EQ(values.size(), 2u);
+    ASSERT_NE(values[0], nullptr);
+    EXPECT_EQ(values[1], nullptr);
+    EXPECT_EQ(std::static_pointer_cast<VariantUIntervalValue>(values[0])->get(), 5u);
+    EXPECT_TRUE(clientA.ws().has(valueId));
+    EXPECT_EQ(clientA.cacheStats().fetches, 1u);
+    EXPECT_EQ(clientA.cacheStats().entries, 1u);
+
+    // a hit isn't
+    values.clear();
+    clientA.cacheGet({valueId}, getComplete);
+    ASSERT_EQ(values.size(), 1u);
+    EXPECT_NE(values[0], nullptr);
+
+    run();
+    EXPECT_EQ(clientA.cacheStats().fetches, 1u);
+    EXPECT_EQ(clientA.cacheStats().hits, 1u);
+
+    // the server's change invalidates it
+    remotePtr->set(6);
+    run();
+
+    EXPECT_EQ(clientA.cached(valueId), nullptr);
+    EXPECT_FALSE(clientA.ws().has(valueId));
+    EXPECT_EQ(clientA.cacheStats().invalidations, 1u);
+
+    // the removal isn't written back
+    EXPECT_TRUE(ws_.has(valueId));
+
+    // and it's next access fetches the new value
+    clientA.cacheGet({valueId}, getComplete);
+    run();
+
+    ASSERT_EQ(values.size(), 1u);
+    ASSERT_NE(values[0], nullptr);
+    EXPECT_EQ(std::static_pointer_cast<VariantUIntervalValue>(values[0])->get(), 6u);
+    EXPECT_EQ(clientA.cacheStats().fetches, 2u);
+
+    // past the budget it's evicted, once the get completes
+    clientA.cacheMode(1);
+
+    EXPECT_EQ(clientA.cacheStats().entries, 0u);
+    EXPECT_EQ(clientA.cacheStats().evictions, 1u);
+    EXPECT_FALSE(clientA.ws().has(valueId));
+    EXPECT_TRUE(ws_.has(valueId));
+
+    values.clear();
+    clientA.cacheGet({valueId}, getComplete);
+    run();
+
+    ASSERT_EQ(values.size(), 1u);
+    EXPECT_NE(values[0], nullptr);
+    EXPECT_EQ(clientA.cacheStats().entries, 0u);
+    EXPECT_EQ(clientA.cacheStats().evictions, 2u);
+}
+
+namespace {
+/// A VsMultiGetResult of a single UInterval value
+CompanEdgeProtocol::ClientMessage makeFetchResult(std::string const& valueId, uint32_t const value)
+{
+    CompanEdgeProtocol::ClientMessage rspMsg;
+    CompanEdgeProtocol::VsMultiGetResult::Result* result = rspMsg.mutable_vsmultigetresult()->add_results();
+    result->set_error(CompanEdgeProtocol::VsMultiGetResult::Success);
+
+    CompanEdgeProtocol::Value* resultValue = result->add_values();
+    resultValue->set_id(valueId);
+    resultValue->set_type(CompanEdgeProtocol::UInterval);
+    resultValue->mutable_uintervalvalue()->set_value(value);
+
+    return rspMsg;
+}
+} // namespace
+
+TEST_F(MicroServiceClientTest, ValueCacheInvalidatedWhileFetching)
+{
+    std::string const valueId("system.a.i");
+
+    // the requests are answered by the test
+    std::vector<MicroServiceValueCache::RequestCompleteCb> requests;
+    MicroServiceValueCache::Ptr cache = std::make_shared<MicroServiceValueCache>(
+            ctx_,
+            ws_,
+            [&requests](CompanEdgeProtocol::ServerMessage&&, MicroServiceValueCache::RequestCompleteCb const& cb) {
+                requests.push_back(cb);
+                return static_cast<uint32_t>(requests.size());
+            },
+            1024 * 1024);
+
+    size_t completed(0);
+    std::vector<VariantValue::Ptr> values;
+    cache->get({valueId}, [&completed, &values](std::vector<VariantValue::Ptr> const& valuePtrs) {
+        ++completed;
+        values = valuePtrs;
+    });
+    run();
+
+    // the invalidate subscribe, then the get
+    ASSERT_EQ(requests.size(), 2u);
+
+    // changed on the server before the fetch is answered
+    cache->invalidate(valueId);
+
+    requests[1](makeFetchResult(valueId, 1));
+    run();
+
+    // the stale value isn't cached, it's fetched again
+    EXPECT_EQ(completed, 0u);
+    EXPECT_EQ(cache->cached(valueId), nullptr);
+    ASSERT_EQ(requests.size(), 4u);
+    EXPECT_EQ(cache->stats().fetches, 2u);
+
+    requests[3](makeFetchResult(valueId, 2));
+
+    EXPECT_EQ(completed, 1u);
+    ASSERT_EQ(values.size(), 1u);
+    ASSERT_NE(values[0], nullptr);
+    EXPECT_EQ(std::static_pointer_cast<VariantUIntervalValue>(values[0])->get(), 2u);
+    EXPECT_NE(cache->cached(valueId), nullptr);
+}
+
+TEST_F(MicroServiceClientTest, ValueCacheDroppedWhileFetching)
+{
+    std::string const valueId("system.a.i");
+
+    std::vector<MicroServiceValueCache::RequestCompleteCb> requests;
+    auto request = [&requests](CompanEdgeProtocol::ServerMessage&&, MicroServiceValueCache::RequestCompleteCb const& cb) {
+        requests.push_back(cb);
+        return static_cast<uint32_t>(requests.size());
+    };
+
+    size_t completed(0);
+    auto getComplete = [&completed](std::vector<VariantValue::Ptr> const&) { ++completed; };
+
+    // dropped with the fetch posted
+    MicroServiceValueCache::Ptr cache = std::make_shared<MicroServiceValueCache>(ctx_, ws_, request, 1024 * 1024);
+    cache->get({valueId}, getComplete);
+    cache.reset();
+
+    run();
+    EXPECT_TRUE(requests.empty());
+
+    // dropped with the fetch sent
+    cache = std::make_shared<MicroServiceValueCache>(ctx_, ws_, request, 1024 * 1024);
+    cache->get({valueId}, getComplete);
+    run();
+    ASSERT_EQ(requests.size(), 2u);
+
+    cache->clear();
+    EXPECT_EQ(completed, 1u);
+    cache.reset();
+
+    // the late response is ignored
+    requests[1](makeFetchResult(valueId, 1));
+    run();
+
+    EXPECT_EQ(completed, 1u);
+    EXPECT_FALSE(ws_.has(valueId));
+}
+
 TEST_F(MicroServiceClientTest, MultiListeners)
 {
     using Map = std::map<ValueId, int>;
@@ -306,15 +650,15 @@ TEST_F(MicroServiceClientTest, MultiListeners)
     createMockDmoStream(strm);
     DmoFile::read(strm, dmo_, ws_);
 
-    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, wsContainerMutex_, connId_++);
+    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, connId_++);
     MicroServiceClientMockable clientA(ctx_, "A", connA);
     run();
 
-    auto connB = std::make_shared<ServerProtocolHandler>(ws_, dmo_, wsContainerMutex_, connId_++);
+    auto connB = std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, connId_++);
     MicroServiceClientMockable clientB(ctx_, "B", connB);
     run();
 
-    auto connC = std::make_shared<ServerProtocolHandler>(ws_, dmo_, wsContainerMutex_, connId_++);
+    auto connC = std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, connId_++);
     MicroServiceClientMockable clientC(ctx_, "C", connC);
     run();
 
@@ -419,7 +763,7 @@ TEST_F(MicroServiceClientTest, ClientPidCompletionUpdate)
     /// Microservice Manager "adds" this information
     DmoValueStoreHelper(dmo_, ws_).insertChild("system.microservices", "A", VariantValue::Remote);
 
-    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, wsContainerMutex_, connId_++);
+    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, connId_++);
     MicroServiceClientMockable clientA(ctx_, "A", connA);
     run();
 
@@ -448,7 +792,7 @@ TEST_F(MicroServiceClientTest, ClientPidCompletionUpdate)
 
 TEST_F(MicroServiceClientTest, DynamicDmoLoader)
 {
-    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, wsContainerMutex_, connId_++);
+    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, connId_++);
     MicroServiceClientMockable clientA(ctx_, "A", connA);
     run();
 
@@ -483,3 +827,261 @@ TEST_F(MicroServiceClientTest, DynamicDmoLoader)
     run();
     EXPECT_TRUE(successLoad);
 }
+
+TEST_F(MicroServiceClientTest, PipelinedRequestWindow)
+{
+    std::stringstream strm;
+    createMockDmoStream(strm);
+    DmoFile::read(strm, dmo_, ws_);
+
+    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, connId_++);
+    MicroServiceClientMockable clientA(ctx_, "A", connA);
+    run();
+
+    size_t const Requests(32);
+
+    clientA.requestWindow(4);
+    EXPECT_EQ(clientA.requestWindow(), 4u);
+
+    std::set<uint32_t> sequenceNos;
+    size_t completed(0);
+    size_t maxOutstanding(0);
+
+    for (size_t count = 0; count < Requests; ++count) {
+        uint32_t sequenceNo = clientA.getValue(
+                ValueId(system_a_id, "i"),
+                [&clientA, &completed, &maxOutstanding](CompanEdgeProtocol::ClientMessage const& rspMsg) {
+                    ASSERT_TRUE(rspMsg.has_vsresult());
+                    EXPECT_EQ(rspMsg.vsresult().status(), CompanEdgeProtocol::VsResult::success);
+                    ASSERT_EQ(rspMsg.vsresult().values_size(), 1);
+
+                    maxOutstanding = std::max(maxOutstanding, clientA.outstandingRequests() + 1);
+                    ++completed;
+                });
+
+        EXPECT_NE(sequenceNo, 0u);
+        sequenceNos.insert(sequenceNo);
+    }
+
+    // past the window, the rest wait
+    EXPECT_EQ(clientA.outstandingRequests(), 4u);
+    EXPECT_EQ(clientA.waitingRequests(), Requests - 4);
+
+    run();
+
+    EXPECT_EQ(sequenceNos.size(), Requests);
+    EXPECT_EQ(completed, Requests);
+    EXPECT_LE(maxOutstanding, 4u);
+    EXPECT_EQ(clientA.outstandingRequests(), 0u);
+    EXPECT_EQ(clientA.waitingRequests(), 0u);
+}
+
+TEST_F(MicroServiceClientTest, PipelinedRequestReissued)
+{
+    std::stringstream strm;
+    createMockDmoStream(strm);
+    DmoFile::read(strm, dmo_, ws_);
+
+    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, connId_++);
+    MicroServiceClientMockable clientA(ctx_, "A", connA);
+    run();
+
+    std::string const valueId(ValueId(system_a_id, "i"));
+
+    bool failed(false);
+    bool completed(false);
+    clientA.getValue(
+            valueId,
+            [&clientA, &valueId, &failed, &completed](CompanEdgeProtocol::ClientMessage const& rspMsg) {
+                EXPECT_FALSE(rspMsg.has_vsresult());
+                failed = true;
+
+                // re-issued from the failure callback, it's sent once reconnected
+                clientA.getValue(valueId, [&completed](CompanEdgeProtocol::ClientMessage const& rspMsg) {
+                    completed = rspMsg.has_vsresult();
+                });
+            });
+
+    // lost with the connection before it's written
+    clientA.clientConnection()->close();
+
+    EXPECT_TRUE(failed);
+    EXPECT_EQ(clientA.outstandingRequests(), 1u);
+
+    run();
+
+    EXPECT_TRUE(completed);
+    EXPECT_EQ(clientA.outstandingRequests(), 0u);
+}
+
+TEST_F(MicroServiceClientTest, PipelinedMultiRequests)
+{
+    std::stringstream strm;
+    createMockDmoStream(strm);
+    DmoFile::read(strm, dmo_, ws_);
+
+    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, connId_++);
+    MicroServiceClientMockable clientA(ctx_, "A", connA);
+    run();
+
+    std::string const valueId(ValueId(system_a_id, "i"));
+
+    bool setCompleted(false);
+    clientA.multiSet({{valueId, "5"}}, [&setCompleted](CompanEdgeProtocol::ClientMessage const& rspMsg) {
+        ASSERT_TRUE(rspMsg.has_vsmultisetresult());
+        ASSERT_EQ(rspMsg.vsmultisetresult().results_size(), 1);
+        EXPECT_EQ(rspMsg.vsmultisetresult().results(0).error(), CompanEdgeProtocol::VsMultiSetResult::Success);
+        setCompleted = true;
+    });
+
+    // pipelined behind the set
+    bool getCompleted(false);
+    clientA.multiGet({valueId}, [&getCompleted](CompanEdgeProtocol::ClientMessage const& rspMsg) {
+        ASSERT_TRUE(rspMsg.has_vsmultigetresult());
+        ASSERT_EQ(rspMsg.vsmultigetresult().results_size(), 1);
+        ASSERT_EQ(rspMsg.vsmultigetresult().results(0).values_size(), 1);
+        EXPECT_EQ(rspMsg.vsmultigetresult().results(0).values(0).uintervalvalue().value(), 5u);
+        getCompleted = true;
+    });
+
+    run();
+
+    EXPECT_TRUE(setCompleted);
+    EXPECT_TRUE(getCompleted);
+    EXPECT_EQ(clientA.outstandingRequests(), 0u);
+}
+
+TEST_F(MicroServiceClientTest, PipelinedRequestFuture)
+{
+    std::stringstream strm;
+    createMockDmoStream(strm);
+    DmoFile::read(strm, dmo_, ws_);
+
+    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, connId_++);
+    MicroServiceClientMockable clientA(ctx_, "A", connA);
+    run();
+
+    CompanEdgeProtocol::ServerMessage getAllMsg;
+    getAllMsg.mutable_vsgetall();
+    MicroServiceClient::RequestFuture getAll = clientA.request(std::move(getAllMsg));
+
+    CompanEdgeProtocol::ServerMessage setMsg;
+    setMsg.mutable_vssetvalue()->set_id(ValueId(system_a_id, "i"));
+    setMsg.mutable_vssetvalue()->set_value("7");
+    MicroServiceClient::RequestFuture set = clientA.request(std::move(setMsg));
+
+    run();
+
+    ASSERT_EQ(getAll.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    CompanEdgeProtocol::ClientMessage getAllRsp = getAll.get();
+    ASSERT_TRUE(getAllRsp.has_vsresult());
+    EXPECT_FALSE(getAllRsp.vsresult().more());
+    EXPECT_GT(getAllRsp.vsresult().values_size(), 0);
+
+    ASSERT_EQ(set.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    EXPECT_EQ(set.get().vsresult().status(), CompanEdgeProtocol::VsResult::success);
+
+    EXPECT_EQ(ws_.get<VariantUIntervalValue>(ValueId(system_a_id, "i"))->get(), 7u);
+}
+
+TEST_F(MicroServiceClientTest, AsyncRequests)
+{
+    std::stringstream strm;
+    createMockDmoStream(strm);
+    DmoFile::read(strm, dmo_, ws_);
+
+    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, connId_++);
+    MicroServiceClientMockable clientA(ctx_, "A", connA);
+    run();
+
+    std::string const valueId(ValueId(system_a_id, "i"));
+
+    // chained, the get sees the set
+    bool completed(false);
+    clientA.asyncSetValue(
+            valueId,
+            "9",
+            [&clientA, &completed, &valueId](
+                    boost::system::error_code const& ec, CompanEdgeProtocol::ClientMessage const& rspMsg) {
+                ASSERT_FALSE(ec);
+                EXPECT_EQ(rspMsg.vsresult().status(), CompanEdgeProtocol::VsResult::success);
+
+                clientA.asyncMultiGet(
+                        {valueId},
+                        [&completed](
+                                boost::system::error_code const& ec, CompanEdgeProtocol::ClientMessage const& rspMsg) {
+                            ASSERT_FALSE(ec);
+                            ASSERT_TRUE(rspMsg.has_vsmultigetresult());
+                            ASSERT_EQ(rspMsg.vsmultigetresult().results_size(), 1);
+                            ASSERT_EQ(rspMsg.vsmultigetresult().results(0).values_size(), 1);
+                            EXPECT_EQ(rspMsg.vsmultigetresult().results(0).values(0).uintervalvalue().value(), 9u);
+                            completed = true;
+                        });
+            });
+
+    run();
+    EXPECT_TRUE(completed);
+
+    // not a request
+    boost::system::error_code error;
+    CompanEdgeProtocol::ServerMessage msg;
+    msg.mutable_valuechanged();
+    clientA.asyncRequest(
+            std::move(msg), [&error](boost::system::error_code const& ec, CompanEdgeProtocol::ClientMessage const&) {
+                error = ec;
+            });
+
+    run();
+    EXPECT_EQ(error, boost::asio::error::invalid_argument);
+
+    // lost with the connection
+    clientA.asyncGetValue(
+            valueId, [&error](boost::system::error_code const& ec, CompanEdgeProtocol::ClientMessage const&) {
+                error = ec;
+            });
+    clientA.clientConnection()->close();
+
+    run();
+    EXPECT_EQ(error, boost::asio::error::connection_aborted);
+}
+
+#if defined(BOOST_ASIO_HAS_CO_AWAIT)
+TEST_F(MicroServiceClientTest, AwaitableRequests)
+{
+    std::stringstream strm;
+    createMockDmoStream(strm);
+    DmoFile::read(strm, dmo_, ws_);
+
+    auto connA = std::make_shared<ServerProtocolHandler>(ws_, dmo_, containerLocks_, connId_++);
+    MicroServiceClientMockable clientA(ctx_, "A", connA);
+    run();
+
+    std::string const valueId(ValueId(system_a_id, "i"));
+    std::vector<std::string> const valueIds({system_a_id});
+    std::vector<std::pair<std::string, std::string>> const values({{valueId, "11"}});
+    bool completed(false);
+
+    boost::asio::co_spawn(
+            ctx_,
+            [&]() -> boost::asio::awaitable<void> {
+                CompanEdgeProtocol::ClientMessage rspMsg =
+                        co_await clientA.asyncSubscribe(valueIds, boost::asio::use_awaitable);
+                EXPECT_EQ(rspMsg.vsresult().status(), CompanEdgeProtocol::VsResult::success);
+                EXPECT_TRUE(clientA.ws().has(valueId));
+
+                rspMsg = co_await clientA.asyncMultiSet(values, boost::asio::use_awaitable);
+                ASSERT_EQ(rspMsg.vsmultisetresult().results_size(), 1);
+                EXPECT_EQ(rspMsg.vsmultisetresult().results(0).error(), CompanEdgeProtocol::VsMultiSetResult::Success);
+
+                rspMsg = co_await clientA.asyncGetValue(valueId, boost::asio::use_awaitable);
+                ASSERT_EQ(rspMsg.vsresult().values_size(), 1);
+                EXPECT_EQ(rspMsg.vsresult().values(0).uintervalvalue().value(), 11u);
+
+                completed = true;
+            },
+            boost::asio::detached);
+
+    run();
+    EXPECT_TRUE(completed);
+}
+#endif
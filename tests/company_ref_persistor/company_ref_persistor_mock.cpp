@@ -0,0 +1,88 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_persistor_mock.cpp
+ @brief Persistor mock
+ */
+#include "company_ref_persistor_mock.h"
+
+#include <company_ref_dmo/company_ref_dmo_shards.h>
+#include <company_ref_dmo/company_ref_dmo_wal.h>
+#include <company_ref_protocol/company_ref_datamodel.pb.h>
+#include <Compan_logger/Compan_logger.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace Compan{
+namespace Edge {
+// defined by the persistor's main, which isn't built into the tests
+CompanLogger PersistorMainLog("appmain", LogLevel::Information);
+} // namespace Edge
+} // namespace Compan
+
+using namespace Compan::Edge;
+
+std::string const PersistorTest::PersistPath("./test_persistor.dmo");
+
+PersistorTest::PersistorTest()
+{
+    removeFiles();
+}
+
+PersistorTest::~PersistorTest()
+{
+    removeFiles();
+
+    EXPECT_TRUE(coutWrapper_.empty());
+    if (!coutWrapper_.empty()) std::cout << coutWrapper_.pop() << std::endl;
+}
+
+void PersistorTest::removeFiles()
+{
+    DmoShards shards(PersistPath);
+    shards.read();
+
+    for (auto& shardPath : shards.shardPaths()) {
+        unlink(shardPath.c_str());
+        unlink(DmoWal::logPath(shardPath).c_str());
+        unlink(DmoWal::rotatedPath(shardPath).c_str());
+    }
+
+    unlink(DmoShards::manifestPath(PersistPath).c_str());
+}
+
+CompanEdgeProtocol::Value PersistorTest::makeValue(std::string const& id, std::string const& text)
+{
+    CompanEdgeProtocol::Value value;
+    value.set_id(id);
+    value.set_type(CompanEdgeProtocol::Text);
+    value.mutable_textvalue()->set_value(text);
+
+    return value;
+}
+
+std::map<std::string, std::string> PersistorTest::restore()
+{
+    std::vector<CompanEdgeDataModel::DataModelMessage> shards;
+    EXPECT_TRUE(DmoShards::restore(PersistPath, shards));
+
+    std::map<std::string, std::string> values;
+    for (auto& dmoData : shards)
+        for (auto& value : dmoData.dataentities().value()) values[value.id()] = value.textvalue().value();
+
+    return values;
+}
+
+bool PersistorTest::waitFor(std::function<bool()> const& condition)
+{
+    for (int i = 0; i < 100; ++i) {
+        if (condition()) return true;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    return condition();
+}
@@ -0,0 +1,42 @@
+/**
+ Copyright © 2024 COMPAN REF
+ @file company_ref_persistor_mock.h
+ @brief Persistor mock
+ */
+#ifndef TESTS_company_ref_PERSISTOR_company_ref_PERSISTOR_MOCK_H_
+#define TESTS_company_ref_PERSISTOR_company_ref_PERSISTOR_MOCK_H_
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <company_ref_protocol/company_ref_protocol.pb.h>
+#include <Compan_logger/Compan_logger_sink_buffered.h>
+
+#include <functional>
+#include <map>
+#include <string>
+
+using namespace Compan::Edge;
+
+class PersistorTest : public testing::Test {
+public:
+    PersistorTest();
+    virtual ~PersistorTest();
+
+    /// Removes the persisted shards, their logs and the manifest
+    void removeFiles();
+
+    static CompanEdgeProtocol::Value makeValue(std::string const& id, std::string const& text);
+
+    /// Restored values, by id
+    static std::map<std::string, std::string> restore();
+
+    /// Polls until the condition holds, or a second has passed
+    static bool waitFor(std::function<bool()> const& condition);
+
+    CompanLoggerSinkBuffered coutWrapper_;
+
+    static std::string const PersistPath;
+};
+
+#endif /* TESTS_company_ref_PERSISTOR_company_ref_PERSISTOR_MOCK_H_ */
@@ -0,0 +1,106 @@
+/**
+  Copyright © 2024 COMPAN REF
+  @file test_company_ref_persistor_bl.cpp
+  @brief Test the Persistor's business logic
+*/
+
+#include "company_ref_persistor_mock.h"
+
+#include <company_ref_persistor/company_ref_persistor_bl.h>
+
+#include <fstream>
+
+#include <unistd.h>
+
+using namespace Compan::Edge;
+
+class PersistorBlMockable : public PersistorBl {
+public:
+    PersistorBlMockable(boost::asio::io_context& ctx, std::string const& cfgPath)
+        : PersistorBl(ctx, "./test_persistor.socket", cfgPath)
+    {
+    }
+
+    virtual ~PersistorBlMockable() = default;
+
+    using PersistorBl::readStatsConfig;
+    using PersistorBl::statsValues;
+};
+
+class PersistorBlTest : public PersistorTest {
+public:
+    using StatsValues = std::vector<std::pair<std::string, std::string>>;
+
+    PersistorBlTest()
+        : PersistorTest()
+        , ctx_()
+    {
+    }
+
+    virtual ~PersistorBlTest() { unlink(CfgPath.c_str()); }
+
+    void writeCfg(std::string const& statsSettings)
+    {
+        std::ofstream oFile(CfgPath.c_str());
+        oFile << "[persist]" << std::endl;
+        oFile << "file=" << PersistPath << std::endl;
+        oFile << "[stats]" << std::endl;
+        oFile << statsSettings;
+    }
+
+    static PersistorWriter::Stats makeStats(uint64_t const bytesWritten, uint64_t const lastFlushMicroseconds)
+    {
+        return PersistorWriter::Stats({1, lastFlushMicroseconds, 0, bytesWritten, 0, 1, 1});
+    }
+
+    boost::asio::io_context ctx_;
+
+    static std::string const CfgPath;
+};
+
+std::string const PersistorBlTest::CfgPath("./test_persistor_bl.ini");
+
+TEST_F(PersistorBlTest, StatsValues)
+{
+    writeCfg("write_rate=persistor.stats.writeRate\n"
+             "dirty=persistor.stats.dirty\n"
+             "flush_latency=persistor.stats.flushLatency\n");
+
+    PersistorBlMockable bl(ctx_, CfgPath);
+    ASSERT_TRUE(bl.readStatsConfig());
+
+    // the write rate is the bytes written since the previous stats, per second
+    StatsValues const first({{"persistor.stats.writeRate", "2000"},
+                             {"persistor.stats.dirty", "7"},
+                             {"persistor.stats.flushLatency", "250"}});
+    EXPECT_EQ(bl.statsValues(makeStats(4000, 250), 7, 2.0), first);
+
+    StatsValues const second({{"persistor.stats.writeRate", "500"},
+                              {"persistor.stats.dirty", "0"},
+                              {"persistor.stats.flushLatency", "120"}});
+    EXPECT_EQ(bl.statsValues(makeStats(4500, 120), 0, 1.0), second);
+
+    // no time has passed, no rate
+    StatsValues const third({{"persistor.stats.writeRate", "0"},
+                             {"persistor.stats.dirty", "0"},
+                             {"persistor.stats.flushLatency", "120"}});
+    EXPECT_EQ(bl.statsValues(makeStats(5000, 120), 0, 0), third);
+}
+
+TEST_F(PersistorBlTest, StatsValues_Configured)
+{
+    // only the configured values are set
+    writeCfg("dirty=persistor.stats.dirty\n");
+
+    PersistorBlMockable bl(ctx_, CfgPath);
+    ASSERT_TRUE(bl.readStatsConfig());
+
+    StatsValues const expected({{"persistor.stats.dirty", "3"}});
+    EXPECT_EQ(bl.statsValues(makeStats(1000, 100), 3, 1.0), expected);
+
+    // none, the stats aren't started
+    writeCfg("interval=1\n");
+
+    PersistorBlMockable noStats(ctx_, CfgPath);
+    EXPECT_FALSE(noStats.readStatsConfig());
+}
@@ -0,0 +1,161 @@
+/**
+  Copyright © 2024 COMPAN REF
+  @file test_company_ref_persistor_client.cpp
+  @brief Test the Persistor's client
+*/
+
+#include "company_ref_persistor_mock.h"
+
+#include <company_ref_persistor/company_ref_persistor_client.h>
+
+#include <fstream>
+
+#include <unistd.h>
+
+using namespace Compan::Edge;
+
+class PersistorClientMockable : public PersistorClient {
+public:
+    PersistorClientMockable(boost::asio::io_context& ctx)
+        : PersistorClient(ctx, "./test_persistor.socket")
+    {
+    }
+
+    virtual ~PersistorClientMockable() = default;
+
+    using PersistorClient::flushDue;
+    using PersistorClient::onMessage;
+    using PersistorClient::onMessageReceived;
+    using PersistorClient::saveToFile;
+};
+
+class PersistorClientTest : public PersistorTest {
+public:
+    PersistorClientTest()
+        : PersistorTest()
+        , ctx_()
+    {
+    }
+
+    virtual ~PersistorClientTest() { unlink(CfgPath.c_str()); }
+
+    /// Writes the config, with the persist section's extra settings
+    void writeCfg(std::string const& persistSettings = std::string())
+    {
+        std::ofstream oFile(CfgPath.c_str());
+        oFile << "[persist]" << std::endl;
+        oFile << "file=" << PersistPath << std::endl;
+        oFile << persistSettings;
+        oFile << "[values]" << std::endl;
+        oFile << "a" << std::endl;
+    }
+
+    boost::asio::io_context ctx_;
+
+    static std::string const CfgPath;
+};
+
+std::string const PersistorClientTest::CfgPath("./test_persistor.ini");
+
+TEST_F(PersistorClientTest, Backlog)
+{
+    PersistorClientMockable client(ctx_);
+
+    CompanEdgeProtocol::ValueChanged valueChanged;
+    *valueChanged.add_value() = makeValue("a.text", "one");
+    *valueChanged.add_value() = makeValue("b.text", "two");
+
+    CompanEdgeProtocol::ValueRemoved valueRemoved;
+    valueRemoved.add_id("c.text");
+
+    client.onMessage(valueChanged);
+    client.onMessage(valueRemoved);
+
+    // nothing is written until started
+    EXPECT_EQ(client.backlog(), 3u);
+    EXPECT_EQ(client.writerStats().flushes, 0u);
+    EXPECT_EQ(client.writerStats().bytesWritten, 0u);
+
+    client.saveToFile();
+    EXPECT_EQ(client.backlog(), 3u);
+
+    writeCfg();
+    client.start(CfgPath);
+
+    client.saveToFile();
+
+    EXPECT_TRUE(waitFor([&client]() { return client.backlog() == 0; }));
+
+    PersistorWriter::Stats const stats(client.writerStats());
+    EXPECT_EQ(stats.flushes, 1u);
+    EXPECT_EQ(stats.lastFlushShards, 3u);
+    EXPECT_GT(stats.bytesWritten, 0u);
+    EXPECT_EQ(stats.writing, 0u);
+
+    std::map<std::string, std::string> const expected({{"a.text", "one"}, {"b.text", "two"}});
+    EXPECT_EQ(restore(), expected);
+}
+
+TEST_F(PersistorClientTest, FlushDue_MaxValues)
+{
+    writeCfg("flush_max_values=3\n");
+
+    PersistorClientMockable client(ctx_);
+    client.start(CfgPath);
+
+    CompanEdgeProtocol::ClientMessage rspMsg;
+    *rspMsg.mutable_valuechanged()->add_value() = makeValue("a.text", "one");
+    *rspMsg.mutable_valuechanged()->add_value() = makeValue("a.text", "two");
+    client.onMessageReceived(rspMsg);
+
+    // a repeated id is one change, left for the flush timeout
+    EXPECT_FALSE(client.flushDue());
+    EXPECT_EQ(client.backlog(), 1u);
+
+    CompanEdgeProtocol::ClientMessage removeMsg;
+    removeMsg.mutable_valueremoved()->add_id("b.text");
+    client.onMessageReceived(removeMsg);
+
+    EXPECT_FALSE(client.flushDue());
+    EXPECT_EQ(client.backlog(), 2u);
+
+    // the third change is handed over without waiting for the timeout
+    rspMsg.mutable_valuechanged()->Clear();
+    *rspMsg.mutable_valuechanged()->add_value() = makeValue("c.text", "three");
+    client.onMessageReceived(rspMsg);
+
+    EXPECT_FALSE(client.flushDue());
+    EXPECT_TRUE(waitFor([&client]() { return client.backlog() == 0; }));
+    EXPECT_EQ(client.writerStats().flushes, 1u);
+
+    std::map<std::string, std::string> const expected({{"a.text", "two"}, {"c.text", "three"}});
+    EXPECT_EQ(restore(), expected);
+}
+
+TEST_F(PersistorClientTest, FlushDue_MaxBytes)
+{
+    writeCfg("flush_max_bytes=256\n");
+
+    PersistorClientMockable client(ctx_);
+    client.start(CfgPath);
+
+    CompanEdgeProtocol::ValueChanged valueChanged;
+    *valueChanged.add_value() = makeValue("a.text", std::string(100, 'a'));
+    client.onMessage(valueChanged);
+
+    EXPECT_FALSE(client.flushDue());
+
+    // replacing a value doesn't count it's previous size
+    client.onMessage(valueChanged);
+    EXPECT_FALSE(client.flushDue());
+
+    valueChanged.Clear();
+    *valueChanged.add_value() = makeValue("b.text", std::string(200, 'b'));
+    client.onMessage(valueChanged);
+
+    EXPECT_TRUE(client.flushDue());
+
+    client.saveToFile();
+    EXPECT_FALSE(client.flushDue());
+    EXPECT_TRUE(waitFor([&client]() { return client.backlog() == 0; }));
+}
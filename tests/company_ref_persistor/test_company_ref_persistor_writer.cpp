@@ -0,0 +1,215 @@
+/**
+  Copyright © 2024 COMPAN REF
+  @file test_company_ref_persistor_writer.cpp
+  @brief Test the Persistor's writer thread
+*/
+
+#include "company_ref_persistor_mock.h"
+
+#include <company_ref_persistor/company_ref_persistor_writer.h>
+
+#include <chrono>
+#include <thread>
+
+using namespace Compan::Edge;
+
+class PersistorWriterTest : public PersistorTest {
+public:
+    PersistorWriterTest()
+        : PersistorTest()
+        , writer_(PersistPath, 2)
+    {
+    }
+
+    virtual ~PersistorWriterTest() = default;
+
+    PersistorWriter writer_;
+};
+
+TEST_F(PersistorWriterTest, FrozenSwap)
+{
+    PersistorWriter::ValueMap values({{"a.text", makeValue("a.text", "one")}, {"b.text", makeValue("b.text", "two")}});
+    PersistorWriter::IdSet removeIds({"c.text"});
+
+    // nothing to hand over
+    PersistorWriter::ValueMap noValues;
+    PersistorWriter::IdSet noRemoveIds;
+    EXPECT_TRUE(writer_.flush(noValues, noRemoveIds));
+    EXPECT_FALSE(writer_.busy());
+
+    // handed over before the thread is started, they're frozen until it writes them
+    EXPECT_TRUE(writer_.flush(values, removeIds));
+    EXPECT_TRUE(values.empty());
+    EXPECT_TRUE(removeIds.empty());
+
+    EXPECT_TRUE(writer_.busy());
+    EXPECT_EQ(writer_.stats().writing, 3u);
+
+    ASSERT_TRUE(writer_.start());
+    writer_.wait();
+
+    EXPECT_FALSE(writer_.busy());
+    EXPECT_EQ(writer_.stats().writing, 0u);
+
+    std::map<std::string, std::string> const expected({{"a.text", "one"}, {"b.text", "two"}});
+    EXPECT_EQ(restore(), expected);
+}
+
+TEST_F(PersistorWriterTest, BusyRetry)
+{
+    PersistorWriter::ValueMap values({{"a.text", makeValue("a.text", "one")}});
+    PersistorWriter::IdSet removeIds;
+
+    EXPECT_TRUE(writer_.flush(values, removeIds));
+
+    // the previous sets are still frozen, the next ones are left to be retried
+    PersistorWriter::ValueMap nextValues({{"a.text", makeValue("a.text", "two")}});
+    PersistorWriter::IdSet nextRemoveIds({"b.text"});
+
+    EXPECT_FALSE(writer_.flush(nextValues, nextRemoveIds));
+    ASSERT_EQ(nextValues.size(), 1u);
+    EXPECT_EQ(nextValues["a.text"].textvalue().value(), "two");
+    EXPECT_EQ(nextRemoveIds.size(), 1u);
+
+    ASSERT_TRUE(writer_.start());
+    writer_.wait();
+
+    EXPECT_TRUE(writer_.flush(nextValues, nextRemoveIds));
+    EXPECT_TRUE(nextValues.empty());
+    writer_.wait();
+
+    std::map<std::string, std::string> const expected({{"a.text", "two"}});
+    EXPECT_EQ(restore(), expected);
+}
+
+TEST_F(PersistorWriterTest, DrainOnDestroy)
+{
+    {
+        PersistorWriter writer(PersistPath, 2);
+        ASSERT_TRUE(writer.start());
+
+        PersistorWriter::ValueMap values({{"a.text", makeValue("a.text", "one")}});
+        PersistorWriter::IdSet removeIds;
+
+        // destroyed without waiting, what's handed over is written before the thread stops
+        EXPECT_TRUE(writer.flush(values, removeIds));
+    }
+
+    std::map<std::string, std::string> const expected({{"a.text", "one"}});
+    EXPECT_EQ(restore(), expected);
+}
+
+TEST_F(PersistorWriterTest, Stats)
+{
+    PersistorWriter::Stats stats(writer_.stats());
+    EXPECT_EQ(stats.flushes, 0u);
+    EXPECT_EQ(stats.bytesWritten, 0u);
+
+    ASSERT_TRUE(writer_.start());
+
+    PersistorWriter::ValueMap values({{"a.text", makeValue("a.text", "one")}, {"b.text", makeValue("b.text", "two")}});
+    PersistorWriter::IdSet removeIds;
+
+    EXPECT_TRUE(writer_.flush(values, removeIds));
+    writer_.wait();
+
+    stats = writer_.stats();
+    EXPECT_EQ(stats.flushes, 1u);
+    EXPECT_EQ(stats.lastFlushShards, 2u);
+    EXPECT_GT(stats.lastFlushBytes, 0u);
+    EXPECT_EQ(stats.bytesWritten, stats.lastFlushBytes);
+    EXPECT_EQ(stats.writing, 0u);
+
+    uint64_t const firstBytes(stats.bytesWritten);
+
+    values.emplace("a.text", makeValue("a.text", "three"));
+    EXPECT_TRUE(writer_.flush(values, removeIds));
+    writer_.wait();
+
+    stats = writer_.stats();
+    EXPECT_EQ(stats.flushes, 2u);
+    EXPECT_EQ(stats.lastFlushShards, 1u);
+    EXPECT_EQ(stats.bytesWritten, firstBytes + stats.lastFlushBytes);
+}
+
+TEST_F(PersistorWriterTest, Durability_NoSync)
+{
+    PersistorWriter writer(PersistPath, 2, PersistorWriter::NoSync);
+    ASSERT_TRUE(writer.start());
+
+    PersistorWriter::ValueMap values({{"a.text", makeValue("a.text", "one")}});
+    PersistorWriter::IdSet removeIds;
+
+    EXPECT_TRUE(writer.flush(values, removeIds));
+    writer.wait();
+
+    // written, and left to the kernel
+    EXPECT_EQ(writer.stats().flushes, 1u);
+    EXPECT_GT(writer.stats().bytesWritten, 0u);
+    EXPECT_EQ(writer.stats().commits, 0u);
+
+    std::map<std::string, std::string> const expected({{"a.text", "one"}});
+    EXPECT_EQ(restore(), expected);
+}
+
+TEST_F(PersistorWriterTest, Durability_SyncOnFlush)
+{
+    PersistorWriter writer(PersistPath, 2, PersistorWriter::SyncOnFlush);
+    ASSERT_TRUE(writer.start());
+
+    for (auto& text : {"one", "two"}) {
+        PersistorWriter::ValueMap values({{"a.text", makeValue("a.text", text)}});
+        PersistorWriter::IdSet removeIds;
+
+        EXPECT_TRUE(writer.flush(values, removeIds));
+        writer.wait();
+    }
+
+    // each flush is synced
+    EXPECT_EQ(writer.stats().flushes, 2u);
+    EXPECT_EQ(writer.stats().commits, 2u);
+}
+
+TEST_F(PersistorWriterTest, Durability_GroupCommit)
+{
+    PersistorWriter writer(PersistPath, 2, PersistorWriter::GroupCommit, std::chrono::milliseconds(200));
+    ASSERT_TRUE(writer.start());
+
+    for (auto& text : {"one", "two", "three"}) {
+        PersistorWriter::ValueMap values({{"a.text", makeValue("a.text", text)}});
+        PersistorWriter::IdSet removeIds;
+
+        EXPECT_TRUE(writer.flush(values, removeIds));
+        writer.wait();
+    }
+
+    // the flushes within the commit window share a sync, once it's passed
+    EXPECT_EQ(writer.stats().flushes, 3u);
+    EXPECT_EQ(writer.stats().commits, 0u);
+
+    EXPECT_TRUE(waitFor([&writer]() { return writer.stats().commits == 1; }));
+
+    std::map<std::string, std::string> const expected({{"a.text", "three"}});
+    EXPECT_EQ(restore(), expected);
+}
+
+TEST_F(PersistorWriterTest, Durability_GroupCommitFlood)
+{
+    PersistorWriter writer(PersistPath, 2, PersistorWriter::GroupCommit, std::chrono::milliseconds(20));
+
+    PersistorWriter::ValueMap values({{"a.text", makeValue("a.text", "zero")}});
+    PersistorWriter::IdSet removeIds;
+    EXPECT_TRUE(writer.flush(values, removeIds));
+
+    ASSERT_TRUE(writer.start());
+
+    // a flush is always handed over before the writer is idle, the commit window still syncs them
+    auto const end = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+    for (size_t i = 0; std::chrono::steady_clock::now() < end; ++i) {
+        values.emplace("a.text", makeValue("a.text", std::to_string(i)));
+
+        while (!writer.flush(values, removeIds)) std::this_thread::yield();
+    }
+
+    EXPECT_GE(writer.stats().commits, 1u);
+}